@@ -796,7 +796,8 @@ static struct {
   { "Aggregate", 9 },
   { "Having", 6 },
   { "Values", 6 },
-  { "Service", 7 }
+  { "Service", 7 },
+  { "Minus", 5 }
 };
 
 
@@ -1307,6 +1308,28 @@ rasqal_algebra_group_graph_pattern_to_algebra(rasqal_query* query,
           true_expr = NULL; /* now owned by gnode */
         }
       } /* end for all optional */
+    } else if(egp->op == RASQAL_GRAPH_PATTERN_OPERATOR_MINUS) {
+      /* If E is of the form MINUS{P} */
+      rasqal_graph_pattern* sgp;
+      rasqal_algebra_node* anode = NULL;
+
+      sgp = rasqal_graph_pattern_get_sub_graph_pattern(egp, 0);
+
+      /* Let A := Transform(P) */
+      if(sgp)
+        anode = rasqal_algebra_graph_pattern_to_algebra(query, sgp);
+      if(!anode) {
+        RASQAL_DEBUG1("rasqal_algebra_graph_pattern_to_algebra() failed\n");
+        goto fail;
+      }
+
+      /* G := Minus(G, A) */
+      gnode = rasqal_new_2op_algebra_node(query, RASQAL_ALGEBRA_OPERATOR_MINUS,
+                                          gnode, anode);
+      if(!gnode) {
+        RASQAL_DEBUG1("rasqal_new_2op_algebra_node() failed\n");
+        goto fail;
+      }
     } else {
       /* If E is any other form:*/
       rasqal_algebra_node* anode;
@@ -1492,6 +1515,9 @@ rasqal_algebra_service_graph_pattern_to_algebra(rasqal_query* query,
   rasqal_graph_pattern* inner_gp;
   char* string = NULL;
   raptor_iostream *iostr = NULL;
+  raptor_sequence* vars_seq = NULL;
+  int size;
+  int i;
 
   service_uri = rasqal_literal_as_uri(gp->origin);
   if(!service_uri)
@@ -1524,6 +1550,24 @@ rasqal_algebra_service_graph_pattern_to_algebra(rasqal_query* query,
     goto fail;
   }
 
+  /* Record the variables the service pattern binds so that the
+   * engine can send it bindings for them */
+  vars_seq = raptor_new_sequence((raptor_data_free_handler)rasqal_free_variable,
+                                 (raptor_data_print_handler)rasqal_variable_print);
+  if(!vars_seq) {
+    rasqal_free_algebra_node(node);
+    return NULL;
+  }
+
+  size = rasqal_variables_table_get_named_variables_count(query->vars_table);
+  for(i = 0; i < size; i++) {
+    rasqal_variable* v = rasqal_variables_table_get(query->vars_table, i);
+
+    if(rasqal_graph_pattern_variable_bound_below(inner_gp, v))
+      raptor_sequence_push(vars_seq, rasqal_new_variable_from_variable(v));
+  }
+  node->vars_seq = vars_seq;
+
   return node;
 
   fail:
@@ -1716,6 +1760,143 @@ rasqal_algebra_remove_znodes(rasqal_query* query, rasqal_algebra_node* node,
 }
 
 
+/*
+ * rasqal_algebra_node_may_bind_variable:
+ * @node: algebra node
+ * @v: variable
+ *
+ * INTERNAL - Check if a variable may be bound in the results of a node
+ *
+ * Only the operators that cannot introduce variables other than
+ * through their sub-nodes and triples are examined; anything else is
+ * assumed to bind @v.
+ *
+ * Return value: non-0 if @v may be bound
+ */
+static int
+rasqal_algebra_node_may_bind_variable(rasqal_algebra_node* node,
+                                      rasqal_variable* v)
+{
+  int i;
+
+  switch(node->op) {
+    case RASQAL_ALGEBRA_OPERATOR_BGP:
+      if(!node->triples)
+        return 0;
+
+      for(i = node->start_column; i <= node->end_column; i++) {
+        rasqal_triple *t;
+
+        t = (rasqal_triple*)raptor_sequence_get_at(node->triples, i);
+        if(rasqal_literal_as_variable(t->subject) == v ||
+           rasqal_literal_as_variable(t->predicate) == v ||
+           rasqal_literal_as_variable(t->object) == v ||
+           (t->origin && rasqal_literal_as_variable(t->origin) == v))
+          return 1;
+      }
+      return 0;
+
+    case RASQAL_ALGEBRA_OPERATOR_JOIN:
+    case RASQAL_ALGEBRA_OPERATOR_LEFTJOIN:
+    case RASQAL_ALGEBRA_OPERATOR_UNION:
+    case RASQAL_ALGEBRA_OPERATOR_DIFF:
+      return rasqal_algebra_node_may_bind_variable(node->node1, v) ||
+             rasqal_algebra_node_may_bind_variable(node->node2, v);
+
+    case RASQAL_ALGEBRA_OPERATOR_MINUS:
+    case RASQAL_ALGEBRA_OPERATOR_FILTER:
+      return rasqal_algebra_node_may_bind_variable(node->node1, v);
+
+    case RASQAL_ALGEBRA_OPERATOR_GRAPH:
+      if(rasqal_literal_as_variable(node->graph) == v)
+        return 1;
+      return rasqal_algebra_node_may_bind_variable(node->node1, v);
+
+    case RASQAL_ALGEBRA_OPERATOR_UNKNOWN:
+    case RASQAL_ALGEBRA_OPERATOR_TOLIST:
+    case RASQAL_ALGEBRA_OPERATOR_ORDERBY:
+    case RASQAL_ALGEBRA_OPERATOR_PROJECT:
+    case RASQAL_ALGEBRA_OPERATOR_DISTINCT:
+    case RASQAL_ALGEBRA_OPERATOR_REDUCED:
+    case RASQAL_ALGEBRA_OPERATOR_SLICE:
+    case RASQAL_ALGEBRA_OPERATOR_ASSIGN:
+    case RASQAL_ALGEBRA_OPERATOR_GROUP:
+    case RASQAL_ALGEBRA_OPERATOR_AGGREGATION:
+    case RASQAL_ALGEBRA_OPERATOR_HAVING:
+    case RASQAL_ALGEBRA_OPERATOR_VALUES:
+    case RASQAL_ALGEBRA_OPERATOR_SERVICE:
+    default:
+      break;
+  }
+
+  return 1;
+}
+
+
+/*
+ * rasqal_algebra_rewrite_optional_unbound:
+ *
+ * INTERNAL - Rewrite the OPTIONAL / !bound() idiom into a Diff
+ *
+ * Filter(!bound(?v), LeftJoin(A, B)) with no join condition returns
+ * the A rows with no compatible B row when ?v is always bound by B
+ * and never by A.  That is Diff(A, B, true) which is evaluated with a
+ * hash anti-join instead of a nested loop join plus a filter.
+ */
+static int
+rasqal_algebra_rewrite_optional_unbound(rasqal_query* query,
+                                        rasqal_algebra_node* node,
+                                        void* data)
+{
+  int* modified = (int*)data;
+  rasqal_algebra_node* lj_node;
+  rasqal_expression* e;
+  rasqal_variable* v;
+
+  if(node->op != RASQAL_ALGEBRA_OPERATOR_FILTER)
+    return 0;
+
+  lj_node = node->node1;
+  if(!lj_node || lj_node->op != RASQAL_ALGEBRA_OPERATOR_LEFTJOIN ||
+     lj_node->expr)
+    return 0;
+
+  /* Filter expression must be !bound(?v) */
+  e = node->expr;
+  if(!e || e->op != RASQAL_EXPR_BANG ||
+     !e->arg1 || e->arg1->op != RASQAL_EXPR_BOUND ||
+     !e->arg1->arg1 || e->arg1->arg1->op != RASQAL_EXPR_LITERAL)
+    return 0;
+
+  v = rasqal_literal_as_variable(e->arg1->arg1->literal);
+  if(!v)
+    return 0;
+
+  /* ?v must be bound in every B row: B is a BGP mentioning it */
+  if(lj_node->node2->op != RASQAL_ALGEBRA_OPERATOR_BGP ||
+     !rasqal_algebra_node_may_bind_variable(lj_node->node2, v))
+    return 0;
+
+  if(rasqal_algebra_node_may_bind_variable(lj_node->node1, v))
+    return 0;
+
+  /* Replace Filter(!bound(?v), LeftJoin(A, B)) by Diff(A, B) */
+  rasqal_free_expression(node->expr);
+  node->expr = NULL;
+  node->op = RASQAL_ALGEBRA_OPERATOR_DIFF;
+  node->node1 = lj_node->node1;
+  node->node2 = lj_node->node2;
+
+  lj_node->node1 = NULL;
+  lj_node->node2 = NULL;
+  rasqal_free_algebra_node(lj_node);
+
+  *modified = 1;
+
+  return 0;
+}
+
+
 static raptor_sequence*
 rasqal_algebra_get_variables_mentioned_in(rasqal_query* query,
                                           int row_index)
@@ -2013,6 +2194,10 @@ rasqal_algebra_query_to_algebra(rasqal_query* query)
   fputs("\n", stderr);
 #endif
 
+  rasqal_algebra_node_visit(query, node,
+                            rasqal_algebra_rewrite_optional_unbound,
+                            &modified);
+
 
   return node;
 }
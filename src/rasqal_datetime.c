@@ -155,6 +155,117 @@ rasqal_xsd_datetime_normalize(rasqal_xsd_datetime *datetime)
 }
 
 
+/* Layout of the common xsd:dateTime prefix; 'D' is any digit */
+static const char rasqal_xsd_datetime_fixed_layout[] = "DDDD-DD-DDTDD:DD:DD";
+#define RASQAL_XSD_DATETIME_FIXED_LAYOUT_LEN 19
+
+#define MICROSECONDS_MAX_DIGITS 6
+
+#define FIXED_2DIGITS(s) (((s)[0] - '0') * 10 + ((s)[1] - '0'))
+
+/**
+ * rasqal_xsd_datetime_parse_fixed:
+ * @datetime_string: xsd:dateTime as lexical form string
+ * @result: target struct for holding dateTime components
+ *
+ * INTERNAL - Parse the common fixed layout form of xsd:dateTime
+ *
+ * Handles only YYYY-MM-DDThh:mm:ss('.' s+)?('Z' | ('+'|'-') hh:mm)?
+ * with a 4 digit year and an hour below 24, checked at fixed
+ * offsets.  @result is only written on success; everything else
+ * including all errors is left to rasqal_xsd_datetime_parse() so
+ * the error codes are unchanged.
+ *
+ * Return value: zero on success, non zero if not handled
+ */
+static int
+rasqal_xsd_datetime_parse_fixed(const char *datetime_string,
+                                rasqal_xsd_datetime *result)
+{
+  const char *p = datetime_string;
+  int i;
+  int year, month, day, hour, minute, second;
+  int microseconds = 0;
+  int timezone_minutes = RASQAL_XSD_DATETIME_NO_TZ;
+  char have_tz = 'N';
+
+  for(i = 0; i < RASQAL_XSD_DATETIME_FIXED_LAYOUT_LEN; i++) {
+    if(rasqal_xsd_datetime_fixed_layout[i] == 'D') {
+      if(!ISNUM(p[i]))
+        return 1;
+    } else if(p[i] != rasqal_xsd_datetime_fixed_layout[i])
+      return 1;
+  }
+
+  year = FIXED_2DIGITS(p) * 100 + FIXED_2DIGITS(p + 2);
+  month = FIXED_2DIGITS(p + 5);
+  day = FIXED_2DIGITS(p + 8);
+  hour = FIXED_2DIGITS(p + 11);
+  minute = FIXED_2DIGITS(p + 14);
+  second = FIXED_2DIGITS(p + 17);
+
+  if(!year || month < 1 || month > 12 || day < 1 ||
+     day > RASQAL_GOOD_CAST(int, days_per_month(month, year)) ||
+     hour > 23 || minute > 59 || second > 59)
+    return 1;
+
+  p += RASQAL_XSD_DATETIME_FIXED_LAYOUT_LEN;
+
+  if(*p == '.') {
+    p++;
+    if(!ISNUM(*p))
+      return 1;
+
+    /* support only to microseconds with truncation */
+    for(i = 0; ISNUM(*p); p++, i++) {
+      if(i < MICROSECONDS_MAX_DIGITS)
+        microseconds = microseconds * 10 + (*p - '0');
+    }
+    for(; i < MICROSECONDS_MAX_DIGITS; i++)
+      microseconds *= 10;
+  }
+
+  if(*p == 'Z') {
+    timezone_minutes = 0;
+    have_tz = 'Z';
+    p++;
+  } else if(*p == '+' || *p == '-') {
+    int tz_hours, tz_minutes;
+
+    if(!ISNUM(p[1]) || !ISNUM(p[2]) || p[3] != ':' ||
+       !ISNUM(p[4]) || !ISNUM(p[5]))
+      return 1;
+
+    tz_hours = FIXED_2DIGITS(p + 1);
+    tz_minutes = FIXED_2DIGITS(p + 4);
+    if(tz_hours > 14 || tz_minutes > 59 || (tz_hours == 14 && tz_minutes))
+      return 1;
+
+    timezone_minutes = tz_hours * 60 + tz_minutes;
+    if(*p == '-')
+      timezone_minutes = -timezone_minutes;
+    have_tz = 'Y';
+    p += 6;
+  }
+
+  if(*p)
+    return 1;
+
+  result->year = year;
+  result->month = RASQAL_GOOD_CAST(unsigned char, month);
+  result->day = RASQAL_GOOD_CAST(unsigned char, day);
+  result->hour = RASQAL_GOOD_CAST(signed char, hour);
+  result->minute = RASQAL_GOOD_CAST(signed char, minute);
+  result->second = RASQAL_GOOD_CAST(signed char, second);
+  result->microseconds = microseconds;
+  result->timezone_minutes = RASQAL_GOOD_CAST(short int, timezone_minutes);
+  result->have_tz = have_tz;
+  result->time_on_timeline = 0;
+
+  return 0;
+}
+
+
 /**
  * rasqal_xsd_datetime_parse:
  * @datetime_string: xsd:dateTime as lexical form string
@@ -209,10 +320,12 @@ rasqal_xsd_datetime_parse(const char *datetime_string,
   char b[B_SIZE];
   unsigned int l, t, t2, is_neg;
   unsigned long u;
-#define MICROSECONDS_MAX_DIGITS 6
 
   if(!datetime_string || !result)
     return -1;
+
+  if(is_dateTime && !rasqal_xsd_datetime_parse_fixed(datetime_string, result))
+    return 0;
   
   p = (const char *)datetime_string;
   is_neg = 0;
@@ -1374,31 +1487,43 @@ rasqal_xsd_datetime_set_from_unixtime(rasqal_xsd_datetime* dt,
 time_t
 rasqal_xsd_datetime_get_as_unixtime(rasqal_xsd_datetime* dt)
 {
-  struct tm time_buf;
+  time_t year;
+  time_t month;
+  time_t era;
+  time_t year_of_era;
+  time_t day_of_era;
+  time_t days;
 
   if(!dt)
     return 0;
-  
-  memset(&time_buf, '\0', sizeof(time_buf));
 
-  time_buf.tm_year = dt->year - TM_YEAR_ORIGIN;
-  time_buf.tm_mon  = dt->month - TM_MONTH_ORIGIN;
-  time_buf.tm_mday = dt->day;
-  time_buf.tm_hour = dt->hour;
-  time_buf.tm_min  = dt->minute;
-  time_buf.tm_sec  = dt->second;
-  time_buf.tm_wday = 0;
-  time_buf.tm_yday = 0;
-  time_buf.tm_isdst = -1;
-
-#ifdef HAVE_TM_GMTOFF
-  if(dt->timezone_minutes == RASQAL_XSD_DATETIME_NO_TZ)
-    time_buf.tm_gmtoff = 0;
-  else
-    time_buf.tm_gmtoff = dt->timezone_minutes * 60;
-#endif
+  /* Days since 1970-01-01 in the proleptic Gregorian calendar using
+   * 400 year eras of 146097 days, counting years from March so the
+   * leap day is the last day of a year.  Like timegm(), year 0
+   * exists and the fields do not need to be normalized.
+   */
+  year = dt->year;
+  month = dt->month - 1;
+  year += month / 12;
+  month %= 12;
+  if(month < 0) {
+    month += 12;
+    year--;
+  }
+  /* month is now 0..11 from January; make it 0..11 from March */
+  if(month < 2) {
+    month += 10;
+    year--;
+  } else
+    month -= 2;
 
-  return rasqal_timegm(&time_buf);
+  era = (year >= 0 ? year : year - 399) / 400;
+  year_of_era = year - era * 400;
+  day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 +
+               (153 * month + 2) / 5 + dt->day - 1;
+  days = era * 146097 + day_of_era - 719468;
+
+  return days * 86400 + dt->hour * 3600 + dt->minute * 60 + dt->second;
 }
 
 
@@ -2222,6 +2347,9 @@ main(int argc, char *argv[])
   MYASSERT(test_datetime_compare(world, "2011-01-02T00:00:00",  "2011-01-02T00:00:00Z", INCOMPARABLE));
   MYASSERT(test_datetime_compare(world, "2011-01-02T00:00:00Z", "2011-01-02T00:00:00",  INCOMPARABLE));
   MYASSERT(test_datetime_compare(world, "2011-01-02T00:00:00Z", "2011-01-02T00:00:00Z", 0));
+  MYASSERT(test_datetime_compare(world, "2011-01-02T00:00:00.5Z", "2011-01-02T00:00:00.25Z", 1));
+  MYASSERT(test_datetime_compare(world, "2011-01-02T01:30:00+01:30", "2011-01-02T00:00:00Z", 0));
+  MYASSERT(test_datetime_compare(world, "2011-01-01T23:00:00-01:00", "2011-01-02T00:00:00.000001Z", -1));
 
 
   if(1) {
@@ -2250,6 +2378,11 @@ main(int argc, char *argv[])
     
     MYASSERT((new_secs = rasqal_xsd_datetime_get_as_unixtime(&dt)));
     MYASSERT(new_secs == secs);
+
+    /* before the epoch and on a leap day */
+    MYASSERT(rasqal_xsd_datetime_set_from_unixtime(&dt, -58017600) == 0);
+    MYASSERT(dt.year == 1968 && dt.month == 2 && dt.day == 29 && dt.hour == 12);
+    MYASSERT(rasqal_xsd_datetime_get_as_unixtime(&dt) == -58017600);
   }
   
   rasqal_free_world(world);
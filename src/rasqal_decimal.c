@@ -103,11 +103,323 @@ struct rasqal_xsd_decimal_s {
   RASQAL_DECIMAL_ROUNDING rounding;
   char* string;
   size_t string_len;
+  /* exact value fixed / 10^scale when fixed_valid is set */
+  rasqal_integer fixed;
+  unsigned int scale;
+  int fixed_valid;
+  /* raw holds the value when raw_valid is set; raw_init is set once
+   * raw has been initialised */
+  int raw_valid;
+  int raw_init;
 };
 
 
 #ifndef STANDALONE
 
+/*
+ * Fixed point fast path
+ *
+ * Values that fit in a #rasqal_integer scaled by a power of ten up
+ * to the decimal precision are held exactly in the fixed and scale
+ * fields and operated on with integer arithmetic.  The raw
+ * MPFR/GMP/double value is only initialised and used when a value
+ * does not fit or an operation such as division needs it.
+ */
+
+#define DECIMAL_FIXED_MAX_SCALE 18
+
+/* sign, 19 digits, a leading "0." and a NUL with room to spare */
+#define DECIMAL_FIXED_BUFFER_SIZE 32
+
+#define DECIMAL_E9 (RASQAL_GOOD_CAST(rasqal_integer, 1000000000))
+
+static const rasqal_integer decimal_powers_of_10[DECIMAL_FIXED_MAX_SCALE + 1] = {
+  1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000,
+  DECIMAL_E9, DECIMAL_E9 * 10, DECIMAL_E9 * 100, DECIMAL_E9 * 1000,
+  DECIMAL_E9 * 10000, DECIMAL_E9 * 100000, DECIMAL_E9 * 1000000,
+  DECIMAL_E9 * 10000000, DECIMAL_E9 * 100000000, DECIMAL_E9 * DECIMAL_E9
+};
+
+
+static unsigned int
+rasqal_xsd_decimal_max_scale(rasqal_xsd_decimal* dec)
+{
+  /* never more fractional digits than the raw form would format */
+  return (dec->precision_digits < DECIMAL_FIXED_MAX_SCALE) ?
+    dec->precision_digits : DECIMAL_FIXED_MAX_SCALE;
+}
+
+
+static void
+rasqal_xsd_decimal_set_fixed(rasqal_xsd_decimal* dec, rasqal_integer fixed,
+                             unsigned int scale)
+{
+  dec->fixed = fixed;
+  dec->scale = scale;
+  dec->fixed_valid = 1;
+  dec->raw_valid = 0;
+}
+
+
+/*
+ * rasqal_xsd_decimal_format_fixed:
+ * @fixed: fixed point value
+ * @scale: number of fractional digits in @fixed
+ * @buffer: buffer of at least DECIMAL_FIXED_BUFFER_SIZE bytes
+ *
+ * INTERNAL - Format a fixed point value in canonical xsd:decimal form
+ *
+ * Trailing fractional zeros are removed leaving at least one
+ * digit after the '.'.
+ *
+ * Return value: length of the string in @buffer
+ */
+static size_t
+rasqal_xsd_decimal_format_fixed(rasqal_integer fixed, unsigned int scale,
+                                char* buffer)
+{
+  char digits[DECIMAL_FIXED_BUFFER_SIZE];
+  unsigned int count = 0;
+  unsigned int first = 0;
+  rasqal_integer v = fixed;
+  char* p = buffer;
+
+  /* digits least significant first; negative remainders so that
+   * RASQAL_INTEGER_MIN needs no special case */
+  do {
+    int digit = RASQAL_GOOD_CAST(int, v % 10);
+
+    digits[count++] = RASQAL_GOOD_CAST(char, '0' + (digit < 0 ? -digit : digit));
+    v /= 10;
+  } while(v);
+
+  while(count <= scale)
+    digits[count++] = '0';
+
+  /* skip trailing fractional zeros but keep one fractional digit */
+  while(first + 1 < scale && digits[first] == '0')
+    first++;
+
+  if(fixed < 0)
+    *p++ = '-';
+
+  while(count > scale)
+    *p++ = digits[--count];
+
+  *p++ = '.';
+  if(!scale)
+    *p++ = '0';
+  else {
+    while(count > first)
+      *p++ = digits[--count];
+  }
+
+  *p = '\0';
+
+  return RASQAL_GOOD_CAST(size_t, p - buffer);
+}
+
+
+/*
+ * rasqal_xsd_decimal_parse_fixed:
+ * @dec: XSD Decimal
+ * @string: decimal lexical form
+ *
+ * INTERNAL - Set the fixed point value of a decimal from a lexical form
+ *
+ * Return value: non-0 if @string is not a plain decimal that fits
+ */
+static int
+rasqal_xsd_decimal_parse_fixed(rasqal_xsd_decimal* dec, const char* string)
+{
+  const char* p = string;
+  rasqal_integer value = 0;
+  unsigned int scale = 0;
+  unsigned int zeros = 0;
+  unsigned int max_scale = rasqal_xsd_decimal_max_scale(dec);
+  int negative = 0;
+  int digits = 0;
+  int in_fraction = 0;
+
+  if(*p == '-' || *p == '+')
+    negative = (*p++ == '-');
+
+  /* Accumulate as a negative value which has the larger range */
+  for(; *p; p++) {
+    int digit;
+
+    if(*p == '.' && !in_fraction) {
+      in_fraction = 1;
+      continue;
+    }
+
+    if(*p < '0' || *p > '9')
+      return 1;
+
+    digits++;
+    digit = *p - '0';
+
+    if(in_fraction) {
+      /* fractional zeros only count if a non-0 digit follows */
+      if(!digit) {
+        zeros++;
+        continue;
+      }
+
+      scale += zeros + 1;
+      if(scale > max_scale)
+        return 1;
+
+      if(rasqal_integer_multiply(value, decimal_powers_of_10[zeros + 1],
+                                 &value))
+        return 1;
+      zeros = 0;
+    } else if(rasqal_integer_multiply(value, 10, &value))
+      return 1;
+
+    if(rasqal_integer_subtract(value, digit, &value))
+      return 1;
+  }
+
+  if(!digits)
+    return 1;
+
+  if(!negative) {
+    if(value == RASQAL_INTEGER_MIN)
+      return 1;
+    value = -value;
+  }
+
+  rasqal_xsd_decimal_set_fixed(dec, value, scale);
+  return 0;
+}
+
+
+/*
+ * rasqal_xsd_decimal_align:
+ * @a: first XSD Decimal
+ * @b: second XSD Decimal
+ * @a_p: pointer to store @a value at the common scale
+ * @b_p: pointer to store @b value at the common scale
+ * @scale_p: pointer to store the common scale
+ *
+ * INTERNAL - Get the fixed point values of two decimals at the same scale
+ *
+ * Return value: non-0 if either is not fixed point or rescaling overflows
+ */
+static int
+rasqal_xsd_decimal_align(rasqal_xsd_decimal* a, rasqal_xsd_decimal* b,
+                         rasqal_integer* a_p, rasqal_integer* b_p,
+                         unsigned int* scale_p)
+{
+  if(!a->fixed_valid || !b->fixed_valid)
+    return 1;
+
+  *a_p = a->fixed;
+  *b_p = b->fixed;
+  *scale_p = a->scale;
+
+  if(a->scale < b->scale) {
+    *scale_p = b->scale;
+    return rasqal_integer_multiply(a->fixed,
+                                   decimal_powers_of_10[b->scale - a->scale],
+                                   a_p);
+  }
+
+  if(b->scale < a->scale)
+    return rasqal_integer_multiply(b->fixed,
+                                   decimal_powers_of_10[a->scale - b->scale],
+                                   b_p);
+
+  return 0;
+}
+
+
+static void
+rasqal_xsd_decimal_init_raw(rasqal_xsd_decimal* dec)
+{
+  if(dec->raw_init)
+    return;
+
+#ifdef RASQAL_DECIMAL_C99
+  dec->raw = 0DD;
+#endif
+#ifdef RASQAL_DECIMAL_MPFR
+  mpfr_init2(dec->raw, dec->precision_bits);
+
+  /* GMP_RNDD, GMP_RNDU, GMP_RNDN, GMP_RNDZ */
+  dec->rounding = mpfr_get_default_rounding_mode();
+#endif
+#ifdef RASQAL_DECIMAL_GMP
+  mpf_init2(dec->raw, dec->precision_bits);
+#endif
+#ifdef RASQAL_DECIMAL_NONE
+  dec->raw = 0e0;
+#endif
+
+  dec->raw_init = 1;
+}
+
+
+/* Prepare @dec to be set by a raw operation */
+static void
+rasqal_xsd_decimal_set_raw(rasqal_xsd_decimal* dec)
+{
+  rasqal_xsd_decimal_init_raw(dec);
+  dec->raw_valid = 1;
+  dec->fixed_valid = 0;
+}
+
+
+/*
+ * rasqal_xsd_decimal_raw_operand:
+ * @dec: XSD Decimal
+ * @tmp: temporary XSD Decimal
+ *
+ * INTERNAL - Get a decimal with the value of @dec held in raw form
+ *
+ * @dec is not changed so that shared values are only read.  If
+ * @dec has no raw value, @tmp is set to it and returned and must be
+ * released with rasqal_xsd_decimal_release_operand().
+ *
+ * Return value: @dec or @tmp
+ */
+static rasqal_xsd_decimal*
+rasqal_xsd_decimal_raw_operand(rasqal_xsd_decimal* dec,
+                               rasqal_xsd_decimal* tmp)
+{
+  char buffer[DECIMAL_FIXED_BUFFER_SIZE];
+
+  if(dec->raw_valid)
+    return dec;
+
+  rasqal_xsd_decimal_init(tmp);
+  rasqal_xsd_decimal_set_raw(tmp);
+
+  rasqal_xsd_decimal_format_fixed(dec->fixed, dec->scale, buffer);
+#if defined(RASQAL_DECIMAL_C99) || defined(RASQAL_DECIMAL_NONE)
+  tmp->raw = strtod(buffer, NULL);
+#endif
+#ifdef RASQAL_DECIMAL_MPFR
+  mpfr_set_str(tmp->raw, buffer, 10, tmp->rounding);
+#endif
+#ifdef RASQAL_DECIMAL_GMP
+  mpf_set_str(tmp->raw, buffer, 10);
+#endif
+
+  return tmp;
+}
+
+
+static void
+rasqal_xsd_decimal_release_operand(rasqal_xsd_decimal* operand,
+                                   rasqal_xsd_decimal* tmp)
+{
+  if(operand == tmp)
+    rasqal_xsd_decimal_clear(tmp);
+}
+
+
 /**
  * rasqal_new_xsd_decimal:
  * @world: rasqal world object
@@ -160,22 +472,10 @@ rasqal_xsd_decimal_init(rasqal_xsd_decimal* dec)
 
   /* over-estimate bits since log(10)/log(2) = 3.32192809488736234789 < 4 */
   dec->precision_bits = dec->precision_digits*4;
-  
-#ifdef RASQAL_DECIMAL_C99
-  dec->raw = 0DD;
-#endif
-#ifdef RASQAL_DECIMAL_MPFR
-  mpfr_init2(dec->raw, dec->precision_bits);
 
-  /* GMP_RNDD, GMP_RNDU, GMP_RNDN, GMP_RNDZ */
-  dec->rounding = mpfr_get_default_rounding_mode();
-#endif
-#ifdef RASQAL_DECIMAL_GMP
-  mpf_init2(dec->raw, dec->precision_bits);
-#endif
-#ifdef RASQAL_DECIMAL_NONE
-  dec->raw = 0e0;
-#endif
+  /* raw is initialised on first use by rasqal_xsd_decimal_init_raw() */
+  dec->raw_init = 0;
+  rasqal_xsd_decimal_set_fixed(dec, 0, 0);
 
   dec->string = NULL;
   dec->string_len = 0;
@@ -197,6 +497,10 @@ static void
 rasqal_xsd_decimal_clear(rasqal_xsd_decimal* dec)
 {
   rasqal_xsd_decimal_clear_string(dec);
+
+  if(!dec->raw_init)
+    return;
+
 #ifdef RASQAL_DECIMAL_C99
 #endif
 #ifdef RASQAL_DECIMAL_MPFR
@@ -208,6 +512,8 @@ rasqal_xsd_decimal_clear(rasqal_xsd_decimal* dec)
 #ifdef RASQAL_DECIMAL_NONE
   dec->raw= 0e0;
 #endif
+  dec->raw_init = 0;
+  dec->raw_valid = 0;
 }  
 
 
@@ -238,6 +544,11 @@ rasqal_xsd_decimal_set_string(rasqal_xsd_decimal* dec, const char* string)
 
   memcpy(dec->string, string, len + 1);
   dec->string_len = len;
+
+  if(!rasqal_xsd_decimal_parse_fixed(dec, string))
+    return 0;
+
+  rasqal_xsd_decimal_set_raw(dec);
   
 #if defined(RASQAL_DECIMAL_C99) || defined(RASQAL_DECIMAL_NONE)
   dec->raw = strtod(string, NULL);
@@ -269,20 +580,10 @@ rasqal_xsd_decimal_set_string(rasqal_xsd_decimal* dec, const char* string)
 int
 rasqal_xsd_decimal_set_long(rasqal_xsd_decimal* dec, long l)
 {
-  int rc=0;
-  
   rasqal_xsd_decimal_clear_string(dec);
 
-#if defined(RASQAL_DECIMAL_C99) || defined(RASQAL_DECIMAL_NONE)
-  dec->raw=l;
-#endif
-#ifdef RASQAL_DECIMAL_MPFR
-  rc = mpfr_set_si(dec->raw, l, dec->rounding);
-#endif
-#ifdef RASQAL_DECIMAL_GMP
-  mpf_set_si(dec->raw, l);
-#endif
-  return rc;
+  rasqal_xsd_decimal_set_fixed(dec, l, 0);
+  return 0;
 }
 
 
@@ -301,6 +602,7 @@ rasqal_xsd_decimal_set_double(rasqal_xsd_decimal* dec, double d)
   int rc=0;
   
   rasqal_xsd_decimal_clear_string(dec);
+  rasqal_xsd_decimal_set_raw(dec);
 
 #if defined(RASQAL_DECIMAL_C99) || defined(RASQAL_DECIMAL_NONE)
   dec->raw=d;
@@ -328,6 +630,10 @@ rasqal_xsd_decimal_get_double(rasqal_xsd_decimal* dec)
 {
   double result=0e0;
 
+  if(dec->fixed_valid)
+    return RASQAL_GOOD_CAST(double, dec->fixed) /
+           RASQAL_GOOD_CAST(double, decimal_powers_of_10[dec->scale]);
+
 #if defined(RASQAL_DECIMAL_C99) || defined(RASQAL_DECIMAL_NONE)
   result=(double)dec->raw;
 #endif
@@ -354,6 +660,10 @@ long
 rasqal_xsd_decimal_get_long(rasqal_xsd_decimal* dec, int* error_p)
 {
   long result = 0;
+  rasqal_xsd_decimal tmp;
+
+  /* conversion rounding follows the raw type */
+  dec = rasqal_xsd_decimal_raw_operand(dec, &tmp);
 
 #if defined(RASQAL_DECIMAL_C99) || defined(RASQAL_DECIMAL_NONE)
   result=(long)dec->raw;
@@ -373,6 +683,8 @@ rasqal_xsd_decimal_get_long(rasqal_xsd_decimal* dec, int* error_p)
     result = mpf_get_si(dec->raw);
 #endif
 
+  rasqal_xsd_decimal_release_operand(dec, &tmp);
+
   return result;
 }
 
@@ -419,6 +731,21 @@ rasqal_xsd_decimal_as_string(rasqal_xsd_decimal* dec)
   
   if(dec->string)
     return dec->string;
+
+  if(dec->fixed_valid) {
+    char buffer[DECIMAL_FIXED_BUFFER_SIZE];
+
+    len = rasqal_xsd_decimal_format_fixed(dec->fixed, dec->scale, buffer);
+    s = RASQAL_MALLOC(char*, len + 1);
+    if(!s)
+      return NULL;
+
+    memcpy(s, buffer, len + 1);
+    dec->string = s;
+    dec->string_len = len;
+
+    return s;
+  }
   
 #ifdef RASQAL_DECIMAL_C99
   len = dec->precision_digits;
@@ -535,8 +862,24 @@ rasqal_xsd_decimal_add(rasqal_xsd_decimal* result,
                        rasqal_xsd_decimal* a, rasqal_xsd_decimal* b)
 {
   int rc=0;
+  rasqal_xsd_decimal a_tmp;
+  rasqal_xsd_decimal b_tmp;
+  rasqal_integer a_fixed;
+  rasqal_integer b_fixed;
+  rasqal_integer fixed;
+  unsigned int scale;
 
   rasqal_xsd_decimal_clear_string(result);
+
+  if(!rasqal_xsd_decimal_align(a, b, &a_fixed, &b_fixed, &scale) &&
+     !rasqal_integer_add(a_fixed, b_fixed, &fixed)) {
+    rasqal_xsd_decimal_set_fixed(result, fixed, scale);
+    return 0;
+  }
+
+  a = rasqal_xsd_decimal_raw_operand(a, &a_tmp);
+  b = rasqal_xsd_decimal_raw_operand(b, &b_tmp);
+  rasqal_xsd_decimal_set_raw(result);
   
 #if defined(RASQAL_DECIMAL_C99) || defined(RASQAL_DECIMAL_NONE)
   result->raw = a->raw + b->raw;
@@ -548,6 +891,9 @@ rasqal_xsd_decimal_add(rasqal_xsd_decimal* result,
   mpf_add(result->raw, a->raw, b->raw);
 #endif
 
+  rasqal_xsd_decimal_release_operand(a, &a_tmp);
+  rasqal_xsd_decimal_release_operand(b, &b_tmp);
+
   return rc;
 }
 
@@ -567,8 +913,24 @@ rasqal_xsd_decimal_subtract(rasqal_xsd_decimal* result,
                             rasqal_xsd_decimal* a, rasqal_xsd_decimal* b)
 {
   int rc=0;
+  rasqal_xsd_decimal a_tmp;
+  rasqal_xsd_decimal b_tmp;
+  rasqal_integer a_fixed;
+  rasqal_integer b_fixed;
+  rasqal_integer fixed;
+  unsigned int scale;
   
   rasqal_xsd_decimal_clear_string(result);
+
+  if(!rasqal_xsd_decimal_align(a, b, &a_fixed, &b_fixed, &scale) &&
+     !rasqal_integer_subtract(a_fixed, b_fixed, &fixed)) {
+    rasqal_xsd_decimal_set_fixed(result, fixed, scale);
+    return 0;
+  }
+
+  a = rasqal_xsd_decimal_raw_operand(a, &a_tmp);
+  b = rasqal_xsd_decimal_raw_operand(b, &b_tmp);
+  rasqal_xsd_decimal_set_raw(result);
   
 #if defined(RASQAL_DECIMAL_C99) || defined(RASQAL_DECIMAL_NONE)
   result->raw = a->raw - b->raw;
@@ -580,6 +942,9 @@ rasqal_xsd_decimal_subtract(rasqal_xsd_decimal* result,
   mpf_sub(result->raw, a->raw, b->raw);
 #endif
 
+  rasqal_xsd_decimal_release_operand(a, &a_tmp);
+  rasqal_xsd_decimal_release_operand(b, &b_tmp);
+
   return rc;
 }
 
@@ -599,8 +964,32 @@ rasqal_xsd_decimal_multiply(rasqal_xsd_decimal* result,
                             rasqal_xsd_decimal* a, rasqal_xsd_decimal* b)
 {
   int rc=0;
+  rasqal_xsd_decimal a_tmp;
+  rasqal_xsd_decimal b_tmp;
+  rasqal_integer fixed;
   
   rasqal_xsd_decimal_clear_string(result);
+
+  if(a->fixed_valid && b->fixed_valid &&
+     !rasqal_integer_multiply(a->fixed, b->fixed, &fixed)) {
+    unsigned int scale = a->scale + b->scale;
+    unsigned int max_scale = rasqal_xsd_decimal_max_scale(result);
+
+    /* drop fractional zeros to get back within the precision */
+    while(scale > max_scale && !(fixed % 10)) {
+      fixed /= 10;
+      scale--;
+    }
+
+    if(scale <= max_scale) {
+      rasqal_xsd_decimal_set_fixed(result, fixed, scale);
+      return 0;
+    }
+  }
+
+  a = rasqal_xsd_decimal_raw_operand(a, &a_tmp);
+  b = rasqal_xsd_decimal_raw_operand(b, &b_tmp);
+  rasqal_xsd_decimal_set_raw(result);
   
 #if defined(RASQAL_DECIMAL_C99) || defined(RASQAL_DECIMAL_NONE)
   result->raw = a->raw * b->raw;
@@ -612,6 +1001,9 @@ rasqal_xsd_decimal_multiply(rasqal_xsd_decimal* result,
   mpf_mul(result->raw, a->raw, b->raw);
 #endif
 
+  rasqal_xsd_decimal_release_operand(a, &a_tmp);
+  rasqal_xsd_decimal_release_operand(b, &b_tmp);
+
   return rc;
 }
 
@@ -629,6 +1021,9 @@ rasqal_xsd_decimal_is_zero(rasqal_xsd_decimal* d)
 {
   int rc = 0;
 
+  if(d->fixed_valid)
+    return !d->fixed;
+
 #if defined(RASQAL_DECIMAL_C99) || defined(RASQAL_DECIMAL_NONE)
   rc = fabs(d->raw) < RASQAL_DOUBLE_EPSILON;
 #endif
@@ -660,11 +1055,18 @@ rasqal_xsd_decimal_divide(rasqal_xsd_decimal* result,
                           rasqal_xsd_decimal* a, rasqal_xsd_decimal* b)
 {
   int rc=0;
+  rasqal_xsd_decimal a_tmp;
+  rasqal_xsd_decimal b_tmp;
   
   rasqal_xsd_decimal_clear_string(result);
 
   if(rasqal_xsd_decimal_is_zero(b))
     return 1;
+
+  /* quotients are rarely exact so always use the raw form */
+  a = rasqal_xsd_decimal_raw_operand(a, &a_tmp);
+  b = rasqal_xsd_decimal_raw_operand(b, &b_tmp);
+  rasqal_xsd_decimal_set_raw(result);
   
 #if defined(RASQAL_DECIMAL_C99) || defined(RASQAL_DECIMAL_NONE)
   result->raw = a->raw / b->raw;
@@ -676,6 +1078,9 @@ rasqal_xsd_decimal_divide(rasqal_xsd_decimal* result,
   mpf_div(result->raw, a->raw, b->raw);
 #endif
 
+  rasqal_xsd_decimal_release_operand(a, &a_tmp);
+  rasqal_xsd_decimal_release_operand(b, &b_tmp);
+
   return rc;
 }
 
@@ -693,8 +1098,17 @@ int
 rasqal_xsd_decimal_negate(rasqal_xsd_decimal* result, rasqal_xsd_decimal* a)
 {
   int rc=0;
+  rasqal_xsd_decimal a_tmp;
   
   rasqal_xsd_decimal_clear_string(result);
+
+  if(a->fixed_valid && a->fixed != RASQAL_INTEGER_MIN) {
+    rasqal_xsd_decimal_set_fixed(result, -a->fixed, a->scale);
+    return 0;
+  }
+
+  a = rasqal_xsd_decimal_raw_operand(a, &a_tmp);
+  rasqal_xsd_decimal_set_raw(result);
   
 #if defined(RASQAL_DECIMAL_C99) || defined(RASQAL_DECIMAL_NONE)
   result->raw = -a->raw;
@@ -706,6 +1120,8 @@ rasqal_xsd_decimal_negate(rasqal_xsd_decimal* result, rasqal_xsd_decimal* a)
   mpf_neg(result->raw, a->raw);
 #endif
 
+  rasqal_xsd_decimal_release_operand(a, &a_tmp);
+
   return rc;
 }
 
@@ -723,8 +1139,18 @@ int
 rasqal_xsd_decimal_abs(rasqal_xsd_decimal* result, rasqal_xsd_decimal* a)
 {
   int rc = 0;
+  rasqal_xsd_decimal a_tmp;
   
   rasqal_xsd_decimal_clear_string(result);
+
+  if(a->fixed_valid && a->fixed != RASQAL_INTEGER_MIN) {
+    rasqal_xsd_decimal_set_fixed(result, (a->fixed < 0) ? -a->fixed : a->fixed,
+                                 a->scale);
+    return 0;
+  }
+
+  a = rasqal_xsd_decimal_raw_operand(a, &a_tmp);
+  rasqal_xsd_decimal_set_raw(result);
   
 #if defined(RASQAL_DECIMAL_C99) || defined(RASQAL_DECIMAL_NONE)
   result->raw = fabs(a->raw);
@@ -736,6 +1162,8 @@ rasqal_xsd_decimal_abs(rasqal_xsd_decimal* result, rasqal_xsd_decimal* a)
   mpf_abs(result->raw, a->raw);
 #endif
 
+  rasqal_xsd_decimal_release_operand(a, &a_tmp);
+
   return rc;
 }
 
@@ -759,6 +1187,22 @@ rasqal_xsd_decimal_round(rasqal_xsd_decimal* result, rasqal_xsd_decimal* a)
 #endif
   
   rasqal_xsd_decimal_clear_string(result);
+
+  if(a->fixed_valid) {
+    rasqal_integer unit = decimal_powers_of_10[a->scale];
+    rasqal_integer q = a->fixed / unit;
+    rasqal_integer r = a->fixed % unit;
+
+    /* halves round away from 0 as round() and mpfr_round() do */
+    if(r >= unit - r)
+      q++;
+    else if(-r >= unit + r)
+      q--;
+    rasqal_xsd_decimal_set_fixed(result, q, 0);
+    return 0;
+  }
+
+  rasqal_xsd_decimal_set_raw(result);
   
 #if defined(RASQAL_DECIMAL_C99) || defined(RASQAL_DECIMAL_NONE)
   result->raw = round(a->raw);
@@ -798,6 +1242,18 @@ rasqal_xsd_decimal_ceil(rasqal_xsd_decimal* result, rasqal_xsd_decimal* a)
   int rc = 0;
   
   rasqal_xsd_decimal_clear_string(result);
+
+  if(a->fixed_valid) {
+    rasqal_integer unit = decimal_powers_of_10[a->scale];
+    rasqal_integer q = a->fixed / unit;
+
+    if(a->fixed % unit > 0)
+      q++;
+    rasqal_xsd_decimal_set_fixed(result, q, 0);
+    return 0;
+  }
+
+  rasqal_xsd_decimal_set_raw(result);
   
 #if defined(RASQAL_DECIMAL_C99) || defined(RASQAL_DECIMAL_NONE)
   result->raw = ceil(a->raw);
@@ -828,6 +1284,18 @@ rasqal_xsd_decimal_floor(rasqal_xsd_decimal* result, rasqal_xsd_decimal* a)
   int rc = 0;
   
   rasqal_xsd_decimal_clear_string(result);
+
+  if(a->fixed_valid) {
+    rasqal_integer unit = decimal_powers_of_10[a->scale];
+    rasqal_integer q = a->fixed / unit;
+
+    if(a->fixed % unit < 0)
+      q--;
+    rasqal_xsd_decimal_set_fixed(result, q, 0);
+    return 0;
+  }
+
+  rasqal_xsd_decimal_set_raw(result);
   
 #if defined(RASQAL_DECIMAL_C99) || defined(RASQAL_DECIMAL_NONE)
   result->raw = floor(a->raw);
@@ -856,6 +1324,17 @@ int
 rasqal_xsd_decimal_compare(rasqal_xsd_decimal* a, rasqal_xsd_decimal* b)
 {
   int rc = 0;
+  rasqal_xsd_decimal a_tmp;
+  rasqal_xsd_decimal b_tmp;
+  rasqal_integer a_fixed;
+  rasqal_integer b_fixed;
+  unsigned int scale;
+
+  if(!rasqal_xsd_decimal_align(a, b, &a_fixed, &b_fixed, &scale))
+    return (a_fixed > b_fixed) - (a_fixed < b_fixed);
+
+  a = rasqal_xsd_decimal_raw_operand(a, &a_tmp);
+  b = rasqal_xsd_decimal_raw_operand(b, &b_tmp);
   
 #if defined(RASQAL_DECIMAL_C99) || defined(RASQAL_DECIMAL_NONE)
   rc = rasqal_double_approximately_compare(a->raw, b->raw);
@@ -867,6 +1346,9 @@ rasqal_xsd_decimal_compare(rasqal_xsd_decimal* a, rasqal_xsd_decimal* b)
   rc=mpf_cmp(a->raw, b->raw);
 #endif
 
+  rasqal_xsd_decimal_release_operand(a, &a_tmp);
+  rasqal_xsd_decimal_release_operand(b, &b_tmp);
+
   return rc;
 }
 
@@ -884,6 +1366,17 @@ int
 rasqal_xsd_decimal_equals(rasqal_xsd_decimal* a, rasqal_xsd_decimal* b)
 {
   int rc;
+  rasqal_xsd_decimal a_tmp;
+  rasqal_xsd_decimal b_tmp;
+  rasqal_integer a_fixed;
+  rasqal_integer b_fixed;
+  unsigned int scale;
+
+  if(!rasqal_xsd_decimal_align(a, b, &a_fixed, &b_fixed, &scale))
+    return (a_fixed == b_fixed);
+
+  a = rasqal_xsd_decimal_raw_operand(a, &a_tmp);
+  b = rasqal_xsd_decimal_raw_operand(b, &b_tmp);
   
 #if defined(RASQAL_DECIMAL_C99) || defined(RASQAL_DECIMAL_NONE)
   rc = rasqal_double_approximately_equal(b->raw, a->raw);
@@ -896,6 +1389,9 @@ rasqal_xsd_decimal_equals(rasqal_xsd_decimal* a, rasqal_xsd_decimal* b)
 #error RASQAL_DECIMAL flagging error
 #endif
 
+  rasqal_xsd_decimal_release_operand(a, &a_tmp);
+  rasqal_xsd_decimal_release_operand(b, &b_tmp);
+
   return rc;
 }
 #endif /* not STANDALONE */
@@ -924,6 +1420,10 @@ main(int argc, char *argv[]) {
   const char* expected_a_plus_b_minus_b = "1234567890.0";
   const char* expected_a_plus_b_minus_b_minus_a = "0.0";
   const char* expected_negative_b = "-123456789012345678.0";
+  const char* c_string = "0.1";
+  const char* d_string = "0.25";
+  const char* expected_c_plus_d = "0.35";
+  const char* expected_c_times_d = "0.025";
   int expected_a_compare_b= -1;
   int expected_a_equals_b= 0;
   rasqal_world *world;
@@ -1034,6 +1534,28 @@ main(int argc, char *argv[]) {
     FAIL;
   }
 
+  /* exact fractions */
+  rasqal_xsd_decimal_set_string(a, c_string);
+  rasqal_xsd_decimal_set_string(b, d_string);
+
+  rasqal_xsd_decimal_add(result, a, b);
+
+  result_s=rasqal_xsd_decimal_as_string(result);
+  if(strcmp(result_s, expected_c_plus_d)) {
+    fprintf(stderr, "FAILED: c+d=%s expected %s\n", result_s, 
+            expected_c_plus_d);
+    FAIL;
+  }
+
+  rasqal_xsd_decimal_multiply(result, a, b);
+
+  result_s=rasqal_xsd_decimal_as_string(result);
+  if(strcmp(result_s, expected_c_times_d)) {
+    fprintf(stderr, "FAILED: c*d=%s expected %s\n", result_s, 
+            expected_c_times_d);
+    FAIL;
+  }
+
 
   FAIL_LABEL
   if(a)
@@ -187,6 +187,11 @@ rasqal_algebra_leftjoin_algebra_node_to_rowsource(rasqal_engine_algebra_data* ex
   if((error_p && *error_p) || !left_rs)
     return NULL;
 
+  /* Every left row is returned by a left join so if only existence
+   * of a row is needed, the right side is never used */
+  if(node->flags & RASQAL_ENGINE_BITFLAG_EXISTS_ONLY)
+    return left_rs;
+
   right_rs = rasqal_algebra_node_to_rowsource(execution_data, node->node2,
                                               error_p);
   if((error_p && *error_p) || !right_rs) {
@@ -198,6 +203,31 @@ rasqal_algebra_leftjoin_algebra_node_to_rowsource(rasqal_engine_algebra_data* ex
 }
 
 
+/*
+ * rasqal_algebra_rowsource_has_variable:
+ * @rowsource: rowsource
+ * @vars_seq: sequence of #rasqal_variable
+ *
+ * INTERNAL - Check if a rowsource binds any of a sequence of variables
+ *
+ * Return value: non-0 if a variable is shared
+ */
+static int
+rasqal_algebra_rowsource_has_variable(rasqal_rowsource* rowsource,
+                                      raptor_sequence* vars_seq)
+{
+  rasqal_variable* v;
+  int i;
+
+  for(i = 0; (v = (rasqal_variable*)raptor_sequence_get_at(vars_seq, i)); i++) {
+    if(rasqal_rowsource_get_variable_offset_by_name(rowsource, v->name) >= 0)
+      return 1;
+  }
+
+  return 0;
+}
+
+
 static rasqal_rowsource*
 rasqal_algebra_join_algebra_node_to_rowsource(rasqal_engine_algebra_data* execution_data,
                                               rasqal_algebra_node* node,
@@ -206,6 +236,72 @@ rasqal_algebra_join_algebra_node_to_rowsource(rasqal_engine_algebra_data* execut
   rasqal_query *query = execution_data->query;
   rasqal_rowsource *left_rs;
   rasqal_rowsource *right_rs;
+  rasqal_algebra_node* service = node->node2;
+  int batch_size;
+
+  left_rs = rasqal_algebra_node_to_rowsource(execution_data, node->node1,
+                                             error_p);
+  if((error_p && *error_p) || !left_rs)
+    return NULL;
+
+  /* Send the left bindings to a SERVICE in batches rather than
+   * joining with all of its results.  Without a shared variable the
+   * bindings cannot restrict the SERVICE so it is retrieved once and
+   * joined. */
+  batch_size = query->features[RASQAL_FEATURE_SERVICE_BATCH_SIZE];
+  if(batch_size > 0 && !node->expr &&
+     service->op == RASQAL_ALGEBRA_OPERATOR_SERVICE && service->vars_seq &&
+     rasqal_algebra_rowsource_has_variable(left_rs, service->vars_seq)) {
+    unsigned char* query_string;
+    size_t len;
+    raptor_sequence* vars_seq;
+    int i;
+
+    len = strlen(RASQAL_GOOD_CAST(const char*, service->query_string));
+    query_string = RASQAL_MALLOC(unsigned char*, len + 1);
+    if(!query_string) {
+      rasqal_free_rowsource(left_rs);
+      return NULL;
+    }
+    memcpy(query_string, service->query_string, len + 1);
+
+    vars_seq = raptor_new_sequence((raptor_data_free_handler)rasqal_free_variable,
+                                   (raptor_data_print_handler)rasqal_variable_print);
+    for(i = 0; vars_seq && i < raptor_sequence_size(service->vars_seq); i++) {
+      rasqal_variable* v;
+
+      v = (rasqal_variable*)raptor_sequence_get_at(service->vars_seq, i);
+      raptor_sequence_push(vars_seq, rasqal_new_variable_from_variable(v));
+    }
+
+    return rasqal_new_bindjoin_rowsource(query->world, query, left_rs,
+                                         service->service_uri, query_string,
+                                         NULL, vars_seq,
+                                         (service->flags & RASQAL_ENGINE_BITFLAG_SILENT),
+                                         batch_size);
+  }
+
+  right_rs = rasqal_algebra_node_to_rowsource(execution_data, node->node2,
+                                              error_p);
+  if((error_p && *error_p) || !right_rs) {
+    rasqal_free_rowsource(left_rs);
+    return NULL;
+  }
+
+  return rasqal_new_join_rowsource(query->world, query, left_rs, right_rs,
+                                   (node->flags & RASQAL_ENGINE_BITFLAG_EXISTS_ONLY) ? RASQAL_JOIN_TYPE_SEMI : RASQAL_JOIN_TYPE_NATURAL,
+                                   node->expr);
+}
+
+
+static rasqal_rowsource*
+rasqal_algebra_minus_algebra_node_to_rowsource(rasqal_engine_algebra_data* execution_data,
+                                               rasqal_algebra_node* node,
+                                               rasqal_engine_error *error_p)
+{
+  rasqal_query *query = execution_data->query;
+  rasqal_rowsource *left_rs;
+  rasqal_rowsource *right_rs;
 
   left_rs = rasqal_algebra_node_to_rowsource(execution_data, node->node1,
                                              error_p);
@@ -219,7 +315,9 @@ rasqal_algebra_join_algebra_node_to_rowsource(rasqal_engine_algebra_data* execut
     return NULL;
   }
 
-  return rasqal_new_join_rowsource(query->world, query, left_rs, right_rs, RASQAL_JOIN_TYPE_NATURAL, node->expr);
+  /* MINUS and DIFF with no expression are both hash anti-joins */
+  return rasqal_new_antijoin_rowsource(query->world, query, left_rs, right_rs,
+                                       (node->op == RASQAL_ALGEBRA_OPERATOR_MINUS));
 }
 
 
@@ -389,6 +487,75 @@ rasqal_algebra_group_algebra_node_to_rowsource(rasqal_engine_algebra_data* execu
 }
 
 
+/*
+ * rasqal_algebra_count_algebra_node_to_rowsource:
+ * @execution_data: execution data
+ * @node: AGGREGATION algebra node
+ *
+ * INTERNAL - Try to answer an aggregation with a count from the triples source
+ *
+ * An aggregation of only COUNT(*), or COUNT(?v) of a variable in
+ * the pattern, over a single triple pattern with no GROUP BY is the
+ * number of triples matching the pattern.  If the triples source can
+ * count them, the rows are never read.
+ *
+ * Return value: count rowsource or NULL if the count is not available
+ */
+static rasqal_rowsource*
+rasqal_algebra_count_algebra_node_to_rowsource(rasqal_engine_algebra_data* execution_data,
+                                               rasqal_algebra_node* node)
+{
+  rasqal_query *query = execution_data->query;
+  rasqal_algebra_node* bgp = node->node1;
+  rasqal_expression* expr;
+  rasqal_variable* v = NULL;
+  rasqal_triple* t;
+  rasqal_integer count;
+
+  if(raptor_sequence_size(node->seq) != 1 ||
+     raptor_sequence_size(node->vars_seq) != 1)
+    return NULL;
+
+  expr = (rasqal_expression*)raptor_sequence_get_at(node->seq, 0);
+  if(expr->op != RASQAL_EXPR_COUNT ||
+     (expr->flags & RASQAL_EXPR_FLAG_DISTINCT) || !expr->arg1)
+    return NULL;
+
+  if(expr->arg1->op != RASQAL_EXPR_VARSTAR) {
+    if(expr->arg1->op != RASQAL_EXPR_LITERAL)
+      return NULL;
+    v = rasqal_literal_as_variable(expr->arg1->literal);
+    if(!v)
+      return NULL;
+  }
+
+  if(bgp->op != RASQAL_ALGEBRA_OPERATOR_BGP || !bgp->triples ||
+     bgp->start_column < 0 || bgp->start_column != bgp->end_column)
+    return NULL;
+
+  t = (rasqal_triple*)raptor_sequence_get_at(bgp->triples, bgp->start_column);
+  if(!t)
+    return NULL;
+
+  /* COUNT(?v) only counts every row if the pattern always binds ?v */
+  if(v && v != rasqal_literal_as_variable(t->subject) &&
+     v != rasqal_literal_as_variable(t->predicate) &&
+     v != rasqal_literal_as_variable(t->object) &&
+     !(t->origin && v == rasqal_literal_as_variable(t->origin)))
+    return NULL;
+
+  if(rasqal_triples_source_triples_count(execution_data->triples_source, t,
+                                         &count))
+    return NULL;
+
+  RASQAL_DEBUG2("Aggregation answered by triples source count %ld\n",
+                RASQAL_GOOD_CAST(long, count));
+
+  return rasqal_new_count_aggregation_rowsource(query->world, query, count,
+                                                (rasqal_variable*)raptor_sequence_get_at(node->vars_seq, 0));
+}
+
+
 static rasqal_rowsource*
 rasqal_algebra_aggregation_algebra_node_to_rowsource(rasqal_engine_algebra_data* execution_data,
                                                      rasqal_algebra_node* node,
@@ -397,6 +564,10 @@ rasqal_algebra_aggregation_algebra_node_to_rowsource(rasqal_engine_algebra_data*
   rasqal_query *query = execution_data->query;
   rasqal_rowsource *rs;
 
+  rs = rasqal_algebra_count_algebra_node_to_rowsource(execution_data, node);
+  if(rs)
+    return rs;
+
   rs = rasqal_algebra_node_to_rowsource(execution_data, node->node1, error_p);
   if((error_p && *error_p) || !rs)
     return NULL;
@@ -554,8 +725,13 @@ rasqal_algebra_node_to_rowsource(rasqal_engine_algebra_data* execution_data,
                                                             node, error_p);
       break;
 
-    case RASQAL_ALGEBRA_OPERATOR_UNKNOWN:
     case RASQAL_ALGEBRA_OPERATOR_DIFF:
+    case RASQAL_ALGEBRA_OPERATOR_MINUS:
+      rs = rasqal_algebra_minus_algebra_node_to_rowsource(execution_data,
+                                                          node, error_p);
+      break;
+
+    case RASQAL_ALGEBRA_OPERATOR_UNKNOWN:
     case RASQAL_ALGEBRA_OPERATOR_TOLIST:
     case RASQAL_ALGEBRA_OPERATOR_REDUCED:
     default:
@@ -573,6 +749,60 @@ rasqal_algebra_node_to_rowsource(rasqal_engine_algebra_data* execution_data,
 
 
 
+/*
+ * rasqal_engine_algebra_mark_exists_only:
+ * @node: algebra node
+ *
+ * INTERNAL - Mark nodes where only the existence of a result row matters
+ *
+ * Used for ASK where the root pattern results are never returned.
+ * A JOIN then only needs to find one matching right row for each left
+ * row (a semi join) and a LEFTJOIN returns every left row so its right
+ * side can be dropped.
+ */
+static void
+rasqal_engine_algebra_mark_exists_only(rasqal_algebra_node* node)
+{
+  switch(node->op) {
+    case RASQAL_ALGEBRA_OPERATOR_JOIN:
+      /* left variables are still needed for matching the right side */
+      node->flags |= RASQAL_ENGINE_BITFLAG_EXISTS_ONLY;
+      break;
+
+    case RASQAL_ALGEBRA_OPERATOR_LEFTJOIN:
+      node->flags |= RASQAL_ENGINE_BITFLAG_EXISTS_ONLY;
+      rasqal_engine_algebra_mark_exists_only(node->node1);
+      break;
+
+    case RASQAL_ALGEBRA_OPERATOR_UNION:
+      rasqal_engine_algebra_mark_exists_only(node->node1);
+      rasqal_engine_algebra_mark_exists_only(node->node2);
+      break;
+
+    case RASQAL_ALGEBRA_OPERATOR_UNKNOWN:
+    case RASQAL_ALGEBRA_OPERATOR_BGP:
+    case RASQAL_ALGEBRA_OPERATOR_FILTER:
+    case RASQAL_ALGEBRA_OPERATOR_DIFF:
+    case RASQAL_ALGEBRA_OPERATOR_TOLIST:
+    case RASQAL_ALGEBRA_OPERATOR_ORDERBY:
+    case RASQAL_ALGEBRA_OPERATOR_PROJECT:
+    case RASQAL_ALGEBRA_OPERATOR_DISTINCT:
+    case RASQAL_ALGEBRA_OPERATOR_REDUCED:
+    case RASQAL_ALGEBRA_OPERATOR_SLICE:
+    case RASQAL_ALGEBRA_OPERATOR_GRAPH:
+    case RASQAL_ALGEBRA_OPERATOR_ASSIGN:
+    case RASQAL_ALGEBRA_OPERATOR_GROUP:
+    case RASQAL_ALGEBRA_OPERATOR_AGGREGATION:
+    case RASQAL_ALGEBRA_OPERATOR_HAVING:
+    case RASQAL_ALGEBRA_OPERATOR_VALUES:
+    case RASQAL_ALGEBRA_OPERATOR_SERVICE:
+    case RASQAL_ALGEBRA_OPERATOR_MINUS:
+    default:
+      break;
+  }
+}
+
+
 static int
 rasqal_query_engine_algebra_execute_init(void* ex_data,
                                          rasqal_query* query,
@@ -647,6 +877,19 @@ rasqal_query_engine_algebra_execute_init(void* ex_data,
   if(!node)
     return 1;
 
+  if(query->verb == RASQAL_QUERY_VERB_ASK) {
+    int offset = rasqal_query_get_offset(query);
+
+    /* ASK only needs to know if there is a first result row
+     * (after any OFFSET which is applied by the query results) */
+    rasqal_engine_algebra_mark_exists_only(node);
+
+    node = rasqal_new_slice_algebra_node(query, node,
+                                         (offset > 0 ? offset : 0) + 1, 0);
+    if(!node)
+      return 1;
+  }
+
 
   execution_data->algebra_node = node;
 
@@ -695,6 +938,11 @@ rasqal_query_engine_algebra_get_all_rows(void* ex_data,
 
   if(execution_data->rowsource) {
     seq = rasqal_rowsource_read_all_rows(execution_data->rowsource);
+    /* a rowsource may fail the query after returning some rows */
+    if(seq && execution_data->query->failed) {
+      raptor_free_sequence(seq);
+      seq = NULL;
+    }
     if(!seq)
       *error_p = RASQAL_ENGINE_FAILED;
   } else
@@ -716,7 +964,8 @@ rasqal_query_engine_algebra_get_row(void* ex_data,
   if(execution_data->rowsource) {
     row = rasqal_rowsource_read_row(execution_data->rowsource);
     if(!row)
-      *error_p = RASQAL_ENGINE_FINISHED;
+      *error_p = execution_data->query->failed ? RASQAL_ENGINE_FAILED :
+                                                 RASQAL_ENGINE_FINISHED;
   } else
     *error_p = RASQAL_ENGINE_FAILED;
 
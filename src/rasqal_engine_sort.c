@@ -36,6 +36,12 @@
 #include <stdlib.h>
 #endif
 #include <stdarg.h>
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
 
 #include "rasqal.h"
 #include "rasqal_internal.h"
@@ -209,20 +215,841 @@ rasqal_engine_rowsort_map_to_sequence(rasqal_map* map, raptor_sequence* seq)
 }
 
 
+/*
+ * Binary sort keys
+ *
+ * A sort key encodes the order values of a row so that memcmp() of
+ * two keys orders the rows as rasqal_literal_array_compare() would
+ * with XQuery comparison rules.  Each order value is a class byte
+ * followed by the value bytes:
+ *   unbound (NULL) < blank node < URI < literal
+ * A NULL value ends the key since NULLs order first for both ASC
+ * and DESC and no later values are compared.  The bytes of a DESC
+ * value, including its class, are inverted.
+ *
+ * Literals of different kinds (say strings and integers) are not
+ * comparable and some values (NaN, decimals, dates) are not
+ * encoded, so the keys are only usable if every literal in an
+ * order position is of one family that is encoded exactly.
+ */
+
+#define ROWSORT_KEY_CLASS_NULL    0x00
+#define ROWSORT_KEY_CLASS_BLANK   0x01
+#define ROWSORT_KEY_CLASS_URI     0x02
+#define ROWSORT_KEY_CLASS_LITERAL 0x03
+
+typedef enum {
+  ROWSORT_KEY_FAMILY_NONE,
+  ROWSORT_KEY_FAMILY_STRING,
+  ROWSORT_KEY_FAMILY_XSD_STRING,
+  ROWSORT_KEY_FAMILY_INTEGER,
+  ROWSORT_KEY_FAMILY_FLOATING,
+  ROWSORT_KEY_FAMILY_DATETIME,
+  ROWSORT_KEY_FAMILY_DATETIME_NO_TZ
+} rasqal_rowsort_key_family;
+
+struct rasqal_rowsort_keys_s {
+  /* number of order conditions */
+  int size;
+
+  /* non-0 for each DESC order condition */
+  int* descending;
+
+  /* literal family seen for each order condition */
+  rasqal_rowsort_key_family* families;
+
+  /* non-0 if some value cannot be encoded consistently */
+  int unusable;
+
+  /* key being built */
+  unsigned char* buffer;
+  size_t buffer_size;
+  size_t length;
+};
+
+
+/**
+ * rasqal_engine_new_rowsort_keys:
+ * @compare_flags: query comparison flags
+ * @order_conditions_sequence: order conditions
+ *
+ * INTERNAL - create a new binary sort key builder
+ *
+ * Keys are only made for XQuery comparison rules.
+ *
+ * Return value: new key builder or NULL if keys cannot be used or on failure
+ */
+rasqal_rowsort_keys*
+rasqal_engine_new_rowsort_keys(int compare_flags,
+                               raptor_sequence* order_conditions_sequence)
+{
+  rasqal_rowsort_keys* keys;
+  int i;
+
+  if((compare_flags & (RASQAL_COMPARE_XQUERY | RASQAL_COMPARE_RDF |
+                       RASQAL_COMPARE_NOCASE)) != RASQAL_COMPARE_XQUERY)
+    return NULL;
+
+  if(!order_conditions_sequence)
+    return NULL;
+
+  keys = RASQAL_CALLOC(rasqal_rowsort_keys*, 1, sizeof(*keys));
+  if(!keys)
+    return NULL;
+
+  keys->size = raptor_sequence_size(order_conditions_sequence);
+  if(keys->size <= 0)
+    goto failed;
+
+  keys->descending = RASQAL_CALLOC(int*, RASQAL_GOOD_CAST(size_t, keys->size),
+                                   sizeof(int));
+  keys->families = RASQAL_CALLOC(rasqal_rowsort_key_family*,
+                                 RASQAL_GOOD_CAST(size_t, keys->size),
+                                 sizeof(rasqal_rowsort_key_family));
+  if(!keys->descending || !keys->families)
+    goto failed;
+
+  for(i = 0; i < keys->size; i++) {
+    rasqal_expression* e;
+
+    e = (rasqal_expression*)raptor_sequence_get_at(order_conditions_sequence, i);
+    keys->descending[i] = (e && e->op == RASQAL_EXPR_ORDER_COND_DESC);
+  }
+
+  return keys;
+
+  failed:
+  rasqal_engine_free_rowsort_keys(keys);
+  return NULL;
+}
+
+
+/**
+ * rasqal_engine_free_rowsort_keys:
+ * @keys: key builder
+ *
+ * INTERNAL - destructor
+ */
+void
+rasqal_engine_free_rowsort_keys(rasqal_rowsort_keys* keys)
+{
+  if(!keys)
+    return;
+
+  if(keys->descending)
+    RASQAL_FREE(int*, keys->descending);
+
+  if(keys->families)
+    RASQAL_FREE(rasqal_rowsort_key_family*, keys->families);
+
+  if(keys->buffer)
+    RASQAL_FREE(char*, keys->buffer);
+
+  RASQAL_FREE(rasqal_rowsort_keys, keys);
+}
+
+
+/**
+ * rasqal_engine_rowsort_keys_usable:
+ * @keys: key builder
+ *
+ * INTERNAL - check all the rows given keys can be sorted by them
+ *
+ * Return value: non-0 if usable
+ */
+int
+rasqal_engine_rowsort_keys_usable(rasqal_rowsort_keys* keys)
+{
+  return keys && !keys->unusable;
+}
+
+
+static unsigned char*
+rasqal_rowsort_keys_reserve(rasqal_rowsort_keys* keys, size_t len)
+{
+  if(keys->length + len > keys->buffer_size) {
+    size_t new_size = keys->buffer_size ? keys->buffer_size * 2 : 64;
+    unsigned char* new_buffer;
+
+    while(new_size < keys->length + len)
+      new_size *= 2;
+
+    new_buffer = RASQAL_MALLOC(unsigned char*, new_size);
+    if(!new_buffer) {
+      keys->unusable = 1;
+      return NULL;
+    }
+
+    if(keys->buffer) {
+      memcpy(new_buffer, keys->buffer, keys->length);
+      RASQAL_FREE(char*, keys->buffer);
+    }
+    keys->buffer = new_buffer;
+    keys->buffer_size = new_size;
+  }
+
+  return keys->buffer + keys->length;
+}
+
+
+/* Add bytes ordered as memcmp() and terminated; 0 and 1 are escaped */
+static void
+rasqal_rowsort_keys_add_string(rasqal_rowsort_keys* keys,
+                               const unsigned char* string, size_t len,
+                               int lowercase)
+{
+  unsigned char* p;
+  size_t i;
+
+  p = rasqal_rowsort_keys_reserve(keys, 2 * len + 1);
+  if(!p)
+    return;
+
+  for(i = 0; i < len; i++) {
+    unsigned char c = string[i];
+
+    if(lowercase && c >= 'A' && c <= 'Z')
+      c = RASQAL_GOOD_CAST(unsigned char, c - 'A' + 'a');
+
+    if(c < 2) {
+      *p++ = 1;
+      *p++ = RASQAL_GOOD_CAST(unsigned char, c + 1);
+    } else
+      *p++ = c;
+  }
+  *p++ = 0;
+
+  keys->length = RASQAL_GOOD_CAST(size_t, p - keys->buffer);
+}
+
+
+/* Add the 64 bits of @value most significant byte first */
+static void
+rasqal_rowsort_keys_add_bits(rasqal_rowsort_keys* keys, rasqal_integer value)
+{
+  unsigned char* p;
+  int shift;
+
+  p = rasqal_rowsort_keys_reserve(keys, 8);
+  if(!p)
+    return;
+
+  for(shift = 56; shift >= 0; shift -= 8)
+    *p++ = RASQAL_GOOD_CAST(unsigned char, (value >> shift) & 0xff);
+
+  keys->length += 8;
+}
+
+
+static void
+rasqal_rowsort_keys_add_byte(rasqal_rowsort_keys* keys, unsigned char c)
+{
+  unsigned char* p = rasqal_rowsort_keys_reserve(keys, 1);
+
+  if(p) {
+    *p = c;
+    keys->length++;
+  }
+}
+
+
+/*
+ * rasqal_rowsort_keys_literal_family:
+ *
+ * INTERNAL - Get the family of a literal that can be encoded in a key
+ *
+ * Return value: family or ROWSORT_KEY_FAMILY_NONE if not encodable
+ */
+static rasqal_rowsort_key_family
+rasqal_rowsort_keys_literal_family(rasqal_literal* l)
+{
+  switch(l->type) {
+    case RASQAL_LITERAL_STRING:
+      /* compared by string, language and datatype */
+      if(l->datatype)
+        return ROWSORT_KEY_FAMILY_NONE;
+      if(l->language) {
+        const unsigned char* p;
+
+        /* language tags are compared case independently */
+        for(p = RASQAL_GOOD_CAST(const unsigned char*, l->language); *p; p++) {
+          if(*p >= 0x80)
+            return ROWSORT_KEY_FAMILY_NONE;
+        }
+      }
+      return ROWSORT_KEY_FAMILY_STRING;
+
+    case RASQAL_LITERAL_XSD_STRING:
+      return ROWSORT_KEY_FAMILY_XSD_STRING;
+
+    case RASQAL_LITERAL_BOOLEAN:
+    case RASQAL_LITERAL_INTEGER:
+    case RASQAL_LITERAL_INTEGER_SUBTYPE:
+      return ROWSORT_KEY_FAMILY_INTEGER;
+
+    case RASQAL_LITERAL_FLOAT:
+    case RASQAL_LITERAL_DOUBLE:
+      /* NaN compares equal to everything */
+      if(l->value.floating != l->value.floating)
+        return ROWSORT_KEY_FAMILY_NONE;
+      return ROWSORT_KEY_FAMILY_FLOATING;
+
+    case RASQAL_LITERAL_DATETIME:
+      /* dateTimes with and without timezones may be incomparable */
+      if(l->value.datetime->timezone_minutes == RASQAL_XSD_DATETIME_NO_TZ)
+        return ROWSORT_KEY_FAMILY_DATETIME_NO_TZ;
+      return ROWSORT_KEY_FAMILY_DATETIME;
+
+    case RASQAL_LITERAL_UNKNOWN:
+    case RASQAL_LITERAL_BLANK:
+    case RASQAL_LITERAL_URI:
+    case RASQAL_LITERAL_DECIMAL:
+    case RASQAL_LITERAL_UDT:
+    case RASQAL_LITERAL_PATTERN:
+    case RASQAL_LITERAL_QNAME:
+    case RASQAL_LITERAL_VARIABLE:
+    case RASQAL_LITERAL_DATE:
+    default:
+      return ROWSORT_KEY_FAMILY_NONE;
+  }
+}
+
+
+/*
+ * rasqal_rowsort_keys_add_value:
+ * @keys: key builder
+ * @i: order condition index
+ * @l: order value (not NULL)
+ *
+ * INTERNAL - Add an order value to the key being built
+ */
+static void
+rasqal_rowsort_keys_add_value(rasqal_rowsort_keys* keys, int i,
+                              rasqal_literal* l)
+{
+  size_t start = keys->length;
+  rasqal_literal_type type = l->type;
+  const unsigned char* s;
+  size_t len;
+
+  if(type == RASQAL_LITERAL_BLANK) {
+    rasqal_rowsort_keys_add_byte(keys, ROWSORT_KEY_CLASS_BLANK);
+    s = l->string;
+    rasqal_rowsort_keys_add_string(keys, s,
+                                   strlen(RASQAL_GOOD_CAST(const char*, s)), 0);
+  } else if(type == RASQAL_LITERAL_URI) {
+    rasqal_rowsort_keys_add_byte(keys, ROWSORT_KEY_CLASS_URI);
+    s = raptor_uri_as_counted_string(l->value.uri, &len);
+    rasqal_rowsort_keys_add_string(keys, s, len, 0);
+  } else {
+    rasqal_rowsort_key_family family;
+
+    family = rasqal_rowsort_keys_literal_family(l);
+    if(family == ROWSORT_KEY_FAMILY_NONE ||
+       (keys->families[i] != ROWSORT_KEY_FAMILY_NONE &&
+        keys->families[i] != family)) {
+      keys->unusable = 1;
+      return;
+    }
+    keys->families[i] = family;
+
+    rasqal_rowsort_keys_add_byte(keys, ROWSORT_KEY_CLASS_LITERAL);
+
+    switch(family) {
+      case ROWSORT_KEY_FAMILY_STRING:
+      case ROWSORT_KEY_FAMILY_XSD_STRING:
+        /* compared with strcmp() so only up to any NUL */
+        s = l->string;
+        rasqal_rowsort_keys_add_string(keys, s,
+                                       strlen(RASQAL_GOOD_CAST(const char*, s)),
+                                       0);
+        if(family == ROWSORT_KEY_FAMILY_STRING) {
+          /* no language orders first */
+          if(l->language) {
+            rasqal_rowsort_keys_add_byte(keys, 2);
+            s = RASQAL_GOOD_CAST(const unsigned char*, l->language);
+            rasqal_rowsort_keys_add_string(keys, s,
+                                           strlen(RASQAL_GOOD_CAST(const char*, s)),
+                                           1);
+          } else
+            rasqal_rowsort_keys_add_byte(keys, 1);
+        }
+        break;
+
+      case ROWSORT_KEY_FAMILY_INTEGER:
+        rasqal_rowsort_keys_add_bits(keys,
+                                     l->value.integer ^ RASQAL_INTEGER_MIN);
+        break;
+
+      case ROWSORT_KEY_FAMILY_FLOATING:
+        if(1) {
+          double d = l->value.floating;
+          rasqal_integer bits;
+
+          /* -0 and 0 are equal */
+          if(d == 0.0)
+            d = 0.0;
+          memcpy(&bits, &d, sizeof(bits));
+          /* negative doubles order in reverse of their bits */
+          bits = (bits < 0) ? ~bits : (bits ^ RASQAL_INTEGER_MIN);
+          rasqal_rowsort_keys_add_bits(keys, bits);
+        }
+        break;
+
+      case ROWSORT_KEY_FAMILY_DATETIME:
+      case ROWSORT_KEY_FAMILY_DATETIME_NO_TZ:
+        rasqal_rowsort_keys_add_bits(keys,
+                                     RASQAL_GOOD_CAST(rasqal_integer, l->value.datetime->time_on_timeline) ^ RASQAL_INTEGER_MIN);
+        rasqal_rowsort_keys_add_bits(keys,
+                                     RASQAL_GOOD_CAST(rasqal_integer, l->value.datetime->microseconds));
+        break;
+
+      case ROWSORT_KEY_FAMILY_NONE:
+      default:
+        keys->unusable = 1;
+        return;
+    }
+  }
+
+  if(keys->descending[i] && !keys->unusable) {
+    unsigned char* p;
+
+    for(p = keys->buffer + start; p < keys->buffer + keys->length; p++)
+      *p = RASQAL_GOOD_CAST(unsigned char, ~*p);
+  }
+}
+
+
+/*
+ * rasqal_rowsort_keys_set_row_key:
+ * @keys: key builder
+ * @row: row with order values
+ *
+ * INTERNAL - Make the sort key of a row from its order values
+ */
+static void
+rasqal_rowsort_keys_set_row_key(rasqal_rowsort_keys* keys, rasqal_row* row)
+{
+  int i;
+
+  keys->length = 0;
+
+  for(i = 0; i < row->order_size && i < keys->size; i++) {
+    rasqal_literal* l = row->order_values[i];
+
+    if(!l) {
+      rasqal_rowsort_keys_add_byte(keys, ROWSORT_KEY_CLASS_NULL);
+      break;
+    }
+
+    rasqal_rowsort_keys_add_value(keys, i, l);
+    if(keys->unusable)
+      return;
+  }
+
+  if(row->order_key)
+    RASQAL_FREE(char*, row->order_key);
+
+  row->order_key = RASQAL_MALLOC(unsigned char*, keys->length + 1);
+  if(!row->order_key) {
+    keys->unusable = 1;
+    return;
+  }
+  if(keys->length)
+    memcpy(row->order_key, keys->buffer, keys->length);
+  row->order_key_len = keys->length;
+}
+
+
+static int
+rasqal_rowsort_row_key_compare(rasqal_row* row_a, rasqal_row* row_b)
+{
+  size_t len = row_a->order_key_len;
+  int result;
+
+  if(row_b->order_key_len < len)
+    len = row_b->order_key_len;
+
+  result = memcmp(row_a->order_key, row_b->order_key, len);
+  if(!result)
+    result = (row_a->order_key_len > row_b->order_key_len) -
+             (row_a->order_key_len < row_b->order_key_len);
+
+  return result;
+}
+
+
+/* Stable merge of two sorted runs into @out; ties are taken from @a */
+static void
+rasqal_rowsort_merge(rasqal_row** a, size_t a_len,
+                     rasqal_row** b, size_t b_len,
+                     rasqal_row** out)
+{
+  size_t i = 0;
+  size_t j = 0;
+
+  while(i < a_len && j < b_len) {
+    if(rasqal_rowsort_row_key_compare(b[j], a[i]) < 0)
+      *out++ = b[j++];
+    else
+      *out++ = a[i++];
+  }
+  while(i < a_len)
+    *out++ = a[i++];
+  while(j < b_len)
+    *out++ = b[j++];
+}
+
+
+/*
+ * rasqal_rowsort_merge_sort:
+ * @array: rows
+ * @temp: work space of the same size
+ * @size: number of rows
+ *
+ * INTERNAL - Stable bottom-up merge sort of rows by key
+ *
+ * Return value: @array or @temp, whichever holds the sorted rows
+ */
+static rasqal_row**
+rasqal_rowsort_merge_sort(rasqal_row** array, rasqal_row** temp, size_t size)
+{
+  size_t width;
+
+  for(width = 1; width < size; width *= 2) {
+    rasqal_row** swap;
+    size_t i;
+
+    for(i = 0; i < size; i += 2 * width) {
+      size_t mid = (i + width < size) ? i + width : size;
+      size_t end = (i + 2 * width < size) ? i + 2 * width : size;
+
+      rasqal_rowsort_merge(array + i, mid - i, array + mid, end - mid,
+                           temp + i);
+    }
+
+    swap = array;
+    array = temp;
+    temp = swap;
+  }
+
+  return array;
+}
+
+
+#ifdef HAVE_PTHREAD
+
+/* Sort in parallel from this many rows */
+#define ROWSORT_PARALLEL_MIN_ROWS 65536
+
+/* Most threads used by a parallel sort */
+#define ROWSORT_PARALLEL_MAX_THREADS 32
+
+/* A range of rows to sort or part of a merge of two runs */
+typedef struct
+{
+  /* sort: rows to sort in place using temp */
+  rasqal_row** array;
+  rasqal_row** temp;
+  size_t size;
+
+  /* merge: runs a and b merged into out */
+  rasqal_row** a;
+  size_t a_len;
+  rasqal_row** b;
+  size_t b_len;
+  rasqal_row** out;
+
+  pthread_t thread;
+  int started;
+} rasqal_rowsort_job;
+
+
+static void*
+rasqal_rowsort_job_run(void* arg)
+{
+  rasqal_rowsort_job* job = (rasqal_rowsort_job*)arg;
+
+  if(job->array) {
+    rasqal_row** sorted;
+
+    sorted = rasqal_rowsort_merge_sort(job->array, job->temp, job->size);
+    if(sorted != job->array)
+      memcpy(job->array, sorted, job->size * sizeof(rasqal_row*));
+  } else
+    rasqal_rowsort_merge(job->a, job->a_len, job->b, job->b_len, job->out);
+
+  return NULL;
+}
+
+
+/* Run jobs on threads; any that cannot be started are run here */
+static void
+rasqal_rowsort_run_jobs(rasqal_rowsort_job* jobs, int count)
+{
+  int i;
+
+  for(i = 0; i < count; i++)
+    jobs[i].started = !pthread_create(&jobs[i].thread, NULL,
+                                      rasqal_rowsort_job_run, &jobs[i]);
+
+  for(i = 0; i < count; i++) {
+    if(jobs[i].started)
+      pthread_join(jobs[i].thread, NULL);
+    else
+      rasqal_rowsort_job_run(&jobs[i]);
+  }
+}
+
+
+/*
+ * rasqal_rowsort_merge_split:
+ *
+ * INTERNAL - Find how many rows of @a are in the first @k rows of the
+ * stable merge of runs @a and @b
+ */
+static size_t
+rasqal_rowsort_merge_split(rasqal_row** a, size_t a_len,
+                           rasqal_row** b, size_t b_len, size_t k)
+{
+  size_t lo = (k > b_len) ? k - b_len : 0;
+  size_t hi = (k < a_len) ? k : a_len;
+
+  while(lo < hi) {
+    size_t i = lo + (hi - lo) / 2;
+    size_t j = k - i;
+
+    /* a[i] is merged before b[j-1] so it is in the first k */
+    if(j > 0 && rasqal_rowsort_row_key_compare(a[i], b[j - 1]) <= 0)
+      lo = i + 1;
+    else
+      hi = i;
+  }
+
+  return lo;
+}
+
+
+static int
+rasqal_rowsort_thread_count(void)
+{
+  long count = 1;
+
+#if defined(HAVE_UNISTD_H) && defined(_SC_NPROCESSORS_ONLN)
+  count = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+  if(count < 1)
+    count = 1;
+  if(count > ROWSORT_PARALLEL_MAX_THREADS)
+    count = ROWSORT_PARALLEL_MAX_THREADS;
+
+  return RASQAL_GOOD_CAST(int, count);
+}
+
+
+/*
+ * rasqal_rowsort_parallel_merge_sort:
+ * @array: rows
+ * @temp: work space of the same size
+ * @size: number of rows
+ * @threads: number of threads
+ *
+ * INTERNAL - Sort rows by key using several threads
+ *
+ * Chunks of the rows are sorted on separate threads and then the
+ * sorted runs are merged in pairs, each merge split into parts at
+ * the same output positions on separate threads.  The merges are
+ * stable so the result is the same as rasqal_rowsort_merge_sort().
+ *
+ * Return value: @array or @temp, whichever holds the sorted rows or
+ * NULL on failure
+ */
+static rasqal_row**
+rasqal_rowsort_parallel_merge_sort(rasqal_row** array, rasqal_row** temp,
+                                   size_t size, int threads)
+{
+  rasqal_rowsort_job* jobs;
+  size_t* runs;
+  int runs_count = threads;
+  int i;
+
+  jobs = RASQAL_CALLOC(rasqal_rowsort_job*, RASQAL_GOOD_CAST(size_t, threads),
+                       sizeof(*jobs));
+  runs = RASQAL_CALLOC(size_t*, RASQAL_GOOD_CAST(size_t, threads + 1),
+                       sizeof(size_t));
+  if(!jobs || !runs) {
+    if(jobs)
+      RASQAL_FREE(rasqal_rowsort_job*, jobs);
+    if(runs)
+      RASQAL_FREE(size_t*, runs);
+    return NULL;
+  }
+
+  /* sort a chunk per thread */
+  for(i = 0; i <= threads; i++)
+    runs[i] = size / RASQAL_GOOD_CAST(size_t, threads) * RASQAL_GOOD_CAST(size_t, i);
+  runs[threads] = size;
+
+  for(i = 0; i < threads; i++) {
+    jobs[i].array = array + runs[i];
+    jobs[i].temp = temp + runs[i];
+    jobs[i].size = runs[i + 1] - runs[i];
+  }
+  rasqal_rowsort_run_jobs(jobs, threads);
+
+  /* merge pairs of runs until there is one */
+  while(runs_count > 1) {
+    int pairs = runs_count / 2;
+    int parts_per_pair = threads / pairs;
+    int jobs_count = 0;
+    rasqal_row** swap;
+    int p;
+
+    if(parts_per_pair < 1)
+      parts_per_pair = 1;
+
+    memset(jobs, 0, RASQAL_GOOD_CAST(size_t, threads) * sizeof(*jobs));
+
+    for(p = 0; p < pairs; p++) {
+      rasqal_row** a = array + runs[2 * p];
+      size_t a_len = runs[2 * p + 1] - runs[2 * p];
+      rasqal_row** b = array + runs[2 * p + 1];
+      size_t b_len = runs[2 * p + 2] - runs[2 * p + 1];
+      rasqal_row** out = temp + runs[2 * p];
+      size_t total = a_len + b_len;
+      int part;
+
+      for(part = 0; part < parts_per_pair; part++) {
+        size_t k1 = total / RASQAL_GOOD_CAST(size_t, parts_per_pair) * RASQAL_GOOD_CAST(size_t, part);
+        size_t k2 = (part == parts_per_pair - 1) ? total :
+          total / RASQAL_GOOD_CAST(size_t, parts_per_pair) * RASQAL_GOOD_CAST(size_t, part + 1);
+        size_t i1 = rasqal_rowsort_merge_split(a, a_len, b, b_len, k1);
+        size_t i2 = rasqal_rowsort_merge_split(a, a_len, b, b_len, k2);
+        rasqal_rowsort_job* job = &jobs[jobs_count++];
+
+        job->a = a + i1;
+        job->a_len = i2 - i1;
+        job->b = b + (k1 - i1);
+        job->b_len = (k2 - i2) - (k1 - i1);
+        job->out = out + k1;
+      }
+    }
+
+    /* an odd run out is copied over unchanged */
+    if(runs_count & 1)
+      memcpy(temp + runs[runs_count - 1], array + runs[runs_count - 1],
+             (runs[runs_count] - runs[runs_count - 1]) * sizeof(rasqal_row*));
+
+    rasqal_rowsort_run_jobs(jobs, jobs_count);
+
+    for(p = 0; p < pairs; p++)
+      runs[p + 1] = runs[2 * p + 2];
+    if(runs_count & 1) {
+      runs[pairs + 1] = runs[runs_count];
+      runs_count = pairs + 1;
+    } else
+      runs_count = pairs;
+
+    swap = array;
+    array = temp;
+    temp = swap;
+  }
+
+  RASQAL_FREE(rasqal_rowsort_job*, jobs);
+  RASQAL_FREE(size_t*, runs);
+
+  return array;
+}
+#endif /* HAVE_PTHREAD */
+
+
+/**
+ * rasqal_engine_rowsort_keys_sort:
+ * @keys: key builder used for all the rows
+ * @rows: sequence of rows in offset order
+ * @seq: sequence to add the sorted rows to
+ *
+ * INTERNAL - Sort rows by their binary sort keys
+ *
+ * Uses a stable merge sort so rows with equal keys stay in their
+ * original order.  Large inputs are sorted on several threads when
+ * available, with the same result.  Only valid if
+ * rasqal_engine_rowsort_keys_usable()
+ *
+ * Return value: non-0 on failure
+ */
+int
+rasqal_engine_rowsort_keys_sort(rasqal_rowsort_keys* keys,
+                                raptor_sequence* rows,
+                                raptor_sequence* seq)
+{
+  rasqal_row** array;
+  rasqal_row** temp;
+  rasqal_row** sorted = NULL;
+  size_t size;
+  size_t i;
+
+  if(!rasqal_engine_rowsort_keys_usable(keys))
+    return 1;
+
+  size = RASQAL_BAD_CAST(size_t, raptor_sequence_size(rows));
+  if(!size)
+    return 0;
+
+  array = RASQAL_MALLOC(rasqal_row**, size * sizeof(rasqal_row*));
+  temp = RASQAL_MALLOC(rasqal_row**, size * sizeof(rasqal_row*));
+  if(!array || !temp) {
+    if(array)
+      RASQAL_FREE(rasqal_row**, array);
+    if(temp)
+      RASQAL_FREE(rasqal_row**, temp);
+    return 1;
+  }
+
+  for(i = 0; i < size; i++)
+    array[i] = (rasqal_row*)raptor_sequence_get_at(rows, RASQAL_GOOD_CAST(int, i));
+
+#ifdef HAVE_PTHREAD
+  if(size >= ROWSORT_PARALLEL_MIN_ROWS) {
+    int threads = rasqal_rowsort_thread_count();
+
+    if(threads > 1)
+      sorted = rasqal_rowsort_parallel_merge_sort(array, temp, size, threads);
+  }
+#endif
+  if(!sorted)
+    sorted = rasqal_rowsort_merge_sort(array, temp, size);
+
+  for(i = 0; i < size; i++) {
+    if(raptor_sequence_push(seq, rasqal_new_row_from_row(sorted[i])))
+      break;
+  }
+
+  RASQAL_FREE(rasqal_row**, array);
+  RASQAL_FREE(rasqal_row**, temp);
+
+  return (i < size);
+}
+
+
 /**
  * rasqal_engine_rowsort_calculate_order_values:
  * @query: query object
  * @order_seq: order conditions sequence
  * @row: row
+ * @keys: binary sort key builder or NULL
  *
  * INTERNAL - Calculate the order condition values for a row
  *
+ * If @keys is given, the binary sort key of the row is also made.
+ *
  * Return value: non-0 on failure 
  */
 int
 rasqal_engine_rowsort_calculate_order_values(rasqal_query* query,
                                              raptor_sequence* order_seq,
-                                             rasqal_row* row)
+                                             rasqal_row* row,
+                                             rasqal_rowsort_keys* keys)
 {
   int i;
   
@@ -247,6 +1074,269 @@ rasqal_engine_rowsort_calculate_order_values(rasqal_query* query,
       rasqal_free_literal(l);
     }
   }
+
+  if(keys && !keys->unusable)
+    rasqal_rowsort_keys_set_row_key(keys, row);
   
   return 0;
 }
+
+
+
+#ifdef STANDALONE
+
+/* one more prototype */
+int main(int argc, char *argv[]);
+
+
+#ifdef HAVE_PTHREAD
+
+/* More rows than the parallel sort minimum, not a multiple of any
+ * thread count tested, with many rows sharing each key */
+#define SORT_TEST_ROWS (ROWSORT_PARALLEL_MIN_ROWS + 4099)
+#define SORT_TEST_KEYS 97
+
+
+static rasqal_row**
+sort_test_make_rows(rasqal_world* world, rasqal_rowsort_keys* keys,
+                    size_t size)
+{
+  rasqal_row** rows;
+  size_t i;
+
+  rows = RASQAL_CALLOC(rasqal_row**, size, sizeof(rasqal_row*));
+  if(!rows)
+    return NULL;
+
+  for(i = 0; i < size; i++) {
+    rasqal_row* row = rasqal_new_row_for_size(world, 0);
+    /* keys in a scrambled order */
+    rasqal_integer value = RASQAL_GOOD_CAST(rasqal_integer, (i * 7919) % SORT_TEST_KEYS);
+
+    if(!row || rasqal_row_set_order_size(row, 1)) {
+      if(row)
+        rasqal_free_row(row);
+      break;
+    }
+    rows[i] = row;
+
+    row->offset = RASQAL_GOOD_CAST(int, i);
+    row->order_values[0] = rasqal_new_integer_literal(world,
+                                                      RASQAL_LITERAL_INTEGER,
+                                                      value);
+    if(!row->order_values[0])
+      break;
+    rasqal_rowsort_keys_set_row_key(keys, row);
+  }
+
+  if(i < size || !rasqal_engine_rowsort_keys_usable(keys)) {
+    for(i = 0; i < size; i++) {
+      if(rows[i])
+        rasqal_free_row(rows[i]);
+    }
+    RASQAL_FREE(rasqal_row**, rows);
+    return NULL;
+  }
+
+  return rows;
+}
+
+
+/* Check rows are in key order and in offset order for equal keys */
+static int
+sort_test_check_stable(rasqal_row** rows, size_t size)
+{
+  size_t i;
+
+  for(i = 1; i < size; i++) {
+    int result = rasqal_rowsort_row_key_compare(rows[i - 1], rows[i]);
+
+    if(result > 0 || (!result && rows[i - 1]->offset > rows[i]->offset))
+      return 1;
+  }
+
+  return 0;
+}
+
+
+/* Check rasqal_rowsort_merge_split() against merging the runs */
+static int
+sort_test_merge_split(rasqal_row** rows, size_t a_len, size_t b_len)
+{
+  size_t size = a_len + b_len;
+  rasqal_row** runs;
+  rasqal_row** temp;
+  rasqal_row** out;
+  rasqal_row** a;
+  rasqal_row** b;
+  size_t k;
+  size_t from_a = 0;
+  int failures = 0;
+
+  runs = RASQAL_CALLOC(rasqal_row**, size + 1, sizeof(rasqal_row*));
+  temp = RASQAL_CALLOC(rasqal_row**, size + 1, sizeof(rasqal_row*));
+  out = RASQAL_CALLOC(rasqal_row**, size + 1, sizeof(rasqal_row*));
+  if(!runs || !temp || !out) {
+    failures++;
+    goto tidy;
+  }
+
+  /* make two sorted runs of the first rows */
+  memcpy(runs, rows, size * sizeof(rasqal_row*));
+  a = runs;
+  b = runs + a_len;
+  if(rasqal_rowsort_merge_sort(a, temp, a_len) != a)
+    memcpy(a, temp, a_len * sizeof(rasqal_row*));
+  if(rasqal_rowsort_merge_sort(b, temp, b_len) != b)
+    memcpy(b, temp, b_len * sizeof(rasqal_row*));
+
+  rasqal_rowsort_merge(a, a_len, b, b_len, out);
+
+  for(k = 0; k <= size; k++) {
+    /* rows of run a have the lowest offsets */
+    if(k > 0 && out[k - 1]->offset < RASQAL_GOOD_CAST(int, a_len))
+      from_a++;
+
+    if(rasqal_rowsort_merge_split(a, a_len, b, b_len, k) != from_a) {
+      failures++;
+      break;
+    }
+  }
+
+  tidy:
+  if(runs)
+    RASQAL_FREE(rasqal_row**, runs);
+  if(temp)
+    RASQAL_FREE(rasqal_row**, temp);
+  if(out)
+    RASQAL_FREE(rasqal_row**, out);
+
+  return failures;
+}
+
+
+static const int sort_test_threads[] = { 2, 3, 4, 7, 8, 0 };
+
+#endif /* HAVE_PTHREAD */
+
+
+int
+main(int argc, char *argv[])
+{
+  const char *program = rasqal_basename(argv[0]);
+#ifdef HAVE_PTHREAD
+  rasqal_world* world;
+  raptor_sequence* order_seq = NULL;
+  rasqal_rowsort_keys* keys = NULL;
+  rasqal_expression* e;
+  rasqal_row** rows = NULL;
+  rasqal_row** expected = NULL;
+  rasqal_row** array = NULL;
+  rasqal_row** temp = NULL;
+  rasqal_row** sorted;
+  size_t size = SORT_TEST_ROWS;
+  size_t i;
+  int failures = 0;
+  int t;
+
+  world = rasqal_new_world();
+  if(!world || rasqal_world_open(world)) {
+    fprintf(stderr, "%s: rasqal_world init failed\n", program);
+    return(1);
+  }
+
+  order_seq = raptor_new_sequence((raptor_data_free_handler)rasqal_free_expression,
+                                  (raptor_data_print_handler)rasqal_expression_print);
+  e = rasqal_new_1op_expression(world, RASQAL_EXPR_ORDER_COND_ASC,
+                                rasqal_new_literal_expression(world,
+                                                              rasqal_new_integer_literal(world, RASQAL_LITERAL_INTEGER, 0)));
+  if(!order_seq || !e || raptor_sequence_push(order_seq, e)) {
+    fprintf(stderr, "%s: failed to create order conditions\n", program);
+    failures++;
+    goto tidy;
+  }
+
+  keys = rasqal_engine_new_rowsort_keys(RASQAL_COMPARE_XQUERY, order_seq);
+  if(keys)
+    rows = sort_test_make_rows(world, keys, size);
+  expected = RASQAL_CALLOC(rasqal_row**, size, sizeof(rasqal_row*));
+  array = RASQAL_CALLOC(rasqal_row**, size, sizeof(rasqal_row*));
+  temp = RASQAL_CALLOC(rasqal_row**, size, sizeof(rasqal_row*));
+  if(!rows || !expected || !array || !temp) {
+    fprintf(stderr, "%s: failed to create %d rows\n", program,
+            RASQAL_GOOD_CAST(int, size));
+    failures++;
+    goto tidy;
+  }
+
+  /* expected result from the single threaded sort */
+  memcpy(array, rows, size * sizeof(rasqal_row*));
+  sorted = rasqal_rowsort_merge_sort(array, temp, size);
+  memcpy(expected, sorted, size * sizeof(rasqal_row*));
+
+  if(sort_test_check_stable(expected, size)) {
+    fprintf(stderr, "%s: merge sort is not in stable key order\n", program);
+    failures++;
+  }
+
+  for(t = 0; sort_test_threads[t]; t++) {
+    int threads = sort_test_threads[t];
+
+    memcpy(array, rows, size * sizeof(rasqal_row*));
+    sorted = rasqal_rowsort_parallel_merge_sort(array, temp, size, threads);
+    if(!sorted) {
+      fprintf(stderr, "%s: parallel sort with %d threads failed\n",
+              program, threads);
+      failures++;
+      continue;
+    }
+
+    for(i = 0; i < size; i++) {
+      if(sorted[i] != expected[i])
+        break;
+    }
+    if(i < size) {
+      fprintf(stderr,
+              "%s: parallel sort with %d threads differs at row %d: offset %d expected %d\n",
+              program, threads, RASQAL_GOOD_CAST(int, i), sorted[i]->offset,
+              expected[i]->offset);
+      failures++;
+    }
+  }
+
+  /* merge splits of runs of different lengths with many equal keys */
+  if(sort_test_merge_split(rows, 300, 500) ||
+     sort_test_merge_split(rows, 500, 300) ||
+     sort_test_merge_split(rows, 0, 10) ||
+     sort_test_merge_split(rows, 10, 0)) {
+    fprintf(stderr, "%s: merge split differs from the merge\n", program);
+    failures++;
+  }
+
+  tidy:
+  if(rows) {
+    for(i = 0; i < size; i++)
+      rasqal_free_row(rows[i]);
+    RASQAL_FREE(rasqal_row**, rows);
+  }
+  if(expected)
+    RASQAL_FREE(rasqal_row**, expected);
+  if(array)
+    RASQAL_FREE(rasqal_row**, array);
+  if(temp)
+    RASQAL_FREE(rasqal_row**, temp);
+  if(keys)
+    rasqal_engine_free_rowsort_keys(keys);
+  if(order_seq)
+    raptor_free_sequence(order_seq);
+
+  rasqal_free_world(world);
+
+  return failures;
+#else
+  fprintf(stderr, "%s: Skipping test: needs threads\n", program);
+  return 0;
+#endif
+}
+
+#endif /* STANDALONE */
@@ -140,19 +140,20 @@ rasqal_expression_evaluate_from_unixtime(rasqal_expression *e,
 {
   rasqal_world* world = eval_context->world;
   rasqal_literal* l;
-  int unixtime = 0;
+  rasqal_integer unixtime = 0;
   rasqal_xsd_datetime* dt;
   
   l = rasqal_expression_evaluate2(e->arg1, eval_context, error_p);
   if((error_p && *error_p) || !l)
     goto failed;
 
-  unixtime = rasqal_literal_as_integer(l, error_p);
+  unixtime = rasqal_literal_as_integer64(l, error_p);
   rasqal_free_literal(l); l = NULL;
   if(error_p && *error_p)
     goto failed;
 
-  dt = rasqal_new_xsd_datetime_from_unixtime(world, unixtime);
+  dt = rasqal_new_xsd_datetime_from_unixtime(world,
+                                             RASQAL_BAD_CAST(time_t, unixtime));
   if(!dt)
     goto failed;
 
@@ -887,21 +887,24 @@ rasqal_expression_evaluate_bnode_constructor(rasqal_expression *e,
 }
 
 
-/**
- * rasqal_expression_evaluate2:
+/*
+ * rasqal_expression_evaluate_value:
  * @e: The expression to evaluate.
  * @eval_context: expression context
  * @error_p: pointer to error return flag
- * 
- * Evaluate a #rasqal_expression tree in the context of a
- * #rasqal_evaluation_context to give a #rasqal_literal result or error.
- * 
- * Return value: a #rasqal_literal value or NULL (a valid value).  @error_p is set to non-0 on failure.  
- **/
-rasqal_literal*
-rasqal_expression_evaluate2(rasqal_expression* e,
-                            rasqal_evaluation_context* eval_context,
-                            int *error_p)
+ *
+ * INTERNAL - Evaluate an expression to a literal that may be computed
+ *
+ * Operator arguments are evaluated with this so that intermediate
+ * numeric results do not have lexical forms made for them; see
+ * rasqal_literal_ensure_string().
+ *
+ * Return value: a #rasqal_literal value or NULL (a valid value).  @error_p is set to non-0 on failure.
+ */
+static rasqal_literal*
+rasqal_expression_evaluate_value(rasqal_expression* e,
+                                 rasqal_evaluation_context* eval_context,
+                                 int *error_p)
 {
   rasqal_world *world;
   int flags;
@@ -948,7 +951,7 @@ rasqal_expression_evaluate2(rasqal_expression* e,
   switch(e->op) {
     case RASQAL_EXPR_AND:
       errs.errs.e1 = 0;
-      l1 = rasqal_expression_evaluate2(e->arg1, eval_context, &errs.errs.e1);
+      l1 = rasqal_expression_evaluate_value(e->arg1, eval_context, &errs.errs.e1);
       if(errs.errs.e1) {
         vars.bools.b1 = 0;
       } else {
@@ -957,7 +960,7 @@ rasqal_expression_evaluate2(rasqal_expression* e,
       }
 
       errs.errs.e2 = 0;
-      l1 = rasqal_expression_evaluate2(e->arg2, eval_context, &errs.errs.e2);
+      l1 = rasqal_expression_evaluate_value(e->arg2, eval_context, &errs.errs.e2);
       if(errs.errs.e2) {
         vars.bools.b2 = 0;
       } else {
@@ -983,7 +986,7 @@ rasqal_expression_evaluate2(rasqal_expression* e,
       
     case RASQAL_EXPR_OR:
       errs.errs.e1 = 0;
-      l1 = rasqal_expression_evaluate2(e->arg1, eval_context, &errs.errs.e1);
+      l1 = rasqal_expression_evaluate_value(e->arg1, eval_context, &errs.errs.e1);
       if(errs.errs.e1) {
         vars.bools.b1 = 0;
       } else {
@@ -992,7 +995,7 @@ rasqal_expression_evaluate2(rasqal_expression* e,
       }
 
       errs.errs.e2 = 0;
-      l1 = rasqal_expression_evaluate2(e->arg2, eval_context, &errs.errs.e2);
+      l1 = rasqal_expression_evaluate_value(e->arg2, eval_context, &errs.errs.e2);
       if(errs.errs.e2) {
         vars.bools.b2 = 0;
       } else {
@@ -1017,11 +1020,11 @@ rasqal_expression_evaluate2(rasqal_expression* e,
       break;
 
     case RASQAL_EXPR_EQ:
-      l1 = rasqal_expression_evaluate2(e->arg1, eval_context, error_p);
+      l1 = rasqal_expression_evaluate_value(e->arg1, eval_context, error_p);
       if((error_p && *error_p) || !l1)
         goto failed;
 
-      l2 = rasqal_expression_evaluate2(e->arg2, eval_context, error_p);
+      l2 = rasqal_expression_evaluate_value(e->arg2, eval_context, error_p);
       if((error_p && *error_p) || !l2) {
         rasqal_free_literal(l1);
         goto failed;
@@ -1030,8 +1033,10 @@ rasqal_expression_evaluate2(rasqal_expression* e,
       /* FIXME - this should probably be checked at literal creation
        * time
        */
-      if(!rasqal_xsd_datatype_check(l1->type, l1->string, flags) ||
-         !rasqal_xsd_datatype_check(l2->type, l2->string, flags)) {
+      if((l1->string &&
+          !rasqal_xsd_datatype_check(l1->type, l1->string, flags)) ||
+         (l2->string &&
+          !rasqal_xsd_datatype_check(l2->type, l2->string, flags))) {
 #ifdef RASQAL_DEBUG_EVAL
         RASQAL_DEBUG1("One of the literals was invalid\n");
 #endif
@@ -1054,11 +1059,11 @@ rasqal_expression_evaluate2(rasqal_expression* e,
       break;
 
     case RASQAL_EXPR_NEQ:
-      l1 = rasqal_expression_evaluate2(e->arg1, eval_context, error_p);
+      l1 = rasqal_expression_evaluate_value(e->arg1, eval_context, error_p);
       if((error_p && *error_p) || !l1)
         goto failed;
 
-      l2 = rasqal_expression_evaluate2(e->arg2, eval_context, error_p);
+      l2 = rasqal_expression_evaluate_value(e->arg2, eval_context, error_p);
       if((error_p && *error_p) || !l2) {
         rasqal_free_literal(l1);
         goto failed;
@@ -1080,11 +1085,11 @@ rasqal_expression_evaluate2(rasqal_expression* e,
       break;
 
     case RASQAL_EXPR_LT:
-      l1 = rasqal_expression_evaluate2(e->arg1, eval_context, error_p);
+      l1 = rasqal_expression_evaluate_value(e->arg1, eval_context, error_p);
       if((error_p && *error_p) || !l1)
         goto failed;
 
-      l2 = rasqal_expression_evaluate2(e->arg2, eval_context, error_p);
+      l2 = rasqal_expression_evaluate_value(e->arg2, eval_context, error_p);
       if((error_p && *error_p) || !l2) {
         rasqal_free_literal(l1);
         goto failed;
@@ -1100,11 +1105,11 @@ rasqal_expression_evaluate2(rasqal_expression* e,
       break;
 
     case RASQAL_EXPR_GT:
-      l1 = rasqal_expression_evaluate2(e->arg1, eval_context, error_p);
+      l1 = rasqal_expression_evaluate_value(e->arg1, eval_context, error_p);
       if((error_p && *error_p) || !l1)
         goto failed;
 
-      l2 = rasqal_expression_evaluate2(e->arg2, eval_context, error_p);
+      l2 = rasqal_expression_evaluate_value(e->arg2, eval_context, error_p);
       if((error_p && *error_p) || !l2) {
         rasqal_free_literal(l1);
         goto failed;
@@ -1120,11 +1125,11 @@ rasqal_expression_evaluate2(rasqal_expression* e,
       break;
 
     case RASQAL_EXPR_LE:
-      l1 = rasqal_expression_evaluate2(e->arg1, eval_context, error_p);
+      l1 = rasqal_expression_evaluate_value(e->arg1, eval_context, error_p);
       if((error_p && *error_p) || !l1)
         goto failed;
 
-      l2 = rasqal_expression_evaluate2(e->arg2, eval_context, error_p);
+      l2 = rasqal_expression_evaluate_value(e->arg2, eval_context, error_p);
       if((error_p && *error_p) || !l2) {
         rasqal_free_literal(l1);
         goto failed;
@@ -1140,11 +1145,11 @@ rasqal_expression_evaluate2(rasqal_expression* e,
       break;        
 
     case RASQAL_EXPR_GE:
-      l1 = rasqal_expression_evaluate2(e->arg1, eval_context, error_p);
+      l1 = rasqal_expression_evaluate_value(e->arg1, eval_context, error_p);
       if((error_p && *error_p) || !l1)
         goto failed;
 
-      l2 = rasqal_expression_evaluate2(e->arg2, eval_context, error_p);
+      l2 = rasqal_expression_evaluate_value(e->arg2, eval_context, error_p);
       if((error_p && *error_p) || !l2) {
         rasqal_free_literal(l1);
         goto failed;
@@ -1160,7 +1165,7 @@ rasqal_expression_evaluate2(rasqal_expression* e,
       break;
 
     case RASQAL_EXPR_UMINUS:
-      l1 = rasqal_expression_evaluate2(e->arg1, eval_context, error_p);
+      l1 = rasqal_expression_evaluate_value(e->arg1, eval_context, error_p);
       if((error_p && *error_p) || !l1)
         goto failed;
 
@@ -1198,11 +1203,11 @@ rasqal_expression_evaluate2(rasqal_expression* e,
       break;
       
     case RASQAL_EXPR_PLUS:
-      l1 = rasqal_expression_evaluate2(e->arg1, eval_context, error_p);
+      l1 = rasqal_expression_evaluate_value(e->arg1, eval_context, error_p);
       if((error_p && *error_p) || !l1)
         goto failed;
 
-      l2 = rasqal_expression_evaluate2(e->arg2, eval_context, error_p);
+      l2 = rasqal_expression_evaluate_value(e->arg2, eval_context, error_p);
       if((error_p && *error_p) || !l2) {
         rasqal_free_literal(l1);
         goto failed;
@@ -1217,11 +1222,11 @@ rasqal_expression_evaluate2(rasqal_expression* e,
       break;
 
     case RASQAL_EXPR_MINUS:
-      l1 = rasqal_expression_evaluate2(e->arg1, eval_context, error_p);
+      l1 = rasqal_expression_evaluate_value(e->arg1, eval_context, error_p);
       if((error_p && *error_p) || !l1)
         goto failed;
 
-      l2 = rasqal_expression_evaluate2(e->arg2, eval_context, error_p);
+      l2 = rasqal_expression_evaluate_value(e->arg2, eval_context, error_p);
       if((error_p && *error_p) || !l2) {
         rasqal_free_literal(l1);
         goto failed;
@@ -1236,11 +1241,11 @@ rasqal_expression_evaluate2(rasqal_expression* e,
       break;
       
     case RASQAL_EXPR_STAR:
-      l1 = rasqal_expression_evaluate2(e->arg1, eval_context, error_p);
+      l1 = rasqal_expression_evaluate_value(e->arg1, eval_context, error_p);
       if((error_p && *error_p) || !l1)
         goto failed;
 
-      l2 = rasqal_expression_evaluate2(e->arg2, eval_context, error_p);
+      l2 = rasqal_expression_evaluate_value(e->arg2, eval_context, error_p);
       if((error_p && *error_p) || !l2) {
         rasqal_free_literal(l1);
         goto failed;
@@ -1255,11 +1260,11 @@ rasqal_expression_evaluate2(rasqal_expression* e,
       break;
       
     case RASQAL_EXPR_SLASH:
-      l1 = rasqal_expression_evaluate2(e->arg1, eval_context, error_p);
+      l1 = rasqal_expression_evaluate_value(e->arg1, eval_context, error_p);
       if((error_p && *error_p) || !l1)
         goto failed;
 
-      l2 = rasqal_expression_evaluate2(e->arg2, eval_context, error_p);
+      l2 = rasqal_expression_evaluate_value(e->arg2, eval_context, error_p);
       if((error_p && *error_p) || !l2) {
         rasqal_free_literal(l1);
         goto failed;
@@ -1274,11 +1279,11 @@ rasqal_expression_evaluate2(rasqal_expression* e,
       break;
       
     case RASQAL_EXPR_REM:
-      l1 = rasqal_expression_evaluate2(e->arg1, eval_context, error_p);
+      l1 = rasqal_expression_evaluate_value(e->arg1, eval_context, error_p);
       if((error_p && *error_p) || !l1)
         goto failed;
 
-      l2 = rasqal_expression_evaluate2(e->arg2, eval_context, error_p);
+      l2 = rasqal_expression_evaluate_value(e->arg2, eval_context, error_p);
       if((error_p && *error_p) || !l2) {
         rasqal_free_literal(l1);
         goto failed;
@@ -1296,15 +1301,16 @@ rasqal_expression_evaluate2(rasqal_expression* e,
       if(errs.errs.e1 || errs.errs.e2)
         goto failed;
 
-      result = rasqal_new_integer_literal(world, RASQAL_LITERAL_INTEGER, vars.i);
+      result = rasqal_new_computed_integer_literal(world, RASQAL_LITERAL_INTEGER,
+                                                   vars.i);
       break;
       
     case RASQAL_EXPR_STR_EQ:
-      l1 = rasqal_expression_evaluate2(e->arg1, eval_context, error_p);
+      l1 = rasqal_expression_evaluate_value(e->arg1, eval_context, error_p);
       if((error_p && *error_p) || !l1)
         goto failed;
 
-      l2 = rasqal_expression_evaluate2(e->arg2, eval_context, error_p);
+      l2 = rasqal_expression_evaluate_value(e->arg2, eval_context, error_p);
       if((error_p && *error_p) || !l2) {
         rasqal_free_literal(l1);
         goto failed;
@@ -1321,11 +1327,11 @@ rasqal_expression_evaluate2(rasqal_expression* e,
       break;
       
     case RASQAL_EXPR_STR_NEQ:
-      l1 = rasqal_expression_evaluate2(e->arg1, eval_context, error_p);
+      l1 = rasqal_expression_evaluate_value(e->arg1, eval_context, error_p);
       if((error_p && *error_p) || !l1)
         goto failed;
 
-      l2 = rasqal_expression_evaluate2(e->arg2, eval_context, error_p);
+      l2 = rasqal_expression_evaluate_value(e->arg2, eval_context, error_p);
       if((error_p && *error_p) || !l2) {
         rasqal_free_literal(l1);
         goto failed;
@@ -1342,7 +1348,7 @@ rasqal_expression_evaluate2(rasqal_expression* e,
       break;
 
     case RASQAL_EXPR_TILDE:
-      l1 = rasqal_expression_evaluate2(e->arg1, eval_context, error_p);
+      l1 = rasqal_expression_evaluate_value(e->arg1, eval_context, error_p);
       if((error_p && *error_p) || !l1)
         goto failed;
 
@@ -1351,11 +1357,12 @@ rasqal_expression_evaluate2(rasqal_expression* e,
       if(errs.e)
         goto failed;
 
-      result = rasqal_new_integer_literal(world, RASQAL_LITERAL_INTEGER, vars.i);
+      result = rasqal_new_computed_integer_literal(world, RASQAL_LITERAL_INTEGER,
+                                                   vars.i);
       break;
 
     case RASQAL_EXPR_BANG:
-      l1 = rasqal_expression_evaluate2(e->arg1, eval_context, error_p);
+      l1 = rasqal_expression_evaluate_value(e->arg1, eval_context, error_p);
       if((error_p && *error_p) || !l1)
         goto failed;
 
@@ -1389,7 +1396,7 @@ rasqal_expression_evaluate2(rasqal_expression* e,
       break;
       
     case RASQAL_EXPR_CAST:
-      l1 = rasqal_expression_evaluate2(e->arg1, eval_context, error_p);
+      l1 = rasqal_expression_evaluate_value(e->arg1, eval_context, error_p);
       if((error_p && *error_p) || !l1)
         goto failed;
 
@@ -1405,7 +1412,7 @@ rasqal_expression_evaluate2(rasqal_expression* e,
     case RASQAL_EXPR_ORDER_COND_DESC:
     case RASQAL_EXPR_GROUP_COND_ASC:
     case RASQAL_EXPR_GROUP_COND_DESC:
-      result = rasqal_expression_evaluate2(e->arg1, eval_context, error_p);
+      result = rasqal_expression_evaluate_value(e->arg1, eval_context, error_p);
       break;
 
     case RASQAL_EXPR_COUNT:
@@ -1600,6 +1607,37 @@ rasqal_expression_evaluate2(rasqal_expression* e,
 }
 
 
+/**
+ * rasqal_expression_evaluate2:
+ * @e: The expression to evaluate.
+ * @eval_context: expression context
+ * @error_p: pointer to error return flag
+ * 
+ * Evaluate a #rasqal_expression tree in the context of a
+ * #rasqal_evaluation_context to give a #rasqal_literal result or error.
+ * 
+ * Return value: a #rasqal_literal value or NULL (a valid value).  @error_p is set to non-0 on failure.  
+ **/
+rasqal_literal*
+rasqal_expression_evaluate2(rasqal_expression* e,
+                            rasqal_evaluation_context* eval_context,
+                            int *error_p)
+{
+  rasqal_literal* result;
+
+  result = rasqal_expression_evaluate_value(e, eval_context, error_p);
+
+  /* results leave the evaluator with a lexical form */
+  if(result && rasqal_literal_ensure_string(result)) {
+    rasqal_free_literal(result);
+    result = NULL;
+    *error_p = 1;
+  }
+
+  return result;
+}
+
+
 #ifndef RASQAL_DISABLE_DEPRECATED
 /**
  * rasqal_expression_evaluate:
@@ -44,6 +44,179 @@
 #define DEBUG_FH stderr
 
 
+/*
+ * String kernels
+ *
+ * These work on counted strings a machine word at a time where they
+ * can, and share cached knowledge of whether a literal string is all
+ * ASCII, where character and byte offsets are the same.
+ */
+
+/* 0x0101..01 and 0x8080..80 in a size_t */
+#define STRINGS_WORD_ONES (~RASQAL_GOOD_CAST(size_t, 0) / 0xFF)
+#define STRINGS_WORD_HIGH_BITS (STRINGS_WORD_ONES * 0x80)
+
+
+/*
+ * rasqal_strings_is_ascii:
+ * @s: string
+ * @len: length of @s in bytes
+ *
+ * INTERNAL - Check if a counted string has only ASCII characters
+ *
+ * Return value: non-0 if all bytes of @s are ASCII
+ */
+static int
+rasqal_strings_is_ascii(const unsigned char* s, size_t len)
+{
+  size_t w;
+
+  for(; len >= sizeof(w); s += sizeof(w), len -= sizeof(w)) {
+    memcpy(&w, s, sizeof(w));
+    if(w & STRINGS_WORD_HIGH_BITS)
+      return 0;
+  }
+
+  for(; len; s++, len--) {
+    if(*s & 0x80)
+      return 0;
+  }
+
+  return 1;
+}
+
+
+/*
+ * rasqal_strings_literal_is_ascii:
+ * @l: literal
+ * @s: string form of @l from rasqal_literal_as_counted_string()
+ * @len: length of @s in bytes
+ *
+ * INTERNAL - Check if a literal string form has only ASCII characters
+ *
+ * When @s is the literal's own string the answer is cached in the
+ * literal for the next string function that sees it.
+ *
+ * Return value: non-0 if all bytes of @s are ASCII
+ */
+static int
+rasqal_strings_literal_is_ascii(rasqal_literal* l, const unsigned char* s,
+                                size_t len)
+{
+  if(s != l->string)
+    return rasqal_strings_is_ascii(s, len);
+
+  if(!l->ascii)
+    l->ascii = rasqal_strings_is_ascii(s, len) ? 1 : -1;
+
+  return (l->ascii > 0);
+}
+
+
+/*
+ * rasqal_strings_set_case:
+ * @dest: destination buffer of at least @len bytes
+ * @src: source string
+ * @len: length of @src in bytes
+ * @upper: non-0 to map to upper case, 0 to lower case
+ *
+ * INTERNAL - Map the case of the ASCII letters in a UTF-8 string
+ *
+ * Other bytes, including all bytes of multi-byte UTF-8 sequences,
+ * are copied unchanged.
+ */
+static void
+rasqal_strings_set_case(unsigned char* dest, const unsigned char* src,
+                        size_t len, int upper)
+{
+  unsigned char first = upper ? 'a' : 'A';
+  /* adding these to a byte under 0x80 sets its high bit when the byte
+   * is at least the first letter and after the last letter respectively */
+  size_t from_first = STRINGS_WORD_ONES * RASQAL_GOOD_CAST(size_t, 0x80 - first);
+  size_t after_last = STRINGS_WORD_ONES * RASQAL_GOOD_CAST(size_t, 0x80 - (first + 26));
+  size_t w;
+
+  for(; len >= sizeof(w); src += sizeof(w), dest += sizeof(w), len -= sizeof(w)) {
+    size_t low;
+    size_t letters;
+
+    memcpy(&w, src, sizeof(w));
+    low = w & ~STRINGS_WORD_HIGH_BITS;
+    letters = (low + from_first) & ~(low + after_last) & ~w &
+              STRINGS_WORD_HIGH_BITS;
+    /* 0x80 >> 2 is the 0x20 case bit */
+    w ^= letters >> 2;
+    memcpy(dest, &w, sizeof(w));
+  }
+
+  for(; len; src++, dest++, len--) {
+    unsigned char c = *src;
+
+    if(RASQAL_GOOD_CAST(unsigned char, c - first) < 26)
+      c ^= 0x20;
+    *dest = c;
+  }
+}
+
+
+/*
+ * rasqal_strings_find:
+ * @haystack: string to search
+ * @haystack_len: length of @haystack in bytes
+ * @needle: string to find
+ * @needle_len: length of @needle in bytes
+ *
+ * INTERNAL - Find the first occurrence of a counted string in another
+ *
+ * Candidates are found with memchr() on the first needle byte which
+ * the C library scans a word or vector at a time.
+ *
+ * Return value: pointer to the match in @haystack or NULL
+ */
+static const unsigned char*
+rasqal_strings_find(const unsigned char* haystack, size_t haystack_len,
+                    const unsigned char* needle, size_t needle_len)
+{
+  const unsigned char* p = haystack;
+  const unsigned char* last;
+
+  if(!needle_len)
+    return haystack;
+
+  if(needle_len > haystack_len)
+    return NULL;
+
+  last = haystack + (haystack_len - needle_len);
+  while(p <= last) {
+    p = RASQAL_GOOD_CAST(const unsigned char*,
+                         memchr(p, *needle, RASQAL_GOOD_CAST(size_t, last - p) + 1));
+    if(!p)
+      break;
+
+    if(!memcmp(p + 1, needle + 1, needle_len - 1))
+      return p;
+    p++;
+  }
+
+  return NULL;
+}
+
+
+/*
+ * rasqal_strings_is_plain_pattern:
+ * @pattern: regex pattern
+ *
+ * INTERNAL - Check if a regex pattern has no regex metacharacters
+ *
+ * Return value: non-0 if @pattern matches only itself as a substring
+ */
+static int
+rasqal_strings_is_plain_pattern(const char* pattern)
+{
+  return !pattern[strcspn(pattern, "\\^$.|?*+()[]{}")];
+}
+
+
 /* 
  * rasqal_expression_evaluate_strlen:
  * @e: The expression to evaluate.
@@ -62,20 +235,24 @@ rasqal_expression_evaluate_strlen(rasqal_expression *e,
   rasqal_literal* l1;
   rasqal_literal* result = NULL;
   const unsigned char *s;
+  size_t s_len = 0;
   int len = 0;
   
   l1 = rasqal_expression_evaluate2(e->arg1, eval_context, error_p);
   if((error_p && *error_p) || !l1)
     goto failed;
   
-  s = rasqal_literal_as_string_flags(l1, eval_context->flags, error_p);
+  s = rasqal_literal_as_counted_string(l1, &s_len, eval_context->flags,
+                                       error_p);
   if(error_p && *error_p)
     goto failed;
 
   if(!s)
     len = 0;
+  else if(rasqal_strings_literal_is_ascii(l1, s, s_len))
+    len = RASQAL_GOOD_CAST(int, s_len);
   else
-    len = raptor_unicode_utf8_strlen(s, strlen(RASQAL_GOOD_CAST(const char*, s)));
+    len = raptor_unicode_utf8_strlen(s, s_len);
   
 
   result = rasqal_new_numeric_literal_from_long(world, RASQAL_LITERAL_INTEGER,
@@ -119,6 +296,8 @@ rasqal_expression_evaluate_substr(rasqal_expression *e,
   size_t len = 0;
   int startingLoc = 0;
   int length = -1;
+  int ascii;
+  rasqal_literal* result;
   
   /* haystack string */
   l1 = rasqal_expression_evaluate2(e->arg1, eval_context, error_p);
@@ -150,14 +329,33 @@ rasqal_expression_evaluate_substr(rasqal_expression *e,
 
   }
   
-  new_s = RASQAL_MALLOC(unsigned char*, len + 1);
-  if(!new_s)
-    goto failed;
+  ascii = rasqal_strings_literal_is_ascii(l1, s, len);
+  if(ascii && startingLoc >= 1 &&
+     RASQAL_GOOD_CAST(size_t, startingLoc) <= len &&
+     (!e->arg3 || length > 0)) {
+    /* ASCII with a non-empty result: characters are bytes */
+    size_t offset = RASQAL_GOOD_CAST(size_t, startingLoc - 1);
+    size_t sub_len = len - offset;
+
+    if(e->arg3 && RASQAL_GOOD_CAST(size_t, length) < sub_len)
+      sub_len = RASQAL_GOOD_CAST(size_t, length);
+
+    new_s = RASQAL_MALLOC(unsigned char*, sub_len + 1);
+    if(!new_s)
+      goto failed;
 
-  /* adjust starting index to xsd fn:substring initial offset 1 */
-  if(!raptor_unicode_utf8_substr(new_s, /* dest_length_p */ NULL,
-                                 s, len, startingLoc - 1, length))
-    goto failed;
+    memcpy(new_s, s + offset, sub_len);
+    new_s[sub_len] = '\0';
+  } else {
+    new_s = RASQAL_MALLOC(unsigned char*, len + 1);
+    if(!new_s)
+      goto failed;
+
+    /* adjust starting index to xsd fn:substring initial offset 1 */
+    if(!raptor_unicode_utf8_substr(new_s, /* dest_length_p */ NULL,
+                                   s, len, startingLoc - 1, length))
+      goto failed;
+  }
 
   if(l1->language) {
     len = strlen(RASQAL_GOOD_CAST(const char*, l1->language));
@@ -178,15 +376,22 @@ rasqal_expression_evaluate_substr(rasqal_expression *e,
     rasqal_free_literal(l3);
 
   /* after this new_s, new_lang and dt_uri become owned by result */
-  return rasqal_new_string_literal(world, new_s, new_lang, dt_uri,
-                                   /* qname */ NULL);
-  
+  result = rasqal_new_string_literal(world, new_s, new_lang, dt_uri,
+                                     /* qname */ NULL);
+  if(result && ascii)
+    result->ascii = 1;
+
+  return result;
 
 
   failed:
   if(error_p)
     *error_p = 1;
   
+  if(new_s)
+    RASQAL_FREE(char*, new_s);
+  if(new_lang)
+    RASQAL_FREE(char*, new_lang);
   if(l1)
     rasqal_free_literal(l1);
   if(l2)
@@ -220,6 +425,8 @@ rasqal_expression_evaluate_set_case(rasqal_expression *e,
   char* new_lang = NULL;
   raptor_uri* dt_uri = NULL;
   size_t len = 0;
+  int ascii = 0;
+  rasqal_literal* result;
   
   l1 = rasqal_expression_evaluate2(e->arg1, eval_context, error_p);
   if((error_p && *error_p) || !l1)
@@ -233,27 +440,13 @@ rasqal_expression_evaluate_set_case(rasqal_expression *e,
   if(!new_s)
     goto failed;
 
-  if(e->op == RASQAL_EXPR_UCASE) {
-    unsigned int i;
-    
-    for(i = 0; i < len; i++) {
-      unsigned char c = s[i];
-      if(islower(RASQAL_GOOD_CAST(int, c)))
-        c = RASQAL_GOOD_CAST(unsigned char, toupper(RASQAL_GOOD_CAST(int, c)));
-      new_s[i] = c;
-    }
-  } else { /* RASQAL_EXPR_LCASE */
-    unsigned int i;
-
-    for(i = 0; i < len; i++) {
-      unsigned char c = s[i];
-      if(isupper(RASQAL_GOOD_CAST(int, c)))
-        c = RASQAL_GOOD_CAST(unsigned char, tolower(RASQAL_GOOD_CAST(int, c)));
-      new_s[i] = c;
-    }
-  }
+  rasqal_strings_set_case(new_s, s, len, (e->op == RASQAL_EXPR_UCASE));
   new_s[len] = '\0';
 
+  /* only ASCII letters change so the result is ASCII if l1 was */
+  if(s == l1->string)
+    ascii = l1->ascii;
+
   if(l1->language) {
     len = strlen(RASQAL_GOOD_CAST(const char*, l1->language));
     new_lang = RASQAL_MALLOC(char*, len + 1);
@@ -270,8 +463,12 @@ rasqal_expression_evaluate_set_case(rasqal_expression *e,
   rasqal_free_literal(l1);
 
   /* after this new_s, new_lang and dt_uri become owned by result */
-  return rasqal_new_string_literal(world, new_s, new_lang, dt_uri,
-                                   /* qname */ NULL);
+  result = rasqal_new_string_literal(world, new_s, new_lang, dt_uri,
+                                     /* qname */ NULL);
+  if(result)
+    result->ascii = ascii;
+
+  return result;
   
   
   failed:
@@ -405,9 +602,7 @@ rasqal_expression_evaluate_str_prefix_suffix(rasqal_expression *e,
     } else if(e->op == RASQAL_EXPR_STRENDS) {
       b = !memcmp(s1 + len1 - len2, s2, len2);
     } else { /* RASQAL_EXPR_CONTAINS */
-      /* b = (strnstr(RASQAL_GOOD_CAST(const char*, s1), RASQAL_GOOD_CAST(const char*, s2), len2) != NULL); */
-      b = (strstr(RASQAL_GOOD_CAST(const char*, s1),
-                  RASQAL_GOOD_CAST(const char*, s2)) != NULL);
+      b = (rasqal_strings_find(s1, len1, s2, len2) != NULL);
     }
   }
   
@@ -825,9 +1020,16 @@ rasqal_expression_evaluate_strmatch(rasqal_expression *e,
   }
   pattern = RASQAL_GOOD_CAST(const char*, l2->string);
 
-  rc = rasqal_regex_match(world, eval_context->locator,
-                          pattern, regex_flags,
-                          match_string, match_len);
+  if(pattern && (!regex_flags || !*regex_flags) &&
+     rasqal_strings_is_plain_pattern(pattern)) {
+    /* no metacharacters or flags: a regex match is a substring search */
+    rc = (rasqal_strings_find(l1_str, match_len,
+                              RASQAL_GOOD_CAST(const unsigned char*, pattern),
+                              strlen(pattern)) != NULL);
+  } else
+    rc = rasqal_regex_match(world, eval_context->locator,
+                            pattern, regex_flags,
+                            match_string, match_len);
 
 #ifdef RASQAL_DEBUG
   if(rc >= 0)
@@ -881,7 +1083,7 @@ rasqal_expression_evaluate_strbefore(rasqal_expression *e,
   const unsigned char *needle;
   size_t haystack_len;
   size_t needle_len;
-  const char *ptr;
+  const unsigned char *ptr;
   unsigned char* result;
   size_t result_len;
   char* new_lang = NULL;
@@ -929,10 +1131,9 @@ rasqal_expression_evaluate_strbefore(rasqal_expression *e,
   if((error_p && *error_p) || !needle)
     goto failed;
 
-  ptr = strstr(RASQAL_GOOD_CAST(const char*, haystack), 
-               RASQAL_GOOD_CAST(const char*, needle));
+  ptr = rasqal_strings_find(haystack, haystack_len, needle, needle_len);
   if(ptr) {
-    result_len = RASQAL_GOOD_CAST(size_t, ptr - RASQAL_GOOD_CAST(const char*, haystack));
+    result_len = RASQAL_GOOD_CAST(size_t, ptr - haystack);
 
     if(l1->language) {
       size_t len = strlen(RASQAL_GOOD_CAST(const char*, l1->language));
@@ -942,14 +1143,10 @@ rasqal_expression_evaluate_strbefore(rasqal_expression *e,
 
       memcpy(new_lang, l1->language, len + 1);
     }
-  } else {
+  } else
     result_len = 0;
-    haystack = RASQAL_GOOD_CAST(const unsigned char *, "");
-  }
-
-  rasqal_free_literal(l1); l1 = NULL;
-  rasqal_free_literal(l2); l2 = NULL;
 
+  /* copy before freeing l1 which owns haystack */
   result = RASQAL_MALLOC(unsigned char*, result_len + 1);
   if(!result)
     goto failed;
@@ -958,6 +1155,9 @@ rasqal_expression_evaluate_strbefore(rasqal_expression *e,
     memcpy(result, haystack, result_len);
   result[result_len] = '\0';
 
+  rasqal_free_literal(l1); l1 = NULL;
+  rasqal_free_literal(l2); l2 = NULL;
+
   return rasqal_new_string_literal(world, result, 
                                    new_lang,
                                    /* datatype */ NULL,
@@ -1001,7 +1201,7 @@ rasqal_expression_evaluate_strafter(rasqal_expression *e,
   const unsigned char *needle;
   size_t haystack_len;
   size_t needle_len;
-  const char *ptr;
+  const unsigned char *ptr;
   unsigned char* result;
   size_t result_len;
   char* new_lang = NULL;
@@ -1050,11 +1250,10 @@ rasqal_expression_evaluate_strafter(rasqal_expression *e,
   if((error_p && *error_p) || !needle)
     goto failed;
 
-  ptr = strstr(RASQAL_GOOD_CAST(const char*, haystack),
-               RASQAL_GOOD_CAST(const char*, needle));
+  ptr = rasqal_strings_find(haystack, haystack_len, needle, needle_len);
   if(ptr) {
     ptr += needle_len;
-    result_len = haystack_len - RASQAL_GOOD_CAST(size_t, (ptr - RASQAL_GOOD_CAST(const char*, haystack)));
+    result_len = haystack_len - RASQAL_GOOD_CAST(size_t, (ptr - haystack));
 
     if(l1->language) {
       size_t len = strlen(RASQAL_GOOD_CAST(const char*, l1->language));
@@ -1064,14 +1263,10 @@ rasqal_expression_evaluate_strafter(rasqal_expression *e,
 
       memcpy(new_lang, l1->language, len + 1);
     }
-  } else {
-    ptr = (const char *)"";
+  } else
     result_len = 0;
-  }
-
-  rasqal_free_literal(l1); l1 = NULL;
-  rasqal_free_literal(l2); l2 = NULL;
 
+  /* copy before freeing l1 which owns haystack */
   result = RASQAL_MALLOC(unsigned char*, result_len + 1);
   if(!result)
     goto failed;
@@ -1080,6 +1275,9 @@ rasqal_expression_evaluate_strafter(rasqal_expression *e,
     memcpy(result, ptr, result_len);
   result[result_len] = '\0';
 
+  rasqal_free_literal(l1); l1 = NULL;
+  rasqal_free_literal(l2); l2 = NULL;
+
   return rasqal_new_string_literal(world, result, 
                                    new_lang,
                                    /* datatype */ NULL,
@@ -57,7 +57,13 @@ static const struct
   const char *label;
 } rasqal_features_list [RASQAL_FEATURE_LAST + 1]= {
   { RASQAL_FEATURE_NO_NET,    1,  "noNet",    "Deny network requests." } ,
-  { RASQAL_FEATURE_RAND_SEED, 1,  "randSeed", "Set rand() seed." }
+  { RASQAL_FEATURE_RAND_SEED, 1,  "randSeed", "Set rand() seed." },
+  { RASQAL_FEATURE_SERVICE_BATCH_SIZE, 1, "serviceBatchSize", "Bindings sent per SERVICE request." },
+  { RASQAL_FEATURE_SERVICE_CONCURRENCY, 1, "serviceConcurrency", "Maximum SERVICE requests at once." },
+  { RASQAL_FEATURE_SERVICE_TIMEOUT, 1, "serviceTimeout", "SERVICE connection timeout in seconds." },
+  { RASQAL_FEATURE_TABLE_LOOKAHEAD, 1, "tableLookahead", "Rows read to size table columns." },
+  { RASQAL_FEATURE_CONSTRUCT_DISTINCT, 1, "constructDistinct", "Recent CONSTRUCT triples checked for repeats." },
+  { RASQAL_FEATURE_APPROX_COUNT_DISTINCT, 1, "approxCountDistinct", "Estimate COUNT(DISTINCT) with 2^N registers." }
 };
 
 
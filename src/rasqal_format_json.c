@@ -41,6 +41,8 @@
 #include "rasqal_internal.h"
 
 
+#ifndef STANDALONE
+
 static void
 rasqal_iostream_write_json_boolean(raptor_iostream* iostr, 
                                    const char* name, int json_bool)
@@ -255,51 +257,1666 @@ rasqal_query_results_write_json1(rasqal_query_results_formatter* formatter,
 }
 
 
-static const char* const json_names[] = { "json", NULL};
+/*
+ * SPARQL JSON results reader
+ *
+ * The input is read into a buffer in large blocks and parsed in
+ * place, one result object at a time, straight into rasqal_literal
+ * values: there is no intermediate document tree and strings without
+ * escapes are copied once from the buffer into their literal.  When
+ * a result is cut off by the end of the buffer, more input is read
+ * and the result is parsed again from its start.
+ *
+ * Results usually follow the head but a results member before the
+ * head is kept in the buffer and read again once the head is known.
+ */
 
-static const char* const json_uri_strings[] = {
-  "http://www.w3.org/ns/formats/SPARQL_Results_JSON",
-  /* W3C Working Draft */
-  "http://www.w3.org/TR/sparql11-results-json/",
-  /* W3C Working Group Note */
-  "http://www.w3.org/TR/rdf-sparql-json-res/",
-  /* Released DAWG WG results in JSON */
-  "http://www.w3.org/TR/2007/NOTE-rdf-sparql-json-res-20070618/",
-  /* URIs from 0.9.16 or earlier */
-  "http://www.w3.org/2001/sw/DataAccess/json-sparql/",
-  "http://www.mindswap.org/%7Ekendall/sparql-results-json/",
-  NULL
-};
+/* bytes read from the iostream at a time */
+#define RASQAL_JSON_READ_SIZE 65536
+
+typedef enum {
+  RASQAL_JSON_OK,
+  /* the value continues past the end of the buffer */
+  RASQAL_JSON_MORE,
+  RASQAL_JSON_ERROR
+} rasqal_json_status;
+
+
+typedef enum {
+  RASQAL_JSON_STATE_START,
+  /* in the top level object */
+  RASQAL_JSON_STATE_TOP,
+  /* at the value of the results member */
+  RASQAL_JSON_STATE_RESULTS_START,
+  /* in the results object */
+  RASQAL_JSON_STATE_RESULTS,
+  /* in the bindings array */
+  RASQAL_JSON_STATE_BINDINGS,
+  RASQAL_JSON_STATE_END
+} rasqal_json_state;
+
+
+typedef struct
+{
+  rasqal_world* world;
+  rasqal_rowsource* rowsource;
+
+  int failed;
+
+  /* Input fields */
+  raptor_uri* base_uri;
+  raptor_iostream* iostr;
+
+  raptor_locator locator;
+
+  /* input buffer and parse position in it */
+  char* buffer;
+  size_t buffer_size;
+  size_t length;
+  size_t pos;
+  /* bytes removed from the start of the buffer */
+  size_t consumed;
+  int eof;
+
+  rasqal_json_state state;
+
+  /* head has been read */
+  int head_done;
+  /* set when a results member was found before the head */
+  int results_deferred;
+  /* buffer offset of the deferred results value */
+  size_t results_offset;
+
+  /* variable names and lengths in rowsource order */
+  const unsigned char** var_names;
+  size_t* var_lengths;
+  int variables_count;
+
+  /* current result row number */
+  int offset;
+
+  /* result row that has been read */
+  rasqal_row* row;
+
+  /* boolean result or -1 if none */
+  int boolean_value;
+
+  /* last datatype URI seen, reused for following literals */
+  raptor_uri* datatype_uri;
+
+  /* Variables table allocated for variables in the result set */
+  rasqal_variables_table* vars_table;
+
+  unsigned int flags;
+} rasqal_rowsource_json_context;
+
+
+/* A string token in the buffer */
+typedef struct
+{
+  size_t start;
+  size_t length;
+  /* non-0 if the string contains backslash escapes */
+  int escaped;
+} rasqal_json_string;
+
+
+static rasqal_json_status
+rasqal_json_skip_ws(rasqal_rowsource_json_context* con, size_t* p)
+{
+  size_t i = *p;
+
+  while(i < con->length) {
+    char c = con->buffer[i];
+
+    if(c != ' ' && c != '\t' && c != '\n' && c != '\r') {
+      *p = i;
+      return RASQAL_JSON_OK;
+    }
+    i++;
+  }
+
+  *p = i;
+
+  return con->eof ? RASQAL_JSON_ERROR : RASQAL_JSON_MORE;
+}
+
+
+static rasqal_json_status
+rasqal_json_expect(rasqal_rowsource_json_context* con, size_t* p, char c)
+{
+  rasqal_json_status status;
+
+  status = rasqal_json_skip_ws(con, p);
+  if(status != RASQAL_JSON_OK)
+    return status;
+
+  if(con->buffer[*p] != c)
+    return RASQAL_JSON_ERROR;
+
+  (*p)++;
+
+  return RASQAL_JSON_OK;
+}
+
+
+/*
+ * rasqal_json_scan_string:
+ *
+ * INTERNAL - Find the extent of the string token at *p
+ */
+static rasqal_json_status
+rasqal_json_scan_string(rasqal_rowsource_json_context* con, size_t* p,
+                        rasqal_json_string* str)
+{
+  rasqal_json_status status;
+  size_t i;
+
+  status = rasqal_json_expect(con, p, '"');
+  if(status != RASQAL_JSON_OK)
+    return status;
+
+  str->start = *p;
+  str->escaped = 0;
+
+  for(i = *p; i < con->length; i++) {
+    char c = con->buffer[i];
+
+    if(c == '"') {
+      str->length = i - str->start;
+      *p = i + 1;
+      return RASQAL_JSON_OK;
+    }
+
+    if(c == '\\') {
+      str->escaped = 1;
+      i++;
+    }
+  }
+
+  return con->eof ? RASQAL_JSON_ERROR : RASQAL_JSON_MORE;
+}
+
+
+/*
+ * rasqal_json_scan_key:
+ *
+ * INTERNAL - Read an object member name and the following ':'
+ */
+static rasqal_json_status
+rasqal_json_scan_key(rasqal_rowsource_json_context* con, size_t* p,
+                     rasqal_json_string* key)
+{
+  rasqal_json_status status;
+
+  status = rasqal_json_scan_string(con, p, key);
+  if(status != RASQAL_JSON_OK)
+    return status;
+
+  return rasqal_json_expect(con, p, ':');
+}
 
-static const raptor_type_q json_types[] = {
-  { "application/sparql-results+json", 31, 10},
-  { "application/json", 16, 10}, 
-  { NULL, 0, 0}
-};
 
 static int
-rasqal_query_results_json_register_factory(rasqal_query_results_format_factory *factory) 
+rasqal_json_string_equals(rasqal_rowsource_json_context* con,
+                          rasqal_json_string* str,
+                          const char* value, size_t value_len)
 {
-  int rc = 0;
+  return str->length == value_len &&
+    !memcmp(con->buffer + str->start, value, value_len);
+}
 
-  factory->desc.names = json_names;
-  factory->desc.mime_types = json_types;
 
-  factory->desc.label = "SPARQL JSON Query Results";
-  factory->desc.uri_strings = json_uri_strings;
+static int
+rasqal_json_hex_value(const char* p, int count, unsigned long* value_p)
+{
+  unsigned long value = 0;
+  int i;
 
-  factory->desc.flags = 0;
-  
-  factory->write         = rasqal_query_results_write_json1;
-  factory->get_rowsource = NULL;
+  for(i = 0; i < count; i++) {
+    char c = p[i];
 
-  return rc;
+    value <<= 4;
+    if(c >= '0' && c <= '9')
+      value += RASQAL_GOOD_CAST(unsigned long, c - '0');
+    else if(c >= 'a' && c <= 'f')
+      value += RASQAL_GOOD_CAST(unsigned long, c - 'a' + 10);
+    else if(c >= 'A' && c <= 'F')
+      value += RASQAL_GOOD_CAST(unsigned long, c - 'A' + 10);
+    else
+      return 1;
+  }
+
+  *value_p = value;
+
+  return 0;
 }
 
 
-int
-rasqal_init_result_format_json(rasqal_world* world)
+/*
+ * rasqal_json_decode_string:
+ * @con: JSON reader context
+ * @str: string token
+ * @len_p: pointer to store decoded length (or NULL)
+ *
+ * INTERNAL - Make a new UTF-8 string from a string token
+ *
+ * Both JSON \uXXXX escapes (with surrogate pairs) and the N-Triples
+ * \UXXXXXXXX escapes written by older versions of the JSON results
+ * writer are decoded.  Escapes of U+0000 and of unpaired surrogates
+ * are errors.
+ *
+ * Return value: new string or NULL on failure
+ */
+static unsigned char*
+rasqal_json_decode_string(rasqal_rowsource_json_context* con,
+                          rasqal_json_string* str, size_t* len_p)
 {
-  return !rasqal_world_register_query_results_format_factory(world,
-                                                             &rasqal_query_results_json_register_factory);
+  const char* src = con->buffer + str->start;
+  const char* end = src + str->length;
+  unsigned char* string;
+  unsigned char* dest;
+
+  /* Decoding never makes a string longer */
+  string = RASQAL_MALLOC(unsigned char*, str->length + 1);
+  if(!string)
+    return NULL;
+
+  if(!str->escaped) {
+    memcpy(string, src, str->length);
+    string[str->length] = '\0';
+    if(len_p)
+      *len_p = str->length;
+    return string;
+  }
+
+  dest = string;
+  while(src < end) {
+    unsigned long unichar;
+    char c = *src++;
+
+    if(c != '\\') {
+      *dest++ = RASQAL_GOOD_CAST(unsigned char, c);
+      continue;
+    }
+
+    if(src == end)
+      goto failed;
+
+    c = *src++;
+    switch(c) {
+      case '"':
+      case '\\':
+      case '/':
+        *dest++ = RASQAL_GOOD_CAST(unsigned char, c);
+        continue;
+
+      case 'b':
+        *dest++ = '\b';
+        continue;
+
+      case 'f':
+        *dest++ = '\f';
+        continue;
+
+      case 'n':
+        *dest++ = '\n';
+        continue;
+
+      case 'r':
+        *dest++ = '\r';
+        continue;
+
+      case 't':
+        *dest++ = '\t';
+        continue;
+
+      case 'u':
+        if(end - src < 4 || rasqal_json_hex_value(src, 4, &unichar))
+          goto failed;
+        src += 4;
+
+        if(unichar >= 0xD800 && unichar <= 0xDBFF) {
+          unsigned long low;
+
+          /* high surrogate must be followed by a low surrogate */
+          if(end - src < 6 || src[0] != '\\' || src[1] != 'u' ||
+             rasqal_json_hex_value(src + 2, 4, &low) ||
+             low < 0xDC00 || low > 0xDFFF)
+            goto failed;
+          src += 6;
+
+          unichar = 0x10000 + ((unichar - 0xD800) << 10) + (low - 0xDC00);
+        } else if(unichar >= 0xDC00 && unichar <= 0xDFFF)
+          /* low surrogate on its own */
+          goto failed;
+        break;
+
+      case 'U':
+        if(end - src < 8 || rasqal_json_hex_value(src, 8, &unichar))
+          goto failed;
+        src += 8;
+        break;
+
+      default:
+        goto failed;
+    }
+
+    /* U+0000 would end the string early */
+    if(!unichar || unichar > 0x10FFFF)
+      goto failed;
+
+    dest += raptor_unicode_utf8_string_put_char(RASQAL_GOOD_CAST(raptor_unichar, unichar),
+                                                dest, 4);
+  }
+
+  *dest = '\0';
+  if(len_p)
+    *len_p = RASQAL_GOOD_CAST(size_t, dest - string);
+
+  return string;
+
+  failed:
+  RASQAL_FREE(char*, string);
+
+  return NULL;
+}
+
+
+/*
+ * rasqal_json_skip_value:
+ *
+ * INTERNAL - Move past the JSON value at *p
+ */
+static rasqal_json_status
+rasqal_json_skip_value(rasqal_rowsource_json_context* con, size_t* p)
+{
+  rasqal_json_status status;
+  rasqal_json_string str;
+  size_t i;
+  char c;
+
+  status = rasqal_json_skip_ws(con, p);
+  if(status != RASQAL_JSON_OK)
+    return status;
+
+  i = *p;
+  c = con->buffer[i];
+
+  if(c == '"')
+    return rasqal_json_scan_string(con, p, &str);
+
+  if(c == '{' || c == '[') {
+    int depth = 0;
+
+    for(; i < con->length; i++) {
+      c = con->buffer[i];
+
+      if(c == '"') {
+        /* skip string contents which may include brackets */
+        for(i++; i < con->length && con->buffer[i] != '"'; i++) {
+          if(con->buffer[i] == '\\')
+            i++;
+        }
+        if(i >= con->length)
+          break;
+      } else if(c == '{' || c == '[') {
+        depth++;
+      } else if(c == '}' || c == ']') {
+        if(!--depth) {
+          *p = i + 1;
+          return RASQAL_JSON_OK;
+        }
+      }
+    }
+
+    return con->eof ? RASQAL_JSON_ERROR : RASQAL_JSON_MORE;
+  }
+
+  if(c == 't' || c == 'f' || c == 'n') {
+    const char* word = (c == 't') ? "true" : (c == 'f') ? "false" : "null";
+    size_t len = strlen(word);
+
+    if(con->length - i < len)
+      return con->eof ? RASQAL_JSON_ERROR : RASQAL_JSON_MORE;
+
+    if(memcmp(con->buffer + i, word, len))
+      return RASQAL_JSON_ERROR;
+
+    *p = i + len;
+    return RASQAL_JSON_OK;
+  }
+
+  if(c == '-' || (c >= '0' && c <= '9')) {
+    for(; i < con->length; i++) {
+      c = con->buffer[i];
+      if(!((c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' ||
+           c == 'e' || c == 'E'))
+        break;
+    }
+
+    /* a number at the end of the buffer may continue */
+    if(i == con->length && !con->eof)
+      return RASQAL_JSON_MORE;
+
+    *p = i;
+    return RASQAL_JSON_OK;
+  }
+
+  return RASQAL_JSON_ERROR;
+}
+
+
+/*
+ * rasqal_json_parse_head:
+ *
+ * INTERNAL - Read the head object and add its variables to the rowsource
+ *
+ * Adding a variable again when the head is parsed again after more
+ * input is read does nothing.
+ */
+static rasqal_json_status
+rasqal_json_parse_head(rasqal_rowsource_json_context* con, size_t* p)
+{
+  rasqal_json_status status;
+
+  /* reading a boolean result */
+  if(!con->rowsource)
+    return rasqal_json_skip_value(con, p);
+
+  status = rasqal_json_expect(con, p, '{');
+
+  while(status == RASQAL_JSON_OK) {
+    rasqal_json_string key;
+    char c;
+
+    status = rasqal_json_skip_ws(con, p);
+    if(status != RASQAL_JSON_OK)
+      break;
+
+    c = con->buffer[*p];
+    if(c == ',') {
+      (*p)++;
+      continue;
+    }
+    if(c == '}') {
+      (*p)++;
+      break;
+    }
+
+    status = rasqal_json_scan_key(con, p, &key);
+    if(status != RASQAL_JSON_OK)
+      break;
+
+    if(!rasqal_json_string_equals(con, &key, "vars", 4)) {
+      status = rasqal_json_skip_value(con, p);
+      continue;
+    }
+
+    status = rasqal_json_expect(con, p, '[');
+    while(status == RASQAL_JSON_OK) {
+      rasqal_json_string name;
+      unsigned char* name_str;
+      size_t name_len;
+      rasqal_variable* v;
+
+      status = rasqal_json_skip_ws(con, p);
+      if(status != RASQAL_JSON_OK)
+        break;
+
+      c = con->buffer[*p];
+      if(c == ',') {
+        (*p)++;
+        continue;
+      }
+      if(c == ']') {
+        (*p)++;
+        break;
+      }
+
+      status = rasqal_json_scan_string(con, p, &name);
+      if(status != RASQAL_JSON_OK)
+        break;
+
+      name_str = rasqal_json_decode_string(con, &name, &name_len);
+      if(!name_str || !name_len) {
+        if(name_str)
+          RASQAL_FREE(char*, name_str);
+        return RASQAL_JSON_ERROR;
+      }
+
+      v = rasqal_variables_table_add2(con->vars_table,
+                                      RASQAL_VARIABLE_TYPE_NORMAL,
+                                      name_str, name_len, NULL);
+      RASQAL_FREE(char*, name_str);
+      if(!v)
+        return RASQAL_JSON_ERROR;
+
+      rasqal_rowsource_add_variable(con->rowsource, v);
+      /* above function takes a reference to v */
+      rasqal_free_variable(v);
+    }
+  }
+
+  return status;
+}
+
+
+/*
+ * rasqal_json_find_variable:
+ *
+ * INTERNAL - Get the rowsource offset of a variable named by a string token
+ *
+ * Results usually list the variables in the same order so the
+ * variable after the one found last is tried first.
+ *
+ * Return value: offset or <0 if not a result variable
+ */
+static int
+rasqal_json_find_variable(rasqal_rowsource_json_context* con,
+                          rasqal_json_string* name, int hint)
+{
+  const char* str = con->buffer + name->start;
+  int i;
+
+  if(hint >= con->variables_count)
+    hint = 0;
+
+  for(i = 0; i < con->variables_count; i++) {
+    int offset = (hint + i) % con->variables_count;
+
+    if(con->var_lengths[offset] == name->length &&
+       !memcmp(con->var_names[offset], str, name->length))
+      return offset;
+  }
+
+  return -1;
 }
+
+
+/*
+ * rasqal_json_new_term:
+ *
+ * INTERNAL - Make a literal from the members of an RDF term object
+ *
+ * Return value: OK with *l_p set to the new literal or NULL if unbound
+ */
+static rasqal_json_status
+rasqal_json_new_term(rasqal_rowsource_json_context* con,
+                     rasqal_json_string* type, rasqal_json_string* value,
+                     rasqal_json_string* lang, rasqal_json_string* datatype,
+                     rasqal_literal** l_p)
+{
+  raptor_world* raptor_world_ptr = con->world->raptor_world_ptr;
+  unsigned char* str;
+  size_t len;
+
+  *l_p = NULL;
+
+  if(!type->length || rasqal_json_string_equals(con, type, "unbound", 7))
+    return RASQAL_JSON_OK;
+
+  if(!value)
+    return RASQAL_JSON_ERROR;
+
+  if(rasqal_json_string_equals(con, type, "uri", 3)) {
+    raptor_uri* uri;
+
+    if(value->escaped) {
+      str = rasqal_json_decode_string(con, value, &len);
+      if(!str)
+        return RASQAL_JSON_ERROR;
+      uri = raptor_new_uri_from_counted_string(raptor_world_ptr, str, len);
+      RASQAL_FREE(char*, str);
+    } else
+      uri = raptor_new_uri_from_counted_string(raptor_world_ptr,
+                                               RASQAL_GOOD_CAST(const unsigned char*, con->buffer + value->start),
+                                               value->length);
+    if(!uri)
+      return RASQAL_JSON_ERROR;
+
+    *l_p = rasqal_new_uri_literal(con->world, uri);
+
+  } else if(rasqal_json_string_equals(con, type, "bnode", 5)) {
+    str = rasqal_json_decode_string(con, value, NULL);
+    if(!str)
+      return RASQAL_JSON_ERROR;
+
+    *l_p = rasqal_new_simple_literal(con->world, RASQAL_LITERAL_BLANK, str);
+
+  } else if(rasqal_json_string_equals(con, type, "literal", 7) ||
+            rasqal_json_string_equals(con, type, "typed-literal", 13)) {
+    char* language = NULL;
+    raptor_uri* datatype_uri = NULL;
+
+    if(lang) {
+      language = RASQAL_GOOD_CAST(char*, rasqal_json_decode_string(con, lang,
+                                                                   NULL));
+      if(!language)
+        return RASQAL_JSON_ERROR;
+    }
+
+    if(datatype) {
+      str = rasqal_json_decode_string(con, datatype, &len);
+      if(!str) {
+        if(language)
+          RASQAL_FREE(char*, language);
+        return RASQAL_JSON_ERROR;
+      }
+
+      if(con->datatype_uri) {
+        size_t dt_len;
+        unsigned char* dt_str;
+
+        dt_str = raptor_uri_as_counted_string(con->datatype_uri, &dt_len);
+        if(dt_len == len && !memcmp(dt_str, str, len))
+          datatype_uri = raptor_uri_copy(con->datatype_uri);
+      }
+
+      if(!datatype_uri) {
+        datatype_uri = raptor_new_uri_from_counted_string(raptor_world_ptr,
+                                                          str, len);
+        if(datatype_uri) {
+          if(con->datatype_uri)
+            raptor_free_uri(con->datatype_uri);
+          con->datatype_uri = raptor_uri_copy(datatype_uri);
+        }
+      }
+      RASQAL_FREE(char*, str);
+
+      if(!datatype_uri) {
+        if(language)
+          RASQAL_FREE(char*, language);
+        return RASQAL_JSON_ERROR;
+      }
+    }
+
+    str = rasqal_json_decode_string(con, value, NULL);
+    if(!str) {
+      if(language)
+        RASQAL_FREE(char*, language);
+      if(datatype_uri)
+        raptor_free_uri(datatype_uri);
+      return RASQAL_JSON_ERROR;
+    }
+
+    /* takes ownership of str, language and datatype_uri */
+    *l_p = rasqal_new_string_literal_node(con->world, str, language,
+                                          datatype_uri);
+  } else
+    return RASQAL_JSON_ERROR;
+
+  return *l_p ? RASQAL_JSON_OK : RASQAL_JSON_ERROR;
+}
+
+
+/*
+ * rasqal_json_parse_term:
+ *
+ * INTERNAL - Read an RDF term object into a new literal
+ */
+static rasqal_json_status
+rasqal_json_parse_term(rasqal_rowsource_json_context* con, size_t* p,
+                       rasqal_literal** l_p)
+{
+  rasqal_json_status status;
+  rasqal_json_string type;
+  rasqal_json_string value;
+  rasqal_json_string lang;
+  rasqal_json_string datatype;
+  int have_value = 0;
+  int have_lang = 0;
+  int have_datatype = 0;
+
+  *l_p = NULL;
+  type.length = 0;
+
+  status = rasqal_json_skip_ws(con, p);
+  if(status != RASQAL_JSON_OK)
+    return status;
+
+  /* null is treated as unbound */
+  if(con->buffer[*p] != '{')
+    return rasqal_json_skip_value(con, p);
+
+  (*p)++;
+
+  while(1) {
+    rasqal_json_string key;
+    char c;
+
+    status = rasqal_json_skip_ws(con, p);
+    if(status != RASQAL_JSON_OK)
+      return status;
+
+    c = con->buffer[*p];
+    if(c == ',') {
+      (*p)++;
+      continue;
+    }
+    if(c == '}') {
+      (*p)++;
+      break;
+    }
+
+    status = rasqal_json_scan_key(con, p, &key);
+    if(status != RASQAL_JSON_OK)
+      return status;
+
+    status = rasqal_json_skip_ws(con, p);
+    if(status != RASQAL_JSON_OK)
+      return status;
+
+    /* members with non-string values such as "value": null are skipped */
+    if(con->buffer[*p] != '"')
+      status = rasqal_json_skip_value(con, p);
+    else if(rasqal_json_string_equals(con, &key, "type", 4))
+      status = rasqal_json_scan_string(con, p, &type);
+    else if(rasqal_json_string_equals(con, &key, "value", 5)) {
+      status = rasqal_json_scan_string(con, p, &value);
+      have_value = 1;
+    } else if(rasqal_json_string_equals(con, &key, "xml:lang", 8)) {
+      status = rasqal_json_scan_string(con, p, &lang);
+      have_lang = 1;
+    } else if(rasqal_json_string_equals(con, &key, "datatype", 8)) {
+      status = rasqal_json_scan_string(con, p, &datatype);
+      have_datatype = 1;
+    } else
+      status = rasqal_json_skip_value(con, p);
+
+    if(status != RASQAL_JSON_OK)
+      return status;
+  }
+
+  return rasqal_json_new_term(con, &type,
+                              have_value ? &value : NULL,
+                              have_lang ? &lang : NULL,
+                              have_datatype ? &datatype : NULL,
+                              l_p);
+}
+
+
+/*
+ * rasqal_json_parse_result:
+ *
+ * INTERNAL - Read a result object into a new row in con->row
+ */
+static rasqal_json_status
+rasqal_json_parse_result(rasqal_rowsource_json_context* con, size_t* p)
+{
+  rasqal_json_status status;
+  rasqal_row* row;
+  int hint = 0;
+
+  status = rasqal_json_expect(con, p, '{');
+  if(status != RASQAL_JSON_OK)
+    return status;
+
+  row = rasqal_new_row(con->rowsource);
+  if(!row)
+    return RASQAL_JSON_ERROR;
+
+  while(1) {
+    rasqal_json_string key;
+    rasqal_literal* l;
+    int offset;
+    char c;
+
+    status = rasqal_json_skip_ws(con, p);
+    if(status != RASQAL_JSON_OK)
+      break;
+
+    c = con->buffer[*p];
+    if(c == ',') {
+      (*p)++;
+      continue;
+    }
+    if(c == '}') {
+      (*p)++;
+      break;
+    }
+
+    status = rasqal_json_scan_key(con, p, &key);
+    if(status != RASQAL_JSON_OK)
+      break;
+
+    offset = rasqal_json_find_variable(con, &key, hint);
+    if(offset < 0) {
+      /* not a variable in the head */
+      status = rasqal_json_skip_value(con, p);
+      if(status != RASQAL_JSON_OK)
+        break;
+      continue;
+    }
+    hint = offset + 1;
+
+    status = rasqal_json_parse_term(con, p, &l);
+    if(status != RASQAL_JSON_OK)
+      break;
+
+    if(row->values[offset])
+      rasqal_free_literal(row->values[offset]);
+    row->values[offset] = l;
+  }
+
+  if(status != RASQAL_JSON_OK) {
+    rasqal_free_row(row);
+    return status;
+  }
+
+  row->offset = con->offset++;
+  con->row = row;
+
+  return RASQAL_JSON_OK;
+}
+
+
+/*
+ * rasqal_json_head_done:
+ *
+ * INTERNAL - Record the variables once the head has been read
+ */
+static rasqal_json_status
+rasqal_json_head_done(rasqal_rowsource_json_context* con)
+{
+  int size;
+  int i;
+
+  con->head_done = 1;
+
+  if(!con->rowsource)
+    return RASQAL_JSON_OK;
+
+  size = rasqal_rowsource_get_size(con->rowsource);
+  if(size <= con->variables_count)
+    return RASQAL_JSON_OK;
+
+  if(con->var_names) {
+    RASQAL_FREE(ptrarray, con->var_names);
+    RASQAL_FREE(sizearray, con->var_lengths);
+  }
+
+  con->var_names = RASQAL_CALLOC(const unsigned char**,
+                                 RASQAL_GOOD_CAST(size_t, size),
+                                 sizeof(unsigned char*));
+  con->var_lengths = RASQAL_CALLOC(size_t*, RASQAL_GOOD_CAST(size_t, size),
+                                   sizeof(size_t));
+  if(!con->var_names || !con->var_lengths)
+    return RASQAL_JSON_ERROR;
+
+  for(i = 0; i < size; i++) {
+    rasqal_variable* v;
+
+    v = rasqal_rowsource_get_variable_by_offset(con->rowsource, i);
+    con->var_names[i] = v->name;
+    con->var_lengths[i] = strlen(RASQAL_GOOD_CAST(const char*, v->name));
+  }
+  con->variables_count = size;
+
+  return RASQAL_JSON_OK;
+}
+
+
+/*
+ * rasqal_json_parse_step:
+ *
+ * INTERNAL - Parse the next part of the results document
+ *
+ * The parse position only moves when a complete part was read.
+ */
+static rasqal_json_status
+rasqal_json_parse_step(rasqal_rowsource_json_context* con)
+{
+  rasqal_json_status status;
+  rasqal_json_string key;
+  size_t p = con->pos;
+  char c;
+
+  switch(con->state) {
+    case RASQAL_JSON_STATE_START:
+      status = rasqal_json_expect(con, &p, '{');
+      if(status == RASQAL_JSON_OK)
+        con->state = RASQAL_JSON_STATE_TOP;
+      break;
+
+    case RASQAL_JSON_STATE_TOP:
+      status = rasqal_json_skip_ws(con, &p);
+      if(status != RASQAL_JSON_OK)
+        break;
+
+      c = con->buffer[p];
+      if(c == ',') {
+        p++;
+        break;
+      }
+
+      if(c == '}') {
+        p++;
+        if(con->results_deferred) {
+          /* results without a head: read them with no variables */
+          status = rasqal_json_head_done(con);
+          p = con->results_offset;
+          con->results_deferred = 0;
+          con->state = RASQAL_JSON_STATE_RESULTS_START;
+        } else {
+          if(!con->head_done)
+            status = rasqal_json_head_done(con);
+          con->state = RASQAL_JSON_STATE_END;
+        }
+        break;
+      }
+
+      status = rasqal_json_scan_key(con, &p, &key);
+      if(status != RASQAL_JSON_OK)
+        break;
+
+      if(rasqal_json_string_equals(con, &key, "head", 4)) {
+        status = rasqal_json_parse_head(con, &p);
+        if(status == RASQAL_JSON_OK)
+          status = rasqal_json_head_done(con);
+        if(status == RASQAL_JSON_OK && con->results_deferred) {
+          p = con->results_offset;
+          con->results_deferred = 0;
+          con->state = RASQAL_JSON_STATE_RESULTS_START;
+        }
+      } else if(rasqal_json_string_equals(con, &key, "results", 7)) {
+        if(con->rowsource && !con->head_done) {
+          /* keep the results in the buffer until the head is read */
+          con->results_offset = p;
+          con->results_deferred = 1;
+        }
+        con->state = RASQAL_JSON_STATE_RESULTS_START;
+      } else if(rasqal_json_string_equals(con, &key, "boolean", 7)) {
+        status = rasqal_json_skip_ws(con, &p);
+        if(status == RASQAL_JSON_OK) {
+          c = con->buffer[p];
+          status = rasqal_json_skip_value(con, &p);
+          if(status == RASQAL_JSON_OK)
+            con->boolean_value = (c == 't');
+        }
+      } else
+        status = rasqal_json_skip_value(con, &p);
+      break;
+
+    case RASQAL_JSON_STATE_RESULTS_START:
+      status = rasqal_json_expect(con, &p, '{');
+      if(status == RASQAL_JSON_OK)
+        con->state = RASQAL_JSON_STATE_RESULTS;
+      break;
+
+    case RASQAL_JSON_STATE_RESULTS:
+      status = rasqal_json_skip_ws(con, &p);
+      if(status != RASQAL_JSON_OK)
+        break;
+
+      c = con->buffer[p];
+      if(c == ',') {
+        p++;
+        break;
+      }
+
+      if(c == '}') {
+        p++;
+        con->state = RASQAL_JSON_STATE_TOP;
+        break;
+      }
+
+      status = rasqal_json_scan_key(con, &p, &key);
+      if(status != RASQAL_JSON_OK)
+        break;
+
+      if(rasqal_json_string_equals(con, &key, "bindings", 8)) {
+        status = rasqal_json_expect(con, &p, '[');
+        if(status == RASQAL_JSON_OK)
+          con->state = RASQAL_JSON_STATE_BINDINGS;
+      } else
+        status = rasqal_json_skip_value(con, &p);
+      break;
+
+    case RASQAL_JSON_STATE_BINDINGS:
+      status = rasqal_json_skip_ws(con, &p);
+      if(status != RASQAL_JSON_OK)
+        break;
+
+      c = con->buffer[p];
+      if(c == ',') {
+        p++;
+        break;
+      }
+
+      if(c == ']') {
+        p++;
+        con->state = RASQAL_JSON_STATE_RESULTS;
+        break;
+      }
+
+      /* results are skipped when reading a boolean or before the head */
+      if(!con->rowsource || con->results_deferred)
+        status = rasqal_json_skip_value(con, &p);
+      else
+        status = rasqal_json_parse_result(con, &p);
+      break;
+
+    case RASQAL_JSON_STATE_END:
+    default:
+      status = RASQAL_JSON_ERROR;
+      break;
+  }
+
+  if(status == RASQAL_JSON_OK)
+    con->pos = p;
+
+  return status;
+}
+
+
+/*
+ * rasqal_json_read_more:
+ *
+ * INTERNAL - Read more input into the buffer
+ *
+ * Return value: non-0 on failure
+ */
+static int
+rasqal_json_read_more(rasqal_rowsource_json_context* con)
+{
+  size_t keep;
+  int read_len;
+
+  if(con->eof)
+    return 1;
+
+  /* Drop the parsed input */
+  keep = con->pos;
+  if(con->results_deferred && con->results_offset < keep)
+    keep = con->results_offset;
+
+  if(keep > 0) {
+    memmove(con->buffer, con->buffer + keep, con->length - keep);
+    con->length -= keep;
+    con->pos -= keep;
+    if(con->results_deferred)
+      con->results_offset -= keep;
+    con->consumed += keep;
+  }
+
+  if(con->buffer_size - con->length < RASQAL_JSON_READ_SIZE) {
+    size_t new_size = con->buffer_size * 2;
+    char* new_buffer;
+
+    if(new_size < con->length + RASQAL_JSON_READ_SIZE)
+      new_size = con->length + RASQAL_JSON_READ_SIZE;
+
+    new_buffer = RASQAL_MALLOC(char*, new_size);
+    if(!new_buffer)
+      return 1;
+
+    if(con->buffer) {
+      memcpy(new_buffer, con->buffer, con->length);
+      RASQAL_FREE(char*, con->buffer);
+    }
+    con->buffer = new_buffer;
+    con->buffer_size = new_size;
+  }
+
+  read_len = raptor_iostream_read_bytes(con->buffer + con->length, 1,
+                                        RASQAL_JSON_READ_SIZE, con->iostr);
+  if(read_len > 0)
+    con->length += RASQAL_GOOD_CAST(size_t, read_len);
+
+  if(read_len < RASQAL_JSON_READ_SIZE)
+    /* finished */
+    con->eof = 1;
+
+  return 0;
+}
+
+
+typedef enum {
+  RASQAL_JSON_WANT_VARIABLES,
+  RASQAL_JSON_WANT_ROW,
+  RASQAL_JSON_WANT_BOOLEAN
+} rasqal_json_want;
+
+
+/*
+ * rasqal_json_process:
+ *
+ * INTERNAL - Parse until the wanted part of the results is read
+ *
+ * Return value: non-0 on failure
+ */
+static int
+rasqal_json_process(rasqal_rowsource_json_context* con, rasqal_json_want want)
+{
+  while(!con->failed && con->state != RASQAL_JSON_STATE_END) {
+    rasqal_json_status status;
+
+    if((want == RASQAL_JSON_WANT_VARIABLES && con->head_done) ||
+       (want == RASQAL_JSON_WANT_ROW && con->row) ||
+       (want == RASQAL_JSON_WANT_BOOLEAN && con->boolean_value >= 0))
+      break;
+
+    status = rasqal_json_parse_step(con);
+    if(status == RASQAL_JSON_MORE) {
+      if(rasqal_json_read_more(con))
+        status = RASQAL_JSON_ERROR;
+    }
+
+    if(status == RASQAL_JSON_ERROR) {
+      con->locator.byte = RASQAL_GOOD_CAST(int, con->consumed + con->pos);
+      rasqal_log_error_simple(con->world, RAPTOR_LOG_LEVEL_ERROR,
+                              &con->locator,
+                              "Syntax error in SPARQL JSON results");
+      con->failed = 1;
+    }
+  }
+
+  return con->failed;
+}
+
+
+static rasqal_rowsource_json_context*
+rasqal_json_init_context(rasqal_world *world, raptor_iostream *iostr,
+                         raptor_uri* base_uri, unsigned int flags)
+{
+  rasqal_rowsource_json_context* con;
+
+  con = RASQAL_CALLOC(rasqal_rowsource_json_context*, 1, sizeof(*con));
+  if(!con)
+    return NULL;
+
+  con->world = world;
+  con->base_uri = base_uri ? raptor_uri_copy(base_uri) : NULL;
+  con->iostr = iostr;
+
+  con->locator.uri = base_uri;
+  con->locator.line = -1;
+  con->locator.column = -1;
+
+  con->flags = flags;
+
+  con->state = RASQAL_JSON_STATE_START;
+  con->boolean_value = -1;
+
+  return con;
+}
+
+
+static void
+rasqal_json_free_context(rasqal_rowsource_json_context* con)
+{
+  if(con->row)
+    rasqal_free_row(con->row);
+
+  if(con->buffer)
+    RASQAL_FREE(char*, con->buffer);
+
+  if(con->var_names)
+    RASQAL_FREE(ptrarray, con->var_names);
+
+  if(con->var_lengths)
+    RASQAL_FREE(sizearray, con->var_lengths);
+
+  if(con->datatype_uri)
+    raptor_free_uri(con->datatype_uri);
+
+  if(con->base_uri)
+    raptor_free_uri(con->base_uri);
+
+  if(con->vars_table)
+    rasqal_free_variables_table(con->vars_table);
+
+  if(con->flags) {
+    if(con->iostr)
+      raptor_free_iostream(con->iostr);
+  }
+
+  RASQAL_FREE(rasqal_rowsource_json_context, con);
+}
+
+
+static int
+rasqal_rowsource_json_init(rasqal_rowsource* rowsource, void *user_data)
+{
+  rasqal_rowsource_json_context* con;
+
+  con = (rasqal_rowsource_json_context*)user_data;
+
+  con->rowsource = rowsource;
+
+  return 0;
+}
+
+
+static int
+rasqal_rowsource_json_finish(rasqal_rowsource* rowsource, void *user_data)
+{
+  rasqal_json_free_context((rasqal_rowsource_json_context*)user_data);
+
+  return 0;
+}
+
+
+static int
+rasqal_rowsource_json_ensure_variables(rasqal_rowsource* rowsource,
+                                       void *user_data)
+{
+  rasqal_rowsource_json_context* con;
+
+  con = (rasqal_rowsource_json_context*)user_data;
+
+  return rasqal_json_process(con, RASQAL_JSON_WANT_VARIABLES);
+}
+
+
+static rasqal_row*
+rasqal_rowsource_json_read_row(rasqal_rowsource* rowsource, void *user_data)
+{
+  rasqal_rowsource_json_context* con;
+  rasqal_row* row;
+
+  con = (rasqal_rowsource_json_context*)user_data;
+
+  if(rasqal_json_process(con, RASQAL_JSON_WANT_ROW))
+    return NULL;
+
+  row = con->row;
+  con->row = NULL;
+
+  return row;
+}
+
+
+static const rasqal_rowsource_handler rasqal_rowsource_json_handler = {
+  /* .version = */ 1,
+  "SPARQL JSON",
+  /* .init = */ rasqal_rowsource_json_init,
+  /* .finish = */ rasqal_rowsource_json_finish,
+  /* .ensure_variables = */ rasqal_rowsource_json_ensure_variables,
+  /* .read_row = */ rasqal_rowsource_json_read_row,
+  /* .read_all_rows = */ NULL,
+  /* .reset = */ NULL,
+  /* .set_requirements = */ NULL,
+  /* .get_inner_rowsource = */ NULL,
+  /* .set_origin = */ NULL,
+};
+
+
+/*
+ * rasqal_query_results_get_rowsource_json:
+ * @world: rasqal world object
+ * @iostr: #raptor_iostream to read the query results from
+ * @base_uri: #raptor_uri base URI of the input format
+ *
+ * INTERNAL - Read SPARQL JSON query results format from an iostream
+ * in a format returning a rowsource.
+ *
+ * Return value: a new rasqal_rowsource or NULL on failure
+ **/
+static rasqal_rowsource*
+rasqal_query_results_get_rowsource_json(rasqal_query_results_formatter* formatter,
+                                        rasqal_world *world,
+                                        rasqal_variables_table* vars_table,
+                                        raptor_iostream *iostr,
+                                        raptor_uri *base_uri,
+                                        unsigned int flags)
+{
+  rasqal_rowsource_json_context* con;
+
+  con = rasqal_json_init_context(world, iostr, base_uri, flags);
+  if(!con)
+    return NULL;
+
+  con->vars_table = rasqal_new_variables_table_from_variables_table(vars_table);
+
+  return rasqal_new_rowsource_from_handler(world, NULL,
+                                           con,
+                                           &rasqal_rowsource_json_handler,
+                                           con->vars_table,
+                                           0);
+}
+
+
+static int
+rasqal_query_results_json_get_boolean(rasqal_query_results_formatter *formatter,
+                                      rasqal_world* world,
+                                      raptor_iostream *iostr,
+                                      raptor_uri *base_uri,
+                                      unsigned int flags)
+{
+  rasqal_rowsource_json_context* con;
+  int bv;
+
+  con = rasqal_json_init_context(world, iostr, base_uri, flags);
+  if(!con)
+    return -1;
+
+  rasqal_json_process(con, RASQAL_JSON_WANT_BOOLEAN);
+  bv = con->boolean_value;
+
+  rasqal_json_free_context(con);
+
+  return bv;
+}
+
+
+static int
+rasqal_query_results_json_recognise_syntax(rasqal_query_results_format_factory* factory,
+                                           const unsigned char *buffer,
+                                           size_t len,
+                                           const unsigned char *identifier,
+                                           const unsigned char *suffix,
+                                           const char *mime_type)
+{
+  if(suffix && !strcmp(RASQAL_GOOD_CAST(const char*, suffix), "srj"))
+    return 8;
+
+  return 0;
+}
+
+
+static const char* const json_names[] = { "json", NULL};
+
+static const char* const json_uri_strings[] = {
+  "http://www.w3.org/ns/formats/SPARQL_Results_JSON",
+  /* W3C Working Draft */
+  "http://www.w3.org/TR/sparql11-results-json/",
+  /* W3C Working Group Note */
+  "http://www.w3.org/TR/rdf-sparql-json-res/",
+  /* Released DAWG WG results in JSON */
+  "http://www.w3.org/TR/2007/NOTE-rdf-sparql-json-res-20070618/",
+  /* URIs from 0.9.16 or earlier */
+  "http://www.w3.org/2001/sw/DataAccess/json-sparql/",
+  "http://www.mindswap.org/%7Ekendall/sparql-results-json/",
+  NULL
+};
+
+static const raptor_type_q json_types[] = {
+  { "application/sparql-results+json", 31, 10},
+  { "application/json", 16, 10}, 
+  { NULL, 0, 0}
+};
+
+static int
+rasqal_query_results_json_register_factory(rasqal_query_results_format_factory *factory) 
+{
+  int rc = 0;
+
+  factory->desc.names = json_names;
+  factory->desc.mime_types = json_types;
+
+  factory->desc.label = "SPARQL JSON Query Results";
+  factory->desc.uri_strings = json_uri_strings;
+
+  factory->desc.flags = 0;
+  
+  factory->write         = rasqal_query_results_write_json1;
+  factory->get_rowsource = rasqal_query_results_get_rowsource_json;
+  factory->recognise_syntax = rasqal_query_results_json_recognise_syntax;
+  factory->get_boolean      = rasqal_query_results_json_get_boolean;
+
+  return rc;
+}
+
+
+int
+rasqal_init_result_format_json(rasqal_world* world)
+{
+  return !rasqal_world_register_query_results_format_factory(world,
+                                                             &rasqal_query_results_json_register_factory);
+}
+
+
+#endif /* not STANDALONE */
+
+
+
+#ifdef STANDALONE
+
+/* one more prototype */
+int main(int argc, char *argv[]);
+
+
+#define JSON_HEAD "{ \"head\": { \"vars\": [ \"x\" ] },\n"
+#define JSON_ROW_START "    { \"x\": { \"type\": \"literal\", \"value\": \""
+#define JSON_ROW_END "\" } }"
+
+static const struct {
+  const char* label;
+  const char* json;
+  /* number of rows or -1 for an ASK result */
+  int rows;
+  /* value of ?x in the last row or the boolean result */
+  const char* value;
+  /* non-0 if a syntax error is expected */
+  int error;
+} json_test_data[] = {
+  { "escapes",
+    JSON_HEAD "  \"results\": { \"bindings\": [\n"
+    JSON_ROW_START "a\\t\\\"\\\\\\/\\u00e9\\u00E9" JSON_ROW_END "\n"
+    "  ] }\n}\n",
+    1, "a\t\"\\/\xc3\xa9\xc3\xa9", 0 },
+  { "surrogate pair",
+    JSON_HEAD "  \"results\": { \"bindings\": [\n"
+    JSON_ROW_START "\\uD83D\\uDE00!" JSON_ROW_END "\n"
+    "  ] }\n}\n",
+    1, "\xf0\x9f\x98\x80!", 0 },
+  { "results before head",
+    "{ \"results\": { \"bindings\": [\n"
+    JSON_ROW_START "1" JSON_ROW_END ",\n"
+    JSON_ROW_START "2" JSON_ROW_END "\n"
+    "  ] },\n"
+    "  \"head\": { \"vars\": [ \"x\" ] }\n}\n",
+    2, "2", 0 },
+  { "ASK true",
+    "{ \"head\": { }, \"boolean\": true }\n",
+    -1, "true", 0 },
+  { "ASK false",
+    "{ \"head\": { \"link\": [] },\n  \"boolean\" : false\n}\n",
+    -1, "false", 0 },
+  { "escaped U+0000",
+    JSON_HEAD "  \"results\": { \"bindings\": [\n"
+    JSON_ROW_START "a\\u0000b" JSON_ROW_END "\n"
+    "  ] }\n}\n",
+    0, NULL, 1 },
+  { "unpaired high surrogate",
+    JSON_HEAD "  \"results\": { \"bindings\": [\n"
+    JSON_ROW_START "\\uD83Dx" JSON_ROW_END "\n"
+    "  ] }\n}\n",
+    0, NULL, 1 },
+  { "unpaired low surrogate",
+    JSON_HEAD "  \"results\": { \"bindings\": [\n"
+    JSON_ROW_START "\\uDE00" JSON_ROW_END "\n"
+    "  ] }\n}\n",
+    0, NULL, 1 },
+  { "bad escape",
+    JSON_HEAD "  \"results\": { \"bindings\": [\n"
+    JSON_ROW_START "\\u00g0" JSON_ROW_END "\n"
+    "  ] }\n}\n",
+    0, NULL, 1 },
+  { "truncated",
+    JSON_HEAD "  \"results\": { \"bindings\": [\n"
+    JSON_ROW_START "1" JSON_ROW_END ",\n"
+    JSON_ROW_START "2",
+    1, "1", 1 },
+  { "not an object",
+    "[ \"head\", \"results\" ]\n",
+    0, NULL, 1 },
+  { "missing colon",
+    "{ \"head\" { \"vars\": [ \"x\" ] } }\n",
+    0, NULL, 1 },
+  { NULL, NULL, 0, NULL, 0 }
+};
+
+
+static int json_test_errors;
+
+static void
+json_test_log_handler(void *user_data, raptor_log_message *message)
+{
+  if(message->level >= RAPTOR_LOG_LEVEL_ERROR)
+    json_test_errors++;
+}
+
+
+/*
+ * Read JSON results
+ *
+ * The value of ?x in the last row (or "true" or "false" for a
+ * boolean result) is written to @value.
+ *
+ * Return value: number of rows
+ */
+static int
+json_test_read(rasqal_world* world, const char* json, size_t json_len,
+               int ask, char* value, size_t value_size)
+{
+  raptor_world* raptor_world_ptr = rasqal_world_get_raptor(world);
+  rasqal_query_results_formatter* formatter;
+  rasqal_query_results* results;
+  raptor_iostream* iostr;
+  raptor_uri* base_uri;
+  int count = 0;
+
+  *value = '\0';
+
+  base_uri = raptor_new_uri(raptor_world_ptr,
+                            RASQAL_GOOD_CAST(const unsigned char*, "http://example.org/"));
+  formatter = rasqal_new_query_results_formatter(world, "json", NULL, NULL);
+  results = rasqal_new_query_results2(world, NULL,
+                                      ask ? RASQAL_QUERY_RESULTS_BOOLEAN :
+                                            RASQAL_QUERY_RESULTS_BINDINGS);
+  iostr = raptor_new_iostream_from_string(raptor_world_ptr,
+                                          RASQAL_GOOD_CAST(void*, json),
+                                          json_len);
+
+  rasqal_query_results_formatter_read(world, iostr, formatter, results,
+                                      base_uri);
+
+  if(ask) {
+    int bv = rasqal_query_results_get_boolean(results);
+
+    if(bv >= 0)
+      strcpy(value, bv ? "true" : "false");
+  } else {
+    while(!rasqal_query_results_finished(results)) {
+      rasqal_literal* l = rasqal_query_results_get_binding_value(results, 0);
+      const unsigned char* str;
+
+      str = l ? rasqal_literal_as_string(l) : NULL;
+      if(str && strlen(RASQAL_GOOD_CAST(const char*, str)) < value_size)
+        strcpy(value, RASQAL_GOOD_CAST(const char*, str));
+      count++;
+      rasqal_query_results_next(results);
+    }
+  }
+
+  raptor_free_iostream(iostr);
+  rasqal_free_query_results(results);
+  rasqal_free_query_results_formatter(formatter);
+  raptor_free_uri(base_uri);
+
+  return count;
+}
+
+
+/* Size of the blocks the reader reads; see RASQAL_JSON_READ_SIZE */
+#define JSON_TEST_READ_SIZE 65536
+
+/*
+ * Make results where the end of the first block read falls in the
+ * middle of the \uXXXX escapes of the second row
+ *
+ * Return value: new string
+ */
+static char*
+json_test_make_split_results(size_t* len_p)
+{
+  const char* start = JSON_HEAD "  \"results\": { \"bindings\": [\n"
+                      JSON_ROW_START;
+  const char* middle = JSON_ROW_END ",\n" JSON_ROW_START;
+  const char* escapes = "\\uD83D\\uDE00";
+  const char* end = JSON_ROW_END "\n  ] }\n}\n";
+  size_t padding;
+  char* json;
+  char* p;
+
+  /* put the block boundary 3 bytes into the escapes */
+  padding = JSON_TEST_READ_SIZE - 3 - strlen(start) - strlen(middle);
+
+  json = (char*)malloc(JSON_TEST_READ_SIZE * 2);
+  p = json;
+  strcpy(p, start);
+  p += strlen(p);
+  memset(p, 'a', padding);
+  p += padding;
+  strcpy(p, middle);
+  strcat(p, escapes);
+  strcat(p, end);
+
+  *len_p = strlen(json);
+
+  return json;
+}
+
+
+int
+main(int argc, char *argv[])
+{
+  const char *program = rasqal_basename(argv[0]);
+  rasqal_world* world;
+  char value[64];
+  char* json;
+  size_t json_len;
+  int failures = 0;
+  int count;
+  int i;
+
+  world = rasqal_new_world();
+  if(!world || rasqal_world_open(world)) {
+    fprintf(stderr, "%s: rasqal_world init failed\n", program);
+    return(1);
+  }
+
+  rasqal_world_set_log_handler(world, NULL, json_test_log_handler);
+
+  for(i = 0; json_test_data[i].label; i++) {
+    int ask = (json_test_data[i].rows < 0);
+    const char* expected_value = json_test_data[i].value;
+
+    json_test_errors = 0;
+    count = json_test_read(world, json_test_data[i].json,
+                           strlen(json_test_data[i].json), ask,
+                           value, sizeof(value));
+
+    if((!ask && count != json_test_data[i].rows) ||
+       strcmp(value, expected_value ? expected_value : "") ||
+       (json_test_errors > 0) != json_test_data[i].error) {
+      fprintf(stderr,
+              "%s: JSON test '%s' returned %d rows with value '%s' and %d errors; expected %d rows with value '%s' and %s\n",
+              program, json_test_data[i].label, count, value,
+              json_test_errors, json_test_data[i].rows,
+              expected_value ? expected_value : "",
+              json_test_data[i].error ? "an error" : "no errors");
+      failures++;
+    }
+  }
+
+  json = json_test_make_split_results(&json_len);
+  json_test_errors = 0;
+  count = json_test_read(world, json, json_len, 0, value, sizeof(value));
+  if(count != 2 || strcmp(value, "\xf0\x9f\x98\x80") || json_test_errors) {
+    fprintf(stderr,
+            "%s: JSON test with an escape across a read block returned %d rows with value '%s' and %d errors\n",
+            program, count, value, json_test_errors);
+    failures++;
+  }
+  free(json);
+
+  rasqal_free_world(world);
+
+  return failures;
+}
+
+#endif /* STANDALONE */
@@ -64,6 +64,243 @@ static rasqal_rowsource* rasqal_query_results_get_rowsource_sparql_xml(rasqal_qu
 
 
 
+/* size of the buffer used for writing result rows */
+#define RASQAL_SPARQL_XML_BUFFER_SIZE 65536
+
+/*
+ * Byte classes for XML escaping: 0 is written as is, 1 to 3 are
+ * written as entities, 4 only in attribute values, 5 need a numeric
+ * reference in attribute values, 6 need a numeric reference or are
+ * not allowed and 7 start UTF-8 sequences.
+ */
+static const unsigned char rasqal_sparql_xml_escape_class[256] = {
+  6, 6, 6, 6, 6, 6, 6, 6, 6, 5, 5, 6, 6, 6, 6, 6,
+  6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+  0, 0, 4, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 0, 3, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 6,
+  7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+  7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+  7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+  7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+  7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+  7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+  7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+  7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7
+};
+
+
+/*
+ * Buffered output of result rows, written through the XML writer in
+ * large blocks
+ */
+typedef struct {
+  raptor_xml_writer* xml_writer;
+
+  raptor_iostream* iostr;
+
+  unsigned char* buffer;
+
+  size_t length;
+} rasqal_sparql_xml_output;
+
+
+static void
+rasqal_sparql_xml_flush(rasqal_sparql_xml_output* out)
+{
+  if(out->length) {
+    raptor_xml_writer_raw_counted(out->xml_writer, out->buffer,
+                                  RASQAL_GOOD_CAST(unsigned int, out->length));
+    out->length = 0;
+  }
+}
+
+
+static void
+rasqal_sparql_xml_write(rasqal_sparql_xml_output* out,
+                        const unsigned char* s, size_t len)
+{
+  if(len > RASQAL_SPARQL_XML_BUFFER_SIZE - out->length) {
+    rasqal_sparql_xml_flush(out);
+
+    if(len > RASQAL_SPARQL_XML_BUFFER_SIZE) {
+      raptor_xml_writer_raw_counted(out->xml_writer, s,
+                                    RASQAL_GOOD_CAST(unsigned int, len));
+      return;
+    }
+  }
+
+  memcpy(out->buffer + out->length, s, len);
+  out->length += len;
+}
+
+
+#define rasqal_sparql_xml_write_string(out, str) \
+  rasqal_sparql_xml_write(out, RASQAL_GOOD_CAST(const unsigned char*, str), \
+                          sizeof(str) - 1)
+
+
+/*
+ * rasqal_sparql_xml_write_escaped:
+ * @out: output
+ * @s: UTF-8 string
+ * @len: length of @s
+ * @quote: '"' for an attribute value or '\0' for element content
+ *
+ * INTERNAL - Write XML escaped text
+ *
+ * The string is classified by a table lookup per byte and written
+ * in one copy when nothing needs escaping.  Strings with characters
+ * that need numeric references or are invalid are escaped by raptor
+ * so the output is the same as the XML writer's.
+ */
+static void
+rasqal_sparql_xml_write_escaped(rasqal_sparql_xml_output* out,
+                                const unsigned char* s, size_t len,
+                                char quote)
+{
+  unsigned int classes = 0;
+  size_t start;
+  size_t i;
+
+  for(i = 0; i < len; i++)
+    classes |= 1U << rasqal_sparql_xml_escape_class[s[i]];
+
+  if(classes == 1U) {
+    rasqal_sparql_xml_write(out, s, len);
+    return;
+  }
+
+  if((classes & (1U << 6)) ||
+     (quote && (classes & (1U << 5))) ||
+     ((classes & (1U << 7)) && !raptor_unicode_check_utf8_string(s, len))) {
+    rasqal_sparql_xml_flush(out);
+    raptor_xml_escape_string_write(s, len, quote, out->iostr);
+    return;
+  }
+
+  for(start = 0, i = 0; i < len; i++) {
+    const char* entity;
+    size_t entity_len;
+
+    switch(rasqal_sparql_xml_escape_class[s[i]]) {
+      case 1:
+        entity = "&amp;";
+        entity_len = 5;
+        break;
+
+      case 2:
+        entity = "&lt;";
+        entity_len = 4;
+        break;
+
+      case 3:
+        entity = "&gt;";
+        entity_len = 4;
+        break;
+
+      case 4:
+        if(!quote)
+          continue;
+        entity = "&quot;";
+        entity_len = 6;
+        break;
+
+      default:
+        continue;
+    }
+
+    rasqal_sparql_xml_write(out, s + start, i - start);
+    rasqal_sparql_xml_write(out,
+                            RASQAL_GOOD_CAST(const unsigned char*, entity),
+                            entity_len);
+    start = i + 1;
+  }
+
+  rasqal_sparql_xml_write(out, s + start, len - start);
+}
+
+
+/*
+ * rasqal_sparql_xml_write_binding:
+ * @out: output
+ * @l: value or NULL when unbound
+ *
+ * INTERNAL - Write the content of a binding element
+ *
+ * Return value: non-0 if the value cannot be written
+ */
+static int
+rasqal_sparql_xml_write_binding(rasqal_sparql_xml_output* out,
+                                rasqal_literal* l)
+{
+  const unsigned char* str;
+  size_t len;
+
+  if(!l) {
+    rasqal_sparql_xml_write_string(out, "<unbound/>");
+    return 0;
+  }
+
+  switch(l->type) {
+    case RASQAL_LITERAL_URI:
+      str = raptor_uri_as_counted_string(l->value.uri, &len);
+      rasqal_sparql_xml_write_string(out, "<uri>");
+      rasqal_sparql_xml_write_escaped(out, str, len, '\0');
+      rasqal_sparql_xml_write_string(out, "</uri>");
+      break;
+
+    case RASQAL_LITERAL_BLANK:
+      rasqal_sparql_xml_write_string(out, "<bnode>");
+      rasqal_sparql_xml_write_escaped(out, l->string, l->string_len, '\0');
+      rasqal_sparql_xml_write_string(out, "</bnode>");
+      break;
+
+    case RASQAL_LITERAL_STRING:
+    case RASQAL_LITERAL_UDT:
+      if(l->language) {
+        rasqal_sparql_xml_write_string(out, "<literal xml:lang=\"");
+        rasqal_sparql_xml_write_escaped(out,
+                                        RASQAL_GOOD_CAST(const unsigned char*, l->language),
+                                        strlen(l->language), '"');
+        rasqal_sparql_xml_write_string(out, "\">");
+      } else if(l->datatype) {
+        str = raptor_uri_as_counted_string(l->datatype, &len);
+        rasqal_sparql_xml_write_string(out, "<literal datatype=\"");
+        rasqal_sparql_xml_write_escaped(out, str, len, '"');
+        rasqal_sparql_xml_write_string(out, "\">");
+      } else
+        rasqal_sparql_xml_write_string(out, "<literal>");
+
+      rasqal_sparql_xml_write_escaped(out, l->string, l->string_len, '\0');
+      rasqal_sparql_xml_write_string(out, "</literal>");
+      break;
+
+    case RASQAL_LITERAL_PATTERN:
+    case RASQAL_LITERAL_QNAME:
+    case RASQAL_LITERAL_INTEGER:
+    case RASQAL_LITERAL_XSD_STRING:
+    case RASQAL_LITERAL_BOOLEAN:
+    case RASQAL_LITERAL_DOUBLE:
+    case RASQAL_LITERAL_FLOAT:
+    case RASQAL_LITERAL_VARIABLE:
+    case RASQAL_LITERAL_DECIMAL:
+    case RASQAL_LITERAL_DATE:
+    case RASQAL_LITERAL_DATETIME:
+    case RASQAL_LITERAL_INTEGER_SUBTYPE:
+
+    case RASQAL_LITERAL_UNKNOWN:
+    default:
+      return 1;
+  }
+
+  return 0;
+}
+
+
 /*
  * rasqal_query_results_write_sparql_xml:
  * @iostr: #raptor_iostream to write the query results to
@@ -92,12 +329,16 @@ rasqal_query_results_write_sparql_xml(rasqal_query_results_formatter* formatter,
   raptor_xml_element *results_element=NULL;
   raptor_xml_element *result_element=NULL;
   raptor_xml_element *element1=NULL;
-  raptor_xml_element *binding_element=NULL;
   raptor_xml_element *variable_element=NULL;
   raptor_qname **attrs=NULL;
   int i;
+  int size = 0;
+  rasqal_sparql_xml_output out;
+  raptor_stringbuffer** binding_tags = NULL;
   rasqal_query_results_type type;
 
+  out.buffer = NULL;
+
   type = rasqal_query_results_get_type(results);
 
   if(type != RASQAL_QUERY_RESULTS_BINDINGS &&
@@ -230,166 +471,76 @@ rasqal_query_results_write_sparql_xml(rasqal_query_results_formatter* formatter,
   raptor_xml_writer_raw_counted(xml_writer, RASQAL_GOOD_CAST(const unsigned char*, "\n"), 1);
 
 
-  /* declare result element for later multiple use */
-  result_element=raptor_new_xml_element_from_namespace_local_name(res_ns,
-                                                                  RASQAL_GOOD_CAST(const unsigned char*, "result"),
-                                                                  NULL, base_uri);
-  if(!result_element)
+  /* Result rows are written directly into a buffer with the binding
+   * start tags for each variable made once */
+  out.xml_writer = xml_writer;
+  out.iostr = iostr;
+  out.length = 0;
+  out.buffer = RASQAL_MALLOC(unsigned char*, RASQAL_SPARQL_XML_BUFFER_SIZE);
+  if(!out.buffer)
     goto tidy;
 
-  while(!rasqal_query_results_finished(results)) {
-    /*     <result> */
-    raptor_xml_writer_raw_counted(xml_writer, RASQAL_GOOD_CAST(const unsigned char*, "    "), 4);
-    raptor_xml_writer_start_element(xml_writer, result_element);
-    raptor_xml_writer_raw_counted(xml_writer, RASQAL_GOOD_CAST(const unsigned char*, "\n"), 1);
+  size = rasqal_query_results_get_bindings_count(results);
+  if(size > 0) {
+    binding_tags = RASQAL_CALLOC(raptor_stringbuffer**,
+                                 RASQAL_GOOD_CAST(size_t, size),
+                                 sizeof(raptor_stringbuffer*));
+    if(!binding_tags)
+      goto tidy;
+  }
 
-    for(i=0; i<rasqal_query_results_get_bindings_count(results); i++) {
-      const unsigned char *name=rasqal_query_results_get_binding_name(results, i);
-      rasqal_literal *l=rasqal_query_results_get_binding_value(results, i);
+  /* each tag is rendered into the empty output buffer and kept */
+  for(i = 0; i < size; i++) {
+    const unsigned char *name = rasqal_query_results_get_binding_name(results, i);
 
-      /*       <binding> */
-      binding_element=raptor_new_xml_element_from_namespace_local_name(res_ns,
-                                                                       RASQAL_GOOD_CAST(const unsigned char*, "binding"),
-                                                                       NULL, base_uri);
-      if(!binding_element)
-        goto tidy;
+    binding_tags[i] = raptor_new_stringbuffer();
+    if(!binding_tags[i])
+      goto tidy;
 
-      attrs=(raptor_qname **)raptor_alloc_memory(sizeof(raptor_qname*));
-      if(!attrs)
-        goto tidy;
-      attrs[0] = raptor_new_qname_from_namespace_local_name(world->raptor_world_ptr,
-                                                            res_ns,
-                                                            RASQAL_GOOD_CAST(const unsigned char*, "name"),
-                                                            name);
+    /*       <binding name="x"> */
+    rasqal_sparql_xml_write_string(&out, "      <binding name=\"");
+    rasqal_sparql_xml_write_escaped(&out, name,
+                                    strlen(RASQAL_GOOD_CAST(const char*, name)),
+                                    '"');
+    rasqal_sparql_xml_write_string(&out, "\">");
 
-      if(!attrs[0]) {
-        raptor_free_memory((void*)attrs);
-        goto tidy;
-      }
+    if(raptor_stringbuffer_append_counted_string(binding_tags[i],
+                                                 out.buffer, out.length, 1))
+      goto tidy;
+    out.length = 0;
+  }
 
-      raptor_xml_element_set_attributes(binding_element, attrs, 1);
-      
+  while(!rasqal_query_results_finished(results)) {
+    /*     <result> */
+    rasqal_sparql_xml_write_string(&out, "    <result>\n");
 
-      raptor_xml_writer_raw_counted(xml_writer, RASQAL_GOOD_CAST(const unsigned char*, "      "), 6);
-      raptor_xml_writer_start_element(xml_writer, binding_element);
+    for(i = 0; i < size; i++) {
+      rasqal_literal *l = rasqal_query_results_get_binding_value(results, i);
 
-      if(!l) {
-        element1=raptor_new_xml_element_from_namespace_local_name(res_ns,
-                                                                  RASQAL_GOOD_CAST(const unsigned char*, "unbound"),
-                                                                  NULL, base_uri);
-        if(!element1)
-          goto tidy;
-        raptor_xml_writer_empty_element(xml_writer, element1);
-
-      } else switch(l->type) {
-        case RASQAL_LITERAL_URI:
-          element1=raptor_new_xml_element_from_namespace_local_name(res_ns,
-                                                                    RASQAL_GOOD_CAST(const unsigned char*, "uri"),
-                                                                    NULL, base_uri);
-          if(!element1)
-            goto tidy;
-          
-          raptor_xml_writer_start_element(xml_writer, element1);
-          raptor_xml_writer_cdata(xml_writer, RASQAL_GOOD_CAST(const unsigned char*, raptor_uri_as_string(l->value.uri)));
-          raptor_xml_writer_end_element(xml_writer, element1);
-
-          break;
-
-        case RASQAL_LITERAL_BLANK:
-          element1=raptor_new_xml_element_from_namespace_local_name(res_ns,
-                                                                    RASQAL_GOOD_CAST(const unsigned char*, "bnode"),
-                                                                    NULL, base_uri);
-          if(!element1)
-            goto tidy;
-          
-          raptor_xml_writer_start_element(xml_writer, element1);
-          raptor_xml_writer_cdata(xml_writer, RASQAL_GOOD_CAST(const unsigned char*, l->string));
-          raptor_xml_writer_end_element(xml_writer, element1);
-          break;
-
-        case RASQAL_LITERAL_STRING:
-        case RASQAL_LITERAL_UDT:
-          element1=raptor_new_xml_element_from_namespace_local_name(res_ns,
-                                                                    RASQAL_GOOD_CAST(const unsigned char*, "literal"),
-                                                                    NULL, base_uri);
-          if(!element1)
-            goto tidy;
-
-          if(l->language || l->datatype) {
-            attrs=(raptor_qname **)raptor_alloc_memory(sizeof(raptor_qname*));
-            if(!attrs)
-              goto tidy;
-
-            if(l->language)
-              attrs[0]=raptor_new_qname(nstack,
-                                        RASQAL_GOOD_CAST(const unsigned char*, "xml:lang"),
-                                        RASQAL_GOOD_CAST(const unsigned char*, l->language));
-            else
-              attrs[0] = raptor_new_qname_from_namespace_local_name(world->raptor_world_ptr,
-                                                                    res_ns,
-                                                                    RASQAL_GOOD_CAST(const unsigned char*, "datatype"),
-                                                                    RASQAL_GOOD_CAST(const unsigned char*, raptor_uri_as_string(l->datatype)));
-            if(!attrs[0]) {
-              raptor_free_memory((void*)attrs);
-              goto tidy;
-            }
-
-            raptor_xml_element_set_attributes(element1, attrs, 1);
-          }
-
-
-          raptor_xml_writer_start_element(xml_writer, element1);
-
-
-          raptor_xml_writer_cdata_counted(xml_writer,
-                                          RASQAL_GOOD_CAST(const unsigned char*, l->string),
-                                          l->string_len);
-
-          raptor_xml_writer_end_element(xml_writer, element1);
-          
-          break;
-        case RASQAL_LITERAL_PATTERN:
-        case RASQAL_LITERAL_QNAME:
-        case RASQAL_LITERAL_INTEGER:
-        case RASQAL_LITERAL_XSD_STRING:
-        case RASQAL_LITERAL_BOOLEAN:
-        case RASQAL_LITERAL_DOUBLE:
-        case RASQAL_LITERAL_FLOAT:
-        case RASQAL_LITERAL_VARIABLE:
-        case RASQAL_LITERAL_DECIMAL:
-        case RASQAL_LITERAL_DATE:
-        case RASQAL_LITERAL_DATETIME:
-        case RASQAL_LITERAL_INTEGER_SUBTYPE:
-
-        case RASQAL_LITERAL_UNKNOWN:
-        default:
-          rasqal_log_error_simple(world, RAPTOR_LOG_LEVEL_ERROR,
-                                  NULL,
-                                  "Cannot turn literal type %u into XML",
-                                  l->type);
-          goto tidy;
-        }
+      rasqal_sparql_xml_write(&out,
+                              raptor_stringbuffer_as_string(binding_tags[i]),
+                              raptor_stringbuffer_length(binding_tags[i]));
 
-      if(element1) {
-        raptor_free_xml_element(element1);
-        element1=NULL;
+      if(rasqal_sparql_xml_write_binding(&out, l)) {
+        rasqal_sparql_xml_flush(&out);
+        rasqal_log_error_simple(world, RAPTOR_LOG_LEVEL_ERROR,
+                                NULL,
+                                "Cannot turn literal type %u into XML",
+                                l->type);
+        goto tidy;
       }
 
       /*       </binding> */
-      raptor_xml_writer_end_element(xml_writer, binding_element);
-      raptor_xml_writer_raw_counted(xml_writer, RASQAL_GOOD_CAST(const unsigned char*, "\n"), 1);
-      
-      raptor_free_xml_element(binding_element);
-      binding_element=NULL;
+      rasqal_sparql_xml_write_string(&out, "</binding>\n");
     }
 
-    raptor_xml_writer_raw_counted(xml_writer, RASQAL_GOOD_CAST(const unsigned char*, "    "), 4);
-    raptor_xml_writer_end_element(xml_writer, result_element);
-    raptor_xml_writer_raw_counted(xml_writer, RASQAL_GOOD_CAST(const unsigned char*, "\n"), 1);
-    
+    rasqal_sparql_xml_write_string(&out, "    </result>\n");
+
     rasqal_query_results_next(results);
   }
 
+  rasqal_sparql_xml_flush(&out);
+
   raptor_xml_writer_raw_counted(xml_writer, RASQAL_GOOD_CAST(const unsigned char*, "  "), 2);
   raptor_xml_writer_end_element(xml_writer, results_element);
   raptor_xml_writer_raw_counted(xml_writer, RASQAL_GOOD_CAST(const unsigned char*, "\n"), 1);
@@ -406,8 +557,15 @@ rasqal_query_results_write_sparql_xml(rasqal_query_results_formatter* formatter,
     raptor_free_xml_element(element1);
   if(variable_element)
     raptor_free_xml_element(variable_element);
-  if(binding_element)
-    raptor_free_xml_element(binding_element);
+  if(binding_tags) {
+    for(i = 0; i < size; i++) {
+      if(binding_tags[i])
+        raptor_free_stringbuffer(binding_tags[i]);
+    }
+    RASQAL_FREE(raptor_stringbuffer**, binding_tags);
+  }
+  if(out.buffer)
+    RASQAL_FREE(unsigned char*, out.buffer);
   if(result_element)
     raptor_free_xml_element(result_element);
   if(results_element)
@@ -40,17 +40,13 @@
 #endif
 #include <stdarg.h>
 
-#ifndef FILE_READ_BUF_SIZE
-#ifdef BUFSIZ
-#define FILE_READ_BUF_SIZE BUFSIZ
-#else
-#define FILE_READ_BUF_SIZE 1024
-#endif
-#endif
-
 #include "rasqal.h"
 #include "rasqal_internal.h"
 
+
+/* size of reads from the results iostream */
+#define RASQAL_SV_READ_SIZE 65536
+
 #include "sv_config.h"
 
 #include "sv.h"
@@ -304,6 +300,20 @@ rasqal_query_results_write_tsv(rasqal_query_results_formatter* formatter,
 
 
 
+/*
+ * The last value read in a column, kept so that a repeated field is
+ * not parsed again
+ */
+typedef struct
+{
+  char* field;
+  size_t field_len;
+  size_t field_size;
+
+  rasqal_literal* literal;
+} rasqal_rowsource_sv_column;
+
+
 typedef struct 
 {
   rasqal_world* world;
@@ -321,9 +331,13 @@ typedef struct
   int emit_mkr;  /* Non 0 for mKR relation */
   char sep;
   sv* t;
-  char buffer[FILE_READ_BUF_SIZE]; /* iostream read buffer */
+  char buffer[RASQAL_SV_READ_SIZE]; /* iostream read buffer */
   int offset; /* current result row number */
 
+  /* last value for each header column */
+  rasqal_rowsource_sv_column* columns;
+  size_t columns_count;
+
   /* Output fields */
   raptor_sequence* results_sequence; /* saved result rows */
 
@@ -349,6 +363,14 @@ rasqal_rowsource_sv_header_callback(sv *t, void *user_data,
 
   con->variables_count = count;
 
+  if(!con->columns && count > 0) {
+    con->columns = RASQAL_CALLOC(rasqal_rowsource_sv_column*, count,
+                                 sizeof(rasqal_rowsource_sv_column));
+    if(!con->columns)
+      return SV_STATUS_NO_MEMORY;
+    con->columns_count = count;
+  }
+
   for(i = 0; i < count; i++) {
     rasqal_variable *v;
     char *p = fields[i];
@@ -374,6 +396,152 @@ rasqal_rowsource_sv_header_callback(sv *t, void *user_data,
 }
 
 
+/*
+ * rasqal_rowsource_sv_new_literal:
+ * @con: SV context
+ * @field: field
+ * @field_len: length of @field
+ *
+ * INTERNAL - Make a literal from a field
+ *
+ * IRIs, plain literals and blank nodes without escapes in Turtle
+ * data are made directly; other terms are parsed as N-Triples.
+ *
+ * Return value: new literal or NULL on failure
+ */
+static rasqal_literal*
+rasqal_rowsource_sv_new_literal(rasqal_rowsource_sv_context* con,
+                                char* field, size_t field_len)
+{
+  unsigned char* lvalue;
+  size_t i;
+
+  if(!con->data_is_turtle) {
+    lvalue = RASQAL_MALLOC(unsigned char*, field_len + 1);
+    if(!lvalue)
+      return NULL;
+
+    memcpy(lvalue, field, field_len);
+    lvalue[field_len] = '\0';
+
+    return rasqal_new_string_literal_node(con->world, lvalue, NULL, NULL);
+  }
+
+  if(field_len >= 2 && field[0] == '<' && field[field_len - 1] == '>' &&
+     !memchr(field, '\\', field_len)) {
+    raptor_uri* uri;
+
+    uri = raptor_new_uri_from_counted_string(con->world->raptor_world_ptr,
+                                             RASQAL_GOOD_CAST(const unsigned char*, field + 1),
+                                             field_len - 2);
+    if(!uri)
+      return NULL;
+
+    return rasqal_new_uri_literal(con->world, uri);
+  }
+
+  if(field_len >= 2 && field[0] == '"' && field[field_len - 1] == '"') {
+    for(i = 1; i < field_len - 1; i++) {
+      if(field[i] == '"' || field[i] == '\\')
+        break;
+    }
+
+    if(i == field_len - 1) {
+      lvalue = RASQAL_MALLOC(unsigned char*, field_len - 1);
+      if(!lvalue)
+        return NULL;
+
+      memcpy(lvalue, field + 1, field_len - 2);
+      lvalue[field_len - 2] = '\0';
+
+      return rasqal_new_string_literal(con->world, lvalue, NULL, NULL, NULL);
+    }
+  }
+
+  if(field_len > 2 && field[0] == '_' && field[1] == ':') {
+    for(i = 2; i < field_len; i++) {
+      char c = field[i];
+
+      if(!((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+           (c >= '0' && c <= '9') || c == '_'))
+        break;
+    }
+
+    if(i == field_len) {
+      lvalue = RASQAL_MALLOC(unsigned char*, field_len - 1);
+      if(!lvalue)
+        return NULL;
+
+      memcpy(lvalue, field + 2, field_len - 2);
+      lvalue[field_len - 2] = '\0';
+
+      return rasqal_new_simple_literal(con->world, RASQAL_LITERAL_BLANK,
+                                       lvalue);
+    }
+  }
+
+  return rasqal_new_literal_from_ntriples_counted_string(con->world,
+                                                         RASQAL_GOOD_CAST(unsigned char*, field),
+                                                         field_len);
+}
+
+
+/*
+ * rasqal_rowsource_sv_get_literal:
+ * @con: SV context
+ * @column: column index
+ * @field: field
+ * @field_len: length of @field
+ *
+ * INTERNAL - Get a literal for a field, reusing the last one in the column if the field is repeated
+ *
+ * Return value: new reference to a literal or NULL on failure
+ */
+static rasqal_literal*
+rasqal_rowsource_sv_get_literal(rasqal_rowsource_sv_context* con,
+                                size_t column, char* field, size_t field_len)
+{
+  rasqal_rowsource_sv_column* col;
+  rasqal_literal* l;
+
+  if(column >= con->columns_count)
+    return rasqal_rowsource_sv_new_literal(con, field, field_len);
+
+  col = &con->columns[column];
+  if(col->literal && col->field_len == field_len &&
+     !memcmp(col->field, field, field_len))
+    return rasqal_new_literal_from_literal(col->literal);
+
+  l = rasqal_rowsource_sv_new_literal(con, field, field_len);
+  if(!l)
+    return NULL;
+
+  if(col->literal) {
+    rasqal_free_literal(col->literal);
+    col->literal = NULL;
+  }
+
+  if(field_len > col->field_size) {
+    char* new_field = RASQAL_MALLOC(char*, field_len);
+
+    /* not remembering the field only loses the reuse */
+    if(!new_field)
+      return l;
+
+    if(col->field)
+      RASQAL_FREE(char*, col->field);
+    col->field = new_field;
+    col->field_size = field_len;
+  }
+
+  memcpy(col->field, field, field_len);
+  col->field_len = field_len;
+  col->literal = rasqal_new_literal_from_literal(l);
+
+  return l;
+}
+
+
 static sv_status_t
 rasqal_rowsource_sv_data_callback(sv *t, void *user_data,
                                   char** fields, size_t *widths,
@@ -400,25 +568,8 @@ rasqal_rowsource_sv_data_callback(sv *t, void *user_data,
     if(!field_len) {
       /* missing */
       l = NULL;
-    } else if(con->data_is_turtle) {
-      l = rasqal_new_literal_from_ntriples_counted_string(con->world,
-                                                          RASQAL_GOOD_CAST(unsigned char*,field),
-                                                          field_len);
-      if(!l)
-        goto fail;
     } else {
-      unsigned char* lvalue;
-
-      lvalue = RASQAL_MALLOC(unsigned char*, field_len + 1);
-      if(!lvalue)
-        goto fail;
-
-      if(!widths[i])
-        *lvalue = '\0';
-      else
-        memcpy(lvalue, field, field_len + 1);
-
-      l = rasqal_new_string_literal_node(con->world, lvalue, NULL, NULL);
+      l = rasqal_rowsource_sv_get_literal(con, i, field, field_len);
       if(!l)
         goto fail;
     }
@@ -476,6 +627,18 @@ rasqal_rowsource_sv_finish(rasqal_rowsource* rowsource, void *user_data)
   if(con->t)
     sv_free(con->t);
 
+  if(con->columns) {
+    size_t i;
+
+    for(i = 0; i < con->columns_count; i++) {
+      if(con->columns[i].field)
+        RASQAL_FREE(char*, con->columns[i].field);
+      if(con->columns[i].literal)
+        rasqal_free_literal(con->columns[i].literal);
+    }
+    RASQAL_FREE(rasqal_rowsource_sv_column*, con->columns);
+  }
+
   if(con->base_uri)
     raptor_free_uri(con->base_uri);
 
@@ -508,7 +671,7 @@ rasqal_rowsource_sv_process(rasqal_rowsource_sv_context* con)
 
     read_len = RASQAL_BAD_CAST(size_t,
                                raptor_iostream_read_bytes(RASQAL_GOOD_CAST(char*, con->buffer), 1,
-                                                          FILE_READ_BUF_SIZE,
+                                                          RASQAL_SV_READ_SIZE,
                                                           con->iostr));
     if(read_len > 0) {
       sv_status_t status;
@@ -522,7 +685,7 @@ rasqal_rowsource_sv_process(rasqal_rowsource_sv_context* con)
       }
     }
 
-    if(read_len < FILE_READ_BUF_SIZE) {
+    if(read_len < RASQAL_SV_READ_SIZE) {
       /* finished */
       break;
     }
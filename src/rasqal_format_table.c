@@ -44,6 +44,8 @@
 #include <rasqal_internal.h>
 
 
+#ifndef STANDALONE
+
 static void
 rasqal_free_chararray(void* object)
 {
@@ -82,26 +84,239 @@ rasqal_iostream_write_counted_string_padded(raptor_iostream *iostr,
 }
     
 
+#define VSEP "|"
+#define VSEP_LEN 1
+#define PAD " "
+#define PAD_LEN 1
+
+/* rows read to size columns when the tableLookahead feature is 0 */
+#define RASQAL_TABLE_DEFAULT_LOOKAHEAD 1000
+
+
+/*
+ * rasqal_query_results_table_format_row:
+ * @world: rasqal world
+ * @results: query results at a row
+ * @bindings_count: number of bindings
+ * @widths: column widths
+ * @fits_p: pointer to store non-0 if the values fit in @widths (or NULL)
+ *
+ * INTERNAL - Format the values of the current result row as strings
+ *
+ * If @fits_p is NULL, @widths are widened to fit the values.
+ *
+ * Return value: new -1 terminated array of strings or NULL on failure
+ */
+static char**
+rasqal_query_results_table_format_row(rasqal_world* world,
+                                      rasqal_query_results* results,
+                                      int bindings_count, size_t* widths,
+                                      int* fits_p)
+{
+  char **values;
+  int i;
+
+  values = RASQAL_CALLOC(char**, RASQAL_GOOD_CAST(size_t, bindings_count + 1), sizeof(char*));
+  if(!values)
+    return NULL;
+
+  if(fits_p)
+    *fits_p = 1;
+
+  for(i = 0; i < bindings_count; i++) {
+    rasqal_literal *l = rasqal_query_results_get_binding_value(results, i);
+    raptor_iostream* str_iostr;
+    size_t v_len;
+
+    if(!l)
+      continue;
+
+    str_iostr = raptor_new_iostream_to_string(world->raptor_world_ptr,
+                                              (void**)&values[i], &v_len,
+                                              rasqal_alloc_memory);
+    if(!str_iostr) {
+      values[i] = RASQAL_GOOD_CAST(char*, -1);
+      rasqal_free_chararray(values);
+      return NULL;
+    }
+    rasqal_literal_write(l, str_iostr);
+    raptor_free_iostream(str_iostr);
+
+    if(v_len > widths[i]) {
+      if(fits_p)
+        *fits_p = 0;
+      else
+        widths[i] = v_len;
+    }
+  }
+  values[i] = RASQAL_GOOD_CAST(char*, -1);
+
+  return values;
+}
+
+
+/*
+ * rasqal_query_results_table_read_block:
+ * @world: rasqal world
+ * @results: query results
+ * @seq: sequence to add formatted rows to
+ * @lookahead: maximum number of rows in @seq
+ * @bindings_count: number of bindings
+ * @widths: column widths to widen
+ *
+ * INTERNAL - Read a block of result rows and size the columns to fit them
+ *
+ * Return value: non-0 on failure
+ */
+static int
+rasqal_query_results_table_read_block(rasqal_world* world,
+                                      rasqal_query_results* results,
+                                      raptor_sequence* seq, int lookahead,
+                                      int bindings_count, size_t* widths)
+{
+  while(raptor_sequence_size(seq) < lookahead &&
+        !rasqal_query_results_finished(results)) {
+    char **values;
+
+    values = rasqal_query_results_table_format_row(world, results,
+                                                   bindings_count, widths,
+                                                   NULL);
+    if(!values || raptor_sequence_push(seq, values))
+      return 1;
+
+    rasqal_query_results_next(results);
+  }
+
+  return 0;
+}
+
+
+static void
+rasqal_query_results_table_write_row(raptor_iostream *iostr, char** values,
+                                     int bindings_count, size_t* widths)
+{
+  int i;
+
+  raptor_iostream_counted_string_write(VSEP, VSEP_LEN, iostr);
+  for(i = 0; i < bindings_count; i++) {
+    char *value = values[i];
+    size_t w = value ? strlen(RASQAL_GOOD_CAST(const char*, value)) : 0;
+
+    raptor_iostream_counted_string_write(PAD, PAD_LEN, iostr);
+    rasqal_iostream_write_counted_string_padded(iostr, value, w,
+                                                ' ', widths[i]);
+    raptor_iostream_counted_string_write(PAD, PAD_LEN, iostr);
+    raptor_iostream_counted_string_write(VSEP, VSEP_LEN, iostr);
+  }
+  raptor_iostream_write_byte('\n', iostr);
+}
+
+
+/*
+ * rasqal_query_results_table_write_block:
+ * @iostr: iostream to write to
+ * @names: binding names
+ * @seq: sequence of formatted rows to write and remove
+ * @bindings_count: number of bindings
+ * @widths: column widths
+ *
+ * INTERNAL - Write a table header and a block of rows
+ *
+ * Return value: width of the table
+ */
+static size_t
+rasqal_query_results_table_write_block(raptor_iostream *iostr,
+                                       const unsigned char** names,
+                                       raptor_sequence* seq,
+                                       int bindings_count, size_t* widths)
+{
+  size_t total_width = 0;
+  size_t sep_len;
+  char **values;
+  int i;
+
+  for(i = 0; i < bindings_count; i++)
+    total_width += widths[i];
+
+  sep_len = total_width + RASQAL_GOOD_CAST(size_t, ((PAD_LEN+PAD_LEN) * bindings_count) + VSEP_LEN * (bindings_count + 1));
+
+  /* Generate separator */
+  rasqal_iostream_write_counted_string_padded(iostr, NULL, 0, '-', sep_len);
+  raptor_iostream_write_byte('\n', iostr);
+
+  /* Generate variables header */
+  raptor_iostream_counted_string_write(VSEP, VSEP_LEN, iostr);
+  for(i = 0; i < bindings_count; i++) {
+    const unsigned char *name = names[i];
+    size_t w;
+
+    if(!name)
+      break;
+    w = strlen(RASQAL_GOOD_CAST(const char*, name));
+    
+    raptor_iostream_counted_string_write(PAD, PAD_LEN, iostr);
+    rasqal_iostream_write_counted_string_padded(iostr, name, w,
+                                                ' ', widths[i]);
+    raptor_iostream_counted_string_write(PAD, PAD_LEN, iostr);
+    raptor_iostream_counted_string_write(VSEP, VSEP_LEN, iostr);
+  }
+  raptor_iostream_write_byte('\n', iostr);
+
+  /* Generate separator */
+  rasqal_iostream_write_counted_string_padded(iostr, NULL, 0, '=', sep_len);
+  raptor_iostream_write_byte('\n', iostr);
+
+  /* Write values */
+  for(i = 0; (values = (char**)raptor_sequence_get_at(seq, i)); i++)
+    rasqal_query_results_table_write_row(iostr, values, bindings_count, widths);
+
+  while((values = (char**)raptor_sequence_pop(seq)))
+    rasqal_free_chararray(values);
+
+  return sep_len;
+}
+
+
+/*
+ * rasqal_query_results_write_table_bindings:
+ *
+ * INTERNAL - Write variable bindings results as a text table
+ *
+ * The column widths are set from the first block of rows, up to the
+ * tableLookahead query feature, which is written once it is read so
+ * only a block of rows is held in memory.  When a later value is too
+ * wide for its column, a new block is read starting with that row
+ * and written with wider columns and a new header.
+ *
+ * The binding names are saved before reading any block since they
+ * are not available once the results are finished.
+ */
 static int
 rasqal_query_results_write_table_bindings(raptor_iostream *iostr,
                                           rasqal_query_results* results,
                                           raptor_uri *base_uri)
 {
   rasqal_world* world = rasqal_query_results_get_world(results);
+  rasqal_query* query = rasqal_query_results_get_query(results);
   raptor_sequence *seq = NULL;
+  const unsigned char **names = NULL;
   size_t *widths = NULL;
   int bindings_count = -1;
+  int lookahead = 0;
   int rows_count = 0;
   int rc = 0;
-  size_t total_width = 0;
-  int i;
-  size_t si;
   size_t sep_len;
-  char *sep = NULL;
+  int i;
+
+  if(query)
+    lookahead = rasqal_query_get_feature(query, RASQAL_FEATURE_TABLE_LOOKAHEAD);
+  if(lookahead <= 0)
+    lookahead = RASQAL_TABLE_DEFAULT_LOOKAHEAD;
 
   bindings_count = rasqal_query_results_get_bindings_count(results);
   widths = RASQAL_CALLOC(size_t*, RASQAL_GOOD_CAST(size_t, bindings_count + 1), sizeof(size_t));
-  if(!widths) {
+  names = RASQAL_CALLOC(const unsigned char**, RASQAL_GOOD_CAST(size_t, bindings_count + 1), sizeof(unsigned char*));
+  if(!widths || !names) {
     rc = 1;
     goto tidy;
   }
@@ -115,6 +330,7 @@ rasqal_query_results_write_table_bindings(raptor_iostream *iostr,
     name = rasqal_query_results_get_binding_name(results, i);
     if(!name)
       break;
+    names[i] = name;
 
     w = strlen(RASQAL_GOOD_CAST(const char*, name));
     if(w > widths[i])
@@ -127,120 +343,62 @@ rasqal_query_results_write_table_bindings(raptor_iostream *iostr,
     goto tidy;
   }
 
+  if(rasqal_query_results_table_read_block(world, results, seq, lookahead,
+                                           bindings_count, widths)) {
+    rc = 1;
+    goto tidy;
+  }
+
+  rows_count = raptor_sequence_size(seq);
+  sep_len = rasqal_query_results_table_write_block(iostr, names, seq,
+                                                   bindings_count, widths);
+
   while(!rasqal_query_results_finished(results)) {
     char **values;
-    values = RASQAL_CALLOC(char**, RASQAL_GOOD_CAST(size_t, bindings_count + 1), sizeof(char*));
+    int fits;
+
+    values = rasqal_query_results_table_format_row(world, results,
+                                                   bindings_count, widths,
+                                                   &fits);
     if(!values) {
       rc = 1;
       goto tidy;
     }
+    rasqal_query_results_next(results);
+    rows_count++;
 
-    for(i = 0; i < bindings_count; i++) {
-      rasqal_literal *l = rasqal_query_results_get_binding_value(results, i);
-      raptor_iostream* str_iostr;
-      size_t v_len;
-      
-      if(!l)
-        continue;
-
-      str_iostr = raptor_new_iostream_to_string(world->raptor_world_ptr,
-                                                (void**)&values[i], &v_len,
-                                                rasqal_alloc_memory);
-      if(!str_iostr) {
-        rc = 1;
-        goto tidy;
-      }
-      rasqal_literal_write(l, str_iostr);
-      raptor_free_iostream(str_iostr);
-      
-      if(v_len > widths[i])
-        widths[i] = v_len;
+    if(fits) {
+      rasqal_query_results_table_write_row(iostr, values, bindings_count,
+                                           widths);
+      rasqal_free_chararray(values);
+      continue;
     }
-    values[i] = RASQAL_GOOD_CAST(char*, -1);
 
-    raptor_sequence_push(seq, values);
-
-    rasqal_query_results_next(results);
-  }
+    /* Widen the columns for a new block starting with this row */
+    for(i = 0; i < bindings_count; i++) {
+      size_t w = values[i] ? strlen(values[i]) : 0;
 
-  rows_count = raptor_sequence_size(seq);
-  
-  total_width = 0;
-  for(i = 0; i < bindings_count; i++)
-    total_width += widths[i];
+      if(w > widths[i])
+        widths[i] = w;
+    }
 
-#define VSEP "|"
-#define VSEP_LEN 1
-#define PAD " "
-#define PAD_LEN 1
-  sep_len = total_width + RASQAL_GOOD_CAST(size_t, ((PAD_LEN+PAD_LEN) * bindings_count) + VSEP_LEN * (bindings_count + 1));
-  sep = RASQAL_MALLOC(char*, sep_len + 1);
-  if(!sep) {
-    rc = 1;
-    goto tidy;
-  }
-  for(si = 0 ; si < sep_len; si++)
-    sep[si]='-';
-  sep[sep_len]='\0';
-
-  if(1) {
-    char * p = sep;
-    memcpy(p, VSEP, VSEP_LEN);
-    p += VSEP_LEN;
-    for(i = 0; i < bindings_count; i++) {
-      p += PAD_LEN + widths[i] + PAD_LEN;
-      memcpy(p, VSEP, VSEP_LEN);
-      p += VSEP_LEN;
+    if(raptor_sequence_push(seq, values) ||
+       rasqal_query_results_table_read_block(world, results, seq, lookahead,
+                                             bindings_count, widths)) {
+      rc = 1;
+      goto tidy;
     }
-  }
-  
+    rows_count += raptor_sequence_size(seq) - 1;
 
-  /* Generate separator */
-  rasqal_iostream_write_counted_string_padded(iostr, NULL, 0, '-', sep_len);
-  raptor_iostream_write_byte('\n', iostr);
+    /* End the previous block */
+    rasqal_iostream_write_counted_string_padded(iostr, NULL, 0, '-', sep_len);
+    raptor_iostream_write_byte('\n', iostr);
 
-  /* Generate variables header */
-  raptor_iostream_counted_string_write(VSEP, VSEP_LEN, iostr);
-  for(i = 0; i < bindings_count; i++) {
-    const unsigned char *name;
-    size_t w;
-    name = rasqal_query_results_get_binding_name(results, i);
-    if(!name)
-      break;
-    w = strlen(RASQAL_GOOD_CAST(const char*, name));
-    
-    raptor_iostream_counted_string_write(PAD, PAD_LEN, iostr);
-    rasqal_iostream_write_counted_string_padded(iostr, name, w,
-                                                ' ', widths[i]);
-    raptor_iostream_counted_string_write(PAD, PAD_LEN, iostr);
-    raptor_iostream_counted_string_write(VSEP, VSEP_LEN, iostr);
+    sep_len = rasqal_query_results_table_write_block(iostr, names, seq,
+                                                     bindings_count, widths);
   }
-  raptor_iostream_write_byte('\n', iostr);
 
-  /* Generate separator */
-  rasqal_iostream_write_counted_string_padded(iostr, NULL, 0, '=', sep_len);
-  raptor_iostream_write_byte('\n', iostr);
-
-  /* Write values */
   if(rows_count) {
-    int rowi;
-    for(rowi = 0; rowi < rows_count; rowi++) {
-      char **values = (char**)raptor_sequence_get_at(seq, rowi);
-      
-      raptor_iostream_counted_string_write(VSEP, VSEP_LEN, iostr);
-      for(i = 0; i < bindings_count; i++) {
-        char *value = values[i];
-        size_t w = value ? strlen(RASQAL_GOOD_CAST(const char*, value)) : 0;
-    
-        raptor_iostream_counted_string_write(PAD, PAD_LEN, iostr);
-        rasqal_iostream_write_counted_string_padded(iostr, value, w,
-                                                    ' ', widths[i]);
-        raptor_iostream_counted_string_write(PAD, PAD_LEN, iostr);
-        raptor_iostream_counted_string_write(VSEP, VSEP_LEN, iostr);
-      }
-      raptor_iostream_write_byte('\n', iostr);
-    }
-
     /* Generate end separator */
     rasqal_iostream_write_counted_string_padded(iostr, NULL, 0, '-', sep_len);
     raptor_iostream_write_byte('\n', iostr);
@@ -248,10 +406,10 @@ rasqal_query_results_write_table_bindings(raptor_iostream *iostr,
   
 
   tidy:
-  if(sep)
-    RASQAL_FREE(string, sep);
   if(widths)
     RASQAL_FREE(intarray, widths);
+  if(names)
+    RASQAL_FREE(unsigned char**, names);
   if(seq)
     raptor_free_sequence(seq);
   
@@ -335,3 +493,131 @@ rasqal_init_result_format_table(rasqal_world* world)
   return !rasqal_world_register_query_results_format_factory(world,
                                                              &rasqal_query_results_table_register_factory);
 }
+
+
+#endif /* not STANDALONE */
+
+
+
+#ifdef STANDALONE
+
+/* one more prototype */
+int main(int argc, char *argv[]);
+
+
+#define TABLE_LOOKAHEAD 2
+
+/* rows of ?x; the 4th is wider than the first block of 2 rows */
+static const char* const table_test_values[] = {
+  "a", "b", "c", "wider than the block", "d", NULL
+};
+
+/* The 3rd row fits the first block's column; the 4th starts a new
+ * block with a wider column and a new header */
+static const char* const table_test_expected =
+  "---------------\n"
+  "| x           |\n"
+  "===============\n"
+  "| string(\"a\") |\n"
+  "| string(\"b\") |\n"
+  "| string(\"c\") |\n"
+  "---------------\n"
+  "----------------------------------\n"
+  "| x                              |\n"
+  "==================================\n"
+  "| string(\"wider than the block\") |\n"
+  "| string(\"d\")                    |\n"
+  "----------------------------------\n";
+
+int
+main(int argc, char *argv[])
+{
+  const char *program = rasqal_basename(argv[0]);
+  rasqal_world* world = NULL;
+  rasqal_query* query = NULL;
+  rasqal_query_results* results = NULL;
+  rasqal_query_results_formatter* formatter = NULL;
+  rasqal_variable* v;
+  raptor_uri* base_uri = NULL;
+  raptor_iostream* iostr = NULL;
+  void* string = NULL;
+  size_t string_len = 0;
+  int failures = 0;
+  int i;
+
+  world = rasqal_new_world();
+  if(!world || rasqal_world_open(world)) {
+    fprintf(stderr, "%s: rasqal_world init failed\n", program);
+    return(1);
+  }
+
+  query = rasqal_new_query(world, "sparql", NULL);
+  rasqal_query_set_feature(query, RASQAL_FEATURE_TABLE_LOOKAHEAD,
+                           TABLE_LOOKAHEAD);
+
+  results = rasqal_new_query_results2(world, query,
+                                      RASQAL_QUERY_RESULTS_BINDINGS);
+  v = rasqal_variables_table_add2(rasqal_query_results_get_variables_table(results),
+                                  RASQAL_VARIABLE_TYPE_NORMAL,
+                                  (const unsigned char*)"x", 0, NULL);
+  rasqal_free_variable(v);
+
+  for(i = 0; table_test_values[i]; i++) {
+    rasqal_row* row;
+    size_t len = strlen(table_test_values[i]);
+    unsigned char* s = RASQAL_MALLOC(unsigned char*, len + 1);
+
+    memcpy(s, table_test_values[i], len + 1);
+    row = rasqal_new_row_for_size(world, 1);
+    row->values[0] = rasqal_new_string_literal(world, s, NULL, NULL, NULL);
+    rasqal_query_results_add_row(results, row);
+  }
+  rasqal_query_results_rewind(results);
+
+  base_uri = raptor_new_uri(world->raptor_world_ptr,
+                            (const unsigned char*)"http://example.org/");
+  formatter = rasqal_new_query_results_formatter(world, "table", NULL, NULL);
+  iostr = raptor_new_iostream_to_string(world->raptor_world_ptr,
+                                        &string, &string_len,
+                                        rasqal_alloc_memory);
+  if(!formatter || !iostr) {
+    fprintf(stderr, "%s: failed to create table formatter\n", program);
+    failures++;
+    goto tidy;
+  }
+
+  if(rasqal_query_results_formatter_write(iostr, formatter, results,
+                                          base_uri)) {
+    fprintf(stderr, "%s: writing table failed\n", program);
+    failures++;
+    goto tidy;
+  }
+  raptor_free_iostream(iostr);
+  iostr = NULL;
+
+  if(!string || strcmp((const char*)string, table_test_expected)) {
+    fprintf(stderr, "%s: wrote table\n%sexpected\n%s", program,
+            string ? (const char*)string : "", table_test_expected);
+    failures++;
+  }
+
+  tidy:
+  if(iostr)
+    raptor_free_iostream(iostr);
+  if(string)
+    rasqal_free_memory(string);
+  if(formatter)
+    rasqal_free_query_results_formatter(formatter);
+  if(base_uri)
+    raptor_free_uri(base_uri);
+  if(results)
+    rasqal_free_query_results(results);
+  if(query)
+    rasqal_free_query(query);
+  if(world)
+    rasqal_free_world(world);
+
+  return failures;
+}
+
+#endif /* STANDALONE */
@@ -127,6 +127,18 @@ rasqal_new_world(void)
 
   world->genid_counter = 1;
 
+#ifdef HAVE_PTHREAD
+  if(pthread_mutex_init(&world->service_lock, NULL)) {
+    RASQAL_FREE(rasqal_world, world);
+    return NULL;
+  }
+  if(pthread_cond_init(&world->service_cond, NULL)) {
+    pthread_mutex_destroy(&world->service_lock);
+    RASQAL_FREE(rasqal_world, world);
+    return NULL;
+  }
+#endif
+
   return world;
 }
 
@@ -230,6 +242,9 @@ rasqal_free_world(rasqal_world* world)
   if(!world)
     return;
   
+  if(world->service_cache)
+    rasqal_free_service_cache(world->service_cache);
+
   rasqal_finish_result_formats(world);
   rasqal_finish_query_results();
 
@@ -246,6 +261,12 @@ rasqal_free_world(rasqal_world* world)
   if(world->raptor_world_ptr && world->raptor_world_allocated_here)
     raptor_free_world(world->raptor_world_ptr);
 
+#ifdef HAVE_PTHREAD
+  rasqal_service_free_connections(world);
+  pthread_cond_destroy(&world->service_cond);
+  pthread_mutex_destroy(&world->service_lock);
+#endif
+
   RASQAL_FREE(rasqal_world, world);
 }
 
@@ -33,6 +33,10 @@ typedef __int16 int16_t;
 #include <stdint.h>
 #endif
 
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #define RASQAL_EXTERN_C extern "C"
@@ -626,6 +630,10 @@ struct rasqal_row_s {
   int order_size;
   rasqal_literal** order_values;
 
+  /* binary sort key made from order_values (or NULL) */
+  unsigned char* order_key;
+  size_t order_key_len;
+
   /* Group ID */
   int group_id;
 
@@ -634,6 +642,61 @@ struct rasqal_row_s {
 };
 
 
+/* Default number of rows in a #rasqal_row_batch */
+#define RASQAL_ROW_BATCH_SIZE 1024
+
+/*
+ * A batch of rows of values stored by column, usually filled by
+ * rasqal_rowsource_read_batch()
+ *
+ * The values are held column-major so that value (@column, @row) is at
+ * values[column * capacity + row].  The @selection vector holds the
+ * (ascending) indexes of the @selected_count rows in the batch that are
+ * live; operators such as FILTER narrow it rather than copy rows.
+ */
+typedef struct {
+  rasqal_world* world;
+
+  /* Rowsource that last filled this batch (not owned); used for
+   * mapping column offsets to variables */
+  rasqal_rowsource* rowsource;
+
+  /* number of columns (variables) */
+  int size;
+
+  /* number of rows allocated */
+  int capacity;
+
+  /* maximum number of rows a producer may add (<= @capacity) */
+  int limit;
+
+  /* number of rows added */
+  int count;
+
+  /* column-major values array of size @size * @capacity */
+  rasqal_literal** values;
+
+  /* per-row offset and group ID, each of size @capacity */
+  int* offsets;
+  int* group_ids;
+
+  /* selection vector of row indexes into the batch */
+  int* selection;
+  int selected_count;
+
+  /* scratch arrays of size @capacity for typed numeric kernels
+   * (or NULL before first use) */
+  rasqal_integer* integers;
+  double* doubles;
+  unsigned char* matches;
+} rasqal_row_batch;
+
+#define RASQAL_ROW_BATCH_VALUE(batch, column, row_i) \
+  ((batch)->values[(column) * (batch)->capacity + (row_i)])
+
+#define RASQAL_ROW_BATCH_IS_FULL(batch) ((batch)->count >= (batch)->limit)
+
+
 typedef struct rasqal_map_s rasqal_map;
 
 /**
@@ -641,19 +704,35 @@ typedef struct rasqal_map_s rasqal_map;
  * @RASQAL_JOIN_TYPE_UNKNOWN: unknown join type
  * @RASQAL_JOIN_TYPE_NATURAL: natural join.  returns compatible rows and no NULLs
  * @RASQAL_JOIN_TYPE_LEFT: left join.  returns compatible rows plus rows from left rowsource that are not compatible or fail filter condition
+ * @RASQAL_JOIN_TYPE_SEMI: semi join.  returns rows from left rowsource that have at least one compatible row passing the filter condition
+ * @RASQAL_JOIN_TYPE_ANTI: anti join.  returns rows from left rowsource that have no compatible row passing the filter condition
  *
  * Rowsource join type.
+ *
+ * Semi and anti joins return only the left rowsource variables and
+ * stop reading the right rowsource at the first match for each left row.
  */
 typedef enum {
   RASQAL_JOIN_TYPE_UNKNOWN,
   RASQAL_JOIN_TYPE_NATURAL,
-  RASQAL_JOIN_TYPE_LEFT
+  RASQAL_JOIN_TYPE_LEFT,
+  RASQAL_JOIN_TYPE_SEMI,
+  RASQAL_JOIN_TYPE_ANTI
 } rasqal_join_type;
 
 
 
 /* rasqal_rowsource_aggregation.c */
 rasqal_rowsource* rasqal_new_aggregation_rowsource(rasqal_world *world, rasqal_query* query, rasqal_rowsource* rowsource, raptor_sequence* exprs_seq, raptor_sequence* vars_seq);
+rasqal_rowsource* rasqal_new_count_aggregation_rowsource(rasqal_world *world, rasqal_query* query, rasqal_integer count, rasqal_variable* variable);
+void* rasqal_builtin_agg_expression_execute_init(rasqal_world *world, rasqal_expression* expr);
+void rasqal_builtin_agg_expression_execute_finish(void* user_data);
+int rasqal_builtin_agg_expression_execute_step(void* user_data, raptor_sequence* literals);
+int rasqal_builtin_agg_expression_execute_merge(void* user_data, void* other_user_data);
+rasqal_literal* rasqal_builtin_agg_expression_execute_result(void* user_data);
+
+/* rasqal_rowsource_antijoin.c */
+rasqal_rowsource* rasqal_new_antijoin_rowsource(rasqal_world *world, rasqal_query* query, rasqal_rowsource* left, rasqal_rowsource* right, int minus);
 
 /* rasqal_rowsource_empty.c */
 rasqal_rowsource* rasqal_new_empty_rowsource(rasqal_world *world, rasqal_query* query);
@@ -667,6 +746,9 @@ rasqal_rowsource* rasqal_new_assignment_rowsource(rasqal_world *world, rasqal_qu
 /* rasqal_rowsource_bindings.c */
 rasqal_rowsource* rasqal_new_bindings_rowsource(rasqal_world *world, rasqal_query *query, rasqal_bindings* bindings);
 
+/* rasqal_rowsource_bindjoin.c */
+rasqal_rowsource* rasqal_new_bindjoin_rowsource(rasqal_world *world, rasqal_query* query, rasqal_rowsource* left, raptor_uri* service_uri, const unsigned char* query_string, raptor_sequence* data_graphs, raptor_sequence* service_vars, unsigned int rs_flags, int batch_size);
+
 /* rasqal_rowsource_distinct.c */
 rasqal_rowsource* rasqal_new_distinct_rowsource(rasqal_world *world, rasqal_query *query, rasqal_rowsource* rs);
 
@@ -760,6 +842,22 @@ typedef rasqal_row* (*rasqal_rowsource_read_row_func) (rasqal_rowsource* rowsour
 typedef raptor_sequence* (*rasqal_rowsource_read_all_rows_func) (rasqal_rowsource* rowsource, void *user_data);
 
 
+/**
+ * rasqal_rowsource_read_batch_func
+ * @user_data: user data
+ * @batch: batch to fill
+ *
+ * Handler function for filling a batch with the next result rows.
+ *
+ * The @batch is empty and sized to the rowsource variables on entry.
+ * The handler adds at most @batch->limit rows and sets the selection
+ * vector; an empty selection means the rowsource is exhausted.
+ *
+ * Return value: non-0 on failure
+ */
+typedef int (*rasqal_rowsource_read_batch_func) (rasqal_rowsource* rowsource, void *user_data, rasqal_row_batch* batch);
+
+
 /**
  * rasqal_rowsource_reset_func
  * @user_data: user data
@@ -812,7 +910,7 @@ typedef int (*rasqal_rowsource_set_origin_func) (rasqal_rowsource* rowsource, vo
 
 /**
  * rasqal_rowsource_handler:
- * @version: API version - 1
+ * @version: API version - 1 or 2
  * @name: rowsource name for debugging
  * @init:  initialisation handler - optional, called at most once (V1)
  * @finish: finishing handler - optional, called at most once (V1)
@@ -823,6 +921,7 @@ typedef int (*rasqal_rowsource_set_origin_func) (rasqal_rowsource* rowsource, vo
  * @set_requirements: set requirements flag handler - optional (V1)
  * @get_inner_rowsource: get inner rowsource handler - optional if has no inner rowsources (V1)
  * @set_origin: set origin (GRAPH) handler - optional (V1)
+ * @read_batch: read a batch of rows handler - optional; may be used instead of @read_row (V2)
  *
  * Row Source implementation factory handler structure.
  * 
@@ -840,6 +939,8 @@ typedef struct {
   rasqal_rowsource_set_requirements_func     set_requirements;
   rasqal_rowsource_get_inner_rowsource_func  get_inner_rowsource;
   rasqal_rowsource_set_origin_func           set_origin;
+  /* API V2 methods */
+  rasqal_rowsource_read_batch_func           read_batch;
 } rasqal_rowsource_handler;
 
 
@@ -898,6 +999,8 @@ typedef struct rasqal_results_compare_s rasqal_results_compare;
  * @offset: size of @rows_sequence
  * @generate_group: non-0 to generate a group (ID 0) around all the returned rows, if there is no grouping returned.
  * @usage: reference count
+ * @batch: batch of rows for use by rasqal_rowsource_read_row() (or NULL)
+ * @batch_offset: offset into selection of @batch
  *
  * Rasqal Row Source class providing a sequence of rows of values similar to a SQL table.
  *
@@ -929,6 +1032,12 @@ typedef struct rasqal_results_compare_s rasqal_results_compare;
  * The @rows_sequence and @offset variables are used by the
  * rasqal_rowsource_read_row() function when operating over a handler
  * that will only return a full sequence: handler->read_all_rows is NULL.
+ *
+ * The @batch and @batch_offset variables are used by the
+ * rasqal_rowsource_read_row() function when operating over a handler
+ * that will only return batches: handler->read_row is NULL.
+ * rasqal_rowsource_read_batch() reads rows a batch at a time from
+ * either kind of handler.
  */
 struct rasqal_rowsource_s
 {
@@ -961,6 +1070,10 @@ struct rasqal_rowsource_s
   unsigned int generate_group : 1;
 
   int usage;
+
+  rasqal_row_batch* batch;
+
+  int batch_offset;
 };
 
 
@@ -972,6 +1085,7 @@ void rasqal_free_rowsource(rasqal_rowsource *rowsource);
 rasqal_row* rasqal_rowsource_read_row(rasqal_rowsource *rowsource);
 int rasqal_rowsource_get_rows_count(rasqal_rowsource *rowsource);
 raptor_sequence* rasqal_rowsource_read_all_rows(rasqal_rowsource *rowsource);
+int rasqal_rowsource_read_batch(rasqal_rowsource *rowsource, rasqal_row_batch* batch);
 int rasqal_rowsource_get_size(rasqal_rowsource *rowsource);
 int rasqal_rowsource_add_variable(rasqal_rowsource *rowsource, rasqal_variable* v);
 rasqal_variable* rasqal_rowsource_get_variable_by_offset(rasqal_rowsource *rowsource, int offset);
@@ -1188,6 +1302,10 @@ int rasqal_double_approximately_equal(double a, double b);
 rasqal_literal* rasqal_new_string_literal_node(rasqal_world*, const unsigned char *string, const char *language, raptor_uri *datatype);
 int rasqal_literal_as_boolean(rasqal_literal* literal, int* error_p);
 int rasqal_literal_as_integer(rasqal_literal* l, int* error_p);
+rasqal_integer rasqal_literal_as_integer64(rasqal_literal* l, int* error_p);
+int rasqal_integer_add(rasqal_integer a, rasqal_integer b, rasqal_integer* result_p);
+int rasqal_integer_subtract(rasqal_integer a, rasqal_integer b, rasqal_integer* result_p);
+int rasqal_integer_multiply(rasqal_integer a, rasqal_integer b, rasqal_integer* result_p);
 double rasqal_literal_as_double(rasqal_literal* l, int* error_p);
 raptor_uri* rasqal_literal_as_uri(rasqal_literal* l);
 int rasqal_literal_string_to_native(rasqal_literal *l, int flags);
@@ -1262,13 +1380,6 @@ int rasqal_strncasecmp(const char* s1, const char* s2, size_t n);
 #  endif
 #endif
 
-/* timegm.c */
-#ifdef HAVE_TIMEGM
-#define rasqal_timegm timegm
-#else
-time_t rasqal_timegm(struct tm *tm);
-#endif
-
 /* rasqal_raptor.c */
 int rasqal_raptor_init(rasqal_world*);
 
@@ -1305,6 +1416,10 @@ extern const unsigned char* rasqal_xsd_boolean_false;
 
 rasqal_literal* rasqal_literal_cast(rasqal_literal* l, raptor_uri* datatype, int flags,  int* error_p);
 rasqal_literal* rasqal_new_numeric_literal(rasqal_world*, rasqal_literal_type type, double d);
+rasqal_literal* rasqal_new_computed_integer_literal(rasqal_world* world, rasqal_literal_type type, rasqal_integer integer);
+rasqal_literal* rasqal_new_computed_floating_literal(rasqal_world* world, rasqal_literal_type type, double d);
+rasqal_literal* rasqal_new_computed_decimal_literal(rasqal_world* world, rasqal_xsd_decimal* decimal);
+int rasqal_literal_ensure_string(rasqal_literal* l);
 int rasqal_literal_is_numeric(rasqal_literal* literal);
 rasqal_literal* rasqal_literal_add(rasqal_literal* l1, rasqal_literal* l2, int *error);
 rasqal_literal* rasqal_literal_subtract(rasqal_literal* l1, rasqal_literal* l2, int *error);
@@ -1317,6 +1432,7 @@ rasqal_literal* rasqal_literal_ceil(rasqal_literal* l1,  int *error_p);
 rasqal_literal* rasqal_literal_floor(rasqal_literal* l1, int *error_p);
 int rasqal_literal_equals_flags(rasqal_literal* l1, rasqal_literal* l2, int flags, int* error);
 int rasqal_literal_not_equals_flags(rasqal_literal* l1, rasqal_literal* l2, int flags, int* error);
+int rasqal_literal_hash(rasqal_literal* l, unsigned int* hash_p);
 void rasqal_literal_write_type(rasqal_literal* l, raptor_iostream* iostr);
 void rasqal_literal_write(rasqal_literal* l, raptor_iostream* iostr);
 void rasqal_expression_write_op(rasqal_expression* e, raptor_iostream* iostr);
@@ -1380,6 +1496,7 @@ int rasqal_query_results_set_boolean(rasqal_query_results* query_results, int va
 /* rasqal_query_write.c */
 int rasqal_query_write_sparql_20060406_graph_pattern(rasqal_graph_pattern* gp, raptor_iostream *iostr,raptor_uri* base_uri);
 int rasqal_query_write_sparql_20060406(raptor_iostream *iostr, rasqal_query* query, raptor_uri *base_uri);
+int rasqal_query_write_sparql_values_clause(rasqal_world* world, raptor_iostream *iostr, rasqal_bindings* bindings);
 
 /* rasqal_result_formats.c */
 rasqal_query_results_format_factory* rasqal_world_register_query_results_format_factory(rasqal_world* world, int (*register_factory) (rasqal_query_results_format_factory*));
@@ -1424,6 +1541,18 @@ void rasqal_row_set_rowsource(rasqal_row* row, rasqal_rowsource* rowsource);
 void rasqal_row_set_weak_rowsource(rasqal_row* row, rasqal_rowsource* rowsource);
 rasqal_variable* rasqal_row_get_variable_by_offset(rasqal_row* row, int offset);
 
+/* rasqal_row_batch.c */
+rasqal_row_batch* rasqal_new_row_batch(rasqal_world* world, int size, int capacity);
+void rasqal_free_row_batch(rasqal_row_batch* batch);
+int rasqal_row_batch_set_size(rasqal_row_batch* batch, int size);
+void rasqal_row_batch_clear(rasqal_row_batch* batch);
+int rasqal_row_batch_add_empty_row(rasqal_row_batch* batch);
+int rasqal_row_batch_add_row(rasqal_row_batch* batch, rasqal_row* row);
+rasqal_row* rasqal_row_batch_get_row(rasqal_row_batch* batch, int row_i);
+int rasqal_row_batch_bind_variables(rasqal_row_batch* batch, int row_i);
+void rasqal_row_batch_select_all(rasqal_row_batch* batch);
+int rasqal_row_batch_select_numeric_compare(rasqal_row_batch* batch, int column, rasqal_op op, rasqal_literal* value);
+
 /* rasqal_row_compatible.c */
 rasqal_row_compatible* rasqal_new_row_compatible(rasqal_variables_table* vt, rasqal_rowsource *first_rowsource, rasqal_rowsource *second_rowsource);
 void rasqal_free_row_compatible(rasqal_row_compatible* map);
@@ -1436,6 +1565,7 @@ int rasqal_reset_triple_meta(rasqal_triple_meta* m);
 void rasqal_free_triples_source(rasqal_triples_source *rts);
 int rasqal_triples_source_triple_present(rasqal_triples_source *rts, rasqal_triple *t);
 int rasqal_triples_source_support_feature(rasqal_triples_source *rts, rasqal_triples_source_feature feature);
+int rasqal_triples_source_triples_count(rasqal_triples_source *rts, rasqal_triple *t, rasqal_integer *count_p);
 
 rasqal_triples_match* rasqal_new_triples_match(rasqal_query* query, rasqal_triples_source* triples_source, rasqal_triple_meta *m, rasqal_triple *t);
 rasqal_triple_parts rasqal_triples_match_bind_match(struct rasqal_triples_match_s* rtm, rasqal_variable *bindings[4],rasqal_triple_parts parts);
@@ -1453,17 +1583,45 @@ const char* rasqal_xsd_datatype_label(rasqal_literal_type native_type);
 int rasqal_xsd_is_datatype_uri(rasqal_world*, raptor_uri* uri);
 
 int rasqal_xsd_datatype_is_numeric(rasqal_literal_type type);
-unsigned char* rasqal_xsd_format_integer(int i, size_t *len_p);
+unsigned char* rasqal_xsd_format_integer(rasqal_integer i, size_t *len_p);
+int rasqal_xsd_parse_integer(const unsigned char* string, rasqal_integer* value_p);
 unsigned char* rasqal_xsd_format_float(float f, size_t *len_p);
 unsigned char* rasqal_xsd_format_double(double d, size_t *len_p);
 rasqal_literal_type rasqal_xsd_datatype_parent_type(rasqal_literal_type type);
 
 int rasqal_xsd_boolean_value_from_string(const unsigned char* string);
 
+/* size of rasqal_world xsd_datatype_hash; a power of 2 over twice the
+ * number of XSD datatype names */
+#define RASQAL_XSD_DATATYPE_HASH_SIZE 64
+
 
 typedef struct rasqal_graph_factory_s rasqal_graph_factory;
 
 /* rasqal_world structure */
+typedef struct rasqal_service_cache_s rasqal_service_cache;
+
+#ifdef HAVE_PTHREAD
+/*
+ * Connection to a SERVICE endpoint
+ *
+ * The WWW object owns the connection, which is a libcurl handle
+ * keeping the HTTP connection alive when raptor uses libcurl.  Each
+ * retrieval shares it with a WWW object of its own made by
+ * raptor_new_www_with_connection().  Only one retrieval at a time
+ * uses a connection and its raptor_world.
+ */
+typedef struct rasqal_service_connection_s
+{
+  /* service URI string */
+  char* endpoint;
+  raptor_world* raptor_world_ptr;
+  raptor_www* www;
+  /* next idle connection of the world */
+  struct rasqal_service_connection_s* next;
+} rasqal_service_connection;
+#endif
+
 struct rasqal_world_s {
   /* opened flag */
   int opened;
@@ -1496,6 +1654,8 @@ struct rasqal_world_s {
   /* rasqal_xsd_datatypes */
   raptor_uri *xsd_namespace_uri;
   raptor_uri **xsd_datatype_uris;
+  /* open addressed hash of XSD local names to xsd_datatype_uris index */
+  unsigned char xsd_datatype_hash[RASQAL_XSD_DATATYPE_HASH_SIZE];
 
   /* graph factory */
   rasqal_graph_factory *graph_factory;
@@ -1517,6 +1677,20 @@ struct rasqal_world_s {
 
   /* generated counter - increments at every generation */
   int genid_counter;
+
+#ifdef HAVE_PTHREAD
+  /* number of service requests being retrieved, guarded by service_lock */
+  pthread_mutex_t service_lock;
+  pthread_cond_t service_cond;
+  int service_requests_active;
+  /* idle SERVICE connections kept for reuse, most recently used
+   * first, guarded by service_lock */
+  rasqal_service_connection* service_connections;
+  int service_connections_count;
+#endif
+
+  /* SERVICE results cache or NULL when disabled */
+  rasqal_service_cache* service_cache;
 };
 
 
@@ -1547,15 +1721,18 @@ typedef enum {
   RASQAL_ALGEBRA_OPERATOR_HAVING   = 17,
   RASQAL_ALGEBRA_OPERATOR_VALUES   = 18,
   RASQAL_ALGEBRA_OPERATOR_SERVICE  = 19,
+  RASQAL_ALGEBRA_OPERATOR_MINUS    = 20,
 
-  RASQAL_ALGEBRA_OPERATOR_LAST = RASQAL_ALGEBRA_OPERATOR_SERVICE
+  RASQAL_ALGEBRA_OPERATOR_LAST = RASQAL_ALGEBRA_OPERATOR_MINUS
 } rasqal_algebra_node_operator;
 
 
 /* bitflags used by rasqal_algebra_node and rasqal_rowsource */
 typedef enum {
   /* used by */
-  RASQAL_ENGINE_BITFLAG_SILENT = 1
+  RASQAL_ENGINE_BITFLAG_SILENT = 1,
+  /* used by JOIN: only the left rows that have a match are needed */
+  RASQAL_ENGINE_BITFLAG_EXISTS_ONLY = 2
 } rasqal_engine_bitflags;
 
 
@@ -1575,7 +1752,7 @@ struct rasqal_algebra_node_s {
   int start_column;
   int end_column;
   
-  /* types JOIN, DIFF, LEFTJOIN, UNION, ORDERBY: node1 and node2 ALWAYS present
+  /* types JOIN, DIFF, LEFTJOIN, UNION, ORDERBY, MINUS: node1 and node2 ALWAYS present
    * types FILTER, TOLIST: node1 ALWAYS present, node2 ALWAYS NULL
    * type PROJECT, GRAPH, GROUPBY, AGGREGATION, HAVING: node1 always present
    * (otherwise NULL)
@@ -1597,7 +1774,9 @@ struct rasqal_algebra_node_s {
   /* types PROJECT, DISTINCT, REDUCED
    * FIXME: sequence of solution mappings */
 
-  /* types PROJECT, AGGREGATION: sequence of #rasqal_variable */
+  /* types PROJECT, AGGREGATION: sequence of #rasqal_variable
+   * type SERVICE: sequence of #rasqal_variable bound by the service pattern
+   */
   raptor_sequence* vars_seq;
 
   /* type SLICE: limit and offset rows */
@@ -1810,10 +1989,16 @@ const char* rasqal_engine_error_as_string(rasqal_engine_error error);
 
 
 /* rasqal_engine_sort.c */
+typedef struct rasqal_rowsort_keys_s rasqal_rowsort_keys;
+
 rasqal_map* rasqal_engine_new_rowsort_map(int is_distinct, int compare_flags, raptor_sequence* order_conditions_sequence);
 int rasqal_engine_rowsort_map_add_row(rasqal_map* map, rasqal_row* row);
 raptor_sequence* rasqal_engine_rowsort_map_to_sequence(rasqal_map* map, raptor_sequence* seq);
-int rasqal_engine_rowsort_calculate_order_values(rasqal_query* query, raptor_sequence* order_seq, rasqal_row* row);
+rasqal_rowsort_keys* rasqal_engine_new_rowsort_keys(int compare_flags, raptor_sequence* order_conditions_sequence);
+void rasqal_engine_free_rowsort_keys(rasqal_rowsort_keys* keys);
+int rasqal_engine_rowsort_keys_usable(rasqal_rowsort_keys* keys);
+int rasqal_engine_rowsort_keys_sort(rasqal_rowsort_keys* keys, raptor_sequence* rows, raptor_sequence* seq);
+int rasqal_engine_rowsort_calculate_order_values(rasqal_query* query, raptor_sequence* order_seq, rasqal_row* row, rasqal_rowsort_keys* keys);
 
 
 /* rasqal_engine_algebra.c */
@@ -1863,6 +2048,7 @@ int rasqal_regex_match(rasqal_world* world, raptor_locator* locator, const char*
 rasqal_results_compare* rasqal_new_results_compare(rasqal_world* world, rasqal_query_results *first_qr, const char* first_qr_label, rasqal_query_results *second_qr, const char* second_qr_label);
 void rasqal_free_results_compare(rasqal_results_compare* rrc);
 void rasqal_results_compare_set_log_handler(rasqal_results_compare* rrc, void* log_user_data, raptor_log_handler log_handler);
+void rasqal_results_compare_set_unordered(rasqal_results_compare* rrc, int unordered);
 int rasqal_results_compare_compare(rasqal_results_compare* rrc);
 rasqal_variable* rasqal_results_compare_get_variable_by_offset(rasqal_results_compare* rrc, int idx);
 int rasqal_results_compare_get_variable_offset_for_result(rasqal_results_compare* rrc, int var_idx, int qr_index);
@@ -1871,6 +2057,18 @@ void rasqal_print_results_compare(FILE *handle, rasqal_results_compare* rrc);
 
 /* rasqal_service.c */
 rasqal_service* rasqal_new_service_from_service(rasqal_service* svc);
+int rasqal_service_set_request_limits(rasqal_service* svc, int timeout, int concurrency);
+int rasqal_service_prefetch(rasqal_service* svc);
+int rasqal_service_get_failed(rasqal_service* svc);
+#ifdef HAVE_PTHREAD
+void rasqal_service_free_connections(rasqal_world* world);
+#endif
+
+/* rasqal_service_cache.c */
+void rasqal_free_service_cache(rasqal_service_cache* cache);
+int rasqal_service_cache_contains(rasqal_service_cache* cache, const unsigned char* key, size_t key_len);
+rasqal_rowsource* rasqal_service_cache_get_rowsource(rasqal_service_cache* cache, const unsigned char* key, size_t key_len, rasqal_variables_table* vars_table);
+int rasqal_service_cache_add(rasqal_service_cache* cache, const unsigned char* key, size_t key_len, raptor_sequence* vars_seq, raptor_sequence* rows_seq);
 
 /* rasqal_solution_modifier.c */
 rasqal_solution_modifier* rasqal_new_solution_modifier(rasqal_query* query, raptor_sequence* order_conditions, raptor_sequence* group_conditions, raptor_sequence* having_conditions, int limit, int offset);
@@ -1967,6 +2165,15 @@ size_t rasqal_format_integer(char* buffer, size_t bufsize, int integer, int widt
 /* Converting a double / float to int - OK but not great */
 #define RASQAL_FLOATING_AS_INT(v) ((int)(v))
 
+/* Range of a #rasqal_integer */
+#ifdef INT64_MAX
+#define RASQAL_INTEGER_MIN INT64_MIN
+#define RASQAL_INTEGER_MAX INT64_MAX
+#else
+#define RASQAL_INTEGER_MIN _I64_MIN
+#define RASQAL_INTEGER_MAX _I64_MAX
+#endif
+
 /* IEEE 32 bit double ~ 1E-07 and 64 bit double  ~ 2E-16 */
 #define RASQAL_DOUBLE_EPSILON (DBL_EPSILON)
 
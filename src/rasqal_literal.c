@@ -73,6 +73,8 @@
 /* prototypes */
 static rasqal_literal_type rasqal_literal_promote_numerics(rasqal_literal* l1, rasqal_literal* l2, int flags);
 static int rasqal_literal_set_typed_value(rasqal_literal* l, rasqal_literal_type type, const unsigned char* string, int canonicalize);
+static rasqal_literal* rasqal_new_integer_literal_common(rasqal_world* world, rasqal_literal_type type, rasqal_integer integer, int lazy);
+static rasqal_literal* rasqal_new_floating_literal_common(rasqal_world *world, rasqal_literal_type type, double d, int lazy);
 
 
 const unsigned char* rasqal_xsd_boolean_true = (const unsigned char*)"true";
@@ -83,7 +85,7 @@ const unsigned char* rasqal_xsd_boolean_false = (const unsigned char*)"false";
  * rasqal_new_integer_literal:
  * @world: rasqal world object
  * @type: Type of literal such as RASQAL_LITERAL_INTEGER or RASQAL_LITERAL_BOOLEAN
- * @integer: int value
+ * @integer: integer value
  *
  * Constructor - Create a new Rasqal integer literal.
  * 
@@ -94,13 +96,45 @@ const unsigned char* rasqal_xsd_boolean_false = (const unsigned char*)"false";
  **/
 rasqal_literal*
 rasqal_new_integer_literal(rasqal_world* world, rasqal_literal_type type,
-                           int integer)
+                           rasqal_integer integer)
+{
+  RASQAL_ASSERT_OBJECT_POINTER_RETURN_VALUE(world, rasqal_world, NULL);
+
+  return rasqal_new_integer_literal_common(world, type, integer, 0);
+}
+
+
+/*
+ * rasqal_new_computed_integer_literal:
+ * @world: rasqal world object
+ * @type: Type of literal such as RASQAL_LITERAL_INTEGER
+ * @integer: integer value
+ *
+ * INTERNAL - Create a new integer literal for a computed value
+ *
+ * The lexical form is not made until it is first used; see
+ * rasqal_literal_ensure_string().
+ *
+ * Return value: New #rasqal_literal or NULL on failure
+ */
+rasqal_literal*
+rasqal_new_computed_integer_literal(rasqal_world* world,
+                                    rasqal_literal_type type,
+                                    rasqal_integer integer)
+{
+  return rasqal_new_integer_literal_common(world, type, integer, 1);
+}
+
+
+static rasqal_literal*
+rasqal_new_integer_literal_common(rasqal_world* world,
+                                  rasqal_literal_type type,
+                                  rasqal_integer integer,
+                                  int lazy)
 {
   raptor_uri* dt_uri;
   rasqal_literal* l;
 
-  RASQAL_ASSERT_OBJECT_POINTER_RETURN_VALUE(world, rasqal_world, NULL);
-
   l  = RASQAL_CALLOC(rasqal_literal*, 1, sizeof(*l));
   if(l) {
     l->valid = 1;
@@ -112,7 +146,7 @@ rasqal_new_integer_literal(rasqal_world* world, rasqal_literal_type type,
        /* static l->string for boolean, does not need freeing */
        l->string = integer ? rasqal_xsd_boolean_true : rasqal_xsd_boolean_false;
        l->string_len = integer ? RASQAL_XSD_BOOLEAN_TRUE_LEN : RASQAL_XSD_BOOLEAN_FALSE_LEN;
-    } else  {
+    } else if(!lazy) {
       size_t slen = 0;      
       l->string = rasqal_xsd_format_integer(integer, &slen);
       l->string_len = RASQAL_BAD_CAST(unsigned int, slen);
@@ -141,8 +175,8 @@ rasqal_new_integer_literal(rasqal_world* world, rasqal_literal_type type,
  *
  * Constructor - Create a new Rasqal numeric literal from a long.
  * 
- * The value is turned into a rasqal integer or decimal literal and
- * given a datatype of xsd:integer
+ * The value is turned into a rasqal integer literal and given a
+ * datatype of xsd:integer; a long always fits in a #rasqal_integer.
  * 
  * Return value: New #rasqal_literal or NULL on failure
  **/
@@ -151,9 +185,6 @@ rasqal_new_numeric_literal_from_long(rasqal_world* world,
                                      rasqal_literal_type type,
                                      long value)
 {
-  rasqal_xsd_decimal* d;
-  unsigned char *string;
-
   RASQAL_ASSERT_OBJECT_POINTER_RETURN_VALUE(world, rasqal_world, NULL);
 
   /* boolean values should always be in range */
@@ -162,17 +193,8 @@ rasqal_new_numeric_literal_from_long(rasqal_world* world,
     return rasqal_new_integer_literal(world, type, ivalue);
   }
   
-  /* For other types, if in int range, make an integer literal */
-  if(value >= INT_MIN && value <= INT_MAX) {
-    return rasqal_new_integer_literal(world, type, RASQAL_GOOD_CAST(int, value));
-  }
-
-  /* Otherwise turn it into a decimal */
-  d = rasqal_new_xsd_decimal(world);
-  rasqal_xsd_decimal_set_long(d, value);
-  string = RASQAL_GOOD_CAST(unsigned char*, rasqal_xsd_decimal_as_counted_string(d, NULL));
-
-  return rasqal_new_decimal_literal_from_decimal(world, string, d);
+  return rasqal_new_integer_literal(world, type,
+                                    RASQAL_GOOD_CAST(rasqal_integer, value));
 }
 
 
@@ -233,28 +255,61 @@ rasqal_new_typed_literal(rasqal_world* world, rasqal_literal_type type,
 rasqal_literal*
 rasqal_new_floating_literal(rasqal_world *world,
                             rasqal_literal_type type, double d)
+{
+  RASQAL_ASSERT_OBJECT_POINTER_RETURN_VALUE(world, rasqal_world, NULL);
+
+  return rasqal_new_floating_literal_common(world, type, d, 0);
+}
+
+
+/*
+ * rasqal_new_computed_floating_literal:
+ * @world: rasqal world object
+ * @type: type - #RASQAL_LITERAL_FLOAT or #RASQAL_LITERAL_DOUBLE
+ * @d: floating value
+ *
+ * INTERNAL - Create a new float literal for a computed value
+ *
+ * The lexical form is not made until it is first used; see
+ * rasqal_literal_ensure_string().
+ *
+ * Return value: New #rasqal_literal or NULL on failure
+ */
+rasqal_literal*
+rasqal_new_computed_floating_literal(rasqal_world *world,
+                                     rasqal_literal_type type, double d)
+{
+  return rasqal_new_floating_literal_common(world, type, d, 1);
+}
+
+
+static rasqal_literal*
+rasqal_new_floating_literal_common(rasqal_world *world,
+                                   rasqal_literal_type type, double d,
+                                   int lazy)
 {
   raptor_uri* dt_uri;
   rasqal_literal* l;
 
-  RASQAL_ASSERT_OBJECT_POINTER_RETURN_VALUE(world, rasqal_world, NULL);
-
   if(type != RASQAL_LITERAL_FLOAT && type != RASQAL_LITERAL_DOUBLE)
     return NULL;
 
   l = RASQAL_CALLOC(rasqal_literal*, 1, sizeof(*l));
   if(l) {
-    size_t slen = 0;
     l->valid = 1;
     l->usage = 1;
     l->world = world;
     l->type = type;
     l->value.floating = d;
-    l->string = rasqal_xsd_format_double(d, &slen);
-    l->string_len = RASQAL_BAD_CAST(unsigned int, slen);
-    if(!l->string) {
-      rasqal_free_literal(l);
-      return NULL;
+    if(!lazy) {
+      size_t slen = 0;
+
+      l->string = rasqal_xsd_format_double(d, &slen);
+      l->string_len = RASQAL_BAD_CAST(unsigned int, slen);
+      if(!l->string) {
+        rasqal_free_literal(l);
+        return NULL;
+      }
     }
     dt_uri = rasqal_xsd_datatype_type_to_uri(world, l->type);
     if(!dt_uri) {
@@ -464,6 +519,45 @@ rasqal_new_decimal_literal_from_decimal(rasqal_world* world,
 }
 
 
+/*
+ * rasqal_new_computed_decimal_literal:
+ * @world: rasqal world object
+ * @decimal: rasqal XSD Decimal (ownership taken)
+ *
+ * INTERNAL - Create a new decimal literal for a computed value
+ *
+ * The lexical form is not made until it is first used; see
+ * rasqal_literal_ensure_string().
+ *
+ * Return value: New #rasqal_literal or NULL on failure
+ */
+rasqal_literal*
+rasqal_new_computed_decimal_literal(rasqal_world* world,
+                                    rasqal_xsd_decimal* decimal)
+{
+  rasqal_literal* l;
+  raptor_uri *dt_uri;
+
+  dt_uri = rasqal_xsd_datatype_type_to_uri(world, RASQAL_LITERAL_DECIMAL);
+  l = RASQAL_CALLOC(rasqal_literal*, 1, sizeof(*l));
+  if(!l || !dt_uri) {
+    if(l)
+      RASQAL_FREE(rasqal_literal, l);
+    rasqal_free_xsd_decimal(decimal);
+    return NULL;
+  }
+
+  l->valid = 1;
+  l->usage = 1;
+  l->world = world;
+  l->type = RASQAL_LITERAL_DECIMAL;
+  l->datatype = raptor_uri_copy(dt_uri);
+  l->value.decimal = decimal;
+
+  return l;
+}
+
+
 /*
  * rasqal_new_numeric_literal:
  * @world: rasqal world object
@@ -472,6 +566,9 @@ rasqal_new_decimal_literal_from_decimal(rasqal_world* world,
  *
  * INTERNAL - Make a numeric datatype from a double  
  *
+ * Integer and floating results are computed literals; see
+ * rasqal_literal_ensure_string().
+ *
  * Return value: new literal or NULL on failure
  **/
 rasqal_literal*
@@ -485,12 +582,14 @@ rasqal_new_numeric_literal(rasqal_world* world, rasqal_literal_type type,
   switch(type) {
     case RASQAL_LITERAL_DOUBLE:
     case RASQAL_LITERAL_FLOAT:
-      return rasqal_new_floating_literal(world, type, d);
+      return rasqal_new_computed_floating_literal(world, type, d);
 
     case RASQAL_LITERAL_INTEGER:
     case RASQAL_LITERAL_INTEGER_SUBTYPE: 
-      if(d >= (double)INT_MIN && d <= (double)INT_MAX)
-        return rasqal_new_integer_literal(world, type, RASQAL_GOOD_CAST(int, d));
+      /* -2^63 <= d < 2^63 */
+      if(d >= -9223372036854775808.0 && d < 9223372036854775808.0)
+        return rasqal_new_computed_integer_literal(world, type,
+                                                   RASQAL_BAD_CAST(rasqal_integer, d));
 
       /* otherwise FALLTHROUGH and make it a decimal */
 
@@ -590,7 +689,6 @@ rasqal_literal_set_typed_value(rasqal_literal* l, rasqal_literal_type type,
                                const unsigned char* string,
                                int canonicalize)
 {  
-  char *eptr;
   raptor_uri* dt_uri;
   int i;
   double d;
@@ -598,6 +696,9 @@ rasqal_literal_set_typed_value(rasqal_literal* l, rasqal_literal_type type,
 
   RASQAL_ASSERT_OBJECT_POINTER_RETURN_VALUE(l, rasqal_literal, 1);
 
+  /* the string may change so forget what was known about it */
+  l->ascii = 0;
+
 retype:
   l->valid = rasqal_xsd_datatype_check(type, string ? string : l->string,
                                        0 /* no flags set */);
@@ -640,24 +741,20 @@ retype:
     case RASQAL_LITERAL_INTEGER:
     case RASQAL_LITERAL_INTEGER_SUBTYPE:
       if(1) {
-        long long_i;
+        rasqal_integer integer = 0;
+        int rc;
 
-        eptr = NULL;
-        errno = 0;
-        long_i = strtol(RASQAL_GOOD_CAST(const char*, l->string), &eptr, 10);
-        if(*eptr)
+        rc = rasqal_xsd_parse_integer(l->string, &integer);
+        if(rc < 0)
           return 1;
 
-        if(errno == ERANGE) {
-          /* under or overflow of strtol() so fallthrough to DECIMAL */
-
-        } else if(long_i >= INT_MIN && long_i <= INT_MAX) {
-          l->value.integer = RASQAL_GOOD_CAST(int, long_i);
+        if(!rc) {
+          l->value.integer = integer;
           break;
         }
       }
       
-      /* Will not fit in an int so turn it into a decimal */
+      /* Will not fit in a rasqal_integer so turn it into a decimal */
       type = RASQAL_LITERAL_DECIMAL;
       goto retype;
 
@@ -846,7 +943,8 @@ rasqal_literal_string_to_native(rasqal_literal *l, int flags)
                                       NULL /* existing string */,
                                       canonicalize);
 
-  if(!rasqal_xsd_datatype_check(native_type, l->string, 1))
+  /* set_typed_value() already checked the lexical form */
+  if(!l->valid)
     return 0;
   
   return rc;
@@ -1398,6 +1496,7 @@ rasqal_literal_write(rasqal_literal* l, raptor_iostream* iostr)
     case RASQAL_LITERAL_DATETIME:
     case RASQAL_LITERAL_INTEGER_SUBTYPE:
       raptor_iostream_write_byte('(', iostr);
+      rasqal_literal_ensure_string(l);
       raptor_iostream_counted_string_write(l->string, l->string_len, iostr);
       raptor_iostream_write_byte(')', iostr);
       break;
@@ -1530,16 +1629,49 @@ rasqal_literal_as_boolean(rasqal_literal* l, int *error_p)
  * @l: #rasqal_literal object
  * @error_p: pointer to error flag
  * 
- * INTERNAL - Return a literal as an integer value
+ * INTERNAL - Return a literal as an int value
  *
- * Integers, booleans, double and float literals natural are turned into
- * integers. If string values are the lexical form of an integer, that is
- * returned.  Otherwise the error flag is set.
+ * As rasqal_literal_as_integer64() but values outside the range of
+ * an int also set the error flag.
  * 
  * Return value: integer value
  **/
 int
 rasqal_literal_as_integer(rasqal_literal* l, int *error_p)
+{
+  int error = 0;
+  rasqal_integer i;
+
+  i = rasqal_literal_as_integer64(l, &error);
+  if(!error && (i < INT_MIN || i > INT_MAX))
+    error = 1;
+
+  if(error) {
+    if(error_p)
+      *error_p = 1;
+    return 0;
+  }
+
+  return RASQAL_BAD_CAST(int, i);
+}
+
+
+/*
+ * rasqal_literal_as_integer64
+ * @l: #rasqal_literal object
+ * @error_p: pointer to error flag
+ * 
+ * INTERNAL - Return a literal as a #rasqal_integer value
+ *
+ * Integers, booleans, double and float literals natural are turned into
+ * integers. If string values are the lexical form of an integer, that is
+ * returned.  Otherwise, or if the value is out of the #rasqal_integer
+ * range, the error flag is set.
+ * 
+ * Return value: integer value
+ **/
+rasqal_integer
+rasqal_literal_as_integer64(rasqal_literal* l, int *error_p)
 {
   if(!l) {
     /* type error */
@@ -1558,23 +1690,27 @@ rasqal_literal_as_integer(rasqal_literal* l, int *error_p)
 
     case RASQAL_LITERAL_DOUBLE:
     case RASQAL_LITERAL_FLOAT:
-      return RASQAL_FLOATING_AS_INT(l->value.floating);
+      /* -2^63 <= value < 2^63; also false for NaN */
+      if(l->value.floating >= -9223372036854775808.0 &&
+         l->value.floating < 9223372036854775808.0)
+        return RASQAL_BAD_CAST(rasqal_integer, l->value.floating);
+
+      if(error_p)
+        *error_p = 1;
+      return 0;
 
     case RASQAL_LITERAL_DECIMAL:
       {
         int error = 0;
         
         long lvalue = rasqal_xsd_decimal_get_long(l->value.decimal, &error);
-        if(lvalue < INT_MIN || lvalue > INT_MAX)
-          error = 1;
-
         if(error) {
           if(error_p)
             *error_p = 1;
           return 0;
         }
         
-        return RASQAL_GOOD_CAST(int, lvalue);
+        return RASQAL_GOOD_CAST(rasqal_integer, lvalue);
       }
 
     case RASQAL_LITERAL_STRING:
@@ -1582,28 +1718,24 @@ rasqal_literal_as_integer(rasqal_literal* l, int *error_p)
       {
         char *eptr;
         double  d;
-        long long_i;
+        rasqal_integer i = 0;
 
-        eptr = NULL;
-        errno = 0;
-        long_i = strtol(RASQAL_GOOD_CAST(const char*, l->string), &eptr, 10);
-        /* If formatted correctly and no under or overflow */
-        if(RASQAL_GOOD_CAST(unsigned char*, eptr) != l->string && *eptr=='\0' &&
-           errno != ERANGE)
-          /* FIXME may lose precision or be out of range from long to int */
-          return RASQAL_BAD_CAST(int, long_i);
+        if(!rasqal_xsd_parse_integer(l->string, &i))
+          return i;
 
         eptr = NULL;
         d = strtod(RASQAL_GOOD_CAST(const char*, l->string), &eptr);
-        if(RASQAL_GOOD_CAST(unsigned char*, eptr) != l->string && *eptr=='\0')
-          return RASQAL_FLOATING_AS_INT(d);
+        if(RASQAL_GOOD_CAST(unsigned char*, eptr) != l->string &&
+           *eptr == '\0' &&
+           d >= -9223372036854775808.0 && d < 9223372036854775808.0)
+          return RASQAL_BAD_CAST(rasqal_integer, d);
       }
       if(error_p)
         *error_p = 1;
       return 0;
 
     case RASQAL_LITERAL_VARIABLE:
-      return rasqal_literal_as_integer(l->value.variable->value, error_p);
+      return rasqal_literal_as_integer64(l->value.variable->value, error_p);
 
     case RASQAL_LITERAL_BLANK:
     case RASQAL_LITERAL_URI:
@@ -1624,6 +1756,79 @@ rasqal_literal_as_integer(rasqal_literal* l, int *error_p)
 }
 
 
+/**
+ * rasqal_integer_add:
+ * @a: integer
+ * @b: integer
+ * @result_p: pointer to store result
+ *
+ * INTERNAL - Add two integers with overflow detection
+ *
+ * Return value: non-0 if the result overflows (*@result_p is not set)
+ */
+int
+rasqal_integer_add(rasqal_integer a, rasqal_integer b,
+                   rasqal_integer* result_p)
+{
+  if((b > 0 && a > RASQAL_INTEGER_MAX - b) ||
+     (b < 0 && a < RASQAL_INTEGER_MIN - b))
+    return 1;
+
+  *result_p = a + b;
+  return 0;
+}
+
+
+/**
+ * rasqal_integer_subtract:
+ * @a: integer
+ * @b: integer
+ * @result_p: pointer to store result
+ *
+ * INTERNAL - Subtract two integers with overflow detection
+ *
+ * Return value: non-0 if the result overflows (*@result_p is not set)
+ */
+int
+rasqal_integer_subtract(rasqal_integer a, rasqal_integer b,
+                        rasqal_integer* result_p)
+{
+  if((b < 0 && a > RASQAL_INTEGER_MAX + b) ||
+     (b > 0 && a < RASQAL_INTEGER_MIN + b))
+    return 1;
+
+  *result_p = a - b;
+  return 0;
+}
+
+
+/**
+ * rasqal_integer_multiply:
+ * @a: integer
+ * @b: integer
+ * @result_p: pointer to store result
+ *
+ * INTERNAL - Multiply two integers with overflow detection
+ *
+ * Return value: non-0 if the result overflows (*@result_p is not set)
+ */
+int
+rasqal_integer_multiply(rasqal_integer a, rasqal_integer b,
+                        rasqal_integer* result_p)
+{
+  if(a > 0) {
+    if(b > 0 ? a > RASQAL_INTEGER_MAX / b : b < RASQAL_INTEGER_MIN / a)
+      return 1;
+  } else if(a < 0) {
+    if(b > 0 ? a < RASQAL_INTEGER_MIN / b : (b && a < RASQAL_INTEGER_MAX / b))
+      return 1;
+  }
+
+  *result_p = a * b;
+  return 0;
+}
+
+
 /*
  * rasqal_literal_as_double:
  * @l: #rasqal_literal object
@@ -1716,6 +1921,67 @@ rasqal_literal_as_uri(rasqal_literal* l)
 }
 
 
+/*
+ * rasqal_literal_ensure_string:
+ * @l: #rasqal_literal object
+ *
+ * INTERNAL - Make the lexical form of a computed numeric literal
+ *
+ * Literals made by rasqal_new_computed_integer_literal() and friends
+ * have no @string until this is called.  Any code reading l->string
+ * directly of a literal that may be computed must call this first.
+ *
+ * Return value: non-0 on failure
+ */
+int
+rasqal_literal_ensure_string(rasqal_literal* l)
+{
+  size_t slen = 0;
+
+  if(l->string)
+    return 0;
+
+  switch(l->type) {
+    case RASQAL_LITERAL_INTEGER:
+    case RASQAL_LITERAL_INTEGER_SUBTYPE:
+      l->string = rasqal_xsd_format_integer(l->value.integer, &slen);
+      break;
+
+    case RASQAL_LITERAL_DOUBLE:
+    case RASQAL_LITERAL_FLOAT:
+      l->string = rasqal_xsd_format_double(l->value.floating, &slen);
+      break;
+
+    case RASQAL_LITERAL_DECIMAL:
+      /* string is owned by l->value.decimal */
+      l->string = RASQAL_GOOD_CAST(unsigned char*, rasqal_xsd_decimal_as_counted_string(l->value.decimal, &slen));
+      break;
+
+    case RASQAL_LITERAL_UNKNOWN:
+    case RASQAL_LITERAL_BLANK:
+    case RASQAL_LITERAL_URI:
+    case RASQAL_LITERAL_STRING:
+    case RASQAL_LITERAL_XSD_STRING:
+    case RASQAL_LITERAL_BOOLEAN:
+    case RASQAL_LITERAL_DATE:
+    case RASQAL_LITERAL_DATETIME:
+    case RASQAL_LITERAL_PATTERN:
+    case RASQAL_LITERAL_QNAME:
+    case RASQAL_LITERAL_VARIABLE:
+    case RASQAL_LITERAL_UDT:
+    default:
+      /* always have a string (or none) from construction */
+      return 0;
+  }
+
+  if(!l->string)
+    return 1;
+
+  l->string_len = RASQAL_BAD_CAST(unsigned int, slen);
+  return 0;
+}
+
+
 /**
  * rasqal_literal_as_counted_string:
  * @l: #rasqal_literal object
@@ -1758,6 +2024,12 @@ rasqal_literal_as_counted_string(rasqal_literal* l, size_t *len_p,
     case RASQAL_LITERAL_DATETIME:
     case RASQAL_LITERAL_UDT:
     case RASQAL_LITERAL_INTEGER_SUBTYPE:
+      if(rasqal_literal_ensure_string(l)) {
+        if(error_p)
+          *error_p = 1;
+        return NULL;
+      }
+
       if(len_p)
         *len_p = l->string_len;
 
@@ -2025,6 +2297,7 @@ rasqal_new_literal_from_promotion(rasqal_literal* lit,
   int errori = 0;
   double d;
   int i;
+  rasqal_integer integer;
   unsigned char *new_s = NULL;
   unsigned char* s;
   size_t len = 0;
@@ -2085,6 +2358,20 @@ rasqal_new_literal_from_promotion(rasqal_literal* lit,
     
   switch(type) {
     case RASQAL_LITERAL_DECIMAL:
+      if(lit->type == RASQAL_LITERAL_INTEGER ||
+         lit->type == RASQAL_LITERAL_INTEGER_SUBTYPE) {
+        /* exact: a double cannot hold every 64 bit integer */
+        unsigned char* string;
+
+        string = rasqal_xsd_format_integer(lit->value.integer, NULL);
+        new_lit = NULL;
+        if(string) {
+          new_lit = rasqal_new_decimal_literal(lit->world, string);
+          RASQAL_FREE(char*, string);
+        }
+        break;
+      }
+
       dec = rasqal_new_xsd_decimal(lit->world);
       if(dec) {
         d = rasqal_literal_as_double(lit, &errori);
@@ -2093,8 +2380,7 @@ rasqal_new_literal_from_promotion(rasqal_literal* lit,
           new_lit = NULL;
         } else {
           rasqal_xsd_decimal_set_double(dec, d);
-          new_lit = rasqal_new_decimal_literal_from_decimal(lit->world,
-                                                            NULL, dec);
+          new_lit = rasqal_new_computed_decimal_literal(lit->world, dec);
         }
       }
       break;
@@ -2105,7 +2391,8 @@ rasqal_new_literal_from_promotion(rasqal_literal* lit,
       if(errori)
         new_lit = NULL;
       else
-        new_lit = rasqal_new_double_literal(lit->world, d);
+        new_lit = rasqal_new_computed_floating_literal(lit->world,
+                                                       RASQAL_LITERAL_DOUBLE, d);
       break;
       
 
@@ -2117,19 +2404,20 @@ rasqal_new_literal_from_promotion(rasqal_literal* lit,
         /* Cannot be stored in a float - fail */
         new_lit = NULL;
       else
-        new_lit = rasqal_new_floating_literal(lit->world, RASQAL_LITERAL_FLOAT,
-                                              d);
+        new_lit = rasqal_new_computed_floating_literal(lit->world,
+                                                       RASQAL_LITERAL_FLOAT, d);
       break;
       
 
     case RASQAL_LITERAL_INTEGER:
     case RASQAL_LITERAL_INTEGER_SUBTYPE:
-      i = rasqal_literal_as_integer(lit, &errori);
+      integer = rasqal_literal_as_integer64(lit, &errori);
       /* failure always means no match */
       if(errori)
         new_lit = NULL;
       else
-        new_lit = rasqal_new_integer_literal(lit->world, type, i);
+        new_lit = rasqal_new_computed_integer_literal(lit->world, type,
+                                                      integer);
       break;
     
     case RASQAL_LITERAL_BOOLEAN:
@@ -2428,6 +2716,14 @@ rasqal_literal_compare(rasqal_literal* l1, rasqal_literal* l2, int flags,
     return 0;
   }
 
+  /* two dateTimes need no promotion; compare their timeline values */
+  if((flags & (RASQAL_COMPARE_RDF | RASQAL_COMPARE_XQUERY)) == RASQAL_COMPARE_XQUERY &&
+     lits[0]->type == RASQAL_LITERAL_DATETIME &&
+     lits[1]->type == RASQAL_LITERAL_DATETIME)
+    return rasqal_xsd_datetime_compare2(lits[0]->value.datetime,
+                                        lits[1]->value.datetime,
+                                        error_p);
+
   new_lits[0] = NULL;
   new_lits[1] = NULL;
 
@@ -2569,7 +2865,9 @@ rasqal_literal_compare(rasqal_literal* l1, rasqal_literal* l2, int flags,
     case RASQAL_LITERAL_INTEGER:
     case RASQAL_LITERAL_BOOLEAN:
     case RASQAL_LITERAL_INTEGER_SUBTYPE:
-      result = new_lits[0]->value.integer - new_lits[1]->value.integer;
+      /* not subtracted: the difference of two integers may overflow */
+      result = (new_lits[0]->value.integer > new_lits[1]->value.integer) -
+               (new_lits[0]->value.integer < new_lits[1]->value.integer);
       break;
 
     case RASQAL_LITERAL_DOUBLE:
@@ -2782,6 +3080,76 @@ rasqal_literal_equals(rasqal_literal* l1, rasqal_literal* l2)
 }
 
 
+
+/*
+ * rasqal_literal_hash:
+ * @l: #rasqal_literal literal
+ * @hash_p: pointer to store hash value
+ *
+ * INTERNAL - Hash a literal consistently with rasqal_literal_equals()
+ *
+ * Literals that are equal by rasqal_literal_equals() get the same
+ * hash.  That can only be guaranteed for types compared by exact
+ * lexical form or integer value: URIs, blank nodes, strings,
+ * user-defined typed literals and integers.  Other types such as
+ * doubles (compared approximately) and booleans (which may equal a
+ * string) are not hashed.
+ *
+ * Return value: non-0 if the literal cannot be hashed
+ */
+int
+rasqal_literal_hash(rasqal_literal* l, unsigned int* hash_p)
+{
+  const unsigned char* p;
+  size_t len;
+  unsigned int hash;
+
+  switch(l->type) {
+    case RASQAL_LITERAL_URI:
+      p = raptor_uri_as_counted_string(l->value.uri, &len);
+      break;
+
+    case RASQAL_LITERAL_BLANK:
+    case RASQAL_LITERAL_STRING:
+    case RASQAL_LITERAL_XSD_STRING:
+    case RASQAL_LITERAL_UDT:
+      p = l->string;
+      len = l->string_len;
+      break;
+
+    case RASQAL_LITERAL_INTEGER:
+    case RASQAL_LITERAL_INTEGER_SUBTYPE:
+      p = RASQAL_GOOD_CAST(const unsigned char*, &l->value.integer);
+      len = sizeof(l->value.integer);
+      break;
+
+    case RASQAL_LITERAL_UNKNOWN:
+    case RASQAL_LITERAL_BOOLEAN:
+    case RASQAL_LITERAL_DOUBLE:
+    case RASQAL_LITERAL_FLOAT:
+    case RASQAL_LITERAL_DECIMAL:
+    case RASQAL_LITERAL_DATE:
+    case RASQAL_LITERAL_DATETIME:
+    case RASQAL_LITERAL_PATTERN:
+    case RASQAL_LITERAL_QNAME:
+    case RASQAL_LITERAL_VARIABLE:
+    default:
+      return 1;
+  }
+
+  /* FNV-1a over the type and the bytes of the value */
+  hash = 2166136261U ^ RASQAL_GOOD_CAST(unsigned int, l->type);
+  hash *= 16777619U;
+  while(len--) {
+    hash ^= *p++;
+    hash *= 16777619U;
+  }
+
+  *hash_p = hash;
+  return 0;
+}
+
+
 /*
  * rasqal_literal_equals_flags:
  * @l1: #rasqal_literal literal
@@ -3091,6 +3459,9 @@ rasqal_literal_as_node(rasqal_literal* l)
     case RASQAL_LITERAL_DATETIME:
     case RASQAL_LITERAL_UDT:
     case RASQAL_LITERAL_INTEGER_SUBTYPE:
+      if(rasqal_literal_ensure_string(l))
+        return NULL;
+
       new_l = RASQAL_CALLOC(rasqal_literal*, 1, sizeof(*new_l));
       if(new_l) {
         new_l->valid = 1;
@@ -3274,6 +3645,12 @@ rasqal_literal_cast(rasqal_literal* l, raptor_uri* to_datatype, int flags,
   if(!l)
     return NULL;
 
+  if(rasqal_literal_ensure_string(l)) {
+    if(error_p)
+      *error_p = 1;
+    return NULL;
+  }
+
 #ifdef RASQAL_DEBUG
   from_datatype = l->datatype;
 #endif
@@ -3448,7 +3825,8 @@ rasqal_literal_is_numeric(rasqal_literal* literal)
 rasqal_literal*
 rasqal_literal_add(rasqal_literal* l1, rasqal_literal* l2, int *error_p)
 {
-  int i;
+  rasqal_integer i;
+  rasqal_integer i2;
   double d;
   rasqal_xsd_decimal* dec;
   int error = 0;
@@ -3465,28 +3843,23 @@ rasqal_literal_add(rasqal_literal* l1, rasqal_literal* l2, int *error_p)
   switch(type) {
     case RASQAL_LITERAL_INTEGER:
     case RASQAL_LITERAL_INTEGER_SUBTYPE:
-      i = rasqal_literal_as_integer(l1, &error);
+      i = rasqal_literal_as_integer64(l1, &error);
       if(error)
         break;
-      i = i + rasqal_literal_as_integer(l2, &error);
+      i2 = rasqal_literal_as_integer64(l2, &error);
       if(error)
         break;
 
-      result = rasqal_new_integer_literal(l1->world, RASQAL_LITERAL_INTEGER, i);
-      break;
-      
-    case RASQAL_LITERAL_FLOAT:
-    case RASQAL_LITERAL_DOUBLE:
-      d = rasqal_literal_as_double(l1, &error);
-      if(error)
-        break;
-      d = d + rasqal_literal_as_double(l2, &error);
-      if(error)
+      if(!rasqal_integer_add(i, i2, &i)) {
+        result = rasqal_new_computed_integer_literal(l1->world, RASQAL_LITERAL_INTEGER,
+                                            i);
         break;
+      }
+
+      /* overflowed so compute it as a decimal */
+      type = RASQAL_LITERAL_DECIMAL;
+      /* FALLTHROUGH */
 
-      result = rasqal_new_numeric_literal(l1->world, type, d);
-      break;
-      
     case RASQAL_LITERAL_DECIMAL:
       l1_p = rasqal_new_literal_from_promotion(l1, type, flags);
       if(l1_p)
@@ -3498,10 +3871,22 @@ rasqal_literal_add(rasqal_literal* l1, rasqal_literal* l2, int *error_p)
           error = 1;
           rasqal_free_xsd_decimal(dec);
         } else
-          result = rasqal_new_decimal_literal_from_decimal(l1->world, NULL, dec);
+          result = rasqal_new_computed_decimal_literal(l1->world, dec);
       }
       break;
       
+    case RASQAL_LITERAL_FLOAT:
+    case RASQAL_LITERAL_DOUBLE:
+      d = rasqal_literal_as_double(l1, &error);
+      if(error)
+        break;
+      d = d + rasqal_literal_as_double(l2, &error);
+      if(error)
+        break;
+
+      result = rasqal_new_numeric_literal(l1->world, type, d);
+      break;
+      
     case RASQAL_LITERAL_UNKNOWN:
     case RASQAL_LITERAL_BLANK:
     case RASQAL_LITERAL_URI:
@@ -3536,7 +3921,8 @@ rasqal_literal_add(rasqal_literal* l1, rasqal_literal* l2, int *error_p)
 rasqal_literal*
 rasqal_literal_subtract(rasqal_literal* l1, rasqal_literal* l2, int *error_p)
 {
-  int i;
+  rasqal_integer i;
+  rasqal_integer i2;
   double d;
   rasqal_xsd_decimal* dec;
   int error = 0;
@@ -3553,28 +3939,23 @@ rasqal_literal_subtract(rasqal_literal* l1, rasqal_literal* l2, int *error_p)
   switch(type) {
     case RASQAL_LITERAL_INTEGER:
     case RASQAL_LITERAL_INTEGER_SUBTYPE:
-      i = rasqal_literal_as_integer(l1, &error);
+      i = rasqal_literal_as_integer64(l1, &error);
       if(error)
         break;
-      i = i - rasqal_literal_as_integer(l2, &error);
+      i2 = rasqal_literal_as_integer64(l2, &error);
       if(error)
         break;
 
-      result = rasqal_new_integer_literal(l1->world, RASQAL_LITERAL_INTEGER, i);
-      break;
-      
-    case RASQAL_LITERAL_FLOAT:
-    case RASQAL_LITERAL_DOUBLE:
-      d = rasqal_literal_as_double(l1, &error);
-      if(error)
-        break;
-      d = d - rasqal_literal_as_double(l2, &error);
-      if(error)
+      if(!rasqal_integer_subtract(i, i2, &i)) {
+        result = rasqal_new_computed_integer_literal(l1->world, RASQAL_LITERAL_INTEGER,
+                                            i);
         break;
+      }
+
+      /* overflowed so compute it as a decimal */
+      type = RASQAL_LITERAL_DECIMAL;
+      /* FALLTHROUGH */
 
-      result = rasqal_new_numeric_literal(l1->world, type, d);
-      break;
-      
     case RASQAL_LITERAL_DECIMAL:
       l1_p = rasqal_new_literal_from_promotion(l1, type, flags);
       if(l1_p)
@@ -3586,10 +3967,22 @@ rasqal_literal_subtract(rasqal_literal* l1, rasqal_literal* l2, int *error_p)
           error = 1;
           rasqal_free_xsd_decimal(dec);
         } else
-          result = rasqal_new_decimal_literal_from_decimal(l1->world, NULL, dec);
+          result = rasqal_new_computed_decimal_literal(l1->world, dec);
       }
       break;
       
+    case RASQAL_LITERAL_FLOAT:
+    case RASQAL_LITERAL_DOUBLE:
+      d = rasqal_literal_as_double(l1, &error);
+      if(error)
+        break;
+      d = d - rasqal_literal_as_double(l2, &error);
+      if(error)
+        break;
+
+      result = rasqal_new_numeric_literal(l1->world, type, d);
+      break;
+      
     case RASQAL_LITERAL_UNKNOWN:
     case RASQAL_LITERAL_BLANK:
     case RASQAL_LITERAL_URI:
@@ -3624,7 +4017,8 @@ rasqal_literal_subtract(rasqal_literal* l1, rasqal_literal* l2, int *error_p)
 rasqal_literal*
 rasqal_literal_multiply(rasqal_literal* l1, rasqal_literal* l2, int *error_p)
 {
-  int i;
+  rasqal_integer i;
+  rasqal_integer i2;
   double d;
   rasqal_xsd_decimal* dec;
   int error = 0;
@@ -3641,28 +4035,23 @@ rasqal_literal_multiply(rasqal_literal* l1, rasqal_literal* l2, int *error_p)
   switch(type) {
     case RASQAL_LITERAL_INTEGER:
     case RASQAL_LITERAL_INTEGER_SUBTYPE:
-      i = rasqal_literal_as_integer(l1, &error);
+      i = rasqal_literal_as_integer64(l1, &error);
       if(error)
         break;
-      i = i * rasqal_literal_as_integer(l2, &error);
+      i2 = rasqal_literal_as_integer64(l2, &error);
       if(error)
         break;
 
-      result = rasqal_new_integer_literal(l1->world, RASQAL_LITERAL_INTEGER, i);
-      break;
-      
-    case RASQAL_LITERAL_FLOAT:
-    case RASQAL_LITERAL_DOUBLE:
-      d = rasqal_literal_as_double(l1, &error);
-      if(error)
-        break;
-      d = d * rasqal_literal_as_double(l2, &error);
-      if(error)
+      if(!rasqal_integer_multiply(i, i2, &i)) {
+        result = rasqal_new_computed_integer_literal(l1->world, RASQAL_LITERAL_INTEGER,
+                                            i);
         break;
+      }
+
+      /* overflowed so compute it as a decimal */
+      type = RASQAL_LITERAL_DECIMAL;
+      /* FALLTHROUGH */
 
-      result = rasqal_new_numeric_literal(l1->world, type, d);
-      break;
-      
     case RASQAL_LITERAL_DECIMAL:
       l1_p = rasqal_new_literal_from_promotion(l1, type, flags);
       if(l1_p)
@@ -3674,10 +4063,22 @@ rasqal_literal_multiply(rasqal_literal* l1, rasqal_literal* l2, int *error_p)
           error = 1;
           rasqal_free_xsd_decimal(dec);
         } else
-          result = rasqal_new_decimal_literal_from_decimal(l1->world, NULL, dec);
+          result = rasqal_new_computed_decimal_literal(l1->world, dec);
       }
       break;
       
+    case RASQAL_LITERAL_FLOAT:
+    case RASQAL_LITERAL_DOUBLE:
+      d = rasqal_literal_as_double(l1, &error);
+      if(error)
+        break;
+      d = d * rasqal_literal_as_double(l2, &error);
+      if(error)
+        break;
+
+      result = rasqal_new_numeric_literal(l1->world, type, d);
+      break;
+      
     case RASQAL_LITERAL_UNKNOWN:
     case RASQAL_LITERAL_BLANK:
     case RASQAL_LITERAL_URI:
@@ -3761,7 +4162,7 @@ rasqal_literal_divide(rasqal_literal* l1, rasqal_literal* l2, int *error_p)
           error = 1;
           rasqal_free_xsd_decimal(dec);
         } else
-          result = rasqal_new_decimal_literal_from_decimal(l1->world, NULL, dec);
+          result = rasqal_new_computed_decimal_literal(l1->world, dec);
       }
       break;
       
@@ -3799,10 +4200,11 @@ rasqal_literal_divide(rasqal_literal* l1, rasqal_literal* l2, int *error_p)
 rasqal_literal*
 rasqal_literal_negate(rasqal_literal* l, int *error_p)
 {
-  int i;
+  rasqal_integer i;
   double d;
   rasqal_xsd_decimal* dec;
   int error = 0;
+  rasqal_literal* l_p = NULL;
   rasqal_literal* result = NULL;
   
   RASQAL_ASSERT_OBJECT_POINTER_RETURN_VALUE(l, rasqal_literal, NULL);
@@ -3810,11 +4212,32 @@ rasqal_literal_negate(rasqal_literal* l, int *error_p)
   switch(l->type) {
     case RASQAL_LITERAL_INTEGER:
     case RASQAL_LITERAL_INTEGER_SUBTYPE:
-      i = rasqal_literal_as_integer(l, &error);
+      i = rasqal_literal_as_integer64(l, &error);
       if(error)
         break;
-      i = -i;
-      result = rasqal_new_integer_literal(l->world, RASQAL_LITERAL_INTEGER, i);
+
+      if(!rasqal_integer_subtract(0, i, &i)) {
+        result = rasqal_new_computed_integer_literal(l->world, RASQAL_LITERAL_INTEGER,
+                                            i);
+        break;
+      }
+
+      /* -RASQAL_INTEGER_MIN overflows so compute it as a decimal */
+      l_p = rasqal_new_literal_from_promotion(l, RASQAL_LITERAL_DECIMAL, 0);
+      if(!l_p) {
+        error = 1;
+        break;
+      }
+      l = l_p;
+      /* FALLTHROUGH */
+
+    case RASQAL_LITERAL_DECIMAL:
+      dec = rasqal_new_xsd_decimal(l->world);
+      if(rasqal_xsd_decimal_negate(dec, l->value.decimal)) {
+        error = 1;
+        rasqal_free_xsd_decimal(dec);
+      } else
+        result = rasqal_new_computed_decimal_literal(l->world, dec);
       break;
       
     case RASQAL_LITERAL_FLOAT:
@@ -3826,15 +4249,6 @@ rasqal_literal_negate(rasqal_literal* l, int *error_p)
       result = rasqal_new_numeric_literal(l->world, l->type, d);
       break;
       
-    case RASQAL_LITERAL_DECIMAL:
-      dec = rasqal_new_xsd_decimal(l->world);
-      if(rasqal_xsd_decimal_negate(dec, l->value.decimal)) {
-        error = 1;
-        rasqal_free_xsd_decimal(dec);
-      } else
-        result = rasqal_new_decimal_literal_from_decimal(l->world, NULL, dec);
-      break;
-      
     case RASQAL_LITERAL_UNKNOWN:
     case RASQAL_LITERAL_BLANK:
     case RASQAL_LITERAL_URI:
@@ -3856,6 +4270,9 @@ rasqal_literal_negate(rasqal_literal* l, int *error_p)
     if(error_p)
       *error_p = 1;
   }
+
+  if(l_p)
+    rasqal_free_literal(l_p);
   
   return result;
 }
@@ -3864,10 +4281,11 @@ rasqal_literal_negate(rasqal_literal* l, int *error_p)
 rasqal_literal*
 rasqal_literal_abs(rasqal_literal* l, int *error_p)
 {
-  int i;
+  rasqal_integer i;
   double d;
   rasqal_xsd_decimal* dec;
   int error = 0;
+  rasqal_literal* l_p = NULL;
   rasqal_literal* result = NULL;
 
   if(!rasqal_literal_is_numeric(l))
@@ -3878,12 +4296,32 @@ rasqal_literal_abs(rasqal_literal* l, int *error_p)
   switch(l->type) {
     case RASQAL_LITERAL_INTEGER:
     case RASQAL_LITERAL_INTEGER_SUBTYPE:
-      i = rasqal_literal_as_integer(l, &error);
+      i = rasqal_literal_as_integer64(l, &error);
       if(error)
         break;
 
-      i = abs(i);
-      result = rasqal_new_integer_literal(l->world, RASQAL_LITERAL_INTEGER, i);
+      if(i >= 0 || !rasqal_integer_subtract(0, i, &i)) {
+        result = rasqal_new_computed_integer_literal(l->world, RASQAL_LITERAL_INTEGER,
+                                            i);
+        break;
+      }
+
+      /* abs(RASQAL_INTEGER_MIN) overflows so compute it as a decimal */
+      l_p = rasqal_new_literal_from_promotion(l, RASQAL_LITERAL_DECIMAL, 0);
+      if(!l_p) {
+        error = 1;
+        break;
+      }
+      l = l_p;
+      /* FALLTHROUGH */
+
+    case RASQAL_LITERAL_DECIMAL:
+      dec = rasqal_new_xsd_decimal(l->world);
+      if(rasqal_xsd_decimal_abs(dec, l->value.decimal)) {
+        error = 1;
+        rasqal_free_xsd_decimal(dec);
+      } else
+        result = rasqal_new_computed_decimal_literal(l->world, dec);
       break;
       
     case RASQAL_LITERAL_FLOAT:
@@ -3896,15 +4334,6 @@ rasqal_literal_abs(rasqal_literal* l, int *error_p)
       result = rasqal_new_numeric_literal(l->world, l->type, d);
       break;
       
-    case RASQAL_LITERAL_DECIMAL:
-      dec = rasqal_new_xsd_decimal(l->world);
-      if(rasqal_xsd_decimal_abs(dec, l->value.decimal)) {
-        error = 1;
-        rasqal_free_xsd_decimal(dec);
-      } else
-        result = rasqal_new_decimal_literal_from_decimal(l->world, NULL, dec);
-      break;
-      
     case RASQAL_LITERAL_UNKNOWN:
     case RASQAL_LITERAL_BLANK:
     case RASQAL_LITERAL_URI:
@@ -3927,6 +4356,9 @@ rasqal_literal_abs(rasqal_literal* l, int *error_p)
       *error_p = 1;
   }
 
+  if(l_p)
+    rasqal_free_literal(l_p);
+
   return result;
 }
 
@@ -3967,7 +4399,7 @@ rasqal_literal_round(rasqal_literal* l, int *error_p)
         error = 1;
         rasqal_free_xsd_decimal(dec);
       } else
-        result = rasqal_new_decimal_literal_from_decimal(l->world, NULL, dec);
+        result = rasqal_new_computed_decimal_literal(l->world, dec);
       break;
       
     case RASQAL_LITERAL_UNKNOWN:
@@ -4032,7 +4464,7 @@ rasqal_literal_ceil(rasqal_literal* l, int *error_p)
         error = 1;
         rasqal_free_xsd_decimal(dec);
       } else
-        result = rasqal_new_decimal_literal_from_decimal(l->world, NULL, dec);
+        result = rasqal_new_computed_decimal_literal(l->world, dec);
       break;
       
     case RASQAL_LITERAL_UNKNOWN:
@@ -4097,7 +4529,7 @@ rasqal_literal_floor(rasqal_literal* l, int *error_p)
         error = 1;
         rasqal_free_xsd_decimal(dec);
       } else
-        result = rasqal_new_decimal_literal_from_decimal(l->world, NULL, dec);
+        result = rasqal_new_computed_decimal_literal(l->world, dec);
       break;
       
     case RASQAL_LITERAL_UNKNOWN:
@@ -4985,6 +5417,34 @@ static const struct {
 };
 
 
+/* Integer values outside 32 bits */
+#define INTEGER_TESTS_COUNT 12
+
+static const struct {
+  /* operation: 0 parse only, '+', '-', '*' or 'n' negate first */
+  char op;
+  const char* first;
+  const char* second;
+  rasqal_literal_type expected_type;
+  const char* expected_string;
+  /* expected rasqal_literal_as_integer() error flag */
+  int expected_int_error;
+} integer_test_data[INTEGER_TESTS_COUNT] = {
+  { 0, "4294967296", NULL, RASQAL_LITERAL_INTEGER, "4294967296", 1 },
+  { 0, "-2147483649", NULL, RASQAL_LITERAL_INTEGER, "-2147483649", 1 },
+  { 0, "2147483647", NULL, RASQAL_LITERAL_INTEGER, "2147483647", 0 },
+  { 0, "9223372036854775807", NULL, RASQAL_LITERAL_INTEGER, "9223372036854775807", 1 },
+  { 0, "9223372036854775808", NULL, RASQAL_LITERAL_DECIMAL, "9223372036854775808", 1 },
+  { '+', "4294967296", "1", RASQAL_LITERAL_INTEGER, "4294967297", 1 },
+  { '-', "2147483647", "-1", RASQAL_LITERAL_INTEGER, "2147483648", 1 },
+  { '*', "3037000499", "3037000499", RASQAL_LITERAL_INTEGER, "9223372030926249001", 1 },
+  { '+', "9223372036854775807", "1", RASQAL_LITERAL_DECIMAL, "9223372036854775808.0", 1 },
+  { '-', "-9223372036854775808", "1", RASQAL_LITERAL_DECIMAL, "-9223372036854775809.0", 1 },
+  { '*', "4294967296", "4294967296", RASQAL_LITERAL_DECIMAL, "18446744073709551616.0", 1 },
+  { 'n', "-9223372036854775808", NULL, RASQAL_LITERAL_DECIMAL, "9223372036854775808.0", 1 }
+};
+
+
 int
 main(int argc, char *argv[]) 
 {
@@ -5068,6 +5528,98 @@ main(int argc, char *argv[])
   }
   
 
+  fprintf(stderr, "%s: Testing integer literals\n", program);
+
+  for(test_id = 0; test_id < INTEGER_TESTS_COUNT; test_id++) {
+    rasqal_literal* l1;
+    rasqal_literal* l2 = NULL;
+    rasqal_literal* result = NULL;
+    const unsigned char* str;
+    int error = 0;
+
+    l1 = rasqal_new_typed_literal(world, RASQAL_LITERAL_INTEGER,
+                                  RASQAL_GOOD_CAST(const unsigned char*, integer_test_data[test_id].first));
+    if(l1 && integer_test_data[test_id].second)
+      l2 = rasqal_new_typed_literal(world, RASQAL_LITERAL_INTEGER,
+                                    RASQAL_GOOD_CAST(const unsigned char*, integer_test_data[test_id].second));
+
+    switch(integer_test_data[test_id].op) {
+      case '+':
+        if(l2)
+          result = rasqal_literal_add(l1, l2, &error);
+        break;
+      case '-':
+        if(l2)
+          result = rasqal_literal_subtract(l1, l2, &error);
+        break;
+      case '*':
+        if(l2)
+          result = rasqal_literal_multiply(l1, l2, &error);
+        break;
+      case 'n':
+        if(l1)
+          result = rasqal_literal_negate(l1, &error);
+        break;
+      default:
+        result = l1 ? rasqal_new_literal_from_literal(l1) : NULL;
+        break;
+    }
+
+    if(!result || error) {
+      fprintf(stderr, "%s: Integer test %d failed to make a result\n",
+              program, test_id);
+      failures++;
+      goto integer_tidy;
+    }
+
+    str = rasqal_literal_as_string(result);
+    if(result->type != integer_test_data[test_id].expected_type ||
+       strcmp(RASQAL_GOOD_CAST(const char*, str),
+              integer_test_data[test_id].expected_string)) {
+      fprintf(stderr,
+              "%s: Integer test %d returned %s type %s expected %s type %s\n",
+              program, test_id, str,
+              rasqal_literal_type_label(result->type),
+              integer_test_data[test_id].expected_string,
+              rasqal_literal_type_label(integer_test_data[test_id].expected_type));
+      failures++;
+    }
+
+    error = 0;
+    (void)rasqal_literal_as_integer(result, &error);
+    if(error != integer_test_data[test_id].expected_int_error) {
+      fprintf(stderr,
+              "%s: Integer test %d as integer error was %d expected %d\n",
+              program, test_id, error,
+              integer_test_data[test_id].expected_int_error);
+      failures++;
+    }
+
+    if(result->type == RASQAL_LITERAL_INTEGER) {
+      rasqal_integer expected_value = 0;
+
+      error = 0;
+      (void)rasqal_xsd_parse_integer(RASQAL_GOOD_CAST(const unsigned char*, integer_test_data[test_id].expected_string),
+                                     &expected_value);
+      if(rasqal_literal_as_integer64(result, &error) != expected_value ||
+         error) {
+        fprintf(stderr,
+                "%s: Integer test %d as 64 bit integer did not return %s\n",
+                program, test_id, integer_test_data[test_id].expected_string);
+        failures++;
+      }
+    }
+
+    integer_tidy:
+    if(result)
+      rasqal_free_literal(result);
+    if(l2)
+      rasqal_free_literal(l2);
+    if(l1)
+      rasqal_free_literal(l1);
+  }
+
+
   tidy:
   rasqal_free_world(world);
 
@@ -311,6 +311,18 @@ rasqal_query_set_feature(rasqal_query* query, rasqal_feature feature, int value)
       
       query->features[RASQAL_GOOD_CAST(int, feature)] = value;
       break;
+
+    case RASQAL_FEATURE_SERVICE_BATCH_SIZE:
+    case RASQAL_FEATURE_SERVICE_CONCURRENCY:
+    case RASQAL_FEATURE_SERVICE_TIMEOUT:
+    case RASQAL_FEATURE_TABLE_LOOKAHEAD:
+    case RASQAL_FEATURE_CONSTRUCT_DISTINCT:
+    case RASQAL_FEATURE_APPROX_COUNT_DISTINCT:
+      if(value < 0)
+        return 1;
+
+      query->features[RASQAL_GOOD_CAST(int, feature)] = value;
+      break;
   }
 
   return 0;
@@ -372,6 +384,15 @@ rasqal_query_get_feature(rasqal_query *query, rasqal_feature feature)
     case RASQAL_FEATURE_RAND_SEED:
       result = (query->features[RASQAL_GOOD_CAST(int, feature)] != 0);
       break;
+
+    case RASQAL_FEATURE_SERVICE_BATCH_SIZE:
+    case RASQAL_FEATURE_SERVICE_CONCURRENCY:
+    case RASQAL_FEATURE_SERVICE_TIMEOUT:
+    case RASQAL_FEATURE_TABLE_LOOKAHEAD:
+    case RASQAL_FEATURE_CONSTRUCT_DISTINCT:
+    case RASQAL_FEATURE_APPROX_COUNT_DISTINCT:
+      result = query->features[RASQAL_GOOD_CAST(int, feature)];
+      break;
   }
   
   return result;
@@ -587,6 +608,9 @@ rasqal_query_set_offset(rasqal_query* query, int offset)
  *
  * Add a data graph to the query.
  *
+ * The @data_graph becomes owned by the query.  If it cannot be added
+ * it is freed.
+ *
  * Return value: non-0 on failure
  **/
 int
@@ -99,11 +99,41 @@
 
 static int rasqal_query_results_execute_and_store_results(rasqal_query_results* query_results);
 static void rasqal_query_results_update_query_bindings(rasqal_query_results* query_results, rasqal_query *query);
+static void rasqal_query_results_free_construct(rasqal_query_results* query_results);
+static void rasqal_query_results_clear_seen(rasqal_query_results* query_results);
 
 
 /*
  * A query result for some query
  */
+/*
+ * A CONSTRUCT template term converted for returning in triples.  Terms
+ * for constant template parts are made once, terms for template blank
+ * nodes once per result and terms for variables again only when the
+ * variable value changes.
+ */
+typedef struct {
+  /* shared term returned with raptor_term_copy() or NULL */
+  raptor_term* term;
+
+  /* variable value the term was made from */
+  rasqal_literal* value;
+
+  /* result the term was made for */
+  int result;
+} rasqal_construct_term;
+
+
+/* A CONSTRUCT triple recently returned, for the constructDistinct feature */
+typedef struct rasqal_construct_seen_s {
+  unsigned int hash;
+
+  raptor_statement* statement;
+
+  struct rasqal_construct_seen_s* next;
+} rasqal_construct_seen;
+
+
 struct rasqal_query_results_s {
   rasqal_world* world;
 
@@ -159,6 +189,17 @@ struct rasqal_query_results_s {
 
   /* non-0 if @vars_table has been initialized from first row */
   int vars_table_init;
+
+  /* converted terms for each triple part of the CONSTRUCT template */
+  rasqal_construct_term* construct_terms;
+  int construct_terms_count;
+
+  /* hash set of up to @seen_size recently returned CONSTRUCT triples */
+  rasqal_construct_seen** seen_buckets;
+  unsigned int seen_mask;
+  rasqal_construct_seen* seen_entries;
+  int seen_size;
+  int seen_count;
 };
     
 
@@ -459,6 +500,8 @@ rasqal_free_query_results(rasqal_query_results* query_results)
   /* free terms owned by static query_results->result_triple */
   raptor_free_statement(&query_results->result_triple);
 
+  rasqal_query_results_free_construct(query_results);
+
   if(query_results->vars_table)
     rasqal_free_variables_table(query_results->vars_table);
 
@@ -1036,6 +1079,9 @@ rasqal_query_results_rewind(rasqal_query_results* query_results)
       rasqal_query_results_update_query_bindings(query_results, query);
   }
 
+  /* triples returned before the rewind may be returned again */
+  rasqal_query_results_clear_seen(query_results);
+
   return 0;
 }
 
@@ -1315,6 +1361,278 @@ rasqal_literal_to_result_term(rasqal_query_results* query_results,
 }
 
 
+static void
+rasqal_query_results_clear_seen(rasqal_query_results* query_results)
+{
+  int i;
+
+  for(i = 0; i < query_results->seen_count; i++)
+    raptor_free_statement(query_results->seen_entries[i].statement);
+  query_results->seen_count = 0;
+
+  if(query_results->seen_buckets)
+    memset(query_results->seen_buckets, '\0',
+           sizeof(rasqal_construct_seen*) * (query_results->seen_mask + 1));
+}
+
+
+static void
+rasqal_query_results_free_construct(rasqal_query_results* query_results)
+{
+  int i;
+
+  if(query_results->construct_terms) {
+    for(i = 0; i < query_results->construct_terms_count; i++) {
+      rasqal_construct_term* ct = &query_results->construct_terms[i];
+
+      if(ct->term)
+        raptor_free_term(ct->term);
+      if(ct->value)
+        rasqal_free_literal(ct->value);
+    }
+    RASQAL_FREE(rasqal_construct_term*, query_results->construct_terms);
+    query_results->construct_terms = NULL;
+  }
+
+  rasqal_query_results_clear_seen(query_results);
+
+  if(query_results->seen_buckets) {
+    RASQAL_FREE(rasqal_construct_seen**, query_results->seen_buckets);
+    query_results->seen_buckets = NULL;
+  }
+
+  if(query_results->seen_entries) {
+    RASQAL_FREE(rasqal_construct_seen*, query_results->seen_entries);
+    query_results->seen_entries = NULL;
+  }
+}
+
+
+/*
+ * rasqal_query_results_init_construct:
+ * @query_results: query results
+ * @query: query
+ *
+ * INTERNAL - Prepare the CONSTRUCT term cache and triple hash set
+ *
+ * Return value: non-0 on failure
+ */
+static int
+rasqal_query_results_init_construct(rasqal_query_results* query_results,
+                                    rasqal_query* query)
+{
+  int size;
+
+  query_results->construct_terms_count = 3 * raptor_sequence_size(query->constructs);
+  query_results->construct_terms = RASQAL_CALLOC(rasqal_construct_term*,
+                                                 RASQAL_GOOD_CAST(size_t, query_results->construct_terms_count + 1),
+                                                 sizeof(rasqal_construct_term));
+  if(!query_results->construct_terms)
+    return 1;
+
+  size = rasqal_query_get_feature(query, RASQAL_FEATURE_CONSTRUCT_DISTINCT);
+  if(size > 0) {
+    unsigned int buckets = 16;
+
+    while(buckets < RASQAL_GOOD_CAST(unsigned int, size))
+      buckets <<= 1;
+
+    query_results->seen_buckets = RASQAL_CALLOC(rasqal_construct_seen**,
+                                                buckets,
+                                                sizeof(rasqal_construct_seen*));
+    query_results->seen_entries = RASQAL_CALLOC(rasqal_construct_seen*,
+                                                RASQAL_GOOD_CAST(size_t, size),
+                                                sizeof(rasqal_construct_seen));
+    if(!query_results->seen_buckets || !query_results->seen_entries)
+      return 1;
+
+    query_results->seen_mask = buckets - 1;
+    query_results->seen_size = size;
+  }
+
+  return 0;
+}
+
+
+/*
+ * rasqal_construct_same_value:
+ * @l1: first literal
+ * @l2: second literal
+ *
+ * INTERNAL - Check if two variable values make the same RDF term
+ *
+ * Return value: non-0 if the values are the same
+ */
+static int
+rasqal_construct_same_value(rasqal_literal* l1, rasqal_literal* l2)
+{
+  if(l1 == l2)
+    return 1;
+
+  if(l1->type != l2->type)
+    return 0;
+
+  if(l1->type == RASQAL_LITERAL_URI)
+    return raptor_uri_equals(l1->value.uri, l2->value.uri);
+
+  if(l1->string_len != l2->string_len ||
+     memcmp(l1->string, l2->string, l1->string_len))
+    return 0;
+
+  if(l1->language || l2->language) {
+    if(!l1->language || !l2->language ||
+       strcmp(l1->language, l2->language))
+      return 0;
+  }
+
+  if(l1->datatype || l2->datatype) {
+    if(!l1->datatype || !l2->datatype ||
+       !raptor_uri_equals(l1->datatype, l2->datatype))
+      return 0;
+  }
+
+  return 1;
+}
+
+
+/*
+ * rasqal_query_results_get_construct_term:
+ * @query_results: query results
+ * @offset: offset of the triple part in the CONSTRUCT template
+ * @l: template literal
+ *
+ * INTERNAL - Get the RDF term for a CONSTRUCT template part
+ *
+ * Return value: new reference to a shared term or NULL
+ */
+static raptor_term*
+rasqal_query_results_get_construct_term(rasqal_query_results* query_results,
+                                        int offset, rasqal_literal* l)
+{
+  rasqal_construct_term* ct = &query_results->construct_terms[offset];
+  rasqal_literal* value = NULL;
+  raptor_term* t;
+
+  if(l->type == RASQAL_LITERAL_VARIABLE) {
+    value = l->value.variable->value;
+    while(value && value->type == RASQAL_LITERAL_VARIABLE)
+      value = value->value.variable->value;
+    if(!value)
+      return NULL;
+
+    if(ct->term && rasqal_construct_same_value(ct->value, value))
+      return raptor_term_copy(ct->term);
+  } else if(l->type == RASQAL_LITERAL_BLANK) {
+    if(ct->term && ct->result == query_results->result_count)
+      return raptor_term_copy(ct->term);
+  } else if(ct->term)
+    return raptor_term_copy(ct->term);
+
+  t = rasqal_literal_to_result_term(query_results, l);
+  if(!t)
+    return NULL;
+
+  if(ct->term)
+    raptor_free_term(ct->term);
+  if(ct->value)
+    rasqal_free_literal(ct->value);
+
+  ct->term = t;
+  ct->value = value ? rasqal_new_literal_from_literal(value) : NULL;
+  ct->result = query_results->result_count;
+
+  return raptor_term_copy(t);
+}
+
+
+static unsigned int
+rasqal_construct_term_hash(raptor_term* t, unsigned int hash)
+{
+  const unsigned char* p = NULL;
+  size_t len = 0;
+
+  switch(t->type) {
+    case RAPTOR_TERM_TYPE_URI:
+      p = raptor_uri_as_counted_string(t->value.uri, &len);
+      break;
+
+    case RAPTOR_TERM_TYPE_BLANK:
+      p = t->value.blank.string;
+      len = t->value.blank.string_len;
+      break;
+
+    case RAPTOR_TERM_TYPE_LITERAL:
+      p = t->value.literal.string;
+      len = t->value.literal.string_len;
+      break;
+
+    case RAPTOR_TERM_TYPE_UNKNOWN:
+    default:
+      break;
+  }
+
+  /* FNV-1a over the type and the bytes of the value */
+  hash ^= RASQAL_GOOD_CAST(unsigned int, t->type);
+  hash *= 16777619U;
+  while(len--) {
+    hash ^= *p++;
+    hash *= 16777619U;
+  }
+
+  return hash;
+}
+
+
+/*
+ * rasqal_query_results_seen_triple:
+ * @query_results: query results
+ * @rs: triple
+ *
+ * INTERNAL - Check if a CONSTRUCT triple was recently returned and remember it
+ *
+ * When the set is full it is emptied, so repeats of triples further
+ * apart than the set size are not found.
+ *
+ * Return value: non-0 if the triple was seen
+ */
+static int
+rasqal_query_results_seen_triple(rasqal_query_results* query_results,
+                                 raptor_statement* rs)
+{
+  unsigned int hash = 2166136261U;
+  rasqal_construct_seen* entry;
+  rasqal_construct_seen** bucket;
+
+  hash = rasqal_construct_term_hash(rs->subject, hash);
+  hash = rasqal_construct_term_hash(rs->predicate, hash);
+  hash = rasqal_construct_term_hash(rs->object, hash);
+
+  bucket = &query_results->seen_buckets[hash & query_results->seen_mask];
+  for(entry = *bucket; entry; entry = entry->next) {
+    if(entry->hash == hash && raptor_statement_equals(entry->statement, rs))
+      return 1;
+  }
+
+  if(query_results->seen_count == query_results->seen_size) {
+    rasqal_query_results_clear_seen(query_results);
+    bucket = &query_results->seen_buckets[hash & query_results->seen_mask];
+  }
+
+  entry = &query_results->seen_entries[query_results->seen_count];
+  /* a failed copy only means the triple is not remembered */
+  entry->statement = raptor_statement_copy(rs);
+  if(!entry->statement)
+    return 0;
+
+  entry->hash = hash;
+  entry->next = *bucket;
+  *bucket = entry;
+  query_results->seen_count++;
+
+  return 0;
+}
+
+
 /**
  * rasqal_query_results_get_triple:
  * @query_results: #rasqal_query_results query_results
@@ -1352,8 +1670,16 @@ rasqal_query_results_get_triple(rasqal_query_results* query_results)
   if(rasqal_query_results_ensure_have_row_internal(query_results))
     return NULL;
 
+  if(!query_results->construct_terms) {
+    if(rasqal_query_results_init_construct(query_results, query)) {
+      rasqal_query_results_free_construct(query_results);
+      return NULL;
+    }
+  }
+
   while(1) {
     int skip = 0;
+    int offset;
 
     if(query_results->current_triple_result < 0)
       query_results->current_triple_result = 0;
@@ -1365,7 +1691,11 @@ rasqal_query_results_get_triple(rasqal_query_results* query_results)
 
     raptor_statement_clear(rs);
 
-    rs->subject = rasqal_literal_to_result_term(query_results, t->subject);
+    offset = 3 * query_results->current_triple_result;
+
+    rs->subject = rasqal_query_results_get_construct_term(query_results,
+                                                          offset,
+                                                          t->subject);
     if(!rs->subject || rs->subject->type == RAPTOR_TERM_TYPE_LITERAL) {
       rasqal_log_warning_simple(query_results->world,
                                 RASQAL_WARNING_LEVEL_BAD_TRIPLE,
@@ -1373,7 +1703,9 @@ rasqal_query_results_get_triple(rasqal_query_results* query_results)
                                 "Triple with non-RDF subject term skipped");
       skip = 1;
     } else {
-      rs->predicate = rasqal_literal_to_result_term(query_results, t->predicate);
+      rs->predicate = rasqal_query_results_get_construct_term(query_results,
+                                                              offset + 1,
+                                                              t->predicate);
       if(!rs->predicate || rs->predicate->type != RAPTOR_TERM_TYPE_URI) {
         rasqal_log_warning_simple(query_results->world,
                                   RASQAL_WARNING_LEVEL_BAD_TRIPLE,
@@ -1381,7 +1713,9 @@ rasqal_query_results_get_triple(rasqal_query_results* query_results)
                                   "Triple with non-RDF predicate term skipped");
         skip = 1;
       } else {
-        rs->object = rasqal_literal_to_result_term(query_results, t->object);
+        rs->object = rasqal_query_results_get_construct_term(query_results,
+                                                             offset + 2,
+                                                             t->object);
         if(!rs->object) {
           rasqal_log_warning_simple(query_results->world,
                                     RASQAL_WARNING_LEVEL_BAD_TRIPLE,
@@ -1392,6 +1726,10 @@ rasqal_query_results_get_triple(rasqal_query_results* query_results)
       }
     }
 
+    if(!skip && query_results->seen_size &&
+       rasqal_query_results_seen_triple(query_results, rs))
+      skip = 1;
+
     if(!skip)
       /* got triple, return it */
       break;
@@ -143,7 +143,8 @@ rasqal_query_write_sparql_literal(sparql_writer_context *wc,
       break;
 
     case RASQAL_LITERAL_INTEGER:
-      raptor_iostream_decimal_write(l->value.integer, iostr);
+      /* the lexical form: an int cannot hold every integer value */
+      raptor_iostream_counted_string_write(l->string, l->string_len, iostr);
       break;
 
     case RASQAL_LITERAL_BOOLEAN:
@@ -758,6 +759,8 @@ rasqal_query_write_sparql_values(sparql_writer_context* wc,
         rasqal_query_write_sparql_row(wc, iostr, row, 1);
         raptor_iostream_write_byte('\n', iostr);
       } else {
+        if(i > 0)
+          raptor_iostream_write_byte(' ', iostr);
         rasqal_query_write_sparql_row(wc, iostr, row, 0);
       }
     }
@@ -1061,6 +1064,40 @@ rasqal_query_write_sparql_20060406_graph_pattern(rasqal_graph_pattern* gp,
 }
 
 
+/*
+ * rasqal_query_write_sparql_values_clause:
+ * @world: rasqal world
+ * @iostr: iostream to write to
+ * @bindings: bindings to write
+ *
+ * INTERNAL - Write a VALUES block for @bindings in SPARQL 1.1 syntax
+ *
+ * All URIs are written in full since no prefixes are declared.
+ *
+ * Return value: non-0 on failure
+ */
+int
+rasqal_query_write_sparql_values_clause(rasqal_world* world,
+                                        raptor_iostream *iostr,
+                                        rasqal_bindings* bindings)
+{
+  sparql_writer_context wc;
+  int rc;
+
+  memset(&wc, '\0', sizeof(wc));
+  wc.world = world;
+  wc.nstack = raptor_new_namespaces(world->raptor_world_ptr, 0);
+  if(!wc.nstack)
+    return 1;
+
+  rc = rasqal_query_write_sparql_values(&wc, iostr, bindings, 0);
+
+  raptor_free_namespaces(wc.nstack);
+
+  return rc;
+}
+
+
 int
 rasqal_query_write_sparql_20060406(raptor_iostream *iostr,
                                    rasqal_query* query, raptor_uri *base_uri)
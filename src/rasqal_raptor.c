@@ -79,6 +79,7 @@ typedef struct {
 static int rasqal_raptor_init_triples_match(rasqal_triples_match* rtm, rasqal_triples_source *rts, void *user_data, rasqal_triple_meta *m, rasqal_triple *t);
 static int rasqal_raptor_triple_present(rasqal_triples_source *rts, void *user_data, rasqal_triple *t);
 static void rasqal_raptor_free_triples_source(void *user_data);
+static int rasqal_raptor_triples_count(rasqal_triples_source *rts, void *user_data, rasqal_triple *t, rasqal_integer *count_p);
 
 
 rasqal_triple*
@@ -213,12 +214,13 @@ rasqal_raptor_init_triples_source_common(rasqal_world* world,
   rtsc = (rasqal_raptor_triples_source_user_data*)user_data;
 
   /* Max API version this triples source generates */
-  rts->version = 2;
+  rts->version = 3;
   
   rts->init_triples_match = rasqal_raptor_init_triples_match;
   rts->triple_present = rasqal_raptor_triple_present;
   rts->free_triples_source = rasqal_raptor_free_triples_source;
   rts->support_feature = rasqal_raptor_support_feature;
+  rts->triples_count = rasqal_raptor_triples_count;
 
   rtsc->world = world;
 
@@ -492,6 +494,88 @@ rasqal_raptor_triple_present(rasqal_triples_source *rts, void *user_data,
 
 
 
+/* Count triples matching @t with variables as wildcards */
+static int
+rasqal_raptor_triples_count(rasqal_triples_source *rts, void *user_data,
+                            rasqal_triple *t, rasqal_integer *count_p)
+{
+  rasqal_raptor_triples_source_user_data* rtsc;
+  rasqal_raptor_triple *triple;
+  rasqal_triple match;
+  rasqal_variable* vars[4];
+  unsigned int parts = RASQAL_TRIPLE_SPO;
+  rasqal_integer count = 0;
+  int repeats = 0;
+  int i;
+  int j;
+
+  rtsc = (rasqal_raptor_triples_source_user_data*)user_data;
+
+  memset(&match, '\0', sizeof(match));
+
+  vars[0] = rasqal_literal_as_variable(t->subject);
+  if(!vars[0])
+    match.subject = t->subject;
+
+  vars[1] = rasqal_literal_as_variable(t->predicate);
+  if(!vars[1])
+    match.predicate = t->predicate;
+
+  vars[2] = rasqal_literal_as_variable(t->object);
+  if(!vars[2])
+    match.object = t->object;
+
+  vars[3] = NULL;
+  if(t->origin) {
+    parts = (rasqal_triple_parts)(parts | RASQAL_TRIPLE_GRAPH);
+    vars[3] = rasqal_literal_as_variable(t->origin);
+    if(!vars[3])
+      match.origin = t->origin;
+  }
+
+  for(i = 0; i < 4; i++) {
+    for(j = i + 1; j < 4; j++) {
+      if(vars[i] && vars[i] == vars[j])
+        repeats = 1;
+    }
+  }
+
+  for(triple = rtsc->head; triple; triple = triple->next) {
+    if(!rasqal_raptor_triple_match(rtsc->world, triple->triple, &match, parts))
+      continue;
+
+    if(repeats) {
+      rasqal_literal* values[4];
+      int equal = 1;
+
+      values[0] = triple->triple->subject;
+      values[1] = triple->triple->predicate;
+      values[2] = triple->triple->object;
+      values[3] = triple->triple->origin;
+
+      /* a repeated variable must match the same value each time */
+      for(i = 0; i < 4 && equal; i++) {
+        for(j = i + 1; j < 4 && equal; j++) {
+          if(vars[i] && vars[i] == vars[j])
+            equal = rasqal_literal_equals_flags(values[i], values[j],
+                                                RASQAL_COMPARE_RDF, NULL);
+        }
+      }
+
+      if(!equal)
+        continue;
+    }
+
+    count++;
+  }
+
+  *count_p = count;
+
+  return 0;
+}
+
+
+
 static void
 rasqal_raptor_free_triples_source(void *user_data)
 {
@@ -157,6 +157,7 @@ rasqal_get_query_results_formatter_factory(rasqal_world* world,
 {
   int i;
   rasqal_query_results_format_factory* factory = NULL;
+  rasqal_query_results_format_factory* first_factory = NULL;
   
   for(i = 0; 1; i++) {
     int factory_flags = 0;
@@ -175,7 +176,10 @@ rasqal_get_query_results_formatter_factory(rasqal_world* world,
     if(flags && (factory_flags & flags) != flags)
       continue;
 
-    if(!name && !uri)
+    if(!first_factory)
+      first_factory = factory;
+
+    if(!name && !uri && !mime_type)
       /* the default is the first registered format */
       break;
 
@@ -215,6 +219,10 @@ rasqal_get_query_results_formatter_factory(rasqal_world* world,
       }
     }
   }
+
+  /* an unknown MIME type alone gets the default format */
+  if(!factory && !name && !uri)
+    factory = first_factory;
   
   return factory;
 }
@@ -49,6 +49,7 @@
  * @second_count: number of variables in second query result
  * @variables_count: number of variables in @vt and @defined_in_map
  * @variables_in_both_count: number of shared variables in both query results
+ * @unordered: non-0 to compare the results ignoring row order
  *
  * Lookup data constructed for comparing two query results to enable
  * quick mapping between values.
@@ -72,9 +73,91 @@ struct rasqal_results_compare_s {
   unsigned int second_count;
   unsigned int variables_count;
   unsigned int variables_in_both_count;
+
+  int unordered;
 };
 
 
+/* A row of the first results in the hash table for unordered comparison */
+typedef struct rasqal_results_compare_entry_s {
+  unsigned int hash;
+
+  /* offset of the row in the first results */
+  int offset;
+
+  rasqal_row* row;
+
+  int matched;
+
+  struct rasqal_results_compare_entry_s* next;
+} rasqal_results_compare_entry;
+
+
+/* A blank node of the first results mapped to one of the second */
+typedef struct rasqal_results_compare_blank_s {
+  const unsigned char* labels[2];
+
+  /* next in the first and second label hash chains */
+  struct rasqal_results_compare_blank_s* next[2];
+
+  /* blank added before this one, for undoing the mapping */
+  struct rasqal_results_compare_blank_s* previous;
+} rasqal_results_compare_blank;
+
+
+/* A row of the second results with blank nodes being matched */
+typedef struct {
+  rasqal_row* row;
+
+  /* offset of the row in the second results */
+  int offset;
+
+  unsigned int hash;
+
+  /* entry the row is currently matched to or NULL */
+  rasqal_results_compare_entry* entry;
+
+  /* last blank added before the row was matched */
+  rasqal_results_compare_blank* blanks;
+} rasqal_results_compare_blank_row;
+
+
+/* Most candidate rows tried when matching rows with blank nodes */
+#define RASQAL_RESULTS_COMPARE_MAX_TRIES 1000000
+
+
+/* State of an unordered comparison */
+typedef struct {
+  rasqal_results_compare* rrc;
+
+  rasqal_results_compare_entry** buckets;
+  unsigned int buckets_mask;
+  rasqal_results_compare_entry* entries;
+  int entries_count;
+
+  /* blank node mapping hashed on the first and on the second labels */
+  rasqal_results_compare_blank** blank_buckets[2];
+  unsigned int blank_buckets_mask;
+
+  /* last blank added to the mapping */
+  rasqal_results_compare_blank* blanks;
+
+  /* rows of the second results with blank nodes */
+  rasqal_results_compare_blank_row* blank_rows;
+  int blank_rows_count;
+  int blank_rows_size;
+
+  /* candidate rows tried when matching rows with blank nodes */
+  int tries;
+
+  /* blank node pairs in the row being matched */
+  const unsigned char** pairs;
+  int pairs_count;
+
+  int differences;
+} rasqal_results_compare_unordered;
+
+
 
 rasqal_results_compare*
 rasqal_new_results_compare(rasqal_world* world,
@@ -199,6 +282,26 @@ rasqal_results_compare_set_log_handler(rasqal_results_compare* rrc,
 }
 
 
+/**
+ * rasqal_results_compare_set_unordered:
+ * @rrc: results compare object
+ * @unordered: non-0 to ignore row order
+ *
+ * Set whether results are compared ignoring the order of rows
+ *
+ * An unordered comparison matches the rows as multisets using a hash
+ * of each row so the results do not need sorting first.  Blank nodes
+ * match when they can be consistently relabelled: each blank node
+ * of the first results matches the same one of the second.
+ */
+void
+rasqal_results_compare_set_unordered(rasqal_results_compare* rrc,
+                                     int unordered)
+{
+  rrc->unordered = unordered;
+}
+
+
 /**
  * rasqal_results_compare_variables_equal:
  * @rrc: results compare object
@@ -307,6 +410,743 @@ rasqal_print_results_compare(FILE *handle, rasqal_results_compare* rrc)
 }
 
 
+/*
+ * rasqal_results_compare_value_hash:
+ * @l: value or NULL
+ *
+ * INTERNAL - Hash a value consistently with rasqal_literal_equals_flags() with RASQAL_COMPARE_XQUERY
+ *
+ * Numbers are compared after type promotion so they are hashed by
+ * their value as a double.  Doubles are equal within a rounding error
+ * so the value is hashed at float precision.  Dates and dateTimes are
+ * hashed by their instant on the timeline.  All blank nodes get the
+ * same hash since they match by a relabelling.
+ *
+ * Return value: hash
+ */
+static unsigned int
+rasqal_results_compare_value_hash(rasqal_literal* l)
+{
+  unsigned char buf[sizeof(time_t) + sizeof(int) + 1];
+  const unsigned char* p = NULL;
+  size_t len = 0;
+  unsigned int hash;
+
+  if(!l)
+    return 0;
+
+  /* as rasqal_literal_equals_flags() does */
+  rasqal_literal_string_to_native(l, 0);
+
+  switch(l->type) {
+    case RASQAL_LITERAL_URI:
+      p = raptor_uri_as_counted_string(l->value.uri, &len);
+      hash = 1;
+      break;
+
+    case RASQAL_LITERAL_STRING:
+    case RASQAL_LITERAL_XSD_STRING:
+    case RASQAL_LITERAL_UDT:
+      p = l->string;
+      len = l->string_len;
+      hash = 2;
+      break;
+
+    case RASQAL_LITERAL_BLANK:
+      hash = 3;
+      break;
+
+    case RASQAL_LITERAL_INTEGER:
+    case RASQAL_LITERAL_DOUBLE:
+    case RASQAL_LITERAL_FLOAT:
+    case RASQAL_LITERAL_DECIMAL:
+    case RASQAL_LITERAL_INTEGER_SUBTYPE:
+      {
+        int error = 0;
+        float f;
+
+        f = RASQAL_GOOD_CAST(float, rasqal_literal_as_double(l, &error));
+        /* one hash for -0 and 0 and for NaN */
+        if(f == 0.0f || f != f)
+          f = 0.0f;
+        memcpy(buf, &f, sizeof(f));
+        p = buf;
+        len = sizeof(f);
+      }
+      hash = 4;
+      break;
+
+    case RASQAL_LITERAL_BOOLEAN:
+      buf[0] = RASQAL_GOOD_CAST(unsigned char, l->value.integer ? 1 : 0);
+      p = buf;
+      len = 1;
+      hash = 5;
+      break;
+
+    case RASQAL_LITERAL_DATE:
+    case RASQAL_LITERAL_DATETIME:
+      {
+        time_t timeline;
+        int microseconds = 0;
+        int has_tz;
+
+        /* a date is compared to a dateTime as a dateTime at the same
+         * time on the timeline */
+        if(l->type == RASQAL_LITERAL_DATE) {
+          timeline = l->value.date->time_on_timeline;
+          has_tz = (l->value.date->timezone_minutes != RASQAL_XSD_DATETIME_NO_TZ);
+        } else {
+          timeline = l->value.datetime->time_on_timeline;
+          microseconds = l->value.datetime->microseconds;
+          has_tz = (l->value.datetime->timezone_minutes != RASQAL_XSD_DATETIME_NO_TZ);
+        }
+        memcpy(buf, &timeline, sizeof(timeline));
+        memcpy(buf + sizeof(timeline), &microseconds, sizeof(microseconds));
+        buf[sizeof(timeline) + sizeof(microseconds)] = RASQAL_GOOD_CAST(unsigned char, has_tz);
+        p = buf;
+        len = sizeof(buf);
+      }
+      hash = 6;
+      break;
+
+    case RASQAL_LITERAL_UNKNOWN:
+    case RASQAL_LITERAL_PATTERN:
+    case RASQAL_LITERAL_QNAME:
+    case RASQAL_LITERAL_VARIABLE:
+    default:
+      hash = 7;
+      break;
+  }
+
+  /* FNV-1a over the kind and the bytes of the value */
+  hash ^= 2166136261U;
+  hash *= 16777619U;
+  while(len--) {
+    hash ^= *p++;
+    hash *= 16777619U;
+  }
+
+  return hash;
+}
+
+
+static unsigned int
+rasqal_results_compare_row_hash(rasqal_results_compare* rrc, rasqal_row* row,
+                                int qr_index)
+{
+  unsigned int hash = 0;
+  unsigned int i;
+
+  for(i = 0; i < rrc->variables_count; i++) {
+    int ix = rrc->defined_in_map[qr_index + RASQAL_GOOD_CAST(int, i << 1)];
+
+    hash = (hash * 31) + rasqal_results_compare_value_hash(row->values[ix]);
+  }
+
+  return hash;
+}
+
+
+static unsigned int
+rasqal_results_compare_label_hash(const unsigned char* label)
+{
+  unsigned int hash = 2166136261U;
+
+  while(*label) {
+    hash ^= *label++;
+    hash *= 16777619U;
+  }
+
+  return hash;
+}
+
+
+/*
+ * rasqal_results_compare_get_blank:
+ * @ruc: unordered comparison
+ * @label: blank node label
+ * @qr_index: results index 0 (first) or 1 (second) of @label
+ *
+ * INTERNAL - Get the label a blank node is mapped to in the other results
+ *
+ * Return value: shared label or NULL if not mapped
+ */
+static const unsigned char*
+rasqal_results_compare_get_blank(rasqal_results_compare_unordered* ruc,
+                                 const unsigned char* label, int qr_index)
+{
+  rasqal_results_compare_blank* blank;
+  unsigned int hash = rasqal_results_compare_label_hash(label);
+
+  blank = ruc->blank_buckets[qr_index][hash & ruc->blank_buckets_mask];
+  for(; blank; blank = blank->next[qr_index]) {
+    if(!strcmp(RASQAL_GOOD_CAST(const char*, blank->labels[qr_index]),
+               RASQAL_GOOD_CAST(const char*, label)))
+      return blank->labels[1 - qr_index];
+  }
+
+  return NULL;
+}
+
+
+static int
+rasqal_results_compare_add_blank(rasqal_results_compare_unordered* ruc,
+                                 const unsigned char* first,
+                                 const unsigned char* second)
+{
+  rasqal_results_compare_blank* blank;
+  int qr_index;
+
+  blank = RASQAL_MALLOC(rasqal_results_compare_blank*, sizeof(*blank));
+  if(!blank)
+    return 1;
+
+  blank->labels[0] = first;
+  blank->labels[1] = second;
+
+  for(qr_index = 0; qr_index < 2; qr_index++) {
+    unsigned int hash;
+    rasqal_results_compare_blank** bucket;
+
+    hash = rasqal_results_compare_label_hash(blank->labels[qr_index]);
+    bucket = &ruc->blank_buckets[qr_index][hash & ruc->blank_buckets_mask];
+    blank->next[qr_index] = *bucket;
+    *bucket = blank;
+  }
+
+  blank->previous = ruc->blanks;
+  ruc->blanks = blank;
+
+  return 0;
+}
+
+
+/*
+ * rasqal_results_compare_remove_blanks:
+ * @ruc: unordered comparison
+ * @blanks: blank to keep the mapping back to
+ *
+ * INTERNAL - Remove the blank node pairs added to the mapping after @blanks
+ *
+ * Pairs are removed last added first so each is at the head of its
+ * hash chains.
+ */
+static void
+rasqal_results_compare_remove_blanks(rasqal_results_compare_unordered* ruc,
+                                     rasqal_results_compare_blank* blanks)
+{
+  while(ruc->blanks != blanks) {
+    rasqal_results_compare_blank* blank = ruc->blanks;
+    int qr_index;
+
+    for(qr_index = 0; qr_index < 2; qr_index++) {
+      unsigned int hash;
+
+      hash = rasqal_results_compare_label_hash(blank->labels[qr_index]);
+      ruc->blank_buckets[qr_index][hash & ruc->blank_buckets_mask] = blank->next[qr_index];
+    }
+
+    ruc->blanks = blank->previous;
+    RASQAL_FREE(rasqal_results_compare_blank*, blank);
+  }
+}
+
+
+/*
+ * rasqal_results_compare_rows_match:
+ * @ruc: unordered comparison
+ * @row1: row of the first results
+ * @row2: row of the second results
+ *
+ * INTERNAL - Check if two rows match with the current blank node mapping
+ *
+ * Blank node pairs that are not mapped yet are left in ruc->pairs
+ * for adding to the mapping if the rows are matched.
+ *
+ * Return value: non-0 if the rows match
+ */
+static int
+rasqal_results_compare_rows_match(rasqal_results_compare_unordered* ruc,
+                                  rasqal_row* row1, rasqal_row* row2)
+{
+  rasqal_results_compare* rrc = ruc->rrc;
+  unsigned int i;
+
+  ruc->pairs_count = 0;
+
+  for(i = 0; i < rrc->variables_count; i++) {
+    rasqal_literal* value1 = row1->values[rrc->defined_in_map[i << 1]];
+    rasqal_literal* value2 = row2->values[rrc->defined_in_map[1 + (i << 1)]];
+    const unsigned char* label1;
+    const unsigned char* label2;
+    const unsigned char* mapped1;
+    const unsigned char* mapped2;
+    int error = 0;
+    int j;
+
+    if(!value1 || !value2) {
+      if(value1 || value2)
+        return 0;
+      continue;
+    }
+
+    if(value1->type != RASQAL_LITERAL_BLANK ||
+       value2->type != RASQAL_LITERAL_BLANK) {
+      if(value1->type == RASQAL_LITERAL_BLANK ||
+         value2->type == RASQAL_LITERAL_BLANK)
+        return 0;
+
+      if(!rasqal_literal_equals_flags(value1, value2, RASQAL_COMPARE_XQUERY,
+                                      &error))
+        return 0;
+      continue;
+    }
+
+    label1 = value1->string;
+    label2 = value2->string;
+
+    mapped1 = rasqal_results_compare_get_blank(ruc, label1, 0);
+    mapped2 = rasqal_results_compare_get_blank(ruc, label2, 1);
+    if(mapped1 || mapped2) {
+      if(!mapped1 || !mapped2 ||
+         strcmp(RASQAL_GOOD_CAST(const char*, mapped1),
+                RASQAL_GOOD_CAST(const char*, label2)))
+        return 0;
+      continue;
+    }
+
+    /* new pairs must also agree with the others in this row */
+    for(j = 0; j < ruc->pairs_count; j++) {
+      int same1 = !strcmp(RASQAL_GOOD_CAST(const char*, ruc->pairs[j << 1]),
+                          RASQAL_GOOD_CAST(const char*, label1));
+      int same2 = !strcmp(RASQAL_GOOD_CAST(const char*, ruc->pairs[1 + (j << 1)]),
+                          RASQAL_GOOD_CAST(const char*, label2));
+      if(same1 != same2)
+        return 0;
+      if(same1)
+        break;
+    }
+
+    if(j == ruc->pairs_count) {
+      ruc->pairs[j << 1] = label1;
+      ruc->pairs[1 + (j << 1)] = label2;
+      ruc->pairs_count++;
+    }
+  }
+
+  return 1;
+}
+
+
+static void
+rasqal_results_compare_report_row(rasqal_results_compare* rrc,
+                                  rasqal_row* row, int rowi, int qr_index)
+{
+  raptor_world* raptor_world_ptr;
+  void *string;
+  size_t length;
+  raptor_iostream* string_iostr;
+  unsigned int i;
+
+  raptor_world_ptr = rasqal_world_get_raptor(rrc->world);
+
+  string_iostr = raptor_new_iostream_to_string(raptor_world_ptr,
+                                               &string, &length,
+                                               (raptor_data_malloc_handler)malloc);
+  if(!string_iostr)
+    return;
+
+  raptor_iostream_counted_string_write("Row ", 4, string_iostr);
+  raptor_iostream_decimal_write(rowi + 1, string_iostr);
+  raptor_iostream_write_byte(' ', string_iostr);
+  raptor_iostream_string_write(qr_index ? rrc->second_qr_label : rrc->first_qr_label,
+                               string_iostr);
+  raptor_iostream_counted_string_write(" not in ", 8, string_iostr);
+  raptor_iostream_string_write(qr_index ? rrc->first_qr_label : rrc->second_qr_label,
+                               string_iostr);
+  raptor_iostream_counted_string_write(":", 1, string_iostr);
+
+  for(i = 0; i < rrc->variables_count; i++) {
+    rasqal_variable* v;
+    int ix = rrc->defined_in_map[qr_index + RASQAL_GOOD_CAST(int, i << 1)];
+
+    v = rasqal_results_compare_get_variable_by_offset(rrc, RASQAL_GOOD_CAST(int, i));
+    raptor_iostream_write_byte(' ', string_iostr);
+    raptor_iostream_string_write(v->name, string_iostr);
+    raptor_iostream_write_byte('=', string_iostr);
+    rasqal_literal_write(row->values[ix], string_iostr);
+  }
+
+  /* this allocates and copies result into 'string' */
+  raptor_free_iostream(string_iostr);
+
+  rrc->message.level = RAPTOR_LOG_LEVEL_ERROR;
+  rrc->message.text = (const char*)string;
+  if(rrc->log_handler)
+    rrc->log_handler(rrc->log_user_data, &rrc->message);
+
+  free(string);
+}
+
+
+/*
+ * rasqal_results_compare_match_rows:
+ * @ruc: unordered comparison
+ *
+ * INTERNAL - Match rows of the second results without blank nodes against the first
+ *
+ * Rows with blank nodes are kept in ruc->blank_rows for
+ * rasqal_results_compare_match_blank_rows()
+ *
+ * Return value: non-0 on failure
+ */
+static int
+rasqal_results_compare_match_rows(rasqal_results_compare_unordered* ruc)
+{
+  rasqal_results_compare* rrc = ruc->rrc;
+  int rowi;
+
+  for(rowi = 0; 1; rowi++) {
+    rasqal_row* row2;
+    rasqal_results_compare_entry* entry;
+    unsigned int hash;
+    unsigned int i;
+    int has_blank = 0;
+
+    row2 = rasqal_query_results_get_row_by_offset(rrc->second_qr, rowi);
+    if(!row2)
+      break;
+
+    for(i = 0; i < rrc->variables_count; i++) {
+      rasqal_literal* l = row2->values[rrc->defined_in_map[1 + (i << 1)]];
+      if(l && l->type == RASQAL_LITERAL_BLANK)
+        has_blank = 1;
+    }
+
+    hash = rasqal_results_compare_row_hash(rrc, row2, 1);
+
+    if(has_blank) {
+      rasqal_results_compare_blank_row* brow;
+
+      if(ruc->blank_rows_count == ruc->blank_rows_size) {
+        rasqal_results_compare_blank_row* blank_rows;
+        int size = ruc->blank_rows_size ? (ruc->blank_rows_size << 1) : 8;
+
+        blank_rows = RASQAL_CALLOC(rasqal_results_compare_blank_row*,
+                                   RASQAL_GOOD_CAST(size_t, size),
+                                   sizeof(*blank_rows));
+        if(!blank_rows) {
+          rasqal_free_row(row2);
+          return 1;
+        }
+        if(ruc->blank_rows) {
+          memcpy(blank_rows, ruc->blank_rows,
+                 RASQAL_GOOD_CAST(size_t, ruc->blank_rows_count) * sizeof(*blank_rows));
+          RASQAL_FREE(rasqal_results_compare_blank_row*, ruc->blank_rows);
+        }
+        ruc->blank_rows = blank_rows;
+        ruc->blank_rows_size = size;
+      }
+
+      brow = &ruc->blank_rows[ruc->blank_rows_count++];
+      brow->row = row2;
+      brow->offset = rowi;
+      brow->hash = hash;
+      continue;
+    }
+
+    for(entry = ruc->buckets[hash & ruc->buckets_mask];
+        entry;
+        entry = entry->next) {
+      if(!entry->matched && entry->hash == hash &&
+         rasqal_results_compare_rows_match(ruc, entry->row, row2))
+        break;
+    }
+
+    if(entry)
+      entry->matched = 1;
+    else {
+      rasqal_results_compare_report_row(rrc, row2, rowi, 1);
+      ruc->differences++;
+    }
+
+    rasqal_free_row(row2);
+  }
+
+  return 0;
+}
+
+
+/*
+ * rasqal_results_compare_find_entry:
+ * @ruc: unordered comparison
+ * @brow: row of the second results with blank nodes
+ * @entry: first candidate row of the first results
+ *
+ * INTERNAL - Find the next unmatched row of the first results that matches @brow
+ *
+ * On success the blank node pairs new to the mapping are left in
+ * ruc->pairs.
+ *
+ * Return value: matching row or NULL if there is none
+ */
+static rasqal_results_compare_entry*
+rasqal_results_compare_find_entry(rasqal_results_compare_unordered* ruc,
+                                  rasqal_results_compare_blank_row* brow,
+                                  rasqal_results_compare_entry* entry)
+{
+  for(; entry; entry = entry->next) {
+    if(entry->matched || entry->hash != brow->hash)
+      continue;
+
+    ruc->tries++;
+    if(rasqal_results_compare_rows_match(ruc, entry->row, brow->row))
+      return entry;
+  }
+
+  return NULL;
+}
+
+
+static int
+rasqal_results_compare_match_blank_row(rasqal_results_compare_unordered* ruc,
+                                       rasqal_results_compare_blank_row* brow,
+                                       rasqal_results_compare_entry* entry)
+{
+  int j;
+
+  brow->entry = entry;
+  brow->blanks = ruc->blanks;
+  entry->matched = 1;
+
+  for(j = 0; j < ruc->pairs_count; j++) {
+    if(rasqal_results_compare_add_blank(ruc, ruc->pairs[j << 1],
+                                        ruc->pairs[1 + (j << 1)]))
+      return 1;
+  }
+
+  return 0;
+}
+
+
+static void
+rasqal_results_compare_unmatch_blank_row(rasqal_results_compare_unordered* ruc,
+                                         rasqal_results_compare_blank_row* brow)
+{
+  rasqal_results_compare_remove_blanks(ruc, brow->blanks);
+  brow->entry->matched = 0;
+  brow->entry = NULL;
+}
+
+
+/*
+ * rasqal_results_compare_match_blank_rows:
+ * @ruc: unordered comparison
+ *
+ * INTERNAL - Match rows of the second results with blank nodes against the first
+ *
+ * Searches for a one to one mapping of blank nodes under which every
+ * row in ruc->blank_rows matches a different row of the first
+ * results.  Each row is matched to the next compatible row in turn
+ * and when a later row cannot be matched, the search backtracks to
+ * try the next choice for the rows before it, removing the blank
+ * node pairs those choices added.
+ *
+ * If there is no such mapping, the rows are matched to the first
+ * compatible row only to report the rows that differ.
+ *
+ * Return value: non-0 on failure
+ */
+static int
+rasqal_results_compare_match_blank_rows(rasqal_results_compare_unordered* ruc)
+{
+  rasqal_results_compare* rrc = ruc->rrc;
+  int level = 0;
+  int i;
+
+  while(level >= 0 && level < ruc->blank_rows_count) {
+    rasqal_results_compare_blank_row* brow = &ruc->blank_rows[level];
+    rasqal_results_compare_entry* entry;
+
+    if(brow->entry) {
+      /* backtracking: try the candidates after the current one */
+      entry = brow->entry->next;
+      rasqal_results_compare_unmatch_blank_row(ruc, brow);
+    } else
+      entry = ruc->buckets[brow->hash & ruc->buckets_mask];
+
+    entry = rasqal_results_compare_find_entry(ruc, brow, entry);
+
+    if(ruc->tries > RASQAL_RESULTS_COMPARE_MAX_TRIES) {
+      rrc->message.level = RAPTOR_LOG_LEVEL_ERROR;
+      rrc->message.text = "Too many blank node mappings to compare results";
+      if(rrc->log_handler)
+        rrc->log_handler(rrc->log_user_data, &rrc->message);
+      return 1;
+    }
+
+    if(entry) {
+      if(rasqal_results_compare_match_blank_row(ruc, brow, entry))
+        return 1;
+      level++;
+    } else
+      level--;
+  }
+
+  if(level >= 0)
+    return 0;
+
+  /* no consistent mapping; all choices have been undone */
+  for(i = 0; i < ruc->blank_rows_count; i++) {
+    rasqal_results_compare_blank_row* brow = &ruc->blank_rows[i];
+    rasqal_results_compare_entry* entry;
+
+    entry = rasqal_results_compare_find_entry(ruc, brow,
+                                              ruc->buckets[brow->hash & ruc->buckets_mask]);
+    if(entry) {
+      if(rasqal_results_compare_match_blank_row(ruc, brow, entry))
+        return 1;
+    } else {
+      rasqal_results_compare_report_row(rrc, brow->row, brow->offset, 1);
+      ruc->differences++;
+    }
+  }
+
+  return 0;
+}
+
+
+/*
+ * rasqal_results_compare_compare_unordered:
+ * @rrc: results compare object
+ *
+ * INTERNAL - Compare results as multisets of rows
+ *
+ * The rows of the first results are put in a hash table on a hash of
+ * their values that is the same for all blank nodes.  Rows of the
+ * second results without blank nodes are matched first, then the
+ * rows with blank nodes by a backtracking search for a one to one
+ * mapping of blank nodes.  Rows left unmatched on either side are
+ * reported.
+ *
+ * Return value: number of differences or <0 on failure
+ */
+static int
+rasqal_results_compare_compare_unordered(rasqal_results_compare* rrc)
+{
+  rasqal_results_compare_unordered ruc;
+  unsigned int buckets = 16;
+  int rowi;
+  int blanks_count = 0;
+  int rc = -1;
+  int i;
+
+  memset(&ruc, '\0', sizeof(ruc));
+  ruc.rrc = rrc;
+
+  for(rowi = 0; 1; rowi++) {
+    rasqal_row* row = rasqal_query_results_get_row_by_offset(rrc->first_qr, rowi);
+    if(!row)
+      break;
+    rasqal_free_row(row);
+  }
+  ruc.entries_count = rowi;
+
+  while(buckets < RASQAL_GOOD_CAST(unsigned int, ruc.entries_count))
+    buckets <<= 1;
+  ruc.buckets_mask = buckets - 1;
+
+  ruc.buckets = RASQAL_CALLOC(rasqal_results_compare_entry**, buckets,
+                              sizeof(rasqal_results_compare_entry*));
+  ruc.entries = RASQAL_CALLOC(rasqal_results_compare_entry*,
+                              RASQAL_GOOD_CAST(size_t, ruc.entries_count + 1),
+                              sizeof(rasqal_results_compare_entry));
+  ruc.pairs = RASQAL_CALLOC(const unsigned char**,
+                            (rrc->variables_count + 1) << 1,
+                            sizeof(const unsigned char*));
+  if(!ruc.buckets || !ruc.entries || !ruc.pairs)
+    goto tidy;
+
+  /* rows are added last first so hash chains are in row order */
+  for(i = ruc.entries_count - 1; i >= 0; i--) {
+    rasqal_results_compare_entry* entry = &ruc.entries[i];
+    rasqal_results_compare_entry** bucket;
+    unsigned int j;
+
+    entry->row = rasqal_query_results_get_row_by_offset(rrc->first_qr, i);
+    entry->offset = i;
+    entry->hash = rasqal_results_compare_row_hash(rrc, entry->row, 0);
+
+    for(j = 0; j < rrc->variables_count; j++) {
+      rasqal_literal* l = entry->row->values[rrc->defined_in_map[j << 1]];
+      if(l && l->type == RASQAL_LITERAL_BLANK)
+        blanks_count++;
+    }
+
+    bucket = &ruc.buckets[entry->hash & ruc.buckets_mask];
+    entry->next = *bucket;
+    *bucket = entry;
+  }
+
+  buckets = 16;
+  while(buckets < RASQAL_GOOD_CAST(unsigned int, blanks_count))
+    buckets <<= 1;
+  ruc.blank_buckets_mask = buckets - 1;
+
+  for(i = 0; i < 2; i++) {
+    ruc.blank_buckets[i] = RASQAL_CALLOC(rasqal_results_compare_blank**,
+                                         buckets,
+                                         sizeof(rasqal_results_compare_blank*));
+    if(!ruc.blank_buckets[i])
+      goto tidy;
+  }
+
+  if(rasqal_results_compare_match_rows(&ruc) ||
+     rasqal_results_compare_match_blank_rows(&ruc))
+    goto tidy;
+
+  for(i = 0; i < ruc.entries_count; i++) {
+    if(!ruc.entries[i].matched) {
+      rasqal_results_compare_report_row(rrc, ruc.entries[i].row, i, 0);
+      ruc.differences++;
+    }
+  }
+
+  rc = ruc.differences;
+
+  tidy:
+  while(ruc.blanks) {
+    rasqal_results_compare_blank* previous = ruc.blanks->previous;
+    RASQAL_FREE(rasqal_results_compare_blank*, ruc.blanks);
+    ruc.blanks = previous;
+  }
+  for(i = 0; i < 2; i++) {
+    if(ruc.blank_buckets[i])
+      RASQAL_FREE(rasqal_results_compare_blank**, ruc.blank_buckets[i]);
+  }
+
+  if(ruc.blank_rows) {
+    for(i = 0; i < ruc.blank_rows_count; i++)
+      rasqal_free_row(ruc.blank_rows[i].row);
+    RASQAL_FREE(rasqal_results_compare_blank_row*, ruc.blank_rows);
+  }
+
+  if(ruc.entries) {
+    for(i = 0; i < ruc.entries_count; i++) {
+      if(ruc.entries[i].row)
+        rasqal_free_row(ruc.entries[i].row);
+    }
+    RASQAL_FREE(rasqal_results_compare_entry*, ruc.entries);
+  }
+  if(ruc.buckets)
+    RASQAL_FREE(rasqal_results_compare_entry**, ruc.buckets);
+  if(ruc.pairs)
+    RASQAL_FREE(const unsigned char**, ruc.pairs);
+
+  return rc;
+}
+
+
 /**
  * rasqal_results_compare_compare:
  * @cqr: query results object
@@ -360,6 +1200,21 @@ rasqal_results_compare_compare(rasqal_results_compare* rrc)
     }
   }
 
+  if(rrc->unordered) {
+    int rc = rasqal_results_compare_compare_unordered(rrc);
+
+    if(rc) {
+      rrc->message.level = RAPTOR_LOG_LEVEL_ERROR;
+      rrc->message.text = (rc < 0) ? "Results comparison failed" :
+                                     "Results have different values";
+      if(rrc->log_handler)
+        rrc->log_handler(rrc->log_user_data, &rrc->message);
+
+      differences++;
+    }
+    goto done;
+  }
+
   /* set results to be stored? */
 
   /* sort rows by something ?  As long as the sort is the same it
@@ -514,6 +1369,96 @@ const struct {
 };
 
 
+#define NUNORDERED_TESTS 13
+
+#define XSD "http://www.w3.org/2001/XMLSchema#"
+
+const struct {
+  const char* first_qr_string;
+  const char* second_qr_string;
+  int expected_equality;
+} unordered_data[NUNORDERED_TESTS] = {
+  /* same rows in a different order */
+  {
+    "a\tb\n<http://example.org/1>\t\"x\"\n<http://example.org/2>\t\"y\"\n",
+    "b\ta\n\"y\"\t<http://example.org/2>\n\"x\"\t<http://example.org/1>\n",
+    1
+  },
+  /* repeated row */
+  {
+    "a\n\"x\"\n\"x\"\n\"y\"\n",
+    "a\n\"x\"\n\"y\"\n\"y\"\n",
+    0
+  },
+  /* blank nodes relabelled */
+  {
+    "a\tb\n_:b1\t_:b2\n_:b2\t_:b1\n",
+    "a\tb\n_:x\t_:y\n_:y\t_:x\n",
+    1
+  },
+  /* one blank node against two */
+  {
+    "a\tb\n_:b1\t_:b1\n",
+    "a\tb\n_:x\t_:y\n",
+    0
+  },
+  /* blank node shared across rows in one results only */
+  {
+    "a\tb\n_:b1\t\"x\"\n_:b1\t\"y\"\n",
+    "a\tb\n_:x\t\"x\"\n_:y\t\"y\"\n",
+    0
+  },
+  /* first compatible row gives the wrong blank node mapping */
+  {
+    "a\tb\n_:b1\t\"x\"\n_:b1\t\"y\"\n_:b2\t\"x\"\n",
+    "a\tb\n_:c2\t\"x\"\n_:c1\t\"x\"\n_:c1\t\"y\"\n",
+    1
+  },
+  /* same but the blank node with two rows has different values */
+  {
+    "a\tb\n_:b1\t\"x\"\n_:b1\t\"y\"\n_:b2\t\"x\"\n",
+    "a\tb\n_:c2\t\"x\"\n_:c1\t\"y\"\n_:c1\t\"y\"\n",
+    0
+  },
+  /* cycle of three blank nodes relabelled and reordered */
+  {
+    "a\tb\n_:b1\t_:b2\n_:b2\t_:b3\n_:b3\t_:b1\n",
+    "a\tb\n_:c3\t_:c1\n_:c2\t_:c3\n_:c1\t_:c2\n",
+    1
+  },
+  /* cycle of three blank nodes against a cycle of two and a loop */
+  {
+    "a\tb\n_:b1\t_:b2\n_:b2\t_:b3\n_:b3\t_:b1\n",
+    "a\tb\n_:c1\t_:c2\n_:c2\t_:c1\n_:c3\t_:c3\n",
+    0
+  },
+  /* equal numbers of different types reordered */
+  {
+    "a\n\"1\"^^<" XSD "integer>\n\"2\"^^<" XSD "integer>\n\"10\"^^<" XSD "integer>\n\"0.5\"^^<" XSD "decimal>\n",
+    "a\n\"5.0E-1\"^^<" XSD "double>\n\"10.00\"^^<" XSD "decimal>\n\"1.0\"^^<" XSD "decimal>\n\"2.0E0\"^^<" XSD "double>\n",
+    1
+  },
+  /* numbers that differ */
+  {
+    "a\n\"1\"^^<" XSD "integer>\n\"2\"^^<" XSD "integer>\n",
+    "a\n\"2.0\"^^<" XSD "decimal>\n\"1.5\"^^<" XSD "decimal>\n",
+    0
+  },
+  /* equal dateTimes in different timezones reordered */
+  {
+    "a\n\"2010-01-02T01:00:00+01:00\"^^<" XSD "dateTime>\n\"2010-01-03T00:00:00.5Z\"^^<" XSD "dateTime>\n",
+    "a\n\"2010-01-03T00:00:00.50Z\"^^<" XSD "dateTime>\n\"2010-01-02T00:00:00Z\"^^<" XSD "dateTime>\n",
+    1
+  },
+  /* equal booleans reordered */
+  {
+    "a\n\"true\"^^<" XSD "boolean>\n\"false\"^^<" XSD "boolean>\n",
+    "a\n\"0\"^^<" XSD "boolean>\n\"1\"^^<" XSD "boolean>\n",
+    1
+  }
+};
+
+
 #if defined(RASQAL_DEBUG) && RASQAL_DEBUG > 1
 static void
 print_bindings_results_simple(rasqal_query_results *results, FILE* output)
@@ -615,6 +1560,50 @@ main(int argc, char *argv[])
       rasqal_free_results_compare(rrc);
   }
 
+  for(i = 0; i < NUNORDERED_TESTS; i++) {
+    raptor_uri* base_uri = raptor_new_uri(raptor_world_ptr,
+                                          (const unsigned char*)"http://example.org/");
+    rasqal_query_results *first_qr;
+    rasqal_query_results *second_qr;
+    int expected_equality = unordered_data[i].expected_equality;
+    rasqal_results_compare* rrc = NULL;
+    int equal;
+
+    first_qr = rasqal_new_query_results_from_string(world, type, base_uri,
+                                                    unordered_data[i].first_qr_string,
+                                                    0);
+    second_qr = rasqal_new_query_results_from_string(world, type, base_uri,
+                                                     unordered_data[i].second_qr_string,
+                                                     0);
+    raptor_free_uri(base_uri);
+
+    if(first_qr && second_qr)
+      rrc = rasqal_new_results_compare(world, first_qr, "first",
+                                       second_qr, "second");
+    if(!rrc) {
+      fprintf(stderr, "%s: failed to create results compare %d\n", program, i);
+      failures++;
+    } else {
+      rasqal_results_compare_set_unordered(rrc, 1);
+
+      equal = rasqal_results_compare_compare(rrc);
+      RASQAL_DEBUG4("%s: unordered compare test %d returned %d\n", program, i, equal);
+      if(equal != expected_equality) {
+        fprintf(stderr,
+                "%s: FAILED unordered compare test %d returned %d  expected %d\n",
+                program, i, equal, expected_equality);
+        failures++;
+      }
+    }
+
+    if(first_qr)
+      rasqal_free_query_results(first_qr);
+    if(second_qr)
+      rasqal_free_query_results(second_qr);
+    if(rrc)
+      rasqal_free_results_compare(rrc);
+  }
+
   if(world)
     rasqal_free_world(world);
 
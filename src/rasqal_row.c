@@ -175,6 +175,8 @@ rasqal_free_row(rasqal_row* row)
     }
     RASQAL_FREE(array, row->order_values);
   }
+  if(row->order_key)
+    RASQAL_FREE(char*, row->order_key);
 
   if(row->rowsource)
     rasqal_free_rowsource(row->rowsource);
@@ -0,0 +1,850 @@
+/* -*- Mode: c; c-basic-offset: 2 -*-
+ *
+ * rasqal_row_batch.c - Rasqal Query Result Row Batch class
+ *
+ * Copyright (C) 2026, David Beckett http://www.dajobe.org/
+ *
+ * This package is Free Software and part of Redland http://librdf.org/
+ *
+ * It is licensed under the following three licenses as alternatives:
+ *   1. GNU Lesser General Public License (LGPL) V2.1 or any newer version
+ *   2. GNU General Public License (GPL) V2 or any newer version
+ *   3. Apache License, V2.0 or any newer version
+ *
+ * You may not use this file except in compliance with at least one of
+ * the above three licenses.
+ *
+ * See LICENSE.html or LICENSE.txt at the top of this package for the
+ * complete terms and further detail along with the license texts for
+ * the licenses in COPYING.LIB, COPYING and LICENSE-2.0.txt respectively.
+ *
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <rasqal_config.h>
+#endif
+
+#ifdef WIN32
+#include <win32_rasqal_config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#include <stdarg.h>
+
+#include "rasqal.h"
+#include "rasqal_internal.h"
+
+
+#ifndef STANDALONE
+
+/**
+ * rasqal_new_row_batch:
+ * @world: rasqal_world
+ * @size: number of columns (may be 0 and set later)
+ * @capacity: maximum number of rows or 0 for the default
+ *
+ * INTERNAL - Constructor - Create a new batch of rows stored by column
+ *
+ * Return value: a new row batch or NULL on failure
+ */
+rasqal_row_batch*
+rasqal_new_row_batch(rasqal_world* world, int size, int capacity)
+{
+  rasqal_row_batch* batch;
+  size_t ncapacity;
+
+  if(!world || size < 0 || capacity < 0)
+    return NULL;
+
+  if(!capacity)
+    capacity = RASQAL_ROW_BATCH_SIZE;
+  ncapacity = RASQAL_GOOD_CAST(size_t, capacity);
+
+  batch = RASQAL_CALLOC(rasqal_row_batch*, 1, sizeof(*batch));
+  if(!batch)
+    return NULL;
+
+  batch->world = world;
+  batch->capacity = capacity;
+  batch->limit = capacity;
+
+  batch->offsets = RASQAL_CALLOC(int*, ncapacity, sizeof(int));
+  batch->group_ids = RASQAL_CALLOC(int*, ncapacity, sizeof(int));
+  batch->selection = RASQAL_CALLOC(int*, ncapacity, sizeof(int));
+  if(!batch->offsets || !batch->group_ids || !batch->selection ||
+     rasqal_row_batch_set_size(batch, size)) {
+    rasqal_free_row_batch(batch);
+    return NULL;
+  }
+
+  return batch;
+}
+
+
+/**
+ * rasqal_free_row_batch:
+ * @batch: row batch
+ *
+ * INTERNAL - Destructor - Free a row batch and all the values in it
+ */
+void
+rasqal_free_row_batch(rasqal_row_batch* batch)
+{
+  if(!batch)
+    return;
+
+  rasqal_row_batch_clear(batch);
+
+  if(batch->values)
+    RASQAL_FREE(rasqal_literal**, batch->values);
+  if(batch->offsets)
+    RASQAL_FREE(int*, batch->offsets);
+  if(batch->group_ids)
+    RASQAL_FREE(int*, batch->group_ids);
+  if(batch->selection)
+    RASQAL_FREE(int*, batch->selection);
+  if(batch->integers)
+    RASQAL_FREE(rasqal_integer*, batch->integers);
+  if(batch->doubles)
+    RASQAL_FREE(double*, batch->doubles);
+  if(batch->matches)
+    RASQAL_FREE(unsigned char*, batch->matches);
+
+  RASQAL_FREE(rasqal_row_batch, batch);
+}
+
+
+/**
+ * rasqal_row_batch_set_size:
+ * @batch: row batch
+ * @size: number of columns
+ *
+ * INTERNAL - Empty the batch and set the number of columns it holds
+ *
+ * Return value: non-0 on failure
+ */
+int
+rasqal_row_batch_set_size(rasqal_row_batch* batch, int size)
+{
+  rasqal_literal** nvalues;
+
+  rasqal_row_batch_clear(batch);
+
+  if(size <= batch->size && batch->values) {
+    batch->size = size;
+    return 0;
+  }
+
+  /* +1 so that a 0-column batch still has an allocated array */
+  nvalues = RASQAL_CALLOC(rasqal_literal**,
+                          RASQAL_GOOD_CAST(size_t, size + 1) * RASQAL_GOOD_CAST(size_t, batch->capacity),
+                          sizeof(rasqal_literal*));
+  if(!nvalues)
+    return 1;
+
+  if(batch->values)
+    RASQAL_FREE(rasqal_literal**, batch->values);
+  batch->values = nvalues;
+  batch->size = size;
+
+  return 0;
+}
+
+
+/**
+ * rasqal_row_batch_clear:
+ * @batch: row batch
+ *
+ * INTERNAL - Remove all rows from the batch and release their values
+ */
+void
+rasqal_row_batch_clear(rasqal_row_batch* batch)
+{
+  int column;
+
+  if(!batch->values)
+    return;
+
+  for(column = 0; column < batch->size; column++) {
+    rasqal_literal** column_values;
+    int i;
+
+    column_values = &RASQAL_ROW_BATCH_VALUE(batch, column, 0);
+    for(i = 0; i < batch->count; i++) {
+      if(column_values[i]) {
+        rasqal_free_literal(column_values[i]);
+        column_values[i] = NULL;
+      }
+    }
+  }
+
+  batch->count = 0;
+  batch->selected_count = 0;
+}
+
+
+/**
+ * rasqal_row_batch_add_empty_row:
+ * @batch: row batch
+ *
+ * INTERNAL - Add a row with no values set to the batch
+ *
+ * The new row is not selected; the caller sets values with
+ * RASQAL_ROW_BATCH_VALUE() and then updates the selection vector.
+ *
+ * Return value: index of new row or <0 if the batch is full
+ */
+int
+rasqal_row_batch_add_empty_row(rasqal_row_batch* batch)
+{
+  int row_i;
+
+  if(RASQAL_ROW_BATCH_IS_FULL(batch))
+    return -1;
+
+  row_i = batch->count++;
+  batch->offsets[row_i] = row_i;
+  batch->group_ids[row_i] = -1;
+
+  return row_i;
+}
+
+
+/**
+ * rasqal_row_batch_add_row:
+ * @batch: row batch
+ * @row: row to add
+ *
+ * INTERNAL - Add new references to the values of a row to the batch
+ *
+ * The row is not selected.  The @row remains owned by the caller.
+ *
+ * Return value: index of new row or <0 on failure
+ */
+int
+rasqal_row_batch_add_row(rasqal_row_batch* batch, rasqal_row* row)
+{
+  int row_i;
+  int column;
+  int size;
+
+  row_i = rasqal_row_batch_add_empty_row(batch);
+  if(row_i < 0)
+    return row_i;
+
+  size = (row->size < batch->size) ? row->size : batch->size;
+  for(column = 0; column < size; column++) {
+    rasqal_literal* l = row->values[column];
+
+    if(l)
+      RASQAL_ROW_BATCH_VALUE(batch, column, row_i) = rasqal_new_literal_from_literal(l);
+  }
+
+  batch->offsets[row_i] = row->offset;
+  batch->group_ids[row_i] = row->group_id;
+
+  return row_i;
+}
+
+
+/**
+ * rasqal_row_batch_get_row:
+ * @batch: row batch
+ * @row_i: index of row in batch
+ *
+ * INTERNAL - Create a new row from a row in the batch
+ *
+ * The row is associated with the rowsource that filled the batch.
+ *
+ * Return value: new row or NULL on failure
+ */
+rasqal_row*
+rasqal_row_batch_get_row(rasqal_row_batch* batch, int row_i)
+{
+  rasqal_row* row;
+  int column;
+
+  if(row_i < 0 || row_i >= batch->count)
+    return NULL;
+
+  row = rasqal_new_row_for_size(batch->world, batch->size);
+  if(!row)
+    return NULL;
+
+  if(batch->rowsource)
+    rasqal_row_set_rowsource(row, batch->rowsource);
+
+  for(column = 0; column < batch->size; column++) {
+    rasqal_literal* l = RASQAL_ROW_BATCH_VALUE(batch, column, row_i);
+
+    if(l)
+      row->values[column] = rasqal_new_literal_from_literal(l);
+  }
+
+  row->offset = batch->offsets[row_i];
+  row->group_id = batch->group_ids[row_i];
+
+  return row;
+}
+
+
+/**
+ * rasqal_row_batch_bind_variables:
+ * @batch: row batch
+ * @row_i: index of row in batch
+ *
+ * INTERNAL - Bind the rowsource variables with the values of a row in the batch
+ *
+ * Return value: non-0 on failure
+ */
+int
+rasqal_row_batch_bind_variables(rasqal_row_batch* batch, int row_i)
+{
+  int column;
+
+  for(column = 0; column < batch->size; column++) {
+    rasqal_variable* v;
+
+    v = rasqal_rowsource_get_variable_by_offset(batch->rowsource, column);
+    if(v) {
+      rasqal_literal *value = RASQAL_ROW_BATCH_VALUE(batch, column, row_i);
+      if(value) {
+        value = rasqal_new_literal_from_literal(value);
+        if(!value)
+          return 1;
+      }
+
+      /* it is OK to bind to NULL */
+      rasqal_variable_set_value(v, value);
+    }
+  }
+
+  return 0;
+}
+
+
+/**
+ * rasqal_row_batch_select_all:
+ * @batch: row batch
+ *
+ * INTERNAL - Set the selection vector to all the rows in the batch
+ */
+void
+rasqal_row_batch_select_all(rasqal_row_batch* batch)
+{
+  int i;
+
+  for(i = 0; i < batch->count; i++)
+    batch->selection[i] = i;
+
+  batch->selected_count = batch->count;
+}
+
+
+/*
+ * Comparison kernels over contiguous native arrays.  These are
+ * simple loops with no branches or calls so that the compiler can
+ * vectorize them.
+ */
+#define RASQAL_ROW_BATCH_COMPARE_KERNEL(values, count, op, value, matches) \
+  do {                                                                   \
+    int ki;                                                              \
+    switch(op) {                                                         \
+      case RASQAL_EXPR_EQ:                                               \
+        for(ki = 0; ki < (count); ki++)                                  \
+          (matches)[ki] &= (unsigned char)((values)[ki] == (value));     \
+        break;                                                           \
+      case RASQAL_EXPR_NEQ:                                              \
+        for(ki = 0; ki < (count); ki++)                                  \
+          (matches)[ki] &= (unsigned char)((values)[ki] != (value));     \
+        break;                                                           \
+      case RASQAL_EXPR_LT:                                               \
+        for(ki = 0; ki < (count); ki++)                                  \
+          (matches)[ki] &= (unsigned char)((values)[ki] < (value));      \
+        break;                                                           \
+      case RASQAL_EXPR_GT:                                               \
+        for(ki = 0; ki < (count); ki++)                                  \
+          (matches)[ki] &= (unsigned char)((values)[ki] > (value));      \
+        break;                                                           \
+      case RASQAL_EXPR_LE:                                               \
+        for(ki = 0; ki < (count); ki++)                                  \
+          (matches)[ki] &= (unsigned char)((values)[ki] <= (value));     \
+        break;                                                           \
+      case RASQAL_EXPR_GE:                                               \
+      default:                                                           \
+        for(ki = 0; ki < (count); ki++)                                  \
+          (matches)[ki] &= (unsigned char)((values)[ki] >= (value));     \
+        break;                                                           \
+    }                                                                    \
+  } while(0)
+
+
+/* integers a double holds exactly: magnitude up to 2^53 */
+#define RASQAL_ROW_BATCH_INTEGER_IS_EXACT_DOUBLE(i) \
+  ((i) >= -((rasqal_integer)1 << 53) && (i) <= ((rasqal_integer)1 << 53))
+
+
+/**
+ * rasqal_row_batch_select_numeric_compare:
+ * @batch: row batch
+ * @column: column to compare
+ * @op: comparison operator - one of RASQAL_EXPR_EQ, RASQAL_EXPR_NEQ, RASQAL_EXPR_LT, RASQAL_EXPR_GT, RASQAL_EXPR_LE or RASQAL_EXPR_GE
+ * @value: xsd:integer or xsd:double literal to compare against
+ *
+ * INTERNAL - Narrow the selection to rows where the column value @op @value is true
+ *
+ * The selected column values are gathered into a native array and
+ * compared in one pass.  Only xsd:integer (and derived types) and
+ * xsd:double column values are handled; integers are compared as
+ * integers when @value is also an integer.  When doubles are
+ * involved, the integers are compared as doubles so the column is
+ * left to the generic path if an integer is too large for a double
+ * to hold exactly.  Unbound values never match, as for a FILTER type
+ * error.
+ *
+ * Return value: 0 on success, >0 if the column has values of other types (selection unchanged) or <0 on failure
+ */
+int
+rasqal_row_batch_select_numeric_compare(rasqal_row_batch* batch, int column,
+                                        rasqal_op op, rasqal_literal* value)
+{
+  rasqal_literal** column_values;
+  int count = batch->selected_count;
+  int all_integers;
+  int inexact_integer;
+  int i;
+  int n;
+
+  if(column < 0 || column >= batch->size)
+    return 1;
+
+  switch(op) {
+    case RASQAL_EXPR_EQ:
+    case RASQAL_EXPR_NEQ:
+    case RASQAL_EXPR_LT:
+    case RASQAL_EXPR_GT:
+    case RASQAL_EXPR_LE:
+    case RASQAL_EXPR_GE:
+      break;
+
+    default:
+      return 1;
+  }
+
+  all_integers = (value->type == RASQAL_LITERAL_INTEGER ||
+                  value->type == RASQAL_LITERAL_INTEGER_SUBTYPE);
+  if(!all_integers && value->type != RASQAL_LITERAL_DOUBLE)
+    return 1;
+  inexact_integer = (all_integers &&
+                     !RASQAL_ROW_BATCH_INTEGER_IS_EXACT_DOUBLE(value->value.integer));
+
+  if(!batch->matches) {
+    size_t ncapacity = RASQAL_GOOD_CAST(size_t, batch->capacity);
+
+    batch->integers = RASQAL_CALLOC(rasqal_integer*, ncapacity,
+                                    sizeof(rasqal_integer));
+    batch->doubles = RASQAL_CALLOC(double*, ncapacity, sizeof(double));
+    batch->matches = RASQAL_CALLOC(unsigned char*, ncapacity, 1);
+    if(!batch->integers || !batch->doubles || !batch->matches) {
+      if(batch->integers)
+        RASQAL_FREE(rasqal_integer*, batch->integers);
+      if(batch->doubles)
+        RASQAL_FREE(double*, batch->doubles);
+      if(batch->matches)
+        RASQAL_FREE(unsigned char*, batch->matches);
+      batch->integers = NULL;
+      batch->doubles = NULL;
+      batch->matches = NULL;
+      return -1;
+    }
+  }
+
+  /* Gather the selected values into contiguous arrays */
+  column_values = &RASQAL_ROW_BATCH_VALUE(batch, column, 0);
+  for(i = 0; i < count; i++) {
+    rasqal_literal* l = column_values[batch->selection[i]];
+
+    if(!l) {
+      batch->integers[i] = 0;
+      batch->doubles[i] = 0.0;
+      batch->matches[i] = 0;
+      continue;
+    }
+
+    switch(l->type) {
+      case RASQAL_LITERAL_INTEGER:
+      case RASQAL_LITERAL_INTEGER_SUBTYPE:
+        batch->integers[i] = l->value.integer;
+        batch->doubles[i] = (double)l->value.integer;
+        if(!RASQAL_ROW_BATCH_INTEGER_IS_EXACT_DOUBLE(l->value.integer))
+          inexact_integer = 1;
+        break;
+
+      case RASQAL_LITERAL_DOUBLE:
+        all_integers = 0;
+        batch->doubles[i] = l->value.floating;
+        break;
+
+      case RASQAL_LITERAL_UNKNOWN:
+      case RASQAL_LITERAL_BLANK:
+      case RASQAL_LITERAL_URI:
+      case RASQAL_LITERAL_STRING:
+      case RASQAL_LITERAL_XSD_STRING:
+      case RASQAL_LITERAL_BOOLEAN:
+      case RASQAL_LITERAL_FLOAT:
+      case RASQAL_LITERAL_DECIMAL:
+      case RASQAL_LITERAL_DATE:
+      case RASQAL_LITERAL_DATETIME:
+      case RASQAL_LITERAL_UDT:
+      case RASQAL_LITERAL_PATTERN:
+      case RASQAL_LITERAL_QNAME:
+      case RASQAL_LITERAL_VARIABLE:
+      default:
+        /* Needs type promotion or is a type error: use generic path */
+        return 1;
+    }
+    batch->matches[i] = 1;
+  }
+
+  /* Comparing as doubles would merge integers that differ */
+  if(!all_integers && inexact_integer)
+    return 1;
+
+  if(all_integers) {
+    rasqal_integer lvalue = value->value.integer;
+    RASQAL_ROW_BATCH_COMPARE_KERNEL(batch->integers, count, op, lvalue,
+                                    batch->matches);
+  } else {
+    double dvalue;
+
+    if(value->type == RASQAL_LITERAL_DOUBLE)
+      dvalue = value->value.floating;
+    else
+      dvalue = (double)value->value.integer;
+    RASQAL_ROW_BATCH_COMPARE_KERNEL(batch->doubles, count, op, dvalue,
+                                    batch->matches);
+  }
+
+  /* Compact the selection vector */
+  for(i = 0, n = 0; i < count; i++) {
+    if(batch->matches[i])
+      batch->selection[n++] = batch->selection[i];
+  }
+  batch->selected_count = n;
+
+  return 0;
+}
+
+
+#endif /* not STANDALONE */
+
+
+
+#ifdef STANDALONE
+
+/* one more prototype */
+int main(int argc, char *argv[]);
+
+
+static const char* const batch_data_2x5_rows[] =
+{
+  /* 2 variable names and 5 rows */
+  "a",   NULL, "b",   NULL,
+  /* row 1 data */
+  "1",   NULL, "foo", NULL,
+  /* row 2 data */
+  "2",   NULL, "bar", NULL,
+  /* row 3 data */
+  "3",   NULL, "baz", NULL,
+  /* row 4 data */
+  "4",   NULL, "fez", NULL,
+  /* row 5 data */
+  "5",   NULL, "kit", NULL,
+  /* end of data */
+  NULL, NULL, NULL, NULL
+};
+
+#define BATCH_TEST_VARS_COUNT 2
+#define BATCH_TEST_ROWS_COUNT 5
+#define BATCH_TEST_CAPACITY 2
+
+
+/* 2^53 + 1: the smallest positive integer a double cannot hold */
+#define COMPARE_TEST_BIG ((((rasqal_integer)1) << 53) + 1)
+
+#define COMPARE_TESTS_COUNT 4
+#define COMPARE_TEST_ROWS 4
+
+static const struct {
+  /* column values: 'i' for xsd:integer, 'd' for xsd:double */
+  const char types[COMPARE_TEST_ROWS + 1];
+  rasqal_integer integers[COMPARE_TEST_ROWS];
+  double doubles[COMPARE_TEST_ROWS];
+  rasqal_op op;
+  /* value to compare against: 'i' or 'd' */
+  char value_type;
+  rasqal_integer value_integer;
+  double value_double;
+  /* expected return and selected rows as a bit per row */
+  int rc;
+  int selected;
+} compare_test_data[COMPARE_TESTS_COUNT] = {
+  /* integers beyond a double's precision compare exactly */
+  { "iiii", { 3, COMPARE_TEST_BIG, COMPARE_TEST_BIG - 1, 5 }, { 0.0 },
+    RASQAL_EXPR_EQ, 'i', COMPARE_TEST_BIG, 0.0, 0, 0x2 },
+  /* mixed integers and doubles */
+  { "idid", { 3, 0, 4, 0 }, { 0.0, 3.0, 0.0, 2.5 },
+    RASQAL_EXPR_GE, 'i', 3, 0.0, 0, 0x7 },
+  /* a large integer with doubles is left to the generic path */
+  { "iddd", { COMPARE_TEST_BIG, 0, 0, 0 }, { 0.0, 1.0, 2.0, 3.0 },
+    RASQAL_EXPR_EQ, 'i', COMPARE_TEST_BIG - 1, 0.0, 1, 0xf },
+  /* as is a large integer compared to a double */
+  { "iiii", { COMPARE_TEST_BIG, 1, 2, 3 }, { 0.0 },
+    RASQAL_EXPR_LT, 'd', 0, 1e300, 1, 0xf }
+};
+
+
+/*
+ * Run rasqal_row_batch_select_numeric_compare() over a batch of test
+ * column values and check the rows it selects
+ */
+static int
+numeric_compare_test(rasqal_world* world, rasqal_query* query,
+                     const char* program, int test_id)
+{
+  rasqal_variables_table* vt = query->vars_table;
+  rasqal_rowsource *rowsource = NULL;
+  rasqal_row_batch* batch = NULL;
+  raptor_sequence* row_seq = NULL;
+  raptor_sequence* vars_seq = NULL;
+  rasqal_variable* v;
+  rasqal_literal* value = NULL;
+  int failures = 0;
+  int selected = 0;
+  int rc;
+  int i;
+
+  row_seq = raptor_new_sequence((raptor_data_free_handler)rasqal_free_row,
+                                (raptor_data_print_handler)rasqal_row_print);
+  vars_seq = raptor_new_sequence((raptor_data_free_handler)rasqal_free_variable,
+                                 (raptor_data_print_handler)rasqal_variable_print);
+  v = rasqal_variables_table_add2(vt, RASQAL_VARIABLE_TYPE_NORMAL,
+                                  RASQAL_GOOD_CAST(const unsigned char*, "n"),
+                                  1, NULL);
+  if(!row_seq || !vars_seq || !v) {
+    failures++;
+    goto tidy;
+  }
+  raptor_sequence_push(vars_seq, v);
+
+  for(i = 0; i < COMPARE_TEST_ROWS; i++) {
+    rasqal_row* row = rasqal_new_row_for_size(world, 1);
+
+    if(!row) {
+      failures++;
+      goto tidy;
+    }
+    if(compare_test_data[test_id].types[i] == 'i')
+      row->values[0] = rasqal_new_integer_literal(world, RASQAL_LITERAL_INTEGER,
+                                                  compare_test_data[test_id].integers[i]);
+    else
+      row->values[0] = rasqal_new_double_literal(world,
+                                                 compare_test_data[test_id].doubles[i]);
+    raptor_sequence_push(row_seq, row);
+  }
+
+  rowsource = rasqal_new_rowsequence_rowsource(world, query, vt,
+                                               row_seq, vars_seq);
+  /* vars_seq and row_seq are now owned by rowsource */
+  vars_seq = row_seq = NULL;
+  batch = rasqal_new_row_batch(world, 0, COMPARE_TEST_ROWS);
+  if(!rowsource || !batch ||
+     rasqal_rowsource_read_batch(rowsource, batch) != COMPARE_TEST_ROWS) {
+    fprintf(stderr, "%s: compare test %d failed to read a batch\n",
+            program, test_id);
+    failures++;
+    goto tidy;
+  }
+
+  if(compare_test_data[test_id].value_type == 'i')
+    value = rasqal_new_integer_literal(world, RASQAL_LITERAL_INTEGER,
+                                       compare_test_data[test_id].value_integer);
+  else
+    value = rasqal_new_double_literal(world,
+                                      compare_test_data[test_id].value_double);
+  if(!value) {
+    failures++;
+    goto tidy;
+  }
+
+  rc = rasqal_row_batch_select_numeric_compare(batch, 0,
+                                               compare_test_data[test_id].op,
+                                               value);
+  for(i = 0; i < batch->selected_count; i++)
+    selected |= 1 << batch->selection[i];
+
+  if(rc != compare_test_data[test_id].rc ||
+     selected != compare_test_data[test_id].selected) {
+    fprintf(stderr,
+            "%s: compare test %d returned %d selecting rows 0x%x, expected %d selecting 0x%x\n",
+            program, test_id, rc, selected,
+            compare_test_data[test_id].rc,
+            compare_test_data[test_id].selected);
+    failures++;
+  }
+
+  tidy:
+  if(value)
+    rasqal_free_literal(value);
+  if(batch)
+    rasqal_free_row_batch(batch);
+  if(rowsource)
+    rasqal_free_rowsource(rowsource);
+  if(row_seq)
+    raptor_free_sequence(row_seq);
+  if(vars_seq)
+    raptor_free_sequence(vars_seq);
+
+  return failures;
+}
+
+
+int
+main(int argc, char *argv[])
+{
+  const char *program = rasqal_basename(argv[0]);
+  rasqal_world* world = NULL;
+  rasqal_query* query = NULL;
+  rasqal_rowsource *rowsource = NULL;
+  rasqal_row_batch* batch = NULL;
+  raptor_sequence* seq = NULL;
+  raptor_sequence* vars_seq = NULL;
+  rasqal_variables_table* vt;
+  int failures = 0;
+  int rows_count = 0;
+  int batches_count = 0;
+  int rc;
+  int test_id;
+
+  world = rasqal_new_world();
+  if(!world || rasqal_world_open(world)) {
+    fprintf(stderr, "%s: rasqal_world init failed\n", program);
+    return(1);
+  }
+
+  query = rasqal_new_query(world, "sparql", NULL);
+
+  vt = query->vars_table;
+
+  seq = rasqal_new_row_sequence(world, vt, batch_data_2x5_rows,
+                                BATCH_TEST_VARS_COUNT, &vars_seq);
+  if(!seq) {
+    fprintf(stderr, "%s: failed to create sequence of %d rows\n", program,
+            BATCH_TEST_ROWS_COUNT);
+    failures++;
+    goto tidy;
+  }
+
+  rowsource = rasqal_new_rowsequence_rowsource(world, query, vt, seq, vars_seq);
+  if(!rowsource) {
+    fprintf(stderr, "%s: failed to create rowsequence rowsource\n", program);
+    failures++;
+    goto tidy;
+  }
+  /* vars_seq and seq are now owned by rowsource */
+  vars_seq = seq = NULL;
+
+  batch = rasqal_new_row_batch(world, 0, BATCH_TEST_CAPACITY);
+  if(!batch) {
+    fprintf(stderr, "%s: failed to create row batch\n", program);
+    failures++;
+    goto tidy;
+  }
+
+  while((rc = rasqal_rowsource_read_batch(rowsource, batch)) > 0) {
+    int i;
+
+    batches_count++;
+    if(batch->size != BATCH_TEST_VARS_COUNT) {
+      fprintf(stderr, "%s: batch #%d has %d columns, expected %d\n",
+              program, batches_count, batch->size, BATCH_TEST_VARS_COUNT);
+      failures++;
+      goto tidy;
+    }
+
+    for(i = 0; i < batch->selected_count; i++) {
+      int row_i = batch->selection[i];
+      rasqal_literal* l = RASQAL_ROW_BATCH_VALUE(batch, 0, row_i);
+      rasqal_row* row;
+      int error = 0;
+      int value;
+
+      rows_count++;
+      value = rasqal_literal_as_integer(l, &error);
+      if(error || value != rows_count) {
+        fprintf(stderr, "%s: batch row #%d has value %d, expected %d\n",
+                program, rows_count, value, rows_count);
+        failures++;
+        goto tidy;
+      }
+
+      row = rasqal_row_batch_get_row(batch, row_i);
+      if(!row || row->size != BATCH_TEST_VARS_COUNT ||
+         rasqal_literal_as_integer(row->values[0], &error) != rows_count) {
+        fprintf(stderr, "%s: batch row #%d did not convert to a row\n",
+                program, rows_count);
+        failures++;
+        if(row)
+          rasqal_free_row(row);
+        goto tidy;
+      }
+      rasqal_free_row(row);
+    }
+  }
+
+  if(rc < 0) {
+    fprintf(stderr, "%s: rasqal_rowsource_read_batch() failed\n", program);
+    failures++;
+    goto tidy;
+  }
+
+  if(rows_count != BATCH_TEST_ROWS_COUNT) {
+    fprintf(stderr, "%s: read %d rows in batches, expected %d\n",
+            program, rows_count, BATCH_TEST_ROWS_COUNT);
+    failures++;
+    goto tidy;
+  }
+
+  if(batches_count != 3) {
+    fprintf(stderr, "%s: read %d batches, expected %d\n",
+            program, batches_count, 3);
+    failures++;
+    goto tidy;
+  }
+
+  for(test_id = 0; test_id < COMPARE_TESTS_COUNT; test_id++)
+    failures += numeric_compare_test(world, query, program, test_id);
+
+  tidy:
+  if(batch)
+    rasqal_free_row_batch(batch);
+  if(seq)
+    raptor_free_sequence(seq);
+  if(vars_seq)
+    raptor_free_sequence(vars_seq);
+  if(rowsource)
+    rasqal_free_rowsource(rowsource);
+  if(query)
+    rasqal_free_query(query);
+  if(world)
+    rasqal_free_world(world);
+
+  return failures;
+}
+
+#endif /* STANDALONE */
@@ -71,7 +71,7 @@ rasqal_new_rowsource_from_handler(rasqal_world* world,
   if(!world || !handler)
     return NULL;
 
-  if(handler->version < 1 || handler->version > 1)
+  if(handler->version < 1 || handler->version > 2)
     return NULL;
 
   rowsource = RASQAL_CALLOC(rasqal_rowsource*, 1, sizeof(*rowsource));
@@ -161,6 +161,9 @@ rasqal_free_rowsource(rasqal_rowsource *rowsource)
   if(rowsource->rows_sequence)
     raptor_free_sequence(rowsource->rows_sequence);
 
+  if(rowsource->batch)
+    rasqal_free_row_batch(rowsource->batch);
+
   RASQAL_FREE(rasqal_rowsource, rowsource);
 }
 
@@ -232,6 +235,41 @@ rasqal_rowsource_ensure_variables(rasqal_rowsource *rowsource)
 }
 
 
+/* Return the next row from a handler that only returns batches */
+static rasqal_row*
+rasqal_rowsource_read_row_from_batch(rasqal_rowsource *rowsource)
+{
+  rasqal_row_batch* batch = rowsource->batch;
+
+  if(!batch) {
+    batch = rasqal_new_row_batch(rowsource->world, rowsource->size, 0);
+    if(!batch)
+      return NULL;
+    rowsource->batch = batch;
+    rowsource->batch_offset = 0;
+  }
+
+  if(rowsource->batch_offset >= batch->selected_count) {
+    if(rasqal_row_batch_set_size(batch, rowsource->size))
+      return NULL;
+    batch->rowsource = rowsource;
+    rowsource->batch_offset = 0;
+
+    if(rowsource->handler->read_batch(rowsource, rowsource->user_data, batch)) {
+      rasqal_row_batch_clear(batch);
+      return NULL;
+    }
+    batch->rowsource = rowsource;
+
+    if(!batch->selected_count)
+      return NULL;
+  }
+
+  return rasqal_row_batch_get_row(batch,
+                                  batch->selection[rowsource->batch_offset++]);
+}
+
+
 /**
  * rasqal_rowsource_read_row:
  * @rowsource: rasqal rowsource
@@ -270,8 +308,12 @@ rasqal_rowsource_read_row(rasqal_rowsource *rowsource)
     if(rasqal_rowsource_ensure_variables(rowsource))
       return NULL;
 
-    if(rowsource->handler->read_row) {
-      row = rowsource->handler->read_row(rowsource, rowsource->user_data);
+    if(rowsource->handler->read_row ||
+       (rowsource->handler->version >= 2 && rowsource->handler->read_batch)) {
+      if(rowsource->handler->read_row)
+        row = rowsource->handler->read_row(rowsource, rowsource->user_data);
+      else
+        row = rasqal_rowsource_read_row_from_batch(rowsource);
       /* row is owned by us */
 
       if(row && rowsource->flags & RASQAL_ROWSOURCE_FLAGS_SAVE_ROWS) {
@@ -415,6 +457,44 @@ rasqal_rowsource_read_all_rows(rasqal_rowsource *rowsource)
   if(!seq)
     return NULL;
 
+  if(rowsource->handler->version >= 2 && rowsource->handler->read_batch &&
+     !(rowsource->flags & RASQAL_ROWSOURCE_FLAGS_SAVE_ROWS)) {
+    rasqal_row_batch* batch;
+    int rc;
+
+    /* Drain a batch at a time from handlers that support it */
+    batch = rasqal_new_row_batch(rowsource->world, rowsource->size, 0);
+    if(!batch) {
+      raptor_free_sequence(seq);
+      return NULL;
+    }
+
+    while((rc = rasqal_rowsource_read_batch(rowsource, batch)) > 0) {
+      int i;
+
+      for(i = 0; i < batch->selected_count; i++) {
+        rasqal_row* row;
+
+        row = rasqal_row_batch_get_row(batch, batch->selection[i]);
+        if(!row) {
+          rc = -1;
+          break;
+        }
+        raptor_sequence_push(seq, row);
+      }
+      if(rc < 0)
+        break;
+    }
+
+    rasqal_free_row_batch(batch);
+    if(rc < 0) {
+      raptor_free_sequence(seq);
+      return NULL;
+    }
+
+    goto done;
+  }
+
   while(1) {
     rasqal_row* row = rasqal_rowsource_read_row(rowsource);
     if(!row)
@@ -447,6 +527,96 @@ rasqal_rowsource_read_all_rows(rasqal_rowsource *rowsource)
 }
 
 
+/**
+ * rasqal_rowsource_read_batch:
+ * @rowsource: rasqal rowsource
+ * @batch: batch to fill
+ *
+ * INTERNAL - Read the next batch of rows from the rowsource
+ *
+ * Any existing rows in @batch are discarded and it is resized to the
+ * rowsource variables.  Handlers with a read_batch method fill the
+ * batch directly; otherwise it is filled one row at a time with
+ * rasqal_rowsource_read_row().  Rows in the batch are those in the
+ * selection vector.
+ *
+ * Return value: number of rows selected, 0 when no more rows are available or <0 on failure
+ **/
+int
+rasqal_rowsource_read_batch(rasqal_rowsource *rowsource,
+                            rasqal_row_batch* batch)
+{
+  int i;
+
+  if(!rowsource || !batch)
+    return -1;
+
+  rasqal_row_batch_clear(batch);
+
+  if(rowsource->finished)
+    return 0;
+
+  if(rasqal_rowsource_ensure_variables(rowsource))
+    return -1;
+
+  if(rasqal_row_batch_set_size(batch, rowsource->size))
+    return -1;
+
+  if(rowsource->handler->version >= 2 && rowsource->handler->read_batch &&
+     !(rowsource->flags & (RASQAL_ROWSOURCE_FLAGS_SAVE_ROWS |
+                           RASQAL_ROWSOURCE_FLAGS_SAVED_ROWS))) {
+    batch->rowsource = rowsource;
+    if(rowsource->handler->read_batch(rowsource, rowsource->user_data,
+                                      batch)) {
+      rasqal_row_batch_clear(batch);
+      return -1;
+    }
+    /* an inner rowsource may have refilled the batch */
+    batch->rowsource = rowsource;
+
+    if(!batch->selected_count) {
+      rowsource->finished = 1;
+      return 0;
+    }
+
+    rowsource->count += batch->selected_count;
+
+    /* Generate a group around all rows if there are no groups returned */
+    if(rowsource->generate_group) {
+      for(i = 0; i < batch->selected_count; i++) {
+        int row_i = batch->selection[i];
+        if(batch->group_ids[row_i] < 0)
+          batch->group_ids[row_i] = 0;
+      }
+    }
+
+    RASQAL_DEBUG4("%s rowsource %p returned a batch of %d rows\n",
+                  rowsource->handler->name, rowsource,
+                  batch->selected_count);
+    return batch->selected_count;
+  }
+
+  /* Adapt a row at a time handler */
+  batch->rowsource = rowsource;
+  while(!RASQAL_ROW_BATCH_IS_FULL(batch)) {
+    rasqal_row* row = rasqal_rowsource_read_row(rowsource);
+    if(!row)
+      break;
+
+    i = rasqal_row_batch_add_row(batch, row);
+    rasqal_free_row(row);
+    if(i < 0) {
+      rasqal_row_batch_clear(batch);
+      return -1;
+    }
+  }
+
+  rasqal_row_batch_select_all(batch);
+
+  return batch->selected_count;
+}
+
+
 /**
  * rasqal_rowsource_get_size:
  * @rowsource: rasqal rowsource
@@ -627,6 +797,11 @@ rasqal_rowsource_reset(rasqal_rowsource* rowsource)
   rowsource->finished = 0;
   rowsource->count = 0;
 
+  if(rowsource->batch) {
+    rasqal_row_batch_clear(rowsource->batch);
+    rowsource->batch_offset = 0;
+  }
+
   if(rowsource->handler->reset)
     return rowsource->handler->reset(rowsource, rowsource->user_data);
 
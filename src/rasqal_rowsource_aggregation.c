@@ -37,6 +37,7 @@
 #ifdef HAVE_STDLIB_H
 #include <stdlib.h>
 #endif
+#include <math.h>
 
 #include <raptor.h>
 
@@ -78,8 +79,19 @@ typedef struct
 
   /* map for distincting literal values */
   rasqal_map* map;
+
+  /* HyperLogLog registers estimating COUNT(DISTINCT) instead of @map
+   * when the query sets RASQAL_FEATURE_APPROX_COUNT_DISTINCT */
+  unsigned char* sketch;
+
+  /* log2 of the number of @sketch registers or 0 to count exactly */
+  int sketch_bits;
 } rasqal_agg_expr_data;
 
+
+#define RASQAL_AGG_SKETCH_MIN_BITS 4
+#define RASQAL_AGG_SKETCH_MAX_BITS 16
+
   
 /*
  * rasqal_aggregation_rowsource_context:
@@ -113,8 +125,14 @@ typedef struct
   /* last group ID seen */
   int last_group_id;
   
-  /* saved row between group boundaries */
-  rasqal_row* saved_row;
+  /* batch of input rows */
+  rasqal_row_batch* batch;
+
+  /* offset into selection of @batch for current input row */
+  int batch_index;
+
+  /* non-0 if current input row is saved between group boundaries */
+  int have_saved_row;
 
   /* output row offset */
   int offset;
@@ -150,7 +168,7 @@ typedef struct
   rasqal_literal* l;
 
   /* number of steps executed - used for AVG in calculating result */
-  int count;
+  rasqal_integer count;
 
   /* error happened */
   int error;
@@ -160,13 +178,28 @@ typedef struct
   
   /* string buffer for GROUP_CONCAT */
   raptor_stringbuffer *sb;
+
+  /* number of empty GROUP_CONCAT values seen while @sb was empty */
+  int sb_empty_count;
+
+  /* native running total for SUM and AVG while all values seen are
+   * xsd:integer (RASQAL_LITERAL_INTEGER), all are xsd:double
+   * (RASQAL_LITERAL_DOUBLE) or all are xsd:decimal
+   * (RASQAL_LITERAL_DECIMAL); RASQAL_LITERAL_UNKNOWN when @l holds
+   * the total */
+  rasqal_literal_type native_type;
+  rasqal_integer native_integer;
+  double native_double;
+  rasqal_xsd_decimal* native_decimal;
 } rasqal_builtin_agg_expression_execute;
 
 
-static void rasqal_builtin_agg_expression_execute_finish(void* user_data);  
+#define RASQAL_AGG_LITERAL_IS_INTEGER(l) \
+  ((l)->type == RASQAL_LITERAL_INTEGER || \
+   (l)->type == RASQAL_LITERAL_INTEGER_SUBTYPE)
 
 
-static void*
+void*
 rasqal_builtin_agg_expression_execute_init(rasqal_world *world,
                                            rasqal_expression* expr)
 {
@@ -181,6 +214,7 @@ rasqal_builtin_agg_expression_execute_init(rasqal_world *world,
   b->l = NULL;
   b->count = 0;
   b->error = 0;
+  b->native_type = RASQAL_LITERAL_UNKNOWN;
 
   if(expr->op == RASQAL_EXPR_GROUP_CONCAT) {
     b->sb = raptor_new_stringbuffer();
@@ -197,7 +231,7 @@ rasqal_builtin_agg_expression_execute_init(rasqal_world *world,
 }
 
 
-static void
+void
 rasqal_builtin_agg_expression_execute_finish(void* user_data)
 {
   rasqal_builtin_agg_expression_execute* b;
@@ -207,6 +241,9 @@ rasqal_builtin_agg_expression_execute_finish(void* user_data)
   if(b->l)
     rasqal_free_literal(b->l);
 
+  if(b->native_decimal)
+    rasqal_free_xsd_decimal(b->native_decimal);
+
   if(b->sb)
     raptor_free_stringbuffer(b->sb);
   
@@ -223,6 +260,13 @@ rasqal_builtin_agg_expression_execute_reset(void* user_data)
 
   b->count = 0;
   b->error = 0;
+  b->sb_empty_count = 0;
+  b->native_type = RASQAL_LITERAL_UNKNOWN;
+
+  if(b->native_decimal) {
+    rasqal_free_xsd_decimal(b->native_decimal);
+    b->native_decimal = NULL;
+  }
 
   if(b->l) {
     rasqal_free_literal(b->l);
@@ -240,7 +284,130 @@ rasqal_builtin_agg_expression_execute_reset(void* user_data)
 }
 
 
+/* Turn a native running total back into the literal @l */
+static int
+rasqal_builtin_agg_expression_execute_materialize(rasqal_builtin_agg_expression_execute* b)
+{
+  if(b->native_type == RASQAL_LITERAL_INTEGER)
+    b->l = rasqal_new_integer_literal(b->world, RASQAL_LITERAL_INTEGER,
+                                      b->native_integer);
+  else if(b->native_type == RASQAL_LITERAL_DOUBLE)
+    b->l = rasqal_new_numeric_literal(b->world, RASQAL_LITERAL_DOUBLE,
+                                      b->native_double);
+  else if(b->native_type == RASQAL_LITERAL_DECIMAL) {
+    /* literal takes ownership of the decimal */
+    b->l = rasqal_new_computed_decimal_literal(b->world, b->native_decimal);
+    b->native_decimal = NULL;
+  } else
+    return 0;
+
+  b->native_type = RASQAL_LITERAL_UNKNOWN;
+  if(!b->l)
+    b->error = 1;
+
+  return b->error;
+}
+
+
+/*
+ * Add @l to the running total without creating a literal when
+ * the values have the same native type.  An integer total that would
+ * overflow is left to rasqal_literal_add() to continue as a decimal.
+ *
+ * Return value: non-0 if the value was added
+ */
+static int
+rasqal_builtin_agg_expression_execute_native_add(rasqal_builtin_agg_expression_execute* b,
+                                                 rasqal_literal* l)
+{
+  if(b->native_type == RASQAL_LITERAL_INTEGER) {
+    if(!RASQAL_AGG_LITERAL_IS_INTEGER(l))
+      return 0;
+    return !rasqal_integer_add(b->native_integer, l->value.integer,
+                               &b->native_integer);
+  }
+
+  if(b->native_type == RASQAL_LITERAL_DOUBLE) {
+    if(l->type != RASQAL_LITERAL_DOUBLE)
+      return 0;
+    b->native_double = b->native_double + l->value.floating;
+    return 1;
+  }
+
+  if(b->native_type == RASQAL_LITERAL_DECIMAL) {
+    if(l->type != RASQAL_LITERAL_DECIMAL)
+      return 0;
+    return !rasqal_xsd_decimal_add(b->native_decimal, b->native_decimal,
+                                   l->value.decimal);
+  }
+
+  /* Start a native total from the first two values */
+  if(!b->l)
+    return 0;
+
+  if(RASQAL_AGG_LITERAL_IS_INTEGER(b->l) && RASQAL_AGG_LITERAL_IS_INTEGER(l)) {
+    if(rasqal_integer_add(b->l->value.integer, l->value.integer,
+                          &b->native_integer))
+      return 0;
+    b->native_type = RASQAL_LITERAL_INTEGER;
+  } else if(b->l->type == RASQAL_LITERAL_DOUBLE &&
+            l->type == RASQAL_LITERAL_DOUBLE) {
+    b->native_type = RASQAL_LITERAL_DOUBLE;
+    b->native_double = b->l->value.floating + l->value.floating;
+  } else if(b->l->type == RASQAL_LITERAL_DECIMAL &&
+            l->type == RASQAL_LITERAL_DECIMAL) {
+    b->native_decimal = rasqal_new_xsd_decimal(b->world);
+    if(!b->native_decimal)
+      return 0;
+
+    if(rasqal_xsd_decimal_add(b->native_decimal, b->l->value.decimal,
+                              l->value.decimal)) {
+      rasqal_free_xsd_decimal(b->native_decimal);
+      b->native_decimal = NULL;
+      return 0;
+    }
+    b->native_type = RASQAL_LITERAL_DECIMAL;
+  } else
+    return 0;
+
+  rasqal_free_literal(b->l);
+  b->l = NULL;
+
+  return 1;
+}
+
+
+/*
+ * Compare two values for MIN and MAX natively if they have the same
+ * native type.
+ *
+ * Return value: non-0 if *@cmp_p was set
+ */
 static int
+rasqal_builtin_agg_expression_execute_native_compare(rasqal_literal* l1,
+                                                     rasqal_literal* l2,
+                                                     int* cmp_p)
+{
+  if(RASQAL_AGG_LITERAL_IS_INTEGER(l1) && RASQAL_AGG_LITERAL_IS_INTEGER(l2)) {
+    *cmp_p = (l1->value.integer > l2->value.integer) -
+             (l1->value.integer < l2->value.integer);
+    return 1;
+  }
+
+  if(l1->type == RASQAL_LITERAL_DOUBLE && l2->type == RASQAL_LITERAL_DOUBLE &&
+     l1->value.floating == l1->value.floating &&
+     l2->value.floating == l2->value.floating) {
+    /* neither is NaN */
+    *cmp_p = (l1->value.floating > l2->value.floating) -
+             (l1->value.floating < l2->value.floating);
+    return 1;
+  }
+
+  return 0;
+}
+
+
+int
 rasqal_builtin_agg_expression_execute_step(void* user_data,
                                            raptor_sequence* literals)
 {
@@ -288,6 +455,8 @@ rasqal_builtin_agg_expression_execute_step(void* user_data,
       if(!error) {
         if(raptor_stringbuffer_length(b->sb))
           raptor_stringbuffer_append_counted_string(b->sb, b->separator, 1, 1);
+        else if(!*str)
+          b->sb_empty_count++;
 
         raptor_stringbuffer_append_string(b->sb, str, 1); 
       }
@@ -295,6 +464,25 @@ rasqal_builtin_agg_expression_execute_step(void* user_data,
     }
   
     
+    if(b->expr->op == RASQAL_EXPR_SUM || b->expr->op == RASQAL_EXPR_AVG) {
+      if(rasqal_builtin_agg_expression_execute_native_add(b, l))
+        continue;
+      if(rasqal_builtin_agg_expression_execute_materialize(b))
+        break;
+    } else if(b->l && (b->expr->op == RASQAL_EXPR_MIN ||
+                       b->expr->op == RASQAL_EXPR_MAX)) {
+      int cmp;
+
+      if(rasqal_builtin_agg_expression_execute_native_compare(b->l, l, &cmp)) {
+        if((b->expr->op == RASQAL_EXPR_MIN && cmp > 0) ||
+           (b->expr->op == RASQAL_EXPR_MAX && cmp < 0)) {
+          rasqal_free_literal(b->l);
+          b->l = rasqal_new_literal_from_literal(l);
+        }
+        continue;
+      }
+    }
+
     if(!b->l)
       result = rasqal_new_literal_from_literal(l);
     else {
@@ -336,7 +524,131 @@ rasqal_builtin_agg_expression_execute_step(void* user_data,
 }
 
 
-static rasqal_literal*
+/*
+ * Merge the partial state @other_user_data into @user_data and reset
+ * @other_user_data.
+ *
+ * This combines the states of input partitions aggregated separately.
+ * The aggregation rowsource reads a single partition and steps every
+ * row of a group into one state so it does not merge.
+ *
+ * @other_user_data must have been stepped over the input rows that
+ * follow the ones stepped over by @user_data so that SAMPLE keeps the
+ * first value and GROUP_CONCAT keeps the input order.  The result is
+ * the same as if all rows had been stepped over by @user_data.
+ *
+ * Return value: non-0 on failure
+ */
+int
+rasqal_builtin_agg_expression_execute_merge(void* user_data,
+                                            void* other_user_data)
+{
+  rasqal_builtin_agg_expression_execute* b;
+  rasqal_builtin_agg_expression_execute* o;
+  rasqal_literal* result = NULL;
+  int cmp;
+
+  b = (rasqal_builtin_agg_expression_execute*)user_data;
+  o = (rasqal_builtin_agg_expression_execute*)other_user_data;
+
+  if(o->error)
+    b->error = 1;
+
+  if(b->error || !o->count)
+    goto tidy;
+
+  b->count += o->count;
+
+  if(b->expr->op == RASQAL_EXPR_COUNT)
+    goto tidy;
+
+  if(b->expr->op == RASQAL_EXPR_GROUP_CONCAT) {
+    if(raptor_stringbuffer_length(b->sb)) {
+      int i;
+
+      /* add the separators the steps would have added before each
+       * of the values in @o */
+      i = o->sb_empty_count + (raptor_stringbuffer_length(o->sb) ? 1 : 0);
+      while(i--)
+        raptor_stringbuffer_append_counted_string(b->sb, b->separator, 1, 1);
+    } else
+      b->sb_empty_count += o->sb_empty_count;
+
+    if(raptor_stringbuffer_append_stringbuffer(b->sb, o->sb))
+      b->error = 1;
+    goto tidy;
+  }
+
+  if(b->expr->op == RASQAL_EXPR_SUM || b->expr->op == RASQAL_EXPR_AVG) {
+    if(b->native_type != RASQAL_LITERAL_UNKNOWN &&
+       b->native_type == o->native_type) {
+      if(b->native_type == RASQAL_LITERAL_INTEGER) {
+        if(!rasqal_integer_add(b->native_integer, o->native_integer,
+                               &b->native_integer))
+          goto tidy;
+      } else if(b->native_type == RASQAL_LITERAL_DOUBLE) {
+        b->native_double = b->native_double + o->native_double;
+        goto tidy;
+      } else if(b->native_type == RASQAL_LITERAL_DECIMAL) {
+        if(rasqal_xsd_decimal_add(b->native_decimal, b->native_decimal,
+                                  o->native_decimal))
+          b->error = 1;
+        goto tidy;
+      }
+    }
+
+    /* Otherwise add the totals as literals */
+    if(rasqal_builtin_agg_expression_execute_materialize(b) ||
+       rasqal_builtin_agg_expression_execute_materialize(o)) {
+      b->error = 1;
+      goto tidy;
+    }
+  }
+
+  if(!o->l)
+    goto tidy;
+
+  if(!b->l) {
+    /* first value seen; this is also the SAMPLE */
+    b->l = o->l;
+    o->l = NULL;
+    goto tidy;
+  }
+
+  if(b->expr->op == RASQAL_EXPR_SUM || b->expr->op == RASQAL_EXPR_AVG) {
+    result = rasqal_literal_add(b->l, o->l, &b->error);
+  } else if(b->expr->op == RASQAL_EXPR_MIN ||
+            b->expr->op == RASQAL_EXPR_MAX) {
+    if(!rasqal_builtin_agg_expression_execute_native_compare(b->l, o->l, &cmp))
+      cmp = rasqal_literal_compare(b->l, o->l, 0, &b->error);
+
+    if((b->expr->op == RASQAL_EXPR_MIN && cmp > 0) ||
+       (b->expr->op == RASQAL_EXPR_MAX && cmp < 0)) {
+      result = o->l;
+      o->l = NULL;
+    } else {
+      result = b->l;
+      b->l = NULL;
+    }
+  } else
+    /* SAMPLE keeps the first value */
+    goto tidy;
+
+  if(b->l)
+    rasqal_free_literal(b->l);
+  b->l = result;
+  if(!result)
+    b->error = 1;
+
+  tidy:
+  if(rasqal_builtin_agg_expression_execute_reset(o))
+    b->error = 1;
+
+  return b->error;
+}
+
+
+rasqal_literal*
 rasqal_builtin_agg_expression_execute_result(void* user_data)
 {
   rasqal_builtin_agg_expression_execute* b;
@@ -346,6 +658,9 @@ rasqal_builtin_agg_expression_execute_result(void* user_data)
   if(b->error)
     return NULL;
 
+  if(rasqal_builtin_agg_expression_execute_materialize(b))
+    return NULL;
+
   if(b->expr->op == RASQAL_EXPR_COUNT) {
     rasqal_literal* result;
 
@@ -407,6 +722,112 @@ rasqal_builtin_agg_expression_execute_result(void* user_data)
 
 
 
+/* Hash a sequence of literals for a COUNT(DISTINCT) sketch */
+static unsigned int
+rasqal_agg_sketch_hash(raptor_sequence* seq)
+{
+  rasqal_literal* l;
+  unsigned int hash = 2166136261U;
+  int i;
+
+  for(i = 0; (l = (rasqal_literal*)raptor_sequence_get_at(seq, i)); i++) {
+    const unsigned char* p = NULL;
+    unsigned int h;
+
+    if(rasqal_literal_hash(l, &h)) {
+      int error = 0;
+
+      /* other types by their lexical form */
+      h = (2166136261U ^ RASQAL_GOOD_CAST(unsigned int, l->type)) * 16777619U;
+      p = RASQAL_GOOD_CAST(const unsigned char*,
+                           rasqal_literal_as_string_flags(l, 0, &error));
+      while(p && *p) {
+        h ^= *p++;
+        h *= 16777619U;
+      }
+    }
+
+    /* rasqal_literal_hash() ignores the language and datatype */
+    if(l->language)
+      p = RASQAL_GOOD_CAST(const unsigned char*, l->language);
+    else if(l->type == RASQAL_LITERAL_UDT && l->datatype)
+      p = raptor_uri_as_string(l->datatype);
+    else
+      p = NULL;
+    while(p && *p) {
+      h ^= *p++;
+      h *= 16777619U;
+    }
+
+    hash = (hash ^ h) * 16777619U;
+  }
+
+  /* mix all bits into the top ones used for the register index */
+  hash ^= hash >> 16;
+  hash *= 0x85ebca6bU;
+  hash ^= hash >> 13;
+  hash *= 0xc2b2ae35U;
+  hash ^= hash >> 16;
+
+  return hash;
+}
+
+
+static void
+rasqal_agg_sketch_add(unsigned char* sketch, int bits, unsigned int hash)
+{
+  unsigned int index = hash >> (32 - bits);
+  unsigned int w = hash << bits;
+  unsigned char rank = 1;
+
+  /* position of the first 1 bit after the index bits */
+  while(!(w & 0x80000000U) && rank <= 32 - bits) {
+    rank++;
+    w <<= 1;
+  }
+
+  if(rank > sketch[index])
+    sketch[index] = rank;
+}
+
+
+/* HyperLogLog estimate with the small and large range corrections */
+static rasqal_integer
+rasqal_agg_sketch_estimate(unsigned char* sketch, int bits)
+{
+  int m = 1 << bits;
+  double sum = 0.0;
+  double alpha;
+  double estimate;
+  int zeros = 0;
+  int i;
+
+  for(i = 0; i < m; i++) {
+    sum += ldexp(1.0, -sketch[i]);
+    if(!sketch[i])
+      zeros++;
+  }
+
+  if(bits == 4)
+    alpha = 0.673;
+  else if(bits == 5)
+    alpha = 0.697;
+  else if(bits == 6)
+    alpha = 0.709;
+  else
+    alpha = 0.7213 / (1.0 + 1.079 / m);
+
+  estimate = alpha * m * m / sum;
+  if(estimate <= 2.5 * m) {
+    if(zeros)
+      estimate = m * log(RASQAL_GOOD_CAST(double, m) / zeros);
+  } else if(estimate > 4294967296.0 / 30.0 && estimate < 4294967296.0)
+    estimate = -4294967296.0 * log(1.0 - estimate / 4294967296.0);
+
+  return RASQAL_GOOD_CAST(rasqal_integer, estimate + 0.5);
+}
+
+
 static int
 rasqal_aggregation_rowsource_init(rasqal_rowsource* rowsource, void *user_data)
 {
@@ -421,6 +842,12 @@ rasqal_aggregation_rowsource_init(rasqal_rowsource* rowsource, void *user_data)
   con->last_group_id = -1;
   con->offset = 0;
   con->step_count = 0;
+
+  con->batch = rasqal_new_row_batch(rowsource->world, 0, 0);
+  if(!con->batch)
+    return 1;
+  con->batch_index = 0;
+  con->have_saved_row = 0;
   
   if(rasqal_rowsource_request_grouping(con->rowsource))
     return 1;
@@ -454,6 +881,9 @@ rasqal_aggregation_rowsource_finish(rasqal_rowsource* rowsource,
 
       if(expr_data->map)
         rasqal_free_map(expr_data->map);
+
+      if(expr_data->sketch)
+        RASQAL_FREE(char*, expr_data->sketch);
     }
 
     RASQAL_FREE(rasqal_agg_expr_data, con->expr_data);
@@ -468,8 +898,8 @@ rasqal_aggregation_rowsource_finish(rasqal_rowsource* rowsource,
   if(con->rowsource)
     rasqal_free_rowsource(con->rowsource);
   
-  if(con->saved_row)
-    rasqal_free_row(con->saved_row);
+  if(con->batch)
+    rasqal_free_row_batch(con->batch);
 
   if(con->input_values)
     raptor_free_sequence(con->input_values);
@@ -517,7 +947,7 @@ rasqal_aggregation_rowsource_read_row(rasqal_rowsource* rowsource,
                                       void *user_data)
 {
   rasqal_aggregation_rowsource_context* con;
-  rasqal_row* row;
+  rasqal_row* row = NULL;
   int error = 0;
   
   con = (rasqal_aggregation_rowsource_context*)user_data;
@@ -528,30 +958,34 @@ rasqal_aggregation_rowsource_read_row(rasqal_rowsource* rowsource,
 
   /* Iterate over input rows until last row seen or group done */
   while(1) {
+    int row_i;
+    int group_id;
+
     error = 0;
     
-    if(con->saved_row)
-      row = con->saved_row;
-    else
-      row = rasqal_rowsource_read_row(con->rowsource);
-
-    if(!row) {
-      /* End of input - calculate last aggregation result */
-      con->finished = 1;
-      break;
+    if(!con->have_saved_row &&
+       con->batch_index >= con->batch->selected_count) {
+      /* Read input rows a batch at a time */
+      con->batch_index = 0;
+      if(rasqal_rowsource_read_batch(con->rowsource, con->batch) <= 0) {
+        /* End of input - calculate last aggregation result */
+        con->finished = 1;
+        break;
+      }
     }
 
+    row_i = con->batch->selection[con->batch_index];
+    group_id = con->batch->group_ids[row_i];
 
-    if(con->last_group_id != row->group_id) {
+    if(con->last_group_id != group_id) {
       int i;
       
-      if(!con->saved_row && con->last_group_id >= 0) {
+      if(!con->have_saved_row && con->last_group_id >= 0) {
         /* Existing aggregation is done - return result */
 
         /* save current row for next time this function is called */
-        con->saved_row = row;
+        con->have_saved_row = 1;
 
-        row = NULL;
 #ifdef RASQAL_DEBUG
         RASQAL_DEBUG2("Aggregation ending group %d", con->last_group_id);
         fputc('\n', DEBUG_FH);
@@ -570,11 +1004,10 @@ rasqal_aggregation_rowsource_read_row(rasqal_rowsource* rowsource,
         break;
       }
 
-      /* reference is now in 'row' variable */
-      con->saved_row = NULL;
+      con->have_saved_row = 0;
       
 #ifdef RASQAL_DEBUG
-      RASQAL_DEBUG2("Aggregation starting group %d", row->group_id);
+      RASQAL_DEBUG2("Aggregation starting group %d", group_id);
       fputc('\n', DEBUG_FH);
 #endif
 
@@ -595,8 +1028,19 @@ rasqal_aggregation_rowsource_read_row(rasqal_rowsource* rowsource,
           }
         }
 
-        /* Init map for each group */
-        if(expr_data->expr->flags & RASQAL_EXPR_FLAG_DISTINCT) {
+        /* Init sketch or map for each group */
+        if(expr_data->sketch_bits) {
+          size_t size = RASQAL_GOOD_CAST(size_t, 1 << expr_data->sketch_bits);
+
+          if(!expr_data->sketch) {
+            expr_data->sketch = RASQAL_MALLOC(unsigned char*, size);
+            if(!expr_data->sketch) {
+              error = 1;
+              break;
+            }
+          }
+          memset(expr_data->sketch, '\0', size);
+        } else if(expr_data->expr->flags & RASQAL_EXPR_FLAG_DISTINCT) {
           expr_data->map = rasqal_new_literal_sequence_sort_map(1 /* is_distinct */,
                                                                 0 /* compare_flags */);
           if(!expr_data->map) {
@@ -609,12 +1053,12 @@ rasqal_aggregation_rowsource_read_row(rasqal_rowsource* rowsource,
       if(error)
         break;
 
-      con->last_group_id = row->group_id;
+      con->last_group_id = group_id;
     } /* end if handling change of group ID */
   
 
     /* Bind the values in the input row to the variables in the table */
-    rasqal_row_bind_variables(row, rowsource->query->vars_table);
+    rasqal_row_batch_bind_variables(con->batch, row_i);
 
     /* Evaluate the expressions giving a sequence of literals to 
      * run the aggregation step over.
@@ -627,7 +1071,7 @@ rasqal_aggregation_rowsource_read_row(rasqal_rowsource* rowsource,
         for(i = 0; i < con->input_values_count; i++) {
           rasqal_literal* value;
           
-          value = rasqal_new_literal_from_literal(row->values[i]);
+          value = rasqal_new_literal_from_literal(RASQAL_ROW_BATCH_VALUE(con->batch, i, row_i));
           raptor_sequence_set_at(con->input_values, i, value);
         }
       }
@@ -648,6 +1092,14 @@ rasqal_aggregation_rowsource_read_row(rasqal_rowsource* rowsource,
         if(error)
           continue;
 
+        if(expr_data->sketch) {
+          if(raptor_sequence_size(seq) > 0)
+            rasqal_agg_sketch_add(expr_data->sketch, expr_data->sketch_bits,
+                                  rasqal_agg_sketch_hash(seq));
+          raptor_free_sequence(seq);
+          continue;
+        }
+
         if(expr_data->map) {
           if(rasqal_literal_sequence_sort_map_add_literal_sequence(expr_data->map, 
                                                                    seq)) {
@@ -680,7 +1132,8 @@ rasqal_aggregation_rowsource_read_row(rasqal_rowsource* rowsource,
       }
     }
 
-    rasqal_free_row(row); row = NULL;
+    /* input row is done */
+    con->batch_index++;
     
     if(error)
       break;
@@ -689,11 +1142,8 @@ rasqal_aggregation_rowsource_read_row(rasqal_rowsource* rowsource,
   
 
   if(error) {
-    /* Discard row on error */
-    if(row) {
-      rasqal_free_row(row);
-      row = NULL;
-    }
+    /* Return no row on error */
+    row = NULL;
   } else if (con->last_group_id >= 0) {
     int offset = 0;
     int i;
@@ -722,7 +1172,18 @@ rasqal_aggregation_rowsource_read_row(rasqal_rowsource* rowsource,
       rasqal_variable* v;
       
       /* Calculate the result because the input ended or a new group started */
-      result = rasqal_builtin_agg_expression_execute_result(expr_data->agg_user_data);
+      if(expr_data->sketch)
+        result = rasqal_new_integer_literal(rowsource->world,
+                                            RASQAL_LITERAL_INTEGER,
+                                            rasqal_agg_sketch_estimate(expr_data->sketch,
+                                                                       expr_data->sketch_bits));
+      else
+        result = rasqal_builtin_agg_expression_execute_result(expr_data->agg_user_data);
+      /* results leave the aggregation with a lexical form */
+      if(result && rasqal_literal_ensure_string(result)) {
+        rasqal_free_literal(result);
+        result = NULL;
+      }
   
 #ifdef RASQAL_DEBUG
       RASQAL_DEBUG2("Aggregation %d ending group with result: ", i);
@@ -872,6 +1333,20 @@ rasqal_new_aggregation_rowsource(rasqal_world *world, rasqal_query* query,
     expr_data->expr = rasqal_new_expression_from_expression(expr);
     expr_data->variable = variable;
 
+    /* COUNT(DISTINCT expr) may be estimated if the query asks */
+    if(expr->op == RASQAL_EXPR_COUNT &&
+       (expr->flags & RASQAL_EXPR_FLAG_DISTINCT) &&
+       expr->arg1 && expr->arg1->op != RASQAL_EXPR_VARSTAR &&
+       query->features[RASQAL_FEATURE_APPROX_COUNT_DISTINCT] > 0) {
+      int bits = query->features[RASQAL_FEATURE_APPROX_COUNT_DISTINCT];
+
+      if(bits < RASQAL_AGG_SKETCH_MIN_BITS)
+        bits = RASQAL_AGG_SKETCH_MIN_BITS;
+      else if(bits > RASQAL_AGG_SKETCH_MAX_BITS)
+        bits = RASQAL_AGG_SKETCH_MAX_BITS;
+      expr_data->sketch_bits = bits;
+    }
+
     /* Prepare expression arguments sequence in per-expr data */
     if(expr->args) {
       /* list of #rasqal_expression arguments already in expr
@@ -909,6 +1384,176 @@ rasqal_new_aggregation_rowsource(rasqal_world *world, rasqal_query* query,
   return NULL;
 }
 
+
+
+/*
+ * rasqal_count_rowsource_context:
+ *
+ * INTERNAL - Count aggregation rowsource context
+ *
+ * Structure for returning a COUNT already known from the triples
+ * source created by rasqal_new_count_aggregation_rowsource().
+ */
+typedef struct 
+{
+  /* output variable to bind */
+  rasqal_variable* variable;
+
+  /* count to return */
+  rasqal_integer count;
+
+  /* non-0 when the row has been returned */
+  int finished;
+} rasqal_count_rowsource_context;
+
+
+static int
+rasqal_count_rowsource_init(rasqal_rowsource* rowsource, void *user_data)
+{
+  return 0;
+}
+
+
+static int
+rasqal_count_rowsource_finish(rasqal_rowsource* rowsource, void *user_data)
+{
+  rasqal_count_rowsource_context* con;
+
+  con = (rasqal_count_rowsource_context*)user_data;
+
+  if(con->variable)
+    rasqal_free_variable(con->variable);
+
+  RASQAL_FREE(rasqal_count_rowsource_context, con);
+
+  return 0;
+}
+
+
+static int
+rasqal_count_rowsource_ensure_variables(rasqal_rowsource* rowsource,
+                                        void *user_data)
+{
+  rasqal_count_rowsource_context* con;
+
+  con = (rasqal_count_rowsource_context*)user_data;
+
+  rowsource->size = 0;
+
+  if(rasqal_rowsource_add_variable(rowsource, con->variable) < 0)
+    return 1;
+
+  return 0;
+}
+
+
+static rasqal_row*
+rasqal_count_rowsource_read_row(rasqal_rowsource* rowsource, void *user_data)
+{
+  rasqal_count_rowsource_context* con;
+  rasqal_literal* result;
+  rasqal_row* row;
+
+  con = (rasqal_count_rowsource_context*)user_data;
+
+  if(con->finished)
+    return NULL;
+
+  con->finished = 1;
+
+  row = rasqal_new_row(rowsource);
+  if(!row)
+    return NULL;
+
+  result = rasqal_new_integer_literal(rowsource->world, RASQAL_LITERAL_INTEGER,
+                                      con->count);
+  /* results leave the aggregation with a lexical form */
+  if(!result || rasqal_literal_ensure_string(result)) {
+    if(result)
+      rasqal_free_literal(result);
+    rasqal_free_row(row);
+    return NULL;
+  }
+
+  rasqal_variable_set_value(con->variable, rasqal_new_literal_from_literal(result));
+  rasqal_row_set_value_at(row, 0, result);
+  rasqal_free_literal(result);
+
+  row->offset = 0;
+
+  return row;
+}
+
+
+static int
+rasqal_count_rowsource_reset(rasqal_rowsource* rowsource, void *user_data)
+{
+  rasqal_count_rowsource_context* con;
+
+  con = (rasqal_count_rowsource_context*)user_data;
+
+  con->finished = 0;
+
+  return 0;
+}
+
+
+static const rasqal_rowsource_handler rasqal_count_rowsource_handler = {
+  /* .version = */ 1,
+  "count aggregation",
+  /* .init = */ rasqal_count_rowsource_init,
+  /* .finish = */ rasqal_count_rowsource_finish,
+  /* .ensure_variables = */ rasqal_count_rowsource_ensure_variables,
+  /* .read_row = */ rasqal_count_rowsource_read_row,
+  /* .read_all_rows = */ NULL,
+  /* .reset = */ rasqal_count_rowsource_reset,
+  /* .set_requirements = */ NULL,
+  /* .get_inner_rowsource = */ NULL,
+  /* .set_origin = */ NULL,
+};
+
+
+/**
+ * rasqal_new_count_aggregation_rowsource:
+ * @world: world
+ * @query: query
+ * @count: count
+ * @variable: variable to bind the count to
+ *
+ * INTERNAL - Create a new rowsource returning a known COUNT aggregate
+ *
+ * This replaces rasqal_new_aggregation_rowsource() for a single
+ * COUNT over rows whose number was found without reading them, such
+ * as from rasqal_triples_source_triples_count().  It returns one row
+ * binding @variable to @count in the same way.
+ *
+ * Return value: new rowsource or NULL on failure
+*/
+rasqal_rowsource*
+rasqal_new_count_aggregation_rowsource(rasqal_world *world,
+                                       rasqal_query* query,
+                                       rasqal_integer count,
+                                       rasqal_variable* variable)
+{
+  rasqal_count_rowsource_context* con;
+
+  if(!world || !query || !variable)
+    return NULL;
+
+  con = RASQAL_CALLOC(rasqal_count_rowsource_context*, 1, sizeof(*con));
+  if(!con)
+    return NULL;
+
+  con->variable = rasqal_new_variable_from_variable(variable);
+  con->count = count;
+
+  return rasqal_new_rowsource_from_handler(world, query,
+                                           con,
+                                           &rasqal_count_rowsource_handler,
+                                           query->vars_table,
+                                           /* flags */ 0);
+}
+
 #endif /* not STANDALONE */
 
 
@@ -1070,6 +1715,370 @@ make_test_expr(rasqal_world* world,
 }
 
 
+#define APPROX_TESTS_COUNT 5
+
+/* RASQAL_AGG_SKETCH_MAX_BITS */
+#define APPROX_MAX_BITS 16
+
+static const struct {
+  int distinct; /* distinct values of ?v */
+  int repeats; /* rows with each value */
+  int bits; /* approxCountDistinct feature value */
+} approx_test_data[APPROX_TESTS_COUNT] = {
+  /* exact count */
+  {     5, 3,  0 },
+  /* small range correction */
+  {     5, 3,  4 },
+  {  1000, 2, 10 },
+  { 20000, 1, 14 },
+  /* clamped to the maximum sketch size */
+  {  3000, 1, 20 }
+};
+
+
+/*
+ * Execute the aggregation part of SELECT (COUNT(DISTINCT ?v) AS ?fake)
+ * with the approxCountDistinct feature set and check the estimate is
+ * within 3 standard errors (1.04/sqrt(registers)) of the distinct count.
+ */
+static int
+approx_count_distinct_test(rasqal_world* world, rasqal_query* query,
+                           const char* program, int test_id)
+{
+  rasqal_variables_table* vt = query->vars_table;
+  int distinct = approx_test_data[test_id].distinct;
+  int repeats = approx_test_data[test_id].repeats;
+  int bits = approx_test_data[test_id].bits;
+  rasqal_rowsource *rowsource = NULL;
+  raptor_sequence* row_seq = NULL;
+  raptor_sequence* vars_seq = NULL;
+  raptor_sequence* exprs_seq = NULL;
+  raptor_sequence* seq = NULL;
+  rasqal_variable* v = NULL;
+  rasqal_variable* output_var = NULL;
+  rasqal_expression* expr = NULL;
+  rasqal_literal* l;
+  rasqal_row* row;
+  double tolerance = 0.0;
+  double estimate;
+  int failures = 0;
+  int i;
+
+  if(bits) {
+    int m = 1 << (bits > APPROX_MAX_BITS ? APPROX_MAX_BITS : bits);
+    tolerance = 3.0 * 1.04 / sqrt(RASQAL_GOOD_CAST(double, m)) * distinct;
+  }
+
+  rasqal_query_set_feature(query, RASQAL_FEATURE_APPROX_COUNT_DISTINCT, bits);
+
+  row_seq = raptor_new_sequence((raptor_data_free_handler)rasqal_free_row,
+                                (raptor_data_print_handler)rasqal_row_print);
+  vars_seq = raptor_new_sequence((raptor_data_free_handler)rasqal_free_variable,
+                                 (raptor_data_print_handler)rasqal_variable_print);
+  v = rasqal_variables_table_add2(vt, RASQAL_VARIABLE_TYPE_NORMAL,
+                                  RASQAL_GOOD_CAST(const unsigned char*, "v"),
+                                  1, NULL);
+  if(!row_seq || !vars_seq || !v) {
+    fprintf(stderr, "%s: approx test %d failed to create rows\n",
+            program, test_id);
+    failures++;
+    goto tidy;
+  }
+  raptor_sequence_push(vars_seq, rasqal_new_variable_from_variable(v));
+
+  for(i = 0; i < distinct * repeats; i++) {
+    row = rasqal_new_row_for_size(world, 1);
+    if(!row) {
+      failures++;
+      goto tidy;
+    }
+    row->values[0] = rasqal_new_integer_literal(world, RASQAL_LITERAL_INTEGER,
+                                                i % distinct);
+    row->group_id = 0;
+    raptor_sequence_push(row_seq, row);
+  }
+
+  rowsource = rasqal_new_rowsequence_rowsource(world, query, vt,
+                                               row_seq, vars_seq);
+  /* vars_seq and row_seq are now owned by rowsource */
+  vars_seq = row_seq = NULL;
+  if(!rowsource) {
+    fprintf(stderr, "%s: failed to create rowsequence rowsource\n", program);
+    failures++;
+    goto tidy;
+  }
+
+  l = rasqal_new_variable_literal(world, v);
+  /* v is now owned by l */
+  v = NULL;
+  expr = rasqal_new_aggregate_function_expression(world, RASQAL_EXPR_COUNT,
+                                                  rasqal_new_literal_expression(world, l),
+                                                  /* params */ NULL,
+                                                  RASQAL_EXPR_FLAG_DISTINCT);
+  output_var = rasqal_variables_table_add2(vt, RASQAL_VARIABLE_TYPE_ANONYMOUS,
+                                           RASQAL_GOOD_CAST(const unsigned char*, "fake"),
+                                           4, NULL);
+
+  exprs_seq = raptor_new_sequence((raptor_data_free_handler)rasqal_free_expression,
+                                  (raptor_data_print_handler)rasqal_expression_print);
+  vars_seq = raptor_new_sequence((raptor_data_free_handler)rasqal_free_variable,
+                                 (raptor_data_print_handler)rasqal_variable_print);
+  if(!expr || !output_var || !exprs_seq || !vars_seq) {
+    fprintf(stderr, "%s: approx test %d failed to create COUNT expression\n",
+            program, test_id);
+    failures++;
+    goto tidy;
+  }
+  raptor_sequence_push(exprs_seq, expr);
+  /* expr is now owned by exprs_seq */
+  expr = NULL;
+  raptor_sequence_push(vars_seq, output_var);
+  /* output_var is now owned by vars_seq */
+  output_var = NULL;
+
+  rowsource = rasqal_new_aggregation_rowsource(world, query, rowsource,
+                                               exprs_seq, vars_seq);
+  if(!rowsource) {
+    fprintf(stderr, "%s: failed to create aggregation rowsource\n", program);
+    failures++;
+    goto tidy;
+  }
+
+  seq = rasqal_rowsource_read_all_rows(rowsource);
+  if(!seq || raptor_sequence_size(seq) != 1) {
+    fprintf(stderr, "%s: approx test %d expected 1 row\n", program, test_id);
+    failures++;
+    goto tidy;
+  }
+
+  row = (rasqal_row*)raptor_sequence_get_at(seq, 0);
+  if(row->size != 2 || !row->values[1] ||
+     row->values[1]->type != RASQAL_LITERAL_INTEGER) {
+    fprintf(stderr, "%s: approx test %d result is not an integer\n",
+            program, test_id);
+    failures++;
+    goto tidy;
+  }
+
+  estimate = RASQAL_GOOD_CAST(double, row->values[1]->value.integer);
+  if(fabs(estimate - distinct) > tolerance) {
+    fprintf(stderr,
+            "%s: approx test %d COUNT(DISTINCT) of %d values with %d bits is %.0f, expected within %.1f\n",
+            program, test_id, distinct, bits, estimate, tolerance);
+    failures++;
+  }
+
+  tidy:
+  if(seq)
+    raptor_free_sequence(seq);
+  if(rowsource)
+    rasqal_free_rowsource(rowsource);
+  if(exprs_seq)
+    raptor_free_sequence(exprs_seq);
+  if(vars_seq)
+    raptor_free_sequence(vars_seq);
+  if(row_seq)
+    raptor_free_sequence(row_seq);
+  if(expr)
+    rasqal_free_expression(expr);
+  if(output_var)
+    rasqal_free_variable(output_var);
+  if(v)
+    rasqal_free_variable(v);
+
+  rasqal_query_set_feature(query, RASQAL_FEATURE_APPROX_COUNT_DISTINCT, 0);
+
+  return failures;
+}
+
+#define MERGE_TEST_ROWS 24
+#define MERGE_TEST_SETS 3
+#define MERGE_TEST_OPS_COUNT 7
+
+static const rasqal_op merge_test_ops[MERGE_TEST_OPS_COUNT] = {
+  RASQAL_EXPR_COUNT, RASQAL_EXPR_SUM, RASQAL_EXPR_AVG, RASQAL_EXPR_MIN,
+  RASQAL_EXPR_MAX, RASQAL_EXPR_SAMPLE, RASQAL_EXPR_GROUP_CONCAT
+};
+
+
+/*
+ * Make the value of row @i of merge test value set @set: 0 is all
+ * integers, 1 mixes integers, doubles and decimals and 2 is strings,
+ * some empty.
+ */
+static rasqal_literal*
+merge_test_value(rasqal_world* world, int set, int i)
+{
+  char buf[16];
+  int v = ((i * 37) % 29) - 14;
+  unsigned char* str;
+  size_t len;
+
+  if(!set || (set == 1 && !(i % 3)))
+    return rasqal_new_integer_literal(world, RASQAL_LITERAL_INTEGER, v);
+
+  if(set == 1 && i % 3 == 1)
+    /* quarters add up exactly in any order */
+    return rasqal_new_double_literal(world, v * 0.25);
+
+  if(set == 1) {
+    sprintf(buf, "%d.5", v);
+    return rasqal_new_decimal_literal(world,
+                                      RASQAL_GOOD_CAST(const unsigned char*, buf));
+  }
+
+  if(!(i % 5))
+    *buf = '\0';
+  else
+    sprintf(buf, "s%d", v + 14);
+
+  /* the string literal takes ownership of str */
+  len = strlen(buf);
+  str = RASQAL_MALLOC(unsigned char*, len + 1);
+  if(!str)
+    return NULL;
+  memcpy(str, buf, len + 1);
+
+  return rasqal_new_string_literal(world, str, NULL, NULL, NULL);
+}
+
+
+/*
+ * Step the rows [@start, @end) into a new aggregate state
+ */
+static void*
+merge_test_step(rasqal_world* world, rasqal_expression* expr,
+                raptor_sequence** rows, int start, int end)
+{
+  void* user_data;
+
+  user_data = rasqal_builtin_agg_expression_execute_init(world, expr);
+  if(!user_data)
+    return NULL;
+
+  for(; start < end; start++)
+    rasqal_builtin_agg_expression_execute_step(user_data, rows[start]);
+
+  return user_data;
+}
+
+
+/*
+ * Split the rows of each value set into three partitions at every pair
+ * of points, aggregate the partitions into separate states, merge them
+ * in order and check the result is the same as stepping every row into
+ * one state.
+ */
+static int
+merge_test(rasqal_world* world, const char* program)
+{
+  raptor_sequence* rows[MERGE_TEST_ROWS];
+  int failures = 0;
+  int set;
+  int op_i;
+  int i;
+
+  for(set = 0; set < MERGE_TEST_SETS; set++) {
+    for(i = 0; i < MERGE_TEST_ROWS; i++) {
+      rows[i] = raptor_new_sequence((raptor_data_free_handler)rasqal_free_literal,
+                                    (raptor_data_print_handler)rasqal_literal_print);
+      if(rows[i])
+        raptor_sequence_push(rows[i], merge_test_value(world, set, i));
+    }
+
+    for(op_i = 0; op_i < MERGE_TEST_OPS_COUNT; op_i++) {
+      rasqal_op op = merge_test_ops[op_i];
+      rasqal_expression* expr;
+      rasqal_expression* arg;
+      void* user_data;
+      rasqal_literal* expected;
+      int split1;
+      int split2;
+
+      arg = rasqal_new_literal_expression(world,
+                                          rasqal_new_integer_literal(world, RASQAL_LITERAL_INTEGER, 0));
+      if(op == RASQAL_EXPR_GROUP_CONCAT) {
+        raptor_sequence* args;
+
+        args = raptor_new_sequence((raptor_data_free_handler)rasqal_free_expression,
+                                   (raptor_data_print_handler)rasqal_expression_print);
+        raptor_sequence_push(args, arg);
+        expr = rasqal_new_group_concat_expression(world, /* flags */ 0, args,
+                                                  /* separator */ NULL);
+      } else
+        expr = rasqal_new_aggregate_function_expression(world, op, arg,
+                                                        /* params */ NULL,
+                                                        /* flags */ 0);
+
+      user_data = merge_test_step(world, expr, rows, 0, MERGE_TEST_ROWS);
+      if(!user_data) {
+        fprintf(stderr, "%s: merge test failed to create %s state\n",
+                program, rasqal_expression_op_label(op));
+        failures++;
+        rasqal_free_expression(expr);
+        continue;
+      }
+      expected = rasqal_builtin_agg_expression_execute_result(user_data);
+      rasqal_builtin_agg_expression_execute_finish(user_data);
+
+      for(split1 = 0; split1 <= MERGE_TEST_ROWS; split1++) {
+        for(split2 = split1; split2 <= MERGE_TEST_ROWS; split2++) {
+          void* parts[3];
+          rasqal_literal* result = NULL;
+          int differ;
+
+          parts[0] = merge_test_step(world, expr, rows, 0, split1);
+          parts[1] = merge_test_step(world, expr, rows, split1, split2);
+          parts[2] = merge_test_step(world, expr, rows, split2,
+                                     MERGE_TEST_ROWS);
+
+          if(parts[0] && parts[1] && parts[2] &&
+             !rasqal_builtin_agg_expression_execute_merge(parts[0], parts[1]) &&
+             !rasqal_builtin_agg_expression_execute_merge(parts[0], parts[2]))
+            result = rasqal_builtin_agg_expression_execute_result(parts[0]);
+
+          if(!expected || !result)
+            differ = (expected != result);
+          else
+            differ = (expected->type != result->type ||
+                      strcmp(RASQAL_GOOD_CAST(const char*, rasqal_literal_as_string(expected)),
+                             RASQAL_GOOD_CAST(const char*, rasqal_literal_as_string(result))));
+          if(differ) {
+            fprintf(stderr,
+                    "%s: merge test %s of value set %d split at %d and %d returned ",
+                    program, rasqal_expression_op_label(op), set,
+                    split1, split2);
+            rasqal_literal_print(result, stderr);
+            fputs(" expected ", stderr);
+            rasqal_literal_print(expected, stderr);
+            fputc('\n', stderr);
+            failures++;
+          }
+
+          if(result)
+            rasqal_free_literal(result);
+          for(i = 0; i < 3; i++) {
+            if(parts[i])
+              rasqal_builtin_agg_expression_execute_finish(parts[i]);
+          }
+        }
+      }
+
+      if(expected)
+        rasqal_free_literal(expected);
+      rasqal_free_expression(expr);
+    }
+
+    for(i = 0; i < MERGE_TEST_ROWS; i++) {
+      if(rows[i])
+        raptor_free_sequence(rows[i]);
+    }
+  }
+
+  return failures;
+}
+
+
 int
 main(int argc, char *argv[]) 
 {
@@ -1390,8 +2399,13 @@ main(int argc, char *argv[])
       raptor_free_sequence(expr_args_seq);
     expr_args_seq = NULL;
   }
-  
-  
+
+  for(test_id = 0; test_id < APPROX_TESTS_COUNT; test_id++)
+    failures += approx_count_distinct_test(world, query, program, test_id);
+
+  failures += merge_test(world, program);
+
+
   tidy:
   if(exprs_seq)
     raptor_free_sequence(exprs_seq);
@@ -0,0 +1,812 @@
+/* -*- Mode: c; c-basic-offset: 2 -*-
+ *
+ * rasqal_rowsource_antijoin.c - Rasqal hash anti-join rowsource class
+ *
+ * Copyright (C) 2026, David Beckett http://www.dajobe.org/
+ *
+ * This package is Free Software and part of Redland http://librdf.org/
+ *
+ * It is licensed under the following three licenses as alternatives:
+ *   1. GNU Lesser General Public License (LGPL) V2.1 or any newer version
+ *   2. GNU General Public License (GPL) V2 or any newer version
+ *   3. Apache License, V2.0 or any newer version
+ *
+ * You may not use this file except in compliance with at least one of
+ * the above three licenses.
+ *
+ * See LICENSE.html or LICENSE.txt at the top of this package for the
+ * complete terms and further detail along with the license texts for
+ * the licenses in COPYING.LIB, COPYING and LICENSE-2.0.txt respectively.
+ *
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#include <rasqal_config.h>
+#endif
+
+#ifdef WIN32
+#include <win32_rasqal_config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+
+#include <raptor.h>
+
+#include "rasqal.h"
+#include "rasqal_internal.h"
+
+
+#define DEBUG_FH stderr
+
+#ifndef STANDALONE
+
+/* smallest number of hash buckets; always a power of 2 */
+#define RASQAL_ANTIJOIN_MIN_BUCKETS 16
+
+typedef struct rasqal_antijoin_entry_s
+{
+  unsigned int hash;
+
+  /* shared pointer into con->right_rows */
+  rasqal_row* row;
+
+  struct rasqal_antijoin_entry_s* next;
+} rasqal_antijoin_entry;
+
+
+typedef struct
+{
+  rasqal_rowsource* left;
+
+  rasqal_rowsource* right;
+
+  /* non-0 for SPARQL MINUS: rows with disjoint domains never match */
+  int minus;
+
+  /* map for checking compatibility of rows */
+  rasqal_row_compatible* rc_map;
+
+  /* offsets of the variables in both left and right rows */
+  int* left_keys;
+  int* right_keys;
+  int keys_count;
+
+  /* all right rows, read once on the first left row */
+  raptor_sequence* right_rows;
+  int right_rows_count;
+
+  /* right rows with all keys bound and hashable */
+  rasqal_antijoin_entry** buckets;
+  unsigned int buckets_mask;
+  rasqal_antijoin_entry* entries;
+
+  /* right rows that cannot be hashed: these are always checked */
+  rasqal_row** unhashed_rows;
+  int unhashed_rows_count;
+
+  int failed;
+
+  /* row offset for read_row() */
+  int offset;
+} rasqal_antijoin_rowsource_context;
+
+
+static void
+rasqal_antijoin_rowsource_free_right(rasqal_antijoin_rowsource_context* con)
+{
+  if(con->buckets) {
+    RASQAL_FREE(rasqal_antijoin_entry**, con->buckets);
+    con->buckets = NULL;
+  }
+
+  if(con->entries) {
+    RASQAL_FREE(rasqal_antijoin_entry*, con->entries);
+    con->entries = NULL;
+  }
+
+  if(con->unhashed_rows) {
+    RASQAL_FREE(rasqal_row**, con->unhashed_rows);
+    con->unhashed_rows = NULL;
+  }
+
+  if(con->right_rows) {
+    raptor_free_sequence(con->right_rows);
+    con->right_rows = NULL;
+  }
+
+  con->right_rows_count = 0;
+  con->unhashed_rows_count = 0;
+}
+
+
+static int
+rasqal_antijoin_rowsource_init(rasqal_rowsource* rowsource, void *user_data)
+{
+  rasqal_antijoin_rowsource_context* con;
+
+  con = (rasqal_antijoin_rowsource_context*)user_data;
+
+  con->failed = 0;
+
+  rasqal_rowsource_set_requirements(con->left, RASQAL_ROWSOURCE_REQUIRE_RESET);
+  rasqal_rowsource_set_requirements(con->right, RASQAL_ROWSOURCE_REQUIRE_RESET);
+
+  return 0;
+}
+
+
+static int
+rasqal_antijoin_rowsource_finish(rasqal_rowsource* rowsource, void *user_data)
+{
+  rasqal_antijoin_rowsource_context* con;
+  con = (rasqal_antijoin_rowsource_context*)user_data;
+
+  rasqal_antijoin_rowsource_free_right(con);
+
+  if(con->left)
+    rasqal_free_rowsource(con->left);
+
+  if(con->right)
+    rasqal_free_rowsource(con->right);
+
+  if(con->left_keys)
+    RASQAL_FREE(int*, con->left_keys);
+
+  if(con->right_keys)
+    RASQAL_FREE(int*, con->right_keys);
+
+  if(con->rc_map)
+    rasqal_free_row_compatible(con->rc_map);
+
+  RASQAL_FREE(rasqal_antijoin_rowsource_context, con);
+
+  return 0;
+}
+
+
+static int
+rasqal_antijoin_rowsource_ensure_variables(rasqal_rowsource* rowsource,
+                                           void *user_data)
+{
+  rasqal_antijoin_rowsource_context* con;
+  int count;
+  int i;
+
+  con = (rasqal_antijoin_rowsource_context*)user_data;
+
+  if(rasqal_rowsource_ensure_variables(con->left))
+    return 1;
+
+  if(rasqal_rowsource_ensure_variables(con->right))
+    return 1;
+
+  rowsource->size = 0;
+
+  /* copy in variables from left rowsource */
+  if(rasqal_rowsource_copy_variables(rowsource, con->left))
+    return 1;
+
+  if(!con->minus) {
+    int right_size = rasqal_rowsource_get_size(con->right);
+
+    /* Diff keeps the right variables in the result; they are never bound */
+    for(i = 0; i < right_size; i++) {
+      rasqal_variable* v;
+
+      v = rasqal_rowsource_get_variable_by_offset(con->right, i);
+      if(!v)
+        break;
+      if(rasqal_rowsource_add_variable(rowsource, v) < 0)
+        return 1;
+    }
+  }
+
+  con->rc_map = rasqal_new_row_compatible(con->left->vars_table,
+                                          con->left, con->right);
+  if(!con->rc_map)
+    return 1;
+
+#ifdef RASQAL_DEBUG
+  RASQAL_DEBUG2("rowsource %p ", rowsource);
+  rasqal_print_row_compatible(stderr, con->rc_map);
+#endif
+
+  /* the key is the variables in both rowsources */
+  count = con->rc_map->variables_in_both_rows_count;
+  if(count > 0) {
+    int key_i = 0;
+
+    con->left_keys = RASQAL_CALLOC(int*, RASQAL_GOOD_CAST(size_t, count),
+                                   sizeof(int));
+    con->right_keys = RASQAL_CALLOC(int*, RASQAL_GOOD_CAST(size_t, count),
+                                    sizeof(int));
+    if(!con->left_keys || !con->right_keys)
+      return 1;
+
+    for(i = 0; i < con->rc_map->variables_count; i++) {
+      int offset1 = con->rc_map->defined_in_map[i << 1];
+      int offset2 = con->rc_map->defined_in_map[1 + (i << 1)];
+
+      if(offset1 >= 0 && offset2 >= 0) {
+        con->left_keys[key_i] = offset1;
+        con->right_keys[key_i] = offset2;
+        key_i++;
+      }
+    }
+  }
+  con->keys_count = count;
+
+  return 0;
+}
+
+
+/*
+ * rasqal_antijoin_rowsource_hash_row:
+ * @row: row
+ * @keys: array of key offsets into @row
+ * @keys_count: number of keys
+ * @hash_p: pointer to store hash
+ *
+ * INTERNAL - Hash the key values of a row
+ *
+ * Return value: non-0 if a key is unbound or cannot be hashed
+ */
+static int
+rasqal_antijoin_rowsource_hash_row(rasqal_row* row, int* keys, int keys_count,
+                                   unsigned int* hash_p)
+{
+  unsigned int hash = 0;
+  int i;
+
+  for(i = 0; i < keys_count; i++) {
+    rasqal_literal* l = row->values[keys[i]];
+    unsigned int h;
+
+    if(!l || rasqal_literal_hash(l, &h))
+      return 1;
+
+    hash = (hash * 31) + h;
+  }
+
+  *hash_p = hash;
+  return 0;
+}
+
+
+/*
+ * rasqal_antijoin_rowsource_build:
+ * @con: anti-join rowsource context
+ *
+ * INTERNAL - Read all right rows into a hash table on their keys
+ *
+ * Right rows with an unbound or unhashable key value are kept in a
+ * separate list that is always checked.
+ *
+ * Return value: non-0 on failure
+ */
+static int
+rasqal_antijoin_rowsource_build(rasqal_antijoin_rowsource_context* con)
+{
+  unsigned int buckets_count;
+  int entries_count = 0;
+  int i;
+
+  con->right_rows = rasqal_rowsource_read_all_rows(con->right);
+  if(!con->right_rows)
+    return 1;
+
+  con->right_rows_count = raptor_sequence_size(con->right_rows);
+  if(!con->right_rows_count || !con->keys_count)
+    return 0;
+
+  buckets_count = RASQAL_ANTIJOIN_MIN_BUCKETS;
+  while(buckets_count < RASQAL_GOOD_CAST(unsigned int, con->right_rows_count))
+    buckets_count <<= 1;
+
+  con->buckets = RASQAL_CALLOC(rasqal_antijoin_entry**,
+                               RASQAL_GOOD_CAST(size_t, buckets_count),
+                               sizeof(rasqal_antijoin_entry*));
+  con->entries = RASQAL_MALLOC(rasqal_antijoin_entry*,
+                               RASQAL_GOOD_CAST(size_t, con->right_rows_count) * sizeof(rasqal_antijoin_entry));
+  con->unhashed_rows = RASQAL_MALLOC(rasqal_row**,
+                                     RASQAL_GOOD_CAST(size_t, con->right_rows_count) * sizeof(rasqal_row*));
+  if(!con->buckets || !con->entries || !con->unhashed_rows)
+    return 1;
+
+  con->buckets_mask = buckets_count - 1;
+
+  for(i = 0; i < con->right_rows_count; i++) {
+    rasqal_row* row;
+    rasqal_antijoin_entry* entry;
+    unsigned int hash;
+
+    row = (rasqal_row*)raptor_sequence_get_at(con->right_rows, i);
+    if(rasqal_antijoin_rowsource_hash_row(row, con->right_keys,
+                                          con->keys_count, &hash)) {
+      con->unhashed_rows[con->unhashed_rows_count++] = row;
+      continue;
+    }
+
+    entry = &con->entries[entries_count++];
+    entry->hash = hash;
+    entry->row = row;
+    entry->next = con->buckets[hash & con->buckets_mask];
+    con->buckets[hash & con->buckets_mask] = entry;
+  }
+
+  RASQAL_DEBUG4("built hash of %d right rows in %u buckets, %d unhashed\n",
+                entries_count, buckets_count, con->unhashed_rows_count);
+
+  return 0;
+}
+
+
+static int
+rasqal_antijoin_rowsource_rows_match(rasqal_antijoin_rowsource_context* con,
+                                     rasqal_row* left_row,
+                                     rasqal_row* right_row)
+{
+  int i;
+
+  if(!rasqal_row_compatible_check(con->rc_map, left_row, right_row))
+    return 0;
+
+  if(!con->minus)
+    return 1;
+
+  /* MINUS: the rows must share at least one bound variable */
+  for(i = 0; i < con->keys_count; i++) {
+    if(left_row->values[con->left_keys[i]] &&
+       right_row->values[con->right_keys[i]])
+      return 1;
+  }
+
+  return 0;
+}
+
+
+/*
+ * rasqal_antijoin_rowsource_has_match:
+ * @con: anti-join rowsource context
+ * @left_row: left row
+ *
+ * INTERNAL - Check if a left row has any matching right row
+ *
+ * Return value: non-0 if the left row is removed
+ */
+static int
+rasqal_antijoin_rowsource_has_match(rasqal_antijoin_rowsource_context* con,
+                                    rasqal_row* left_row)
+{
+  unsigned int hash;
+  int i;
+
+  if(!con->right_rows_count)
+    return 0;
+
+  /* No shared variables: every pair is compatible but a MINUS
+   * never removes rows with disjoint domains */
+  if(!con->keys_count)
+    return !con->minus;
+
+  if(!rasqal_antijoin_rowsource_hash_row(left_row, con->left_keys,
+                                         con->keys_count, &hash)) {
+    rasqal_antijoin_entry* entry;
+
+    for(entry = con->buckets[hash & con->buckets_mask];
+        entry;
+        entry = entry->next) {
+      if(entry->hash == hash &&
+         rasqal_antijoin_rowsource_rows_match(con, left_row, entry->row))
+        return 1;
+    }
+
+    for(i = 0; i < con->unhashed_rows_count; i++) {
+      if(rasqal_antijoin_rowsource_rows_match(con, left_row,
+                                              con->unhashed_rows[i]))
+        return 1;
+    }
+
+    return 0;
+  }
+
+  /* Left row has an unbound or unhashable key which may be
+   * compatible with any right row */
+  for(i = 0; i < con->right_rows_count; i++) {
+    rasqal_row* right_row;
+
+    right_row = (rasqal_row*)raptor_sequence_get_at(con->right_rows, i);
+    if(rasqal_antijoin_rowsource_rows_match(con, left_row, right_row))
+      return 1;
+  }
+
+  return 0;
+}
+
+
+static rasqal_row*
+rasqal_antijoin_rowsource_read_row(rasqal_rowsource* rowsource,
+                                   void *user_data)
+{
+  rasqal_antijoin_rowsource_context* con;
+  rasqal_row* row = NULL;
+
+  con = (rasqal_antijoin_rowsource_context*)user_data;
+
+  if(con->failed)
+    return NULL;
+
+  while(1) {
+    row = rasqal_rowsource_read_row(con->left);
+    if(!row)
+      break;
+
+    if(!con->right_rows && rasqal_antijoin_rowsource_build(con)) {
+      con->failed = 1;
+      rasqal_free_row(row);
+      return NULL;
+    }
+
+    if(!rasqal_antijoin_rowsource_has_match(con, row))
+      break;
+
+    rasqal_free_row(row);
+  }
+
+  if(row) {
+    if(row->size < rowsource->size &&
+       rasqal_row_expand_size(row, rowsource->size)) {
+      rasqal_free_row(row);
+      con->failed = 1;
+      return NULL;
+    }
+
+    rasqal_row_set_rowsource(row, rowsource);
+    row->offset = con->offset++;
+
+    rasqal_row_bind_variables(row, rowsource->query->vars_table);
+  }
+
+  return row;
+}
+
+
+static int
+rasqal_antijoin_rowsource_reset(rasqal_rowsource* rowsource, void *user_data)
+{
+  rasqal_antijoin_rowsource_context* con;
+  int rc;
+
+  con = (rasqal_antijoin_rowsource_context*)user_data;
+
+  con->failed = 0;
+  con->offset = 0;
+
+  /* right rows are read again on the next left row */
+  rasqal_antijoin_rowsource_free_right(con);
+
+  rc = rasqal_rowsource_reset(con->left);
+  if(rc)
+    return rc;
+
+  return rasqal_rowsource_reset(con->right);
+}
+
+
+static rasqal_rowsource*
+rasqal_antijoin_rowsource_get_inner_rowsource(rasqal_rowsource* rowsource,
+                                              void *user_data, int offset)
+{
+  rasqal_antijoin_rowsource_context *con;
+  con = (rasqal_antijoin_rowsource_context*)user_data;
+
+  if(offset == 0)
+    return con->left;
+  else if(offset == 1)
+    return con->right;
+  else
+    return NULL;
+}
+
+
+static const rasqal_rowsource_handler rasqal_antijoin_rowsource_handler = {
+  /* .version = */ 1,
+  "antijoin",
+  /* .init = */ rasqal_antijoin_rowsource_init,
+  /* .finish = */ rasqal_antijoin_rowsource_finish,
+  /* .ensure_variables = */ rasqal_antijoin_rowsource_ensure_variables,
+  /* .read_row = */ rasqal_antijoin_rowsource_read_row,
+  /* .read_all_rows = */ NULL,
+  /* .reset = */ rasqal_antijoin_rowsource_reset,
+  /* .set_requirements = */ NULL,
+  /* .get_inner_rowsource = */ rasqal_antijoin_rowsource_get_inner_rowsource,
+  /* .set_origin = */ NULL
+};
+
+
+/**
+ * rasqal_new_antijoin_rowsource:
+ * @world: world object
+ * @query: query object
+ * @left: input left (first) rowsource
+ * @right: input right (second) rowsource
+ * @minus: non-0 for SPARQL MINUS semantics
+ *
+ * INTERNAL - create a new hash anti-join over two rowsources
+ *
+ * Returns the rows of @left that have no compatible row in @right.
+ * The right rows are read once and hashed on the variables shared
+ * with @left so each left row is checked without a rescan.
+ *
+ * With @minus set this is the SPARQL Minus operator: a right row only
+ * removes a left row if they share a bound variable, and only the
+ * left variables are returned.  Otherwise this is the SPARQL Diff
+ * operator with a true expression, the result of
+ * Filter(!bound(?v), LeftJoin(left, right, true)) when ?v is always
+ * bound by @right and never by @left, and the right variables are
+ * returned unbound.
+ *
+ * The @left and @right rowsources become owned by the rowsource.
+ *
+ * Return value: new rowsource or NULL on failure
+ */
+rasqal_rowsource*
+rasqal_new_antijoin_rowsource(rasqal_world *world,
+                              rasqal_query* query,
+                              rasqal_rowsource* left,
+                              rasqal_rowsource* right,
+                              int minus)
+{
+  rasqal_antijoin_rowsource_context* con;
+  int flags = 0;
+
+  if(!world || !query || !left || !right)
+    goto fail;
+
+  con = RASQAL_CALLOC(rasqal_antijoin_rowsource_context*, 1, sizeof(*con));
+  if(!con)
+    goto fail;
+
+  con->left = left;
+  con->right = right;
+  con->minus = minus;
+
+  return rasqal_new_rowsource_from_handler(world, query,
+                                           con,
+                                           &rasqal_antijoin_rowsource_handler,
+                                           query->vars_table,
+                                           flags);
+
+  fail:
+  if(left)
+    rasqal_free_rowsource(left);
+  if(right)
+    rasqal_free_rowsource(right);
+  return NULL;
+}
+
+
+#endif /* not STANDALONE */
+
+
+
+#ifdef STANDALONE
+
+/* one more prototype */
+int main(int argc, char *argv[]);
+
+
+const char* const antijoin_1_data_2x4_rows[] =
+{
+  /* 2 variable names and 4 rows */
+  "a",   NULL, "b",   NULL,
+  /* row 1 data */
+  "foo", NULL, "red", NULL,
+  /* row 2 data */
+  "baz", NULL, "blue", NULL,
+  /* row 3 data */
+  "bob", NULL, "green", NULL,
+  /* row 4 data */
+  "tom", NULL, NULL, NULL,
+  /* end of data */
+  NULL, NULL, NULL, NULL
+};
+
+
+/* anti-join on b */
+
+const char* const antijoin_2_data_2x3_rows[] =
+{
+  /* 2 variable names and 3 rows */
+  "b",     NULL, "c",      NULL,
+  /* row 1 data */
+  "red",   NULL, "orange", NULL,
+  /* row 2 data */
+  "blue",  NULL, "indigo", NULL,
+  /* row 3 data - unbound b */
+  NULL,    NULL, "violet", NULL,
+  /* end of data */
+  NULL, NULL, NULL, NULL
+};
+
+const char* const antijoin_3_data_2x2_rows[] =
+{
+  /* 2 variable names and 2 rows */
+  "b",     NULL, "c",      NULL,
+  /* row 1 data */
+  "red",   NULL, "orange", NULL,
+  /* row 2 data */
+  "blue",  NULL, "indigo", NULL,
+  /* end of data */
+  NULL, NULL, NULL, NULL
+};
+
+/* no shared variables */
+const char* const antijoin_4_data_2x1_rows[] =
+{
+  /* 2 variable names and 1 row */
+  "c",     NULL, "d",      NULL,
+  /* row 1 data */
+  "red",   NULL, "orange", NULL,
+  /* end of data */
+  NULL, NULL, NULL, NULL
+};
+
+
+typedef struct {
+  int minus;
+  const char* const* right_data;
+  int expected;
+  int expected_size;
+} antijoin_test_config_type;
+
+#define ANTIJOIN_TESTS_COUNT 4
+const antijoin_test_config_type antijoin_test_config[ANTIJOIN_TESTS_COUNT] = {
+  /* MINUS: right row with unbound b shares no variable so keeps bob, tom */
+  { 1, antijoin_2_data_2x3_rows, 2, 2 },
+  /* Diff: tom has unbound b so is compatible with every right row */
+  { 0, antijoin_3_data_2x2_rows, 1, 3 },
+  /* Diff: right row with unbound b is compatible with every left row */
+  { 0, antijoin_2_data_2x3_rows, 0, 3 },
+  /* MINUS: disjoint domains never remove rows */
+  { 1, antijoin_4_data_2x1_rows, 4, 2 }
+};
+
+
+int
+main(int argc, char *argv[])
+{
+  const char *program = rasqal_basename(argv[0]);
+  rasqal_rowsource *rowsource = NULL;
+  rasqal_rowsource *left_rs = NULL;
+  rasqal_rowsource *right_rs = NULL;
+  rasqal_world* world = NULL;
+  rasqal_query* query = NULL;
+  int count;
+  raptor_sequence* seq = NULL;
+  int failures = 0;
+  rasqal_variables_table* vt;
+  int size;
+  raptor_sequence* vars_seq = NULL;
+  int test_count;
+
+  world = rasqal_new_world(); rasqal_world_open(world);
+
+  query = rasqal_new_query(world, "sparql", NULL);
+
+  vt = query->vars_table;
+
+  for(test_count = 0; test_count < ANTIJOIN_TESTS_COUNT; test_count++) {
+    const antijoin_test_config_type* config = &antijoin_test_config[test_count];
+    int vars_count = 2;
+
+    fprintf(stderr, "%s: test #%d  minus %d\n", program, test_count,
+            config->minus);
+
+    seq = rasqal_new_row_sequence(world, vt, antijoin_1_data_2x4_rows,
+                                  vars_count, &vars_seq);
+    if(!seq) {
+      fprintf(stderr,
+              "%s: failed to create left sequence of %d vars\n", program,
+              vars_count);
+      failures++;
+      goto tidy;
+    }
+
+    left_rs = rasqal_new_rowsequence_rowsource(world, query, vt, seq, vars_seq);
+    if(!left_rs) {
+      fprintf(stderr, "%s: failed to create left rowsource\n", program);
+      failures++;
+      goto tidy;
+    }
+    /* vars_seq and seq are now owned by left_rs */
+    vars_seq = seq = NULL;
+
+    seq = rasqal_new_row_sequence(world, vt, config->right_data, vars_count,
+                                  &vars_seq);
+    if(!seq) {
+      fprintf(stderr,
+              "%s: failed to create right sequence of %d vars\n", program,
+              vars_count);
+      failures++;
+      goto tidy;
+    }
+
+    right_rs = rasqal_new_rowsequence_rowsource(world, query, vt, seq, vars_seq);
+    if(!right_rs) {
+      fprintf(stderr, "%s: failed to create right rowsource\n", program);
+      failures++;
+      goto tidy;
+    }
+    /* vars_seq and seq are now owned by right_rs */
+    vars_seq = seq = NULL;
+
+    rowsource = rasqal_new_antijoin_rowsource(world, query, left_rs, right_rs,
+                                              config->minus);
+    if(!rowsource) {
+      fprintf(stderr, "%s: failed to create antijoin rowsource\n", program);
+      failures++;
+      goto tidy;
+    }
+    /* left_rs and right_rs are now owned by rowsource */
+    left_rs = right_rs = NULL;
+
+    seq = rasqal_rowsource_read_all_rows(rowsource);
+    if(!seq) {
+      fprintf(stderr,
+              "%s: read_rows returned a NULL seq for an antijoin rowsource\n",
+              program);
+      failures++;
+      goto tidy;
+    }
+    count = raptor_sequence_size(seq);
+    if(count != config->expected) {
+      fprintf(stderr,
+              "%s: read_rows returned %d rows for an antijoin rowsource, expected %d\n",
+              program, count, config->expected);
+      failures++;
+      goto tidy;
+    }
+
+    size = rasqal_rowsource_get_size(rowsource);
+    if(size != config->expected_size) {
+      fprintf(stderr,
+              "%s: read_rows returned %d columns (variables) for an antijoin rowsource, expected %d\n",
+              program, size, config->expected_size);
+      failures++;
+      goto tidy;
+    }
+
+#ifdef RASQAL_DEBUG
+    rasqal_rowsource_print_row_sequence(rowsource, seq, DEBUG_FH);
+#endif
+
+    raptor_free_sequence(seq); seq = NULL;
+    rasqal_free_rowsource(rowsource); rowsource = NULL;
+
+    /* end test_count loop */
+  }
+
+  tidy:
+  if(seq)
+    raptor_free_sequence(seq);
+  if(left_rs)
+    rasqal_free_rowsource(left_rs);
+  if(right_rs)
+    rasqal_free_rowsource(right_rs);
+  if(rowsource)
+    rasqal_free_rowsource(rowsource);
+  if(query)
+    rasqal_free_query(query);
+  if(world)
+    rasqal_free_world(world);
+
+  return failures;
+}
+
+#endif /* STANDALONE */
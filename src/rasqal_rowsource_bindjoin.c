@@ -0,0 +1,1042 @@
+/* -*- Mode: c; c-basic-offset: 2 -*-
+ *
+ * rasqal_rowsource_bindjoin.c - Rasqal SERVICE bind-join rowsource class
+ *
+ * Copyright (C) 2026, David Beckett http://www.dajobe.org/
+ *
+ * This package is Free Software and part of Redland http://librdf.org/
+ *
+ * It is licensed under the following three licenses as alternatives:
+ *   1. GNU Lesser General Public License (LGPL) V2.1 or any newer version
+ *   2. GNU General Public License (GPL) V2 or any newer version
+ *   3. Apache License, V2.0 or any newer version
+ *
+ * You may not use this file except in compliance with at least one of
+ * the above three licenses.
+ *
+ * See LICENSE.html or LICENSE.txt at the top of this package for the
+ * complete terms and further detail along with the license texts for
+ * the licenses in COPYING.LIB, COPYING and LICENSE-2.0.txt respectively.
+ *
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#include <rasqal_config.h>
+#endif
+
+#ifdef WIN32
+#include <win32_rasqal_config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+
+#include <raptor.h>
+
+#include "rasqal.h"
+#include "rasqal_internal.h"
+
+
+#define DEBUG_FH stderr
+
+#ifndef STANDALONE
+
+/*
+ * Bind-join of a pattern with a SERVICE pattern
+ *
+ * Rows from the left (local) rowsource are collected into batches
+ * and the distinct values they have for the variables shared with
+ * the service pattern are sent with the service query as a trailing
+ * VALUES block.  The remote results therefore only contain solutions
+ * that can join with the batch and they are joined with the batch
+ * rows locally as they are read.
+ *
+ * All the rows in a batch bind the same set of shared variables so
+ * that no VALUES row contains UNDEF and each remote solution matches
+ * exactly one VALUES row.
+ *
+ * Several batches are read ahead and their requests are started
+ * together so that they are retrieved concurrently.
+ */
+
+/* batches requested ahead when there is no service concurrency limit */
+#define RASQAL_BINDJOIN_DEFAULT_PENDING 4
+
+typedef struct
+{
+  /* left rows */
+  raptor_sequence* rows;
+  int count;
+
+  /* service request for the rows */
+  rasqal_service* svc;
+} rasqal_bindjoin_batch;
+
+
+typedef struct
+{
+  /* left (local) rowsource */
+  rasqal_rowsource* left;
+
+  /* service parameters */
+  raptor_uri* service_uri;
+  const unsigned char* query_string;
+  raptor_sequence* data_graphs;
+  /* bit flags; currently using RASQAL_ENGINE_BITFLAG_SILENT */
+  unsigned int flags;
+
+  /* sequence of #rasqal_variable bound by the service pattern */
+  raptor_sequence* service_vars;
+
+  /* maximum number of left rows sent in one request */
+  int batch_size;
+
+  /* number of variables in left rows */
+  int left_size;
+
+  /* offsets into left rows of variables also bound by the service */
+  int* join_offsets;
+  int join_offsets_count;
+
+  /* batch being joined */
+  rasqal_bindjoin_batch* batch;
+
+  /* sequence of #rasqal_bindjoin_batch requested and waiting */
+  raptor_sequence* pending;
+  int max_pending;
+
+  /* first left row of the next batch or NULL */
+  rasqal_row* next_left_row;
+  int left_finished;
+
+  /* results of the current batch request */
+  rasqal_rowsource* remote;
+  /* offset in this rowsource for each remote variable or -1 */
+  int* remote_map;
+  int remote_size;
+
+  /* current remote row and the next batch row to try joining with it */
+  rasqal_row* remote_row;
+  int batch_index;
+
+  int failed;
+
+  /* row offset for read_row() */
+  int offset;
+} rasqal_bindjoin_rowsource_context;
+
+
+/* A variable value that can be sent in a VALUES block */
+#define RASQAL_BINDJOIN_VALUE_IS_BOUND(l) \
+  ((l) && (l)->type != RASQAL_LITERAL_BLANK)
+
+
+static void
+rasqal_free_bindjoin_batch(rasqal_bindjoin_batch* batch)
+{
+  if(batch->rows)
+    raptor_free_sequence(batch->rows);
+
+  if(batch->svc)
+    rasqal_free_service(batch->svc);
+
+  RASQAL_FREE(rasqal_bindjoin_batch, batch);
+}
+
+
+static int
+rasqal_bindjoin_rowsource_init(rasqal_rowsource* rowsource, void *user_data)
+{
+  rasqal_bindjoin_rowsource_context* con;
+  int concurrency;
+
+  con = (rasqal_bindjoin_rowsource_context*)user_data;
+
+  con->pending = raptor_new_sequence((raptor_data_free_handler)rasqal_free_bindjoin_batch,
+                                     NULL);
+  if(!con->pending)
+    return 1;
+
+  concurrency = rowsource->query->features[RASQAL_FEATURE_SERVICE_CONCURRENCY];
+  con->max_pending = concurrency > 0 ? concurrency : RASQAL_BINDJOIN_DEFAULT_PENDING;
+
+  return 0;
+}
+
+
+static void
+rasqal_bindjoin_rowsource_end_batch(rasqal_bindjoin_rowsource_context* con)
+{
+  if(con->remote_row) {
+    rasqal_free_row(con->remote_row);
+    con->remote_row = NULL;
+  }
+
+  if(con->remote) {
+    rasqal_free_rowsource(con->remote);
+    con->remote = NULL;
+  }
+
+  if(con->remote_map) {
+    RASQAL_FREE(int*, con->remote_map);
+    con->remote_map = NULL;
+  }
+  con->remote_size = 0;
+
+  if(con->batch) {
+    rasqal_free_bindjoin_batch(con->batch);
+    con->batch = NULL;
+  }
+}
+
+
+static int
+rasqal_bindjoin_rowsource_finish(rasqal_rowsource* rowsource, void *user_data)
+{
+  rasqal_bindjoin_rowsource_context* con;
+
+  con = (rasqal_bindjoin_rowsource_context*)user_data;
+
+  rasqal_bindjoin_rowsource_end_batch(con);
+
+  if(con->pending)
+    raptor_free_sequence(con->pending);
+
+  if(con->next_left_row)
+    rasqal_free_row(con->next_left_row);
+
+  if(con->join_offsets)
+    RASQAL_FREE(int*, con->join_offsets);
+
+  if(con->left)
+    rasqal_free_rowsource(con->left);
+
+  if(con->service_uri)
+    raptor_free_uri(con->service_uri);
+
+  if(con->query_string)
+    RASQAL_FREE(cstring, con->query_string);
+
+  if(con->data_graphs)
+    raptor_free_sequence(con->data_graphs);
+
+  if(con->service_vars)
+    raptor_free_sequence(con->service_vars);
+
+  RASQAL_FREE(rasqal_bindjoin_rowsource_context, con);
+
+  return 0;
+}
+
+
+static int
+rasqal_bindjoin_rowsource_ensure_variables(rasqal_rowsource* rowsource,
+                                           void *user_data)
+{
+  rasqal_bindjoin_rowsource_context* con;
+  int size;
+  int i;
+
+  con = (rasqal_bindjoin_rowsource_context*)user_data;
+
+  if(rasqal_rowsource_ensure_variables(con->left))
+    return 1;
+
+  rowsource->size = 0;
+  if(rasqal_rowsource_copy_variables(rowsource, con->left))
+    return 1;
+
+  con->left_size = rowsource->size;
+
+  size = raptor_sequence_size(con->service_vars);
+  if(size > 0) {
+    con->join_offsets = RASQAL_CALLOC(int*, RASQAL_GOOD_CAST(size_t, size),
+                                      sizeof(int));
+    if(!con->join_offsets)
+      return 1;
+  }
+
+  for(i = 0; i < size; i++) {
+    rasqal_variable* v;
+    int offset;
+
+    v = (rasqal_variable*)raptor_sequence_get_at(con->service_vars, i);
+    offset = rasqal_rowsource_get_variable_offset_by_name(con->left, v->name);
+    if(offset >= 0)
+      con->join_offsets[con->join_offsets_count++] = offset;
+    else if(rasqal_rowsource_add_variable(rowsource, v) < 0)
+      return 1;
+  }
+
+  return 0;
+}
+
+
+/*
+ * rasqal_bindjoin_rowsource_same_bound:
+ *
+ * INTERNAL - Check two left rows bind the same join variables
+ */
+static int
+rasqal_bindjoin_rowsource_same_bound(rasqal_bindjoin_rowsource_context* con,
+                                     rasqal_row* row1, rasqal_row* row2)
+{
+  int i;
+
+  for(i = 0; i < con->join_offsets_count; i++) {
+    int offset = con->join_offsets[i];
+
+    if(RASQAL_BINDJOIN_VALUE_IS_BOUND(row1->values[offset]) !=
+       RASQAL_BINDJOIN_VALUE_IS_BOUND(row2->values[offset]))
+      return 0;
+  }
+
+  return 1;
+}
+
+
+/*
+ * rasqal_bindjoin_rowsource_same_key:
+ *
+ * INTERNAL - Check two left rows of a batch have the same join values
+ */
+static int
+rasqal_bindjoin_rowsource_same_key(rasqal_bindjoin_rowsource_context* con,
+                                   rasqal_row* row1, rasqal_row* row2)
+{
+  int i;
+
+  for(i = 0; i < con->join_offsets_count; i++) {
+    int offset = con->join_offsets[i];
+    rasqal_literal* l1 = row1->values[offset];
+
+    if(!RASQAL_BINDJOIN_VALUE_IS_BOUND(l1))
+      continue;
+
+    if(!rasqal_literal_same_term(l1, row2->values[offset]))
+      return 0;
+  }
+
+  return 1;
+}
+
+
+/*
+ * rasqal_bindjoin_rowsource_batch_bindings:
+ * @rowsource: bind-join rowsource
+ * @con: bind-join context
+ * @batch: batch of left rows
+ *
+ * INTERNAL - Build the VALUES bindings for a batch
+ *
+ * Return value: new bindings, NULL if no variables are shared or on
+ * failure (@con->failed is set)
+ */
+static rasqal_bindings*
+rasqal_bindjoin_rowsource_batch_bindings(rasqal_rowsource* rowsource,
+                                         rasqal_bindjoin_rowsource_context* con,
+                                         rasqal_bindjoin_batch* batch)
+{
+  rasqal_query* query = rowsource->query;
+  raptor_sequence* vars_seq = NULL;
+  raptor_sequence* rows_seq = NULL;
+  raptor_sequence* keys_seq = NULL;
+  rasqal_row* first;
+  int vars_count = 0;
+  int i;
+
+  first = (rasqal_row*)raptor_sequence_get_at(batch->rows, 0);
+
+  vars_seq = raptor_new_sequence((raptor_data_free_handler)rasqal_free_variable,
+                                 (raptor_data_print_handler)rasqal_variable_print);
+  rows_seq = raptor_new_sequence((raptor_data_free_handler)rasqal_free_row,
+                                 (raptor_data_print_handler)rasqal_row_print);
+  /* shared pointers to the batch rows with distinct keys */
+  keys_seq = raptor_new_sequence(NULL, NULL);
+  if(!vars_seq || !rows_seq || !keys_seq)
+    goto failed;
+
+  for(i = 0; i < con->join_offsets_count; i++) {
+    int offset = con->join_offsets[i];
+    rasqal_variable* v;
+
+    if(!RASQAL_BINDJOIN_VALUE_IS_BOUND(first->values[offset]))
+      continue;
+
+    v = rasqal_rowsource_get_variable_by_offset(rowsource, offset);
+    if(raptor_sequence_push(vars_seq, rasqal_new_variable_from_variable(v)))
+      goto failed;
+    vars_count++;
+  }
+
+  if(!vars_count) {
+    raptor_free_sequence(vars_seq);
+    raptor_free_sequence(rows_seq);
+    raptor_free_sequence(keys_seq);
+    return NULL;
+  }
+
+  for(i = 0; i < batch->count; i++) {
+    rasqal_row* left_row;
+    rasqal_row* row;
+    int j;
+    int k;
+
+    left_row = (rasqal_row*)raptor_sequence_get_at(batch->rows, i);
+
+    for(j = 0; j < raptor_sequence_size(keys_seq); j++) {
+      rasqal_row* key_row = (rasqal_row*)raptor_sequence_get_at(keys_seq, j);
+      if(rasqal_bindjoin_rowsource_same_key(con, key_row, left_row))
+        break;
+    }
+    if(j < raptor_sequence_size(keys_seq))
+      continue;
+
+    if(raptor_sequence_push(keys_seq, left_row))
+      goto failed;
+
+    row = rasqal_new_row_for_size(rowsource->world, vars_count);
+    if(!row)
+      goto failed;
+
+    k = 0;
+    for(j = 0; j < con->join_offsets_count; j++) {
+      rasqal_literal* l = left_row->values[con->join_offsets[j]];
+
+      if(RASQAL_BINDJOIN_VALUE_IS_BOUND(l))
+        row->values[k++] = rasqal_new_literal_from_literal(l);
+    }
+
+    if(raptor_sequence_push(rows_seq, row))
+      goto failed;
+  }
+
+  raptor_free_sequence(keys_seq);
+
+  /* vars_seq and rows_seq become owned by the bindings */
+  return rasqal_new_bindings(query, vars_seq, rows_seq);
+
+  failed:
+  if(vars_seq)
+    raptor_free_sequence(vars_seq);
+  if(rows_seq)
+    raptor_free_sequence(rows_seq);
+  if(keys_seq)
+    raptor_free_sequence(keys_seq);
+  con->failed = 1;
+
+  return NULL;
+}
+
+
+/*
+ * rasqal_bindjoin_rowsource_batch_query_string:
+ * @rowsource: bind-join rowsource
+ * @con: bind-join context
+ * @batch: batch of left rows
+ *
+ * INTERNAL - Make the service query for a batch
+ *
+ * Return value: new query string or NULL on failure
+ */
+static unsigned char*
+rasqal_bindjoin_rowsource_batch_query_string(rasqal_rowsource* rowsource,
+                                             rasqal_bindjoin_rowsource_context* con,
+                                             rasqal_bindjoin_batch* batch)
+{
+  rasqal_bindings* bindings;
+  raptor_iostream* iostr;
+  unsigned char* string = NULL;
+
+  bindings = rasqal_bindjoin_rowsource_batch_bindings(rowsource, con, batch);
+  if(con->failed)
+    return NULL;
+
+  iostr = raptor_new_iostream_to_string(rowsource->world->raptor_world_ptr,
+                                        (void**)&string, NULL,
+                                        rasqal_alloc_memory);
+  if(!iostr) {
+    if(bindings)
+      rasqal_free_bindings(bindings);
+    return NULL;
+  }
+
+  raptor_iostream_string_write(con->query_string, iostr);
+  if(bindings) {
+    raptor_iostream_write_byte('\n', iostr);
+    rasqal_query_write_sparql_values_clause(rowsource->world, iostr, bindings);
+    rasqal_free_bindings(bindings);
+  }
+  raptor_free_iostream(iostr);
+
+  return string;
+}
+
+
+/*
+ * rasqal_bindjoin_rowsource_read_batch:
+ * @rowsource: bind-join rowsource
+ * @con: bind-join context
+ *
+ * INTERNAL - Read a batch of left rows and start its service request
+ *
+ * Return value: new batch or NULL at the end of the left rows or on
+ * failure (@con->failed is set)
+ */
+static rasqal_bindjoin_batch*
+rasqal_bindjoin_rowsource_read_batch(rasqal_rowsource* rowsource,
+                                     rasqal_bindjoin_rowsource_context* con)
+{
+  rasqal_query* query = rowsource->query;
+  rasqal_bindjoin_batch* batch;
+  rasqal_row* first;
+  unsigned char* query_string;
+
+  first = con->next_left_row;
+  con->next_left_row = NULL;
+  if(!first) {
+    if(con->left_finished)
+      return NULL;
+
+    first = rasqal_rowsource_read_row(con->left);
+    if(!first) {
+      con->left_finished = 1;
+      return NULL;
+    }
+  }
+
+  batch = RASQAL_CALLOC(rasqal_bindjoin_batch*, 1, sizeof(*batch));
+  if(!batch) {
+    rasqal_free_row(first);
+    goto failed;
+  }
+
+  batch->rows = raptor_new_sequence((raptor_data_free_handler)rasqal_free_row,
+                                    (raptor_data_print_handler)rasqal_row_print);
+  if(!batch->rows) {
+    rasqal_free_row(first);
+    goto failed;
+  }
+
+  if(raptor_sequence_push(batch->rows, first))
+    goto failed;
+  batch->count = 1;
+
+  /* A batch with no join values sends the plain service query and
+   * takes the following rows with no join values, up to the batch
+   * size like any other batch so the left rows held stay bounded.
+   * Consecutive batches with no join values send the same query which
+   * the SERVICE results cache can answer. */
+  while(!con->left_finished && batch->count < con->batch_size) {
+    rasqal_row* row = rasqal_rowsource_read_row(con->left);
+
+    if(!row) {
+      con->left_finished = 1;
+      break;
+    }
+
+    if(!rasqal_bindjoin_rowsource_same_bound(con, first, row)) {
+      con->next_left_row = row;
+      break;
+    }
+
+    if(raptor_sequence_push(batch->rows, row))
+      goto failed;
+    batch->count++;
+  }
+
+  query_string = rasqal_bindjoin_rowsource_batch_query_string(rowsource, con,
+                                                              batch);
+  if(!query_string)
+    goto failed;
+
+  RASQAL_DEBUG3("Sending %d bindings to service with query '%s'\n",
+                batch->count, query_string);
+
+  batch->svc = rasqal_new_service(rowsource->world, con->service_uri,
+                                  query_string, con->data_graphs);
+  RASQAL_FREE(char*, query_string);
+
+  /* Failures are reported when the batch results are read */
+  if(batch->svc) {
+    rasqal_service_set_request_limits(batch->svc,
+                                      query->features[RASQAL_FEATURE_SERVICE_TIMEOUT],
+                                      query->features[RASQAL_FEATURE_SERVICE_CONCURRENCY]);
+    rasqal_service_prefetch(batch->svc);
+  }
+
+  return batch;
+
+  failed:
+  if(batch)
+    rasqal_free_bindjoin_batch(batch);
+  con->failed = 1;
+
+  return NULL;
+}
+
+
+/*
+ * rasqal_bindjoin_rowsource_next_batch:
+ * @rowsource: bind-join rowsource
+ * @con: bind-join context
+ *
+ * INTERNAL - Move to the next batch and read its service results
+ *
+ * Return value: non-0 at the end of the left rows or on failure
+ */
+static int
+rasqal_bindjoin_rowsource_next_batch(rasqal_rowsource* rowsource,
+                                     rasqal_bindjoin_rowsource_context* con)
+{
+  rasqal_rowsource* remote = NULL;
+  int i;
+
+  rasqal_bindjoin_rowsource_end_batch(con);
+
+  /* Keep up to max_pending requests in progress */
+  while(raptor_sequence_size(con->pending) < con->max_pending) {
+    rasqal_bindjoin_batch* batch;
+
+    batch = rasqal_bindjoin_rowsource_read_batch(rowsource, con);
+    if(!batch)
+      break;
+
+    if(raptor_sequence_push(con->pending, batch)) {
+      con->failed = 1;
+      return 1;
+    }
+  }
+
+  if(con->failed)
+    return 1;
+
+  con->batch = (rasqal_bindjoin_batch*)raptor_sequence_unshift(con->pending);
+  if(!con->batch)
+    return 1;
+
+  if(con->batch->svc)
+    remote = rasqal_service_execute_as_rowsource(con->batch->svc,
+                                                 rowsource->vars_table);
+
+  if(!remote) {
+    if(!(con->flags & RASQAL_ENGINE_BITFLAG_SILENT)) {
+      /* the service has logged the error */
+      rowsource->query->failed = 1;
+      con->failed = 1;
+      return 1;
+    }
+
+    /* Silent errors join the batch with one empty solution */
+    remote = rasqal_new_empty_rowsource(rowsource->world, rowsource->query);
+    if(!remote) {
+      con->failed = 1;
+      return 1;
+    }
+  }
+  con->remote = remote;
+
+  if(rasqal_rowsource_ensure_variables(remote)) {
+    con->failed = 1;
+    return 1;
+  }
+
+  con->remote_size = rasqal_rowsource_get_size(remote);
+  if(con->remote_size > 0) {
+    con->remote_map = RASQAL_CALLOC(int*,
+                                    RASQAL_GOOD_CAST(size_t, con->remote_size),
+                                    sizeof(int));
+    if(!con->remote_map) {
+      con->failed = 1;
+      return 1;
+    }
+  }
+
+  for(i = 0; i < con->remote_size; i++) {
+    rasqal_variable* v = rasqal_rowsource_get_variable_by_offset(remote, i);
+
+    con->remote_map[i] = rasqal_rowsource_get_variable_offset_by_name(rowsource,
+                                                                      v->name);
+  }
+
+  return 0;
+}
+
+
+/*
+ * rasqal_bindjoin_rowsource_compatible:
+ *
+ * INTERNAL - Check a left row and a remote row agree on shared variables
+ */
+static int
+rasqal_bindjoin_rowsource_compatible(rasqal_bindjoin_rowsource_context* con,
+                                     rasqal_row* left_row,
+                                     rasqal_row* remote_row)
+{
+  int i;
+
+  for(i = 0; i < con->remote_size; i++) {
+    int offset = con->remote_map[i];
+    rasqal_literal* left_value;
+    rasqal_literal* remote_value = remote_row->values[i];
+
+    if(offset < 0 || offset >= con->left_size || !remote_value)
+      continue;
+
+    left_value = left_row->values[offset];
+    if(left_value && !rasqal_literal_equals(left_value, remote_value))
+      return 0;
+  }
+
+  return 1;
+}
+
+
+static rasqal_row*
+rasqal_bindjoin_rowsource_read_row(rasqal_rowsource* rowsource,
+                                   void *user_data)
+{
+  rasqal_bindjoin_rowsource_context* con;
+
+  con = (rasqal_bindjoin_rowsource_context*)user_data;
+
+  if(con->failed)
+    return NULL;
+
+  while(1) {
+    if(con->remote_row) {
+      while(con->batch_index < con->batch->count) {
+        rasqal_row* left_row;
+        rasqal_row* row;
+        int i;
+
+        left_row = (rasqal_row*)raptor_sequence_get_at(con->batch->rows,
+                                                       con->batch_index++);
+        if(!rasqal_bindjoin_rowsource_compatible(con, left_row,
+                                                 con->remote_row))
+          continue;
+
+        row = rasqal_new_row(rowsource);
+        if(!row) {
+          con->failed = 1;
+          return NULL;
+        }
+
+        for(i = 0; i < con->left_size; i++) {
+          if(left_row->values[i])
+            row->values[i] = rasqal_new_literal_from_literal(left_row->values[i]);
+        }
+
+        for(i = 0; i < con->remote_size; i++) {
+          int offset = con->remote_map[i];
+          rasqal_literal* l = con->remote_row->values[i];
+
+          if(offset >= 0 && l && !row->values[offset])
+            row->values[offset] = rasqal_new_literal_from_literal(l);
+        }
+
+        row->offset = con->offset++;
+
+        return row;
+      }
+
+      rasqal_free_row(con->remote_row);
+      con->remote_row = NULL;
+    }
+
+    if(con->remote) {
+      con->remote_row = rasqal_rowsource_read_row(con->remote);
+      if(con->remote_row) {
+        con->batch_index = 0;
+        continue;
+      }
+
+      /* A response that stopped part way through fails the query
+       * unless the service is silent when the rows read are kept */
+      if(con->batch->svc && rasqal_service_get_failed(con->batch->svc) &&
+         !(con->flags & RASQAL_ENGINE_BITFLAG_SILENT)) {
+        rasqal_query_simple_error(rowsource->query,
+                                  "Failed to fetch all results from service");
+        con->failed = 1;
+        return NULL;
+      }
+    }
+
+    if(rasqal_bindjoin_rowsource_next_batch(rowsource, con))
+      break;
+  }
+
+  return NULL;
+}
+
+
+static const rasqal_rowsource_handler rasqal_bindjoin_rowsource_handler = {
+  /* .version = */ 1,
+  "bindjoin",
+  /* .init = */ rasqal_bindjoin_rowsource_init,
+  /* .finish = */ rasqal_bindjoin_rowsource_finish,
+  /* .ensure_variables = */ rasqal_bindjoin_rowsource_ensure_variables,
+  /* .read_row = */ rasqal_bindjoin_rowsource_read_row,
+  /* .read_all_rows = */ NULL,
+  /* .reset = */ NULL,
+  /* .set_requirements = */ NULL,
+  /* .get_inner_rowsource = */ NULL,
+  /* .set_origin = */ NULL,
+};
+
+
+/**
+ * rasqal_new_bindjoin_rowsource:
+ * @world: world object
+ * @query: query object
+ * @left: left (local) rowsource
+ * @service_uri: service URI
+ * @query_string: query to send to service
+ * @data_graphs: sequence of data graphs (or NULL)
+ * @service_vars: sequence of #rasqal_variable bound by the service pattern
+ * @rs_flags: service rowsource flags
+ * @batch_size: maximum number of left rows sent in one request
+ *
+ * INTERNAL - create a new rowsource joining rows with a service by
+ * sending batches of their bindings to it
+ *
+ * The @left, @query_string, @data_graphs and @service_vars become
+ * owned by the new rowsource.  @service_uri is copied.
+ *
+ * Return value: new rowsource or NULL on failure
+ */
+rasqal_rowsource*
+rasqal_new_bindjoin_rowsource(rasqal_world *world,
+                              rasqal_query* query,
+                              rasqal_rowsource* left,
+                              raptor_uri* service_uri,
+                              const unsigned char* query_string,
+                              raptor_sequence* data_graphs,
+                              raptor_sequence* service_vars,
+                              unsigned int rs_flags,
+                              int batch_size)
+{
+  rasqal_bindjoin_rowsource_context* con;
+  int flags = 0;
+
+  if(!world || !query || !left || !service_uri || !query_string ||
+     !service_vars || batch_size < 1)
+    goto fail;
+
+  con = RASQAL_CALLOC(rasqal_bindjoin_rowsource_context*, 1, sizeof(*con));
+  if(!con)
+    goto fail;
+
+  con->left = left;
+  con->service_uri = raptor_uri_copy(service_uri);
+  con->query_string = query_string;
+  con->data_graphs = data_graphs;
+  con->service_vars = service_vars;
+  con->flags = rs_flags;
+  con->batch_size = batch_size;
+
+  return rasqal_new_rowsource_from_handler(world, query,
+                                           con,
+                                           &rasqal_bindjoin_rowsource_handler,
+                                           query->vars_table,
+                                           flags);
+
+  fail:
+  if(left)
+    rasqal_free_rowsource(left);
+  if(query_string)
+    RASQAL_FREE(cstring, query_string);
+  if(data_graphs)
+    raptor_free_sequence(data_graphs);
+  if(service_vars)
+    raptor_free_sequence(service_vars);
+  return NULL;
+}
+
+
+#endif /* not STANDALONE */
+
+
+
+#ifdef STANDALONE
+
+/* one more prototype */
+int main(int argc, char *argv[]);
+
+
+const char* const bindjoin_1_data_2x2_rows[] =
+{
+  /* 2 variable names and 2 rows */
+  "a",   NULL, "b",   NULL,
+  /* row 1 data */
+  "foo", NULL, "red", NULL,
+  /* row 2 data */
+  "bob", NULL, "green", NULL,
+  /* end of data */
+  NULL, NULL, NULL, NULL
+};
+
+#define BINDJOIN_SERVICE_QUERY "SELECT * WHERE { ?b ?p ?c }"
+
+
+int
+main(int argc, char *argv[])
+{
+  const char *program = rasqal_basename(argv[0]);
+  rasqal_rowsource *rowsource = NULL;
+  rasqal_world* world = NULL;
+  rasqal_query* query = NULL;
+  raptor_sequence* seq = NULL;
+  raptor_sequence* vars_seq = NULL;
+  raptor_sequence* rows_seq = NULL;
+  raptor_sequence* service_vars = NULL;
+  rasqal_variables_table* vt;
+  rasqal_bindings* bindings = NULL;
+  raptor_iostream* iostr = NULL;
+  unsigned char* string = NULL;
+  unsigned char* query_string = NULL;
+  raptor_uri* service_uri = NULL;
+  rasqal_variable* b;
+  const char* const expected = "VALUES ?b { \"red\" \"green\" }\n";
+  int vars_count = 2;
+  int failures = 0;
+  int size;
+  int i;
+
+  world = rasqal_new_world(); rasqal_world_open(world);
+
+  query = rasqal_new_query(world, "sparql", NULL);
+
+  vt = query->vars_table;
+
+  seq = rasqal_new_row_sequence(world, vt, bindjoin_1_data_2x2_rows,
+                                vars_count, &vars_seq);
+  if(!seq) {
+    fprintf(stderr, "%s: failed to create sequence of %d vars\n", program,
+            vars_count);
+    failures++;
+    goto tidy;
+  }
+  b = (rasqal_variable*)raptor_sequence_get_at(vars_seq, 1);
+
+  /* VALUES block for the ?b values sent to a service */
+  rows_seq = raptor_new_sequence((raptor_data_free_handler)rasqal_free_row,
+                                 (raptor_data_print_handler)rasqal_row_print);
+  for(i = 0; i < 2; i++) {
+    rasqal_row* row = (rasqal_row*)raptor_sequence_get_at(seq, i);
+    rasqal_row* key = rasqal_new_row_for_size(world, 1);
+
+    key->values[0] = rasqal_new_literal_from_literal(row->values[1]);
+    raptor_sequence_push(rows_seq, key);
+  }
+
+  service_vars = raptor_new_sequence((raptor_data_free_handler)rasqal_free_variable,
+                                     (raptor_data_print_handler)rasqal_variable_print);
+  raptor_sequence_push(service_vars, rasqal_new_variable_from_variable(b));
+
+  bindings = rasqal_new_bindings(query, service_vars, rows_seq);
+  /* service_vars and rows_seq are now owned by bindings */
+  service_vars = rows_seq = NULL;
+
+  iostr = raptor_new_iostream_to_string(world->raptor_world_ptr,
+                                        (void**)&string, NULL,
+                                        rasqal_alloc_memory);
+  rasqal_query_write_sparql_values_clause(world, iostr, bindings);
+  raptor_free_iostream(iostr); iostr = NULL;
+
+  if(!string || strcmp(RASQAL_GOOD_CAST(const char*, string), expected)) {
+    fprintf(stderr, "%s: VALUES block was '%s', expected '%s'\n", program,
+            string, expected);
+    failures++;
+    goto tidy;
+  }
+
+  /* An empty left side sends no requests and returns no rows */
+  raptor_free_sequence(seq);
+  seq = raptor_new_sequence((raptor_data_free_handler)rasqal_free_row,
+                            (raptor_data_print_handler)rasqal_row_print);
+
+  rowsource = rasqal_new_rowsequence_rowsource(world, query, vt, seq, vars_seq);
+  /* vars_seq and seq are now owned by rowsource */
+  vars_seq = seq = NULL;
+  if(!rowsource) {
+    fprintf(stderr, "%s: failed to create left rowsource\n", program);
+    failures++;
+    goto tidy;
+  }
+
+  service_uri = raptor_new_uri(world->raptor_world_ptr,
+                               RASQAL_GOOD_CAST(const unsigned char*, "http://example.org/service"));
+
+  query_string = RASQAL_MALLOC(unsigned char*, sizeof(BINDJOIN_SERVICE_QUERY));
+  memcpy(query_string, BINDJOIN_SERVICE_QUERY, sizeof(BINDJOIN_SERVICE_QUERY));
+
+  service_vars = raptor_new_sequence((raptor_data_free_handler)rasqal_free_variable,
+                                     (raptor_data_print_handler)rasqal_variable_print);
+  raptor_sequence_push(service_vars, rasqal_new_variable_from_variable(b));
+  raptor_sequence_push(service_vars,
+                       rasqal_variables_table_add2(vt, RASQAL_VARIABLE_TYPE_NORMAL,
+                                                   RASQAL_GOOD_CAST(const unsigned char*, "c"),
+                                                   0, NULL));
+
+  rowsource = rasqal_new_bindjoin_rowsource(world, query, rowsource,
+                                            service_uri, query_string, NULL,
+                                            service_vars, 0, 2);
+  /* query_string and service_vars are now owned by rowsource */
+  query_string = NULL;
+  service_vars = NULL;
+  if(!rowsource) {
+    fprintf(stderr, "%s: failed to create bindjoin rowsource\n", program);
+    failures++;
+    goto tidy;
+  }
+
+  seq = rasqal_rowsource_read_all_rows(rowsource);
+  if(!seq || raptor_sequence_size(seq)) {
+    fprintf(stderr,
+            "%s: read_rows did not return an empty seq for an empty left side\n",
+            program);
+    failures++;
+    goto tidy;
+  }
+
+  /* a, b and the service only variable c */
+  size = rasqal_rowsource_get_size(rowsource);
+  if(size != 3) {
+    fprintf(stderr,
+            "%s: bindjoin rowsource has %d columns (variables), expected 3\n",
+            program, size);
+    failures++;
+    goto tidy;
+  }
+
+  tidy:
+  if(string)
+    rasqal_free_memory(string);
+  if(bindings)
+    rasqal_free_bindings(bindings);
+  if(seq)
+    raptor_free_sequence(seq);
+  if(vars_seq)
+    raptor_free_sequence(vars_seq);
+  if(rows_seq)
+    raptor_free_sequence(rows_seq);
+  if(service_vars)
+    raptor_free_sequence(service_vars);
+  if(service_uri)
+    raptor_free_uri(service_uri);
+  if(rowsource)
+    rasqal_free_rowsource(rowsource);
+  if(query)
+    rasqal_free_query(query);
+  if(world)
+    rasqal_free_world(world);
+
+  return failures;
+}
+
+#endif /* STANDALONE */
@@ -44,6 +44,20 @@
 #define DEBUG_FH stderr
 
 
+#define RASQAL_FILTER_NUMERIC_CONDITIONS_MAX 8
+
+/*
+ * A comparison of a variable against an xsd:integer or xsd:double
+ * constant: (value of column) op literal
+ */
+typedef struct
+{
+  int column;
+  rasqal_op op;
+  rasqal_literal* literal;
+} rasqal_filter_numeric_condition;
+
+
 typedef struct 
 {
   /* inner rowsource to filter */
@@ -55,6 +69,13 @@ typedef struct
   /* offset into results for current row */
   int offset;
   
+  /* numeric conditions that are conjuncts of @expr and can be
+   * evaluated over a whole batch at once */
+  rasqal_filter_numeric_condition numeric_conditions[RASQAL_FILTER_NUMERIC_CONDITIONS_MAX];
+  int numeric_conditions_count;
+
+  /* non-0 if @expr has conjuncts that are not in @numeric_conditions */
+  int residual_expr;
 } rasqal_filter_rowsource_context;
 
 
@@ -65,6 +86,84 @@ rasqal_filter_rowsource_init(rasqal_rowsource* rowsource, void *user_data)
 }
 
 
+/*
+ * rasqal_filter_rowsource_add_numeric_conditions:
+ * @rowsource: filter rowsource
+ * @con: filter rowsource context
+ * @expr: expression
+ *
+ * INTERNAL - Find numeric comparisons in the conjuncts of an expression
+ *
+ * Return value: number of conjuncts of @expr that were not added
+ */
+static int
+rasqal_filter_rowsource_add_numeric_conditions(rasqal_rowsource* rowsource,
+                                               rasqal_filter_rowsource_context* con,
+                                               rasqal_expression* expr)
+{
+  rasqal_expression* var_expr;
+  rasqal_expression* value_expr;
+  rasqal_filter_numeric_condition* cond;
+  rasqal_op op = expr->op;
+  rasqal_literal_type type;
+  int column;
+
+  if(op == RASQAL_EXPR_AND)
+    return rasqal_filter_rowsource_add_numeric_conditions(rowsource, con,
+                                                          expr->arg1) +
+           rasqal_filter_rowsource_add_numeric_conditions(rowsource, con,
+                                                          expr->arg2);
+
+  if(op != RASQAL_EXPR_EQ && op != RASQAL_EXPR_NEQ &&
+     op != RASQAL_EXPR_LT && op != RASQAL_EXPR_GT &&
+     op != RASQAL_EXPR_LE && op != RASQAL_EXPR_GE)
+    return 1;
+
+  if(expr->arg1->op != RASQAL_EXPR_LITERAL ||
+     expr->arg2->op != RASQAL_EXPR_LITERAL)
+    return 1;
+
+  /* Normalize to ?var op constant */
+  if(expr->arg1->literal->type == RASQAL_LITERAL_VARIABLE) {
+    var_expr = expr->arg1;
+    value_expr = expr->arg2;
+  } else {
+    var_expr = expr->arg2;
+    value_expr = expr->arg1;
+    if(op == RASQAL_EXPR_LT)
+      op = RASQAL_EXPR_GT;
+    else if(op == RASQAL_EXPR_GT)
+      op = RASQAL_EXPR_LT;
+    else if(op == RASQAL_EXPR_LE)
+      op = RASQAL_EXPR_GE;
+    else if(op == RASQAL_EXPR_GE)
+      op = RASQAL_EXPR_LE;
+  }
+
+  if(var_expr->literal->type != RASQAL_LITERAL_VARIABLE)
+    return 1;
+
+  type = value_expr->literal->type;
+  if(type != RASQAL_LITERAL_INTEGER && type != RASQAL_LITERAL_DOUBLE)
+    return 1;
+
+  column = rasqal_rowsource_get_variable_offset_by_name(rowsource,
+                                                        var_expr->literal->value.variable->name);
+  if(column < 0)
+    return 1;
+
+  if(con->numeric_conditions_count == RASQAL_FILTER_NUMERIC_CONDITIONS_MAX)
+    return 1;
+
+  cond = &con->numeric_conditions[con->numeric_conditions_count++];
+  cond->column = column;
+  cond->op = op;
+  cond->literal = value_expr->literal;
+
+  return 0;
+}
+
+
 static int
 rasqal_filter_rowsource_ensure_variables(rasqal_rowsource* rowsource,
                                          void *user_data)
@@ -80,6 +179,11 @@ rasqal_filter_rowsource_ensure_variables(rasqal_rowsource* rowsource,
   if(rasqal_rowsource_copy_variables(rowsource, con->rowsource))
     return 1;
   
+  con->numeric_conditions_count = 0;
+  con->residual_expr = rasqal_filter_rowsource_add_numeric_conditions(rowsource,
+                                                                      con,
+                                                                      con->expr);
+
   return 0;
 }
 
@@ -168,6 +272,89 @@ rasqal_filter_rowsource_read_row(rasqal_rowsource* rowsource, void *user_data)
 }
 
 
+static int
+rasqal_filter_rowsource_read_batch(rasqal_rowsource* rowsource,
+                                   void *user_data,
+                                   rasqal_row_batch* batch)
+{
+  rasqal_query *query = rowsource->query;
+  rasqal_filter_rowsource_context *con;
+  int i;
+
+  con = (rasqal_filter_rowsource_context*)user_data;
+
+  /* Read input batches into @batch until some rows pass, narrowing
+   * the selection vector in place */
+  while(1) {
+    int rc;
+    int selected = 0;
+    int residual = con->residual_expr;
+    int j;
+
+    rc = rasqal_rowsource_read_batch(con->rowsource, batch);
+    if(rc < 0)
+      return 1;
+    if(!rc)
+      break;
+
+    /* Apply numeric comparison conjuncts over the whole batch first.
+     * Rows they reject cannot pass @expr; if any condition could not
+     * be applied, the full expression is evaluated on the survivors.
+     */
+    for(j = 0; j < con->numeric_conditions_count && batch->selected_count; j++) {
+      rasqal_filter_numeric_condition* cond = &con->numeric_conditions[j];
+
+      rc = rasqal_row_batch_select_numeric_compare(batch, cond->column,
+                                                   cond->op, cond->literal);
+      if(rc < 0)
+        return 1;
+      if(rc > 0)
+        residual = 1;
+    }
+
+    if(!residual) {
+      if(batch->selected_count)
+        break;
+      continue;
+    }
+
+    for(i = 0; i < batch->selected_count; i++) {
+      int row_i = batch->selection[i];
+      rasqal_literal* result;
+      int bresult = 1;
+      int error = 0;
+
+      if(rasqal_row_batch_bind_variables(batch, row_i))
+        return 1;
+
+      result = rasqal_expression_evaluate2(con->expr, query->eval_context,
+                                           &error);
+      if(error) {
+        bresult = 0;
+      } else {
+        error = 0;
+        bresult = rasqal_literal_as_boolean(result, &error);
+        rasqal_free_literal(result);
+      }
+
+      if(bresult)
+        batch->selection[selected++] = row_i;
+    }
+
+    RASQAL_DEBUG3("filter batch selected %d of %d rows\n", selected,
+                  batch->selected_count);
+    batch->selected_count = selected;
+    if(selected)
+      break;
+  }
+
+  for(i = 0; i < batch->selected_count; i++)
+    batch->offsets[batch->selection[i]] = con->offset++;
+
+  return 0;
+}
+
+
 static int
 rasqal_filter_rowsource_reset(rasqal_rowsource* rowsource, void *user_data)
 {
@@ -192,7 +379,7 @@ rasqal_filter_rowsource_get_inner_rowsource(rasqal_rowsource* rowsource,
 
 
 static const rasqal_rowsource_handler rasqal_filter_rowsource_handler = {
-  /* .version =          */ 1,
+  /* .version =          */ 2,
   "filter",
   /* .init =             */ rasqal_filter_rowsource_init,
   /* .finish =           */ rasqal_filter_rowsource_finish,
@@ -203,6 +390,7 @@ static const rasqal_rowsource_handler rasqal_filter_rowsource_handler = {
   /* .set_requirements = */ NULL,
   /* .get_inner_rowsource = */ rasqal_filter_rowsource_get_inner_rowsource,
   /* .set_origin =       */ NULL,
+  /* .read_batch =       */ rasqal_filter_rowsource_read_batch
 };
 
 
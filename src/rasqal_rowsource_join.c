@@ -137,7 +137,8 @@ rasqal_join_rowsource_init(rasqal_rowsource* rowsource, void *user_data)
     /* free expression always */
     rasqal_free_expression(con->expr); con->expr = NULL;
 
-    if(con->join_type == RASQAL_JOIN_TYPE_NATURAL) {
+    if(con->join_type == RASQAL_JOIN_TYPE_NATURAL ||
+       con->join_type == RASQAL_JOIN_TYPE_SEMI) {
       if(!bresult) {
         /* Constraint is always false so row source is finished */
         con->state = JS_FINISHED;
@@ -230,6 +231,13 @@ rasqal_join_rowsource_ensure_variables(rasqal_rowsource* rowsource,
     rasqal_variable* v;
     int offset;
     
+    if(con->join_type == RASQAL_JOIN_TYPE_SEMI ||
+       con->join_type == RASQAL_JOIN_TYPE_ANTI) {
+      /* right variables are never returned */
+      con->right_map[i] = -1;
+      continue;
+    }
+
     v = rasqal_rowsource_get_variable_by_offset(con->right, i);
     if(!v)
       break;
@@ -299,18 +307,28 @@ rasqal_join_rowsource_build_merged_row(rasqal_rowsource* rowsource,
 }
 
 
-static rasqal_row*
-rasqal_join_rowsource_read_row(rasqal_rowsource* rowsource, void *user_data)
+/*
+ * rasqal_join_rowsource_next_match:
+ * @rowsource: join rowsource
+ * @con: join rowsource context
+ * @right_row_p: pointer to store matching right row
+ *
+ * INTERNAL - Advance the join to the next output row
+ *
+ * On a match the output row is the merge of con->left_row with the
+ * right row stored in *@right_row_p, which is NULL when the left row
+ * is returned alone for a LEFT join.  The right row becomes owned by
+ * the caller.
+ *
+ * Return value: non-0 if a match was found, 0 when finished
+ */
+static int
+rasqal_join_rowsource_next_match(rasqal_rowsource* rowsource,
+                                 rasqal_join_rowsource_context* con,
+                                 rasqal_row** right_row_p)
 {
-  rasqal_join_rowsource_context* con;
-  rasqal_row* row = NULL;
   rasqal_query *query = rowsource->query;
 
-  con = (rasqal_join_rowsource_context*)user_data;
-
-  if(con->failed || con->state == JS_FINISHED)
-    return NULL;
-
   while(1) {
     rasqal_row *right_row;
     int bresult = 1;
@@ -338,7 +356,7 @@ rasqal_join_rowsource_read_row(rasqal_rowsource* rowsource, void *user_data)
 
       if(!con->left_row) {
         con->state = JS_FINISHED;
-        return NULL;
+        return 0;
       }
 
       con->right_rows_joined_count = 0;
@@ -366,13 +384,14 @@ rasqal_join_rowsource_read_row(rasqal_rowsource* rowsource, void *user_data)
       /* if all right table returned no bindings, return left row */
       if(!con->right_rows_joined_count) {
         /* otherwise return LEFT or RIGHT row only */
-        if(con->join_type == RASQAL_JOIN_TYPE_LEFT) {
+        if(con->join_type == RASQAL_JOIN_TYPE_LEFT ||
+           con->join_type == RASQAL_JOIN_TYPE_ANTI) {
           /* LEFT JOIN - add left row if expr fails or not compatible */
           if(con->left_row) {
             con->right_rows_joined_count++;
         
-            row = rasqal_join_rowsource_build_merged_row(rowsource, con, NULL);
-            break;
+            *right_row_p = NULL;
+            return 1;
           }
         }
       }
@@ -432,9 +451,8 @@ rasqal_join_rowsource_read_row(rasqal_rowsource* rowsource, void *user_data)
       if(compatible && bresult && right_row) {
         con->right_rows_joined_count++;
 
-        /* consumes right_row */
-        row = rasqal_join_rowsource_build_merged_row(rowsource, con, right_row);
-        break;
+        *right_row_p = right_row;
+        return 1;
       }
       
     } else if(con->join_type == RASQAL_JOIN_TYPE_LEFT) {
@@ -447,9 +465,9 @@ rasqal_join_rowsource_read_row(rasqal_rowsource* rowsource, void *user_data)
 
         /* No constraint OR constraint & compatible so return merged row */
 
-        /* Compute row only now it is known to be needed (consumes right_row) */
-        row = rasqal_join_rowsource_build_merged_row(rowsource, con, right_row);
-        break;
+        /* Row is only computed by the caller now it is known to be needed */
+        *right_row_p = right_row;
+        return 1;
       }
 
 #if 0    
@@ -484,11 +502,46 @@ rasqal_join_rowsource_read_row(rasqal_rowsource* rowsource, void *user_data)
        */
 
     } /* end if LEFT JOIN */
+    else if(compatible && bresult && right_row) {
+      /* SEMI or ANTI JOIN: the first match decides the left row so
+       * stop reading the right rowsource */
+      rasqal_free_row(right_row);
+      con->state = JS_START;
+
+      if(con->join_type == RASQAL_JOIN_TYPE_SEMI) {
+        *right_row_p = NULL;
+        return 1;
+      }
+
+      /* ANTI JOIN: left row has a match so is not returned */
+      continue;
+    }
 
     if(right_row)
       rasqal_free_row(right_row);
       
   } /* end while */
+}
+
+
+static rasqal_row*
+rasqal_join_rowsource_read_row(rasqal_rowsource* rowsource, void *user_data)
+{
+  rasqal_join_rowsource_context* con;
+  rasqal_row* row = NULL;
+  rasqal_row *right_row = NULL;
+
+  con = (rasqal_join_rowsource_context*)user_data;
+
+  if(con->failed || con->state == JS_FINISHED)
+    return NULL;
+
+  if(rasqal_join_rowsource_next_match(rowsource, con, &right_row)) {
+    /* consumes right_row */
+    row = rasqal_join_rowsource_build_merged_row(rowsource, con, right_row);
+    if(!row)
+      con->failed = 1;
+  }
 
   if(row) {
     rasqal_row_set_rowsource(row, rowsource);
@@ -501,6 +554,65 @@ rasqal_join_rowsource_read_row(rasqal_rowsource* rowsource, void *user_data)
 }
 
 
+static int
+rasqal_join_rowsource_read_batch(rasqal_rowsource* rowsource, void *user_data,
+                                 rasqal_row_batch* batch)
+{
+  rasqal_join_rowsource_context* con;
+
+  con = (rasqal_join_rowsource_context*)user_data;
+
+  /* Merge matches straight into the batch columns; consumers bind
+   * variables from the batch as needed */
+  while(!RASQAL_ROW_BATCH_IS_FULL(batch)) {
+    rasqal_row *right_row = NULL;
+    int row_i;
+    int i;
+
+    /* a failure is an error, not the end of the rows */
+    if(con->failed)
+      return 1;
+
+    if(con->state == JS_FINISHED)
+      break;
+
+    if(!rasqal_join_rowsource_next_match(rowsource, con, &right_row))
+      break;
+
+    row_i = rasqal_row_batch_add_empty_row(batch);
+    if(row_i < 0) {
+      if(right_row)
+        rasqal_free_row(right_row);
+      con->failed = 1;
+      return 1;
+    }
+
+    for(i = 0; i < con->left_row->size; i++) {
+      rasqal_literal *l = con->left_row->values[i];
+      if(l)
+        RASQAL_ROW_BATCH_VALUE(batch, i, row_i) = rasqal_new_literal_from_literal(l);
+    }
+
+    if(right_row) {
+      for(i = 0; i < right_row->size; i++) {
+        rasqal_literal *l = right_row->values[i];
+        int dest_i = con->right_map[i];
+        if(l && !RASQAL_ROW_BATCH_VALUE(batch, dest_i, row_i))
+          RASQAL_ROW_BATCH_VALUE(batch, dest_i, row_i) = rasqal_new_literal_from_literal(l);
+      }
+
+      rasqal_free_row(right_row);
+    }
+
+    batch->offsets[row_i] = con->offset++;
+  }
+
+  rasqal_row_batch_select_all(batch);
+
+  return 0;
+}
+
+
 static int
 rasqal_join_rowsource_reset(rasqal_rowsource* rowsource, void *user_data)
 {
@@ -537,7 +649,7 @@ rasqal_join_rowsource_get_inner_rowsource(rasqal_rowsource* rowsource,
 
 
 static const rasqal_rowsource_handler rasqal_join_rowsource_handler = {
-  /* .version = */ 1,
+  /* .version = */ 2,
   "join",
   /* .init = */ rasqal_join_rowsource_init,
   /* .finish = */ rasqal_join_rowsource_finish,
@@ -548,6 +660,7 @@ static const rasqal_rowsource_handler rasqal_join_rowsource_handler = {
   /* .set_requirements = */ NULL,
   /* .get_inner_rowsource = */ rasqal_join_rowsource_get_inner_rowsource,
   /* .set_origin = */ NULL,
+  /* .read_batch = */ rasqal_join_rowsource_read_batch
 };
 
 
@@ -585,9 +698,11 @@ rasqal_new_join_rowsource(rasqal_world *world,
   if(!world || !query || !left || !right)
     goto fail;
 
-  /* only left outer join and cross join supported */
+  /* only left outer join, cross join, semi join and anti join supported */
   if(join_type != RASQAL_JOIN_TYPE_LEFT &&
-     join_type != RASQAL_JOIN_TYPE_NATURAL)
+     join_type != RASQAL_JOIN_TYPE_NATURAL &&
+     join_type != RASQAL_JOIN_TYPE_SEMI &&
+     join_type != RASQAL_JOIN_TYPE_ANTI)
     goto fail;
   
   con = RASQAL_CALLOC(rasqal_join_rowsource_context*, 1, sizeof(*con));
@@ -654,23 +769,28 @@ const char* const join_2_data_3x2_rows[] =
 };
 
 
+/* there is one variable 'b' that is joined on */
+#define EXPECTED_COLUMNS_COUNT (2 + 3 - 1)
+const char* const join_result_vars[] = { "a" , "b" , "c", "d" };
+
+/* semi and anti joins return only the left columns */
+#define EXPECTED_LEFT_COLUMNS_COUNT 2
+
 typedef struct {
   rasqal_join_type join_type;
   int expected;
+  int expected_size;
 } join_test_config_type;
 
-#define JOIN_TESTS_COUNT 2
+#define JOIN_TESTS_COUNT 4
 const join_test_config_type join_test_config[JOIN_TESTS_COUNT] = { 
-  { RASQAL_JOIN_TYPE_NATURAL, 2 },
-  { RASQAL_JOIN_TYPE_LEFT, 3 },
+  { RASQAL_JOIN_TYPE_NATURAL, 2, EXPECTED_COLUMNS_COUNT },
+  { RASQAL_JOIN_TYPE_LEFT, 3, EXPECTED_COLUMNS_COUNT },
+  { RASQAL_JOIN_TYPE_SEMI, 2, EXPECTED_LEFT_COLUMNS_COUNT },
+  { RASQAL_JOIN_TYPE_ANTI, 1, EXPECTED_LEFT_COLUMNS_COUNT },
 };
 
 
-/* there is one variable 'b' that is joined on */
-#define EXPECTED_COLUMNS_COUNT (2 + 3 - 1)
-const char* const join_result_vars[] = { "a" , "b" , "c", "d" };
-
-
 int
 main(int argc, char *argv[]) 
 {
@@ -685,7 +805,6 @@ main(int argc, char *argv[])
   int failures = 0;
   rasqal_variables_table* vt;
   int size;
-  int expected_size = EXPECTED_COLUMNS_COUNT;
   int i;
   raptor_sequence* vars_seq = NULL;
   int test_count;
@@ -699,6 +818,7 @@ main(int argc, char *argv[])
   for(test_count = 0; test_count < JOIN_TESTS_COUNT; test_count++) {
     rasqal_join_type join_type = join_test_config[test_count].join_type;
     int expected_count = join_test_config[test_count].expected;
+    int expected_size = join_test_config[test_count].expected_size;
     int vars_count;
 
     fprintf(stderr, "%s: test #%d  join type %d\n", program, test_count,
@@ -57,6 +57,9 @@ typedef struct
   /* variables projection array: [output row var index]=input row var index */
   int* projection;
 
+  /* batch of input rows for read_batch() */
+  rasqal_row_batch* batch;
+
 } rasqal_project_rowsource_context;
 
 
@@ -127,6 +130,9 @@ rasqal_project_rowsource_finish(rasqal_rowsource* rowsource, void *user_data)
   if(con->projection)
     RASQAL_FREE(int*, con->projection);
   
+  if(con->batch)
+    rasqal_free_row_batch(con->batch);
+  
   RASQAL_FREE(rasqal_project_rowsource_context, con);
 
   return 0;
@@ -197,6 +203,89 @@ rasqal_project_rowsource_read_row(rasqal_rowsource* rowsource, void *user_data)
 }
 
 
+static int
+rasqal_project_rowsource_read_batch(rasqal_rowsource* rowsource,
+                                    void *user_data,
+                                    rasqal_row_batch* batch)
+{
+  rasqal_project_rowsource_context *con;
+  rasqal_row_batch* input;
+  rasqal_query *query = rowsource->query;
+  int has_expressions = 0;
+  int i;
+  int rc;
+
+  con = (rasqal_project_rowsource_context*)user_data;
+
+  if(!con->batch) {
+    con->batch = rasqal_new_row_batch(rowsource->world, 0, batch->capacity);
+    if(!con->batch)
+      return 1;
+  }
+  input = con->batch;
+  input->limit = batch->limit;
+
+  rc = rasqal_rowsource_read_batch(con->rowsource, input);
+  if(rc <= 0)
+    return (rc < 0);
+
+  for(i = 0; i < rowsource->size; i++) {
+    if(con->projection[i] < 0) {
+      has_expressions = 1;
+      break;
+    }
+  }
+
+  for(i = 0; i < input->selected_count; i++) {
+    int input_i = input->selection[i];
+    int row_i;
+    int column;
+
+    row_i = rasqal_row_batch_add_empty_row(batch);
+    if(row_i < 0)
+      return 1;
+
+    batch->offsets[row_i] = input->offsets[input_i];
+    batch->group_ids[row_i] = input->group_ids[input_i];
+
+    /* Expressions are evaluated over the input row variables */
+    if(has_expressions && rasqal_row_batch_bind_variables(input, input_i))
+      return 1;
+
+    for(column = 0; column < rowsource->size; column++) {
+      int offset = con->projection[column];
+
+      if(offset >= 0) {
+        rasqal_literal* l = RASQAL_ROW_BATCH_VALUE(input, offset, input_i);
+        if(l)
+          RASQAL_ROW_BATCH_VALUE(batch, column, row_i) = rasqal_new_literal_from_literal(l);
+      } else {
+        rasqal_variable* v;
+
+        v = (rasqal_variable*)raptor_sequence_get_at(con->projection_variables, column);
+        if(v && v->expression) {
+          int error = 0;
+
+          if(v->value)
+            rasqal_free_literal(v->value);
+
+          v->value = rasqal_expression_evaluate2(v->expression,
+                                                 query->eval_context,
+                                                 &error);
+          /* Errors are ignored as for read_row() */
+          if(!error)
+            RASQAL_ROW_BATCH_VALUE(batch, column, row_i) = rasqal_new_literal_from_literal(v->value);
+        }
+      }
+    }
+  }
+
+  rasqal_row_batch_select_all(batch);
+
+  return 0;
+}
+
+
 static int
 rasqal_project_rowsource_reset(rasqal_rowsource* rowsource, void *user_data)
 {
@@ -221,7 +310,7 @@ rasqal_project_rowsource_get_inner_rowsource(rasqal_rowsource* rowsource,
 
 
 static const rasqal_rowsource_handler rasqal_project_rowsource_handler = {
-  /* .version =          */ 1,
+  /* .version =          */ 2,
   "project",
   /* .init =             */ rasqal_project_rowsource_init,
   /* .finish =           */ rasqal_project_rowsource_finish,
@@ -232,6 +321,7 @@ static const rasqal_rowsource_handler rasqal_project_rowsource_handler = {
   /* .set_requirements = */ NULL,
   /* .get_inner_rowsource = */ rasqal_project_rowsource_get_inner_rowsource,
   /* .set_origin =       */ NULL,
+  /* .read_batch =       */ rasqal_project_rowsource_read_batch
 };
 
 
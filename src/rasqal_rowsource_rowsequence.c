@@ -219,7 +219,7 @@ static const rasqal_rowsource_handler rasqal_rowsequence_rowsource_handler = {
 /**
  * rasqal_new_rowsequence_rowsource:
  * @world: world object
- * @query: query object
+ * @query: query object (or NULL)
  * @vt: variables table
  * @rows_seq: input sequence of #rasqal_row
  * @vars_seq: input sequence of #rasqal_variable for all rows in @rows_seq
@@ -245,7 +245,7 @@ rasqal_new_rowsequence_rowsource(rasqal_world *world,
   rasqal_rowsequence_rowsource_context* con;
   int flags = 0;
   
-  if(!world || !query || !vt || !vars_seq)
+  if(!world || !vt || !vars_seq)
     return NULL;
 
   if(!raptor_sequence_size(vars_seq))
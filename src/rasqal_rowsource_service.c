@@ -54,13 +54,20 @@ typedef struct
 } rasqal_service_rowsource_context;
 
 
+/*
+ * rasqal_service_rowsource_execute:
+ * @con: service rowsource context
+ *
+ * INTERNAL - Read the service response when the rowsource is first used
+ *
+ * The request was started when the rowsource was made, so this only
+ * waits for the response if it has not started yet.
+ *
+ * Return value: non-0 on failure
+ */
 static int
-rasqal_service_rowsource_init(rasqal_rowsource* rowsource, void *user_data)
+rasqal_service_rowsource_execute(rasqal_service_rowsource_context* con)
 {
-  rasqal_service_rowsource_context* con;
-
-  con = (rasqal_service_rowsource_context*)user_data;
-
   con->rowsource = rasqal_service_execute_as_rowsource(con->svc,
                                                        con->query->vars_table);
 
@@ -70,9 +77,11 @@ rasqal_service_rowsource_init(rasqal_rowsource* rowsource, void *user_data)
     if(con->flags & RASQAL_ENGINE_BITFLAG_SILENT) {
       con->rowsource = rasqal_new_empty_rowsource(con->query->world,
                                                   con->query);
-      return 0;
+      return !con->rowsource;
     }
 
+    /* the service has logged the error */
+    con->query->failed = 1;
     return 1;
   }
   
@@ -107,6 +116,9 @@ rasqal_service_rowsource_ensure_variables(rasqal_rowsource* rowsource,
   
   con = (rasqal_service_rowsource_context*)user_data;
 
+  if(rasqal_service_rowsource_execute(con))
+    return 1;
+
   rc = rasqal_rowsource_ensure_variables(con->rowsource);
   if(rc)
     return rc;
@@ -116,14 +128,46 @@ rasqal_service_rowsource_ensure_variables(rasqal_rowsource* rowsource,
   return rc;
 }
 
+/*
+ * rasqal_service_rowsource_check_failed:
+ * @con: service rowsource context
+ *
+ * INTERNAL - Report a service response that stopped part way through
+ *
+ * The results reader ends the rows at the end of the data it was
+ * given so the retrieval is checked once there are no more rows.
+ * Silent services keep the rows that were read.
+ *
+ * Return value: non-0 if the query failed
+ */
+static int
+rasqal_service_rowsource_check_failed(rasqal_service_rowsource_context* con)
+{
+  if(!rasqal_service_get_failed(con->svc) ||
+     (con->flags & RASQAL_ENGINE_BITFLAG_SILENT))
+    return 0;
+
+  rasqal_query_simple_error(con->query,
+                            "Failed to fetch all results from service");
+  return 1;
+}
+
 static rasqal_row*
 rasqal_service_rowsource_read_row(rasqal_rowsource* rowsource, void *user_data)
 {
   rasqal_service_rowsource_context* con;
+  rasqal_row* row;
   
   con = (rasqal_service_rowsource_context*)user_data;
 
-  return rasqal_rowsource_read_row(con->rowsource);
+  if(!con->rowsource)
+    return NULL;
+
+  row = rasqal_rowsource_read_row(con->rowsource);
+  if(!row)
+    rasqal_service_rowsource_check_failed(con);
+
+  return row;
 }
 
 static raptor_sequence*
@@ -131,16 +175,26 @@ rasqal_service_rowsource_read_all_rows(rasqal_rowsource* rowsource,
                                        void *user_data)
 {
   rasqal_service_rowsource_context* con;
+  raptor_sequence* seq;
 
   con = (rasqal_service_rowsource_context*)user_data;
 
-  return rasqal_rowsource_read_all_rows(con->rowsource);
+  if(!con->rowsource)
+    return NULL;
+
+  seq = rasqal_rowsource_read_all_rows(con->rowsource);
+  if(seq && rasqal_service_rowsource_check_failed(con)) {
+    raptor_free_sequence(seq);
+    seq = NULL;
+  }
+
+  return seq;
 }
 
 static const rasqal_rowsource_handler rasqal_service_rowsource_handler = {
   /* .version = */ 1,
   "service",
-  /* .init = */ rasqal_service_rowsource_init,
+  /* .init = */ NULL,
   /* .finish = */ rasqal_service_rowsource_finish,
   /* .ensure_variables = */ rasqal_service_rowsource_ensure_variables,
   /* .read_row = */ rasqal_service_rowsource_read_row,
@@ -204,6 +258,16 @@ rasqal_new_service_rowsource(rasqal_world *world, rasqal_query* query,
   con->query = query;
   con->flags = rs_flags;
 
+  rasqal_service_set_request_limits(svc,
+                                    query->features[RASQAL_FEATURE_SERVICE_TIMEOUT],
+                                    query->features[RASQAL_FEATURE_SERVICE_CONCURRENCY]);
+
+  /* Start the request as the query starts so that the independent
+   * services of a query are retrieved at the same time, up to the
+   * concurrency limit, rather than one by one as each is read.  A
+   * failure is reported when the rowsource is read. */
+  rasqal_service_prefetch(svc);
+
   return rasqal_new_rowsource_from_handler(world, query,
                                            con,
                                            &rasqal_service_rowsource_handler,
@@ -57,6 +57,9 @@ typedef struct
 
   /* offset for output row */
   int output_offset;
+
+  /* non-0 when read_batch() has passed the end of the result range */
+  int finished;
 } rasqal_slice_rowsource_context;
 
 
@@ -117,6 +120,11 @@ rasqal_slice_rowsource_read_row(rasqal_rowsource* rowsource, void *user_data)
   
   con = (rasqal_slice_rowsource_context*)user_data;
 
+  /* Do not read the input at all once past the end of the range */
+  if(con->row_limit >= 0 &&
+     con->input_offset > con->row_limit + (con->row_offset > 0 ? con->row_offset : 0))
+    return NULL;
+
   while(1) {
     int check;
 
@@ -154,6 +162,76 @@ rasqal_slice_rowsource_read_row(rasqal_rowsource* rowsource, void *user_data)
 }
 
 
+static int
+rasqal_slice_rowsource_read_batch(rasqal_rowsource* rowsource,
+                                  void *user_data,
+                                  rasqal_row_batch* batch)
+{
+  rasqal_slice_rowsource_context *con;
+  int saved_limit = batch->limit;
+  int i;
+
+  con = (rasqal_slice_rowsource_context*)user_data;
+
+  while(!con->finished) {
+    int selected = 0;
+    int rc;
+
+    /* Never ask the input for more rows than the range can use */
+    if(con->row_limit >= 0) {
+      int remaining;
+
+      remaining = con->row_limit + (con->row_offset > 0 ? con->row_offset : 0)
+                  - con->input_offset + 1;
+      if(remaining <= 0) {
+        con->finished = 1;
+        break;
+      }
+      if(remaining < batch->limit)
+        batch->limit = remaining;
+    }
+
+    rc = rasqal_rowsource_read_batch(con->rowsource, batch);
+    batch->limit = saved_limit;
+    if(rc < 0)
+      return 1;
+    if(!rc)
+      break;
+
+    for(i = 0; i < batch->selected_count; i++) {
+      int check;
+
+      check = rasqal_query_check_limit_offset_core(con->input_offset,
+                                                   con->row_limit,
+                                                   con->row_offset);
+      con->input_offset++;
+
+      /* finished if beyond result range */
+      if(check > 0) {
+        con->finished = 1;
+        break;
+      }
+
+      /* in range, keep row */
+      if(!check)
+        batch->selection[selected++] = batch->selection[i];
+    }
+
+    batch->selected_count = selected;
+    if(selected)
+      break;
+  }
+
+  if(con->finished && !batch->selected_count)
+    rasqal_row_batch_clear(batch);
+
+  for(i = 0; i < batch->selected_count; i++)
+    batch->offsets[batch->selection[i]] = con->output_offset++;
+
+  return 0;
+}
+
+
 static int
 rasqal_slice_rowsource_reset(rasqal_rowsource* rowsource, void *user_data)
 {
@@ -163,6 +241,7 @@ rasqal_slice_rowsource_reset(rasqal_rowsource* rowsource, void *user_data)
 
   con->input_offset = 1;
   con->output_offset = 1;
+  con->finished = 0;
 
   return rasqal_rowsource_reset(con->rowsource);
 }
@@ -183,7 +262,7 @@ rasqal_slice_rowsource_get_inner_rowsource(rasqal_rowsource* rowsource,
 
 
 static const rasqal_rowsource_handler rasqal_slice_rowsource_handler = {
-  /* .version =          */ 1,
+  /* .version =          */ 2,
   "slice",
   /* .init =             */ rasqal_slice_rowsource_init,
   /* .finish =           */ rasqal_slice_rowsource_finish,
@@ -194,6 +273,7 @@ static const rasqal_rowsource_handler rasqal_slice_rowsource_handler = {
   /* .set_requirements = */ NULL,
   /* .get_inner_rowsource = */ rasqal_slice_rowsource_get_inner_rowsource,
   /* .set_origin =       */ NULL,
+  /* .read_batch =       */ rasqal_slice_rowsource_read_batch
 };
 
 
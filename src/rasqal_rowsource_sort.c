@@ -105,6 +105,9 @@ rasqal_sort_rowsource_process(rasqal_rowsource* rowsource,
                               rasqal_sort_rowsource_context* con)
 {
   int offset = 0;
+  rasqal_rowsort_keys* keys = NULL;
+  raptor_sequence* rows = NULL;
+  int rc = 0;
 
   /* already processed */
   if(con->seq)
@@ -114,6 +117,21 @@ rasqal_sort_rowsource_process(rasqal_rowsource* rowsource,
                                  (raptor_data_print_handler)rasqal_row_print);
   if(!con->seq)
     return 1;
+
+  /* Without DISTINCT, try sorting by binary keys; the rows are kept
+   * in order until it is known if all of them have usable keys */
+  if(!con->distinct) {
+    keys = rasqal_engine_new_rowsort_keys(rowsource->query->compare_flags,
+                                          con->order_seq);
+    if(keys) {
+      rows = raptor_new_sequence((raptor_data_free_handler)rasqal_free_row,
+                                 (raptor_data_print_handler)rasqal_row_print);
+      if(!rows) {
+        rasqal_engine_free_rowsort_keys(keys);
+        return 1;
+      }
+    }
+  }
   
   while(1) {
     rasqal_row* row;
@@ -124,17 +142,42 @@ rasqal_sort_rowsource_process(rasqal_rowsource* rowsource,
 
     if(rasqal_row_set_order_size(row, con->order_size)) {
       rasqal_free_row(row);
-      return 1;
+      rc = 1;
+      goto done;
     }
 
-    rasqal_engine_rowsort_calculate_order_values(rowsource->query, con->order_seq, row);
+    rasqal_engine_rowsort_calculate_order_values(rowsource->query, con->order_seq,
+                                                 row, keys);
 
     row->offset = offset;
 
+    if(rows) {
+      /* after this, row is owned by rows */
+      if(raptor_sequence_push(rows, row)) {
+        rc = 1;
+        goto done;
+      }
+      offset++;
+      continue;
+    }
+
     /* after this, row is owned by map */
     if(!rasqal_engine_rowsort_map_add_row(con->map, row))
       offset++;
   }
+
+  if(rows) {
+    if(rasqal_engine_rowsort_keys_usable(keys)) {
+      rc = rasqal_engine_rowsort_keys_sort(keys, rows, con->seq);
+      goto done;
+    }
+
+    /* some keys were not usable so sort by comparing the values */
+    while(raptor_sequence_size(rows) > 0) {
+      rasqal_row* row = (rasqal_row*)raptor_sequence_unshift(rows);
+      rasqal_engine_rowsort_map_add_row(con->map, row);
+    }
+  }
   
 #ifdef RASQAL_DEBUG
   fputs("resulting ", DEBUG_FH);
@@ -146,7 +189,13 @@ rasqal_sort_rowsource_process(rasqal_rowsource* rowsource,
   rasqal_engine_rowsort_map_to_sequence(con->map, con->seq);
   rasqal_free_map(con->map); con->map = NULL;
 
-  return 0;
+  done:
+  if(rows)
+    raptor_free_sequence(rows);
+  if(keys)
+    rasqal_engine_free_rowsort_keys(keys);
+
+  return rc;
 }
 
 
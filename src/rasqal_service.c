@@ -38,13 +38,30 @@
 #include <unistd.h>
 #endif
 #include <stdarg.h>
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
 
 #include "rasqal.h"
 #include "rasqal_internal.h"
 
 
+#ifndef STANDALONE
+
 #define DEFAULT_FORMAT "application/sparql-results+xml"
 
+/* bytes buffered between the HTTP transfer and the results reader */
+#define RASQAL_SERVICE_STREAM_BUFFER_SIZE 65536
+
+
+#ifdef HAVE_PTHREAD
+/* idle SERVICE connections kept open in a world */
+#define RASQAL_SERVICE_MAX_IDLE_CONNECTIONS 8
+
+typedef struct rasqal_service_stream_s rasqal_service_stream;
+
+static void rasqal_service_stream_finish(void *user_data);
+#endif
 
 struct rasqal_service_s
 {
@@ -60,6 +77,16 @@ struct rasqal_service_s
   /* URL retrieval fields */
   raptor_www* www;
   int started;
+  /* connection timeout in seconds or 0 for the default */
+  int timeout;
+  /* maximum number of requests retrieved at once or 0 for no limit */
+  int concurrency;
+#ifdef HAVE_PTHREAD
+  /* response being retrieved by rasqal_service_prefetch() */
+  rasqal_service_stream* stream;
+#endif
+  /* set if the last retrieval failed, even after part of the response */
+  int failed;
 
   /* response fields */
   raptor_uri* final_uri;
@@ -189,6 +216,12 @@ rasqal_free_service(rasqal_service* svc)
   if(svc->data_graphs)
     raptor_free_sequence(svc->data_graphs);
   
+#ifdef HAVE_PTHREAD
+  /* Ends a prefetched retrieval that was never read */
+  if(svc->stream)
+    rasqal_service_stream_finish(svc->stream);
+#endif
+
   rasqal_service_set_www(svc, NULL);
 
   RASQAL_FREE(rasqal_service, svc);
@@ -201,6 +234,10 @@ rasqal_free_service(rasqal_service* svc)
  * @www: WWW object (or NULL)
  *
  * Set the WWW object to use when executing the service
+ *
+ * When rasqal is built with thread support the response is
+ * retrieved on another thread with a WWW object of its own that
+ * shares the connection of @www.
  * 
  * Return value: non 0 on failure
  **/
@@ -249,6 +286,32 @@ rasqal_service_set_format(rasqal_service* svc, const char *format)
 }
 
 
+/*
+ * rasqal_service_set_request_limits:
+ * @svc: #rasqal_service service object
+ * @timeout: connection timeout in seconds or 0 for the default
+ * @concurrency: maximum number of service requests in the world
+ *   being retrieved at once or 0 for no limit
+ *
+ * INTERNAL - Set limits used when executing the service
+ *
+ * Return value: non 0 on failure
+ */
+int
+rasqal_service_set_request_limits(rasqal_service* svc, int timeout,
+                                  int concurrency)
+{
+  if(timeout < 0 || concurrency < 0)
+    return 1;
+
+  svc->timeout = timeout;
+  svc->concurrency = concurrency;
+
+  return 0;
+}
+
+
+#ifndef HAVE_PTHREAD
 static void
 rasqal_service_write_bytes(raptor_www* www,
                            void *userdata, const void *ptr, 
@@ -266,6 +329,7 @@ rasqal_service_write_bytes(raptor_www* www,
                                             RASQAL_GOOD_CAST(const unsigned char*, ptr),
                                             len, 1);
 }
+#endif
 
 
 static void
@@ -297,234 +361,1237 @@ rasqal_service_content_type_handler(raptor_www* www, void* userdata,
 }
 
 
-/**
- * rasqal_service_execute_as_rowsource:
+/*
+ * rasqal_service_set_www_options:
  * @svc: rasqal service
+ * @www: WWW object to retrieve the service with
  *
- * INTERNAL - Execute a rasqal sparql protocol service to a rowsurce
- *
- * Return value: query results or NULL on failure
+ * INTERNAL - Set the request options of the service on a WWW object
  */
-rasqal_rowsource*
-rasqal_service_execute_as_rowsource(rasqal_service* svc,
-                                    rasqal_variables_table* vars_table)
+static void
+rasqal_service_set_www_options(rasqal_service* svc, raptor_www* www)
 {
-  raptor_iostream* read_iostr = NULL;
-  raptor_uri* read_base_uri = NULL;
-  rasqal_query_results_formatter* read_formatter = NULL;
-  raptor_uri* retrieval_uri = NULL;
-  raptor_stringbuffer* uri_sb = NULL;
-  size_t len;
-  unsigned char* str;
-  raptor_world* raptor_world_ptr = rasqal_world_get_raptor(svc->world);
-  rasqal_rowsource* rowsource = NULL;
-  
-  if(!svc->www) {
-    svc->www = raptor_new_www(raptor_world_ptr);
-
-    if(!svc->www) {
-      rasqal_log_error_simple(svc->world, RAPTOR_LOG_LEVEL_ERROR, NULL,
-                              "Failed to create WWW");
-      goto error;
-    }
-  }
-    
-  svc->started = 0;
-  svc->final_uri = NULL;
-  svc->sb = raptor_new_stringbuffer();
-  svc->content_type = NULL;
-  
   if(svc->format)
-    raptor_www_set_http_accept(svc->www, svc->format);
+    raptor_www_set_http_accept(www, svc->format);
   else
-    raptor_www_set_http_accept(svc->www, DEFAULT_FORMAT);
-
-  raptor_www_set_write_bytes_handler(svc->www,
-                                     rasqal_service_write_bytes, svc);
-  raptor_www_set_content_type_handler(svc->www,
-                                      rasqal_service_content_type_handler, svc);
+    raptor_www_set_http_accept(www, DEFAULT_FORMAT);
 
+  if(svc->timeout > 0)
+    raptor_www_set_connection_timeout(www, svc->timeout);
 
-  /* Construct a URI to retrieve following SPARQL protocol HTTP
-   *  binding from concatenation of
-   *
-   * 1. service_uri
-   * 2. '?'
-   * 3. "query=" query_string
-   * 4. "&default-graph-uri=" background graph URI if any
-   * 5. "&named-graph-uri=" named graph URI for all named graphs
-   * with URI-escaping of the values
-   */
+  raptor_www_set_content_type_handler(www,
+                                      rasqal_service_content_type_handler, svc);
+}
 
-  uri_sb = raptor_new_stringbuffer();
-  if(!uri_sb) {
-    rasqal_log_error_simple(svc->world, RAPTOR_LOG_LEVEL_ERROR, NULL,
-                            "Failed to create stringbuffer");
-    goto error;
-  }
 
-  str = raptor_uri_as_counted_string(svc->service_uri, &len);
-  raptor_stringbuffer_append_counted_string(uri_sb, str, len, 1);
+#ifdef HAVE_PTHREAD
+/*
+ * Streaming service response
+ *
+ * raptor_www_fetch() only returns once the whole response has been
+ * received so it is run in a separate thread.  The response bytes
+ * pass through a fixed size ring buffer to an iostream that the
+ * query results reader rowsource reads from, so rows are decoded as
+ * the bytes arrive and memory use does not grow with the response.
+ * A full buffer blocks the transfer until the reader catches up.
+ *
+ * Raptor URIs and worlds are not thread safe so the retrieval
+ * thread uses a raptor_world and WWW object of its own that no other
+ * thread touches until it has ended.  Only strings cross between the
+ * threads: the final URI, content type and error message of the
+ * retrieval.  The raptor_world comes with a connection to the
+ * endpoint that is kept for the next retrieval from it.
+ *
+ * Each transfer takes one of the service concurrency limit request
+ * slots of the world while it is receiving.  A transfer blocked on a
+ * full buffer gives its slot up until the reader makes space, so a
+ * reader waiting on another request (such as the right side of a
+ * join of two services) cannot be stopped by the limit.
+ *
+ * A SERVICE rowsource starts its retrieval when it is made, as the
+ * query starts, and bind-joins start the requests of the batches
+ * they read ahead, all with rasqal_service_prefetch().  The requests
+ * are retrieved at the same time, up to the service concurrency
+ * limit, rather than one after another.
+ */
+struct rasqal_service_stream_s
+{
+  /* service the response is for */
+  rasqal_service* svc;
+  /* non-0 when holding a reference to @svc; until then @svc owns this */
+  int svc_reference;
 
-  raptor_stringbuffer_append_counted_string(uri_sb,
-                                            RASQAL_GOOD_CAST(const unsigned char*, "?"), 1, 1);
+  /* used by the retrieval thread only while it is running */
+  rasqal_service_connection* connection;
+  raptor_www* www;
+  raptor_uri* retrieval_uri;
+  /* raptor_www_fetch() was called */
+  int fetched;
 
-  if(svc->query_string) {
-    raptor_stringbuffer_append_counted_string(uri_sb,
-                                              RASQAL_GOOD_CAST(const unsigned char*, "query="), 6, 1);
-    raptor_stringbuffer_append_uri_escaped_counted_string(uri_sb,
-                                                          svc->query_string,
-                                                          svc->query_string_len,
-                                                          1);
-  }
+  pthread_t thread;
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
 
+  unsigned char buffer[RASQAL_SERVICE_STREAM_BUFFER_SIZE];
+  size_t start;
+  size_t length;
 
-  if(svc->data_graphs) {
-    rasqal_data_graph* dg;
-    int i;
-    int bg_graph_count;
-    
-    for(i = 0, bg_graph_count = 0;
-        (dg = (rasqal_data_graph*)raptor_sequence_get_at(svc->data_graphs, i));
-        i++) {
-      unsigned char* graph_str;
-      size_t graph_len;
-      raptor_uri* graph_uri;
-      
-      if(dg->flags & RASQAL_DATA_GRAPH_BACKGROUND) {
+  /* response body has started; content type and final URI are known */
+  int started;
+  /* final URI of the retrieval (or NULL) */
+  char* final_uri_string;
+  /* first error logged by the retrieval (or NULL) */
+  char* error;
+  /* @error has been reported to the query */
+  int error_reported;
+  /* transfer has ended */
+  int finished;
+  int failed;
+  /* reader has gone; remaining response is not wanted */
+  int cancelled;
+  /* as @cancelled but guarded by the world service_lock */
+  int abandoned;
+  /* holding a world request slot; used by the retrieval thread only */
+  int has_slot;
+};
 
-        if(bg_graph_count++) {
-          if(bg_graph_count == 2) {
-            /* Warn once, only when the second BG is seen */
-            rasqal_log_warning_simple(svc->world,
-                                      RASQAL_WARNING_LEVEL_MULTIPLE_BG_GRAPHS,
-                                      NULL,
-                                      "Attempted to add multiple background graphs");
-          }
-          /* always skip after first BG */
-          continue;
-        }
-        
-        raptor_stringbuffer_append_counted_string(uri_sb,
-                                                  RASQAL_GOOD_CAST(const unsigned char*, "&default-graph-uri="), 19, 1);
-        graph_uri = dg->uri;
-      } else {
-        raptor_stringbuffer_append_counted_string(uri_sb,
-                                                  RASQAL_GOOD_CAST(const unsigned char*, "&named-graph-uri="), 17, 1);
-        graph_uri = dg->name_uri;
-      }
-      
-      graph_str = raptor_uri_as_counted_string(graph_uri, &graph_len);
-      raptor_stringbuffer_append_uri_escaped_counted_string(uri_sb,
-                                                            RASQAL_GOOD_CAST(const char*, graph_str), graph_len, 1);
-    }
-  }
-  
 
-  str = raptor_stringbuffer_as_string(uri_sb);
+/*
+ * rasqal_free_service_connection:
+ * @conn: service connection
+ *
+ * INTERNAL - Destructor - Close a connection to a service endpoint
+ */
+static void
+rasqal_free_service_connection(rasqal_service_connection* conn)
+{
+  if(conn->www)
+    raptor_free_www(conn->www);
+  if(conn->raptor_world_ptr)
+    raptor_free_world(conn->raptor_world_ptr);
+  if(conn->endpoint)
+    RASQAL_FREE(char*, conn->endpoint);
+
+  RASQAL_FREE(rasqal_service_connection, conn);
+}
 
-  retrieval_uri = raptor_new_uri(raptor_world_ptr, str);
-  if(!retrieval_uri) {
-    rasqal_log_error_simple(svc->world, RAPTOR_LOG_LEVEL_ERROR, NULL,
-                            "Failed to create retrieval URI %s",
-                            raptor_uri_as_string(retrieval_uri));
-    goto error;
-  }
 
-  raptor_free_stringbuffer(uri_sb); uri_sb = NULL;
-  
-  if(raptor_www_fetch(svc->www, retrieval_uri)) {
-    rasqal_log_error_simple(svc->world, RAPTOR_LOG_LEVEL_ERROR, NULL,
-                            "Failed to fetch retrieval URI %s",
-                            raptor_uri_as_string(retrieval_uri));
-    goto error;
-  }
+/*
+ * rasqal_new_service_connection:
+ * @svc: rasqal service
+ *
+ * INTERNAL - Constructor - Make a connection to the endpoint of a service
+ *
+ * The connection is opened by the first retrieval that uses it.
+ *
+ * Return value: new connection or NULL on failure
+ */
+static rasqal_service_connection*
+rasqal_new_service_connection(rasqal_service* svc)
+{
+  rasqal_service_connection* conn;
+  const char* endpoint;
+  size_t len;
 
-  /* Takes ownership of svc->sb */
-  read_iostr = rasqal_new_iostream_from_stringbuffer(raptor_world_ptr,
-                                                     svc->sb);
-  svc->sb = NULL;
-  if(!read_iostr) {
-    rasqal_log_error_simple(svc->world, RAPTOR_LOG_LEVEL_ERROR, NULL,
-                            "Failed to create iostream from string");
-    goto error;
-  }
-    
-  read_base_uri = svc->final_uri ? svc->final_uri : svc->service_uri;
-  read_formatter = rasqal_new_query_results_formatter(svc->world,
-                                                      /* format name */ NULL,
-                                                      svc->content_type,
-                                                      /* format URI */ NULL);
-  if(!read_formatter) {
-    rasqal_log_error_simple(svc->world, RAPTOR_LOG_LEVEL_ERROR, NULL,
-                            "Failed to find query results reader for content type %s returned from %s",
-                            svc->content_type,
-                            raptor_uri_as_string(read_base_uri));
-    goto error;
-  }
+  conn = RASQAL_CALLOC(rasqal_service_connection*, 1, sizeof(*conn));
+  if(!conn)
+    return NULL;
 
-  /* Takes ownership of read_iostr with flags = 1 */
-  rowsource = rasqal_query_results_formatter_get_read_rowsource(svc->world,
-                                                                read_iostr,
-                                                                read_formatter,
-                                                                vars_table,
-                                                                read_base_uri,
-                                                                /* flags */ 1);
-  read_iostr = NULL;
-  if(!rowsource) {
-    rasqal_log_error_simple(svc->world, RAPTOR_LOG_LEVEL_ERROR, NULL,
-                            "Failed to decode %s query results data returned from %s",
-                            svc->content_type,
-                            raptor_uri_as_string(read_base_uri));
-    goto error;
-  }
+  endpoint = RASQAL_GOOD_CAST(const char*,
+                              raptor_uri_as_string(svc->service_uri));
+  len = strlen(endpoint);
+  conn->endpoint = RASQAL_MALLOC(char*, len + 1);
+  if(!conn->endpoint)
+    goto failed;
+  memcpy(conn->endpoint, endpoint, len + 1);
+
+  conn->raptor_world_ptr = raptor_new_world();
+  if(!conn->raptor_world_ptr)
+    goto failed;
+#if RAPTOR_VERSION >= 20009
+  /* the rasqal world raptor_world did the global WWW library setup */
+  raptor_world_set_flag(conn->raptor_world_ptr,
+                        RAPTOR_WORLD_FLAG_WWW_SKIP_INIT_FINISH, 1);
+#endif
+  if(raptor_world_open(conn->raptor_world_ptr))
+    goto failed;
 
+  /* owns the connection that retrievals share */
+  conn->www = raptor_new_www(conn->raptor_world_ptr);
+  if(!conn->www)
+    goto failed;
 
-  error:
-  if(retrieval_uri)
-    raptor_free_uri(retrieval_uri);
+  return conn;
 
-  if(uri_sb)
-    raptor_free_stringbuffer(uri_sb);
+  failed:
+  rasqal_free_service_connection(conn);
 
-  if(read_formatter)
-    rasqal_free_query_results_formatter(read_formatter);
+  return NULL;
+}
 
-  if(read_iostr)
-    raptor_free_iostream(read_iostr);
 
-  if(svc->final_uri) {
-    raptor_free_uri(svc->final_uri);
-    svc->final_uri = NULL;
+/*
+ * rasqal_service_get_connection:
+ * @svc: rasqal service
+ *
+ * INTERNAL - Take an idle connection to the endpoint of a service or make one
+ *
+ * Return value: connection or NULL on failure
+ */
+static rasqal_service_connection*
+rasqal_service_get_connection(rasqal_service* svc)
+{
+  rasqal_world* world = svc->world;
+  rasqal_service_connection* conn;
+  rasqal_service_connection** prev;
+  const char* endpoint;
+
+  endpoint = RASQAL_GOOD_CAST(const char*,
+                              raptor_uri_as_string(svc->service_uri));
+
+  pthread_mutex_lock(&world->service_lock);
+  for(prev = &world->service_connections; (conn = *prev); prev = &conn->next) {
+    if(!strcmp(conn->endpoint, endpoint)) {
+      *prev = conn->next;
+      conn->next = NULL;
+      world->service_connections_count--;
+      break;
+    }
   }
+  pthread_mutex_unlock(&world->service_lock);
 
-  if(svc->content_type) {
-    RASQAL_FREE(char*, svc->content_type);
-    svc->content_type = NULL;
-  }
+  if(!conn)
+    conn = rasqal_new_service_connection(svc);
 
-  if(svc->sb) {
-    raptor_free_stringbuffer(svc->sb);
-    svc->sb = NULL;
-  }
-  
-  return rowsource;
+  return conn;
 }
 
 
-/**
- * rasqal_service_execute:
- * @svc: rasqal service
+/*
+ * rasqal_service_release_connection:
+ * @world: rasqal world
+ * @conn: service connection no retrieval is using
  *
- * Execute a rasqal sparql protocol service
+ * INTERNAL - Keep a connection for the next retrieval from its endpoint
  *
- * Return value: query results or NULL on failure
+ * Only the RASQAL_SERVICE_MAX_IDLE_CONNECTIONS most recently used
+ * connections of the world are kept open.
  */
-rasqal_query_results*
-rasqal_service_execute(rasqal_service* svc)
+static void
+rasqal_service_release_connection(rasqal_world* world,
+                                  rasqal_service_connection* conn)
 {
-  rasqal_query_results* results = NULL;
-  rasqal_variables_table* vars_table;
+  rasqal_service_connection* oldest = NULL;
+
+  raptor_world_set_log_handler(conn->raptor_world_ptr, NULL, NULL);
+
+  pthread_mutex_lock(&world->service_lock);
+  conn->next = world->service_connections;
+  world->service_connections = conn;
+  if(++world->service_connections_count > RASQAL_SERVICE_MAX_IDLE_CONNECTIONS) {
+    rasqal_service_connection** prev = &world->service_connections;
+
+    while((*prev)->next)
+      prev = &(*prev)->next;
+    oldest = *prev;
+    *prev = NULL;
+    world->service_connections_count--;
+  }
+  pthread_mutex_unlock(&world->service_lock);
+
+  if(oldest)
+    rasqal_free_service_connection(oldest);
+}
+
+
+/*
+ * rasqal_service_free_connections:
+ * @world: rasqal world
+ *
+ * INTERNAL - Close the idle SERVICE connections of a world
+ */
+void
+rasqal_service_free_connections(rasqal_world* world)
+{
+  rasqal_service_connection* conn;
+
+  while((conn = world->service_connections)) {
+    world->service_connections = conn->next;
+    rasqal_free_service_connection(conn);
+  }
+  world->service_connections_count = 0;
+}
+
+
+/*
+ * rasqal_service_stream_acquire_slot:
+ * @stream: service stream
+ *
+ * INTERNAL - Wait for a free world request slot and take it
+ *
+ * Called by the retrieval thread without the stream lock held.
+ *
+ * Return value: non-0 if a slot was taken or 0 if the stream was abandoned
+ */
+static int
+rasqal_service_stream_acquire_slot(rasqal_service_stream* stream)
+{
+  rasqal_world* world = stream->svc->world;
+  int limit = stream->svc->concurrency;
+
+  pthread_mutex_lock(&world->service_lock);
+  while(limit > 0 && world->service_requests_active >= limit &&
+        !stream->abandoned)
+    pthread_cond_wait(&world->service_cond, &world->service_lock);
+  if(!stream->abandoned) {
+    world->service_requests_active++;
+    stream->has_slot = 1;
+  }
+  pthread_mutex_unlock(&world->service_lock);
+
+  return stream->has_slot;
+}
+
+
+/*
+ * rasqal_service_stream_release_slot:
+ * @stream: service stream
+ *
+ * INTERNAL - Give up the world request slot of the stream if it has one
+ *
+ * Called by the retrieval thread without the stream lock held.
+ */
+static void
+rasqal_service_stream_release_slot(rasqal_service_stream* stream)
+{
+  rasqal_world* world = stream->svc->world;
+
+  if(!stream->has_slot)
+    return;
+
+  pthread_mutex_lock(&world->service_lock);
+  world->service_requests_active--;
+  pthread_cond_broadcast(&world->service_cond);
+  pthread_mutex_unlock(&world->service_lock);
+
+  stream->has_slot = 0;
+}
+
+
+static void
+rasqal_service_stream_write_bytes(raptor_www* www,
+                                  void *userdata, const void *ptr,
+                                  size_t size, size_t nmemb)
+{
+  rasqal_service_stream* stream = (rasqal_service_stream*)userdata;
+  const unsigned char* p = RASQAL_GOOD_CAST(const unsigned char*, ptr);
+  size_t len = size * nmemb;
+
+  pthread_mutex_lock(&stream->lock);
+
+  if(!stream->started) {
+    raptor_uri* final_uri = raptor_www_get_final_uri(www);
+
+    if(final_uri) {
+      size_t uri_len;
+      unsigned char* uri_str = raptor_uri_as_counted_string(final_uri,
+                                                            &uri_len);
+
+      stream->final_uri_string = RASQAL_MALLOC(char*, uri_len + 1);
+      if(stream->final_uri_string)
+        memcpy(stream->final_uri_string, uri_str, uri_len + 1);
+      raptor_free_uri(final_uri);
+    }
+    stream->started = 1;
+    pthread_cond_broadcast(&stream->cond);
+  }
+
+  while(len > 0 && !stream->cancelled) {
+    size_t end;
+    size_t avail;
+
+    if(stream->length == RASQAL_SERVICE_STREAM_BUFFER_SIZE &&
+       stream->has_slot) {
+      /* let another request run while waiting for the reader */
+      pthread_mutex_unlock(&stream->lock);
+      rasqal_service_stream_release_slot(stream);
+      pthread_mutex_lock(&stream->lock);
+    }
+
+    while(stream->length == RASQAL_SERVICE_STREAM_BUFFER_SIZE &&
+          !stream->cancelled)
+      pthread_cond_wait(&stream->cond, &stream->lock);
+    if(stream->cancelled)
+      break;
+
+    if(!stream->has_slot) {
+      pthread_mutex_unlock(&stream->lock);
+      rasqal_service_stream_acquire_slot(stream);
+      pthread_mutex_lock(&stream->lock);
+      /* an abandoned stream is also cancelled */
+      continue;
+    }
+
+    /* copy into the contiguous free space after the buffered bytes */
+    end = (stream->start + stream->length) % RASQAL_SERVICE_STREAM_BUFFER_SIZE;
+    avail = RASQAL_SERVICE_STREAM_BUFFER_SIZE - stream->length;
+    if(avail > RASQAL_SERVICE_STREAM_BUFFER_SIZE - end)
+      avail = RASQAL_SERVICE_STREAM_BUFFER_SIZE - end;
+    if(avail > len)
+      avail = len;
+
+    memcpy(stream->buffer + end, p, avail);
+    stream->length += avail;
+    p += avail;
+    len -= avail;
+
+    pthread_cond_broadcast(&stream->cond);
+  }
+
+  if(stream->cancelled)
+    /* makes the transfer stop at the next block */
+    raptor_www_abort(www, "Service results reader finished");
+
+  pthread_mutex_unlock(&stream->lock);
+}
+
+
+/* Keep the first error of the retrieval thread for the reader to report */
+static void
+rasqal_service_stream_log_handler(void *user_data, raptor_log_message *message)
+{
+  rasqal_service_stream* stream = (rasqal_service_stream*)user_data;
+  size_t len;
+
+  if(message->level < RAPTOR_LOG_LEVEL_ERROR || !message->text)
+    return;
+
+  pthread_mutex_lock(&stream->lock);
+  if(!stream->error) {
+    len = strlen(message->text);
+    stream->error = RASQAL_MALLOC(char*, len + 1);
+    if(stream->error)
+      memcpy(stream->error, message->text, len + 1);
+  }
+  pthread_mutex_unlock(&stream->lock);
+}
+
+
+/*
+ * rasqal_service_stream_report_error:
+ * @stream: service stream
+ *
+ * INTERNAL - Log the error of a failed retrieval in the rasqal world
+ *
+ * Called by the reader with the stream lock held once the transfer
+ * has finished.
+ */
+static void
+rasqal_service_stream_report_error(rasqal_service_stream* stream)
+{
+  if(!stream->failed || !stream->error || stream->error_reported)
+    return;
+
+  stream->error_reported = 1;
+  rasqal_log_error_simple(stream->svc->world, RAPTOR_LOG_LEVEL_ERROR, NULL,
+                          "%s", stream->error);
+}
+
+
+static void*
+rasqal_service_stream_fetch(void* arg)
+{
+  rasqal_service_stream* stream = (rasqal_service_stream*)arg;
+  int rc = 1;
+
+  if(rasqal_service_stream_acquire_slot(stream)) {
+    stream->fetched = 1;
+    rc = raptor_www_fetch(stream->www, stream->retrieval_uri);
+
+    rasqal_service_stream_release_slot(stream);
+  }
+
+  pthread_mutex_lock(&stream->lock);
+  stream->finished = 1;
+  stream->failed = (rc != 0);
+  stream->svc->failed = stream->failed;
+  pthread_cond_broadcast(&stream->cond);
+  pthread_mutex_unlock(&stream->lock);
+
+  return NULL;
+}
+
+
+/*
+ * rasqal_service_stream_free_transfer:
+ * @stream: service stream
+ *
+ * INTERNAL - Free the raptor objects of a retrieval that is not running
+ */
+static void
+rasqal_service_stream_free_transfer(rasqal_service_stream* stream)
+{
+  if(stream->retrieval_uri)
+    raptor_free_uri(stream->retrieval_uri);
+  if(stream->www)
+    raptor_free_www(stream->www);
+
+  if(stream->connection) {
+    /* A connection is only kept after a complete response */
+    if(!stream->fetched || !stream->failed)
+      rasqal_service_release_connection(stream->svc->world,
+                                        stream->connection);
+    else
+      rasqal_free_service_connection(stream->connection);
+  }
+
+  if(stream->final_uri_string)
+    RASQAL_FREE(char*, stream->final_uri_string);
+  if(stream->error)
+    RASQAL_FREE(char*, stream->error);
+}
+
+
+static void
+rasqal_service_stream_finish(void *user_data)
+{
+  rasqal_service_stream* stream = (rasqal_service_stream*)user_data;
+  rasqal_world* world = stream->svc->world;
+
+  pthread_mutex_lock(&stream->lock);
+  stream->cancelled = 1;
+  pthread_cond_broadcast(&stream->cond);
+  pthread_mutex_unlock(&stream->lock);
+
+  pthread_mutex_lock(&world->service_lock);
+  stream->abandoned = 1;
+  pthread_cond_broadcast(&world->service_cond);
+  pthread_mutex_unlock(&world->service_lock);
+
+  pthread_join(stream->thread, NULL);
+
+  pthread_cond_destroy(&stream->cond);
+  pthread_mutex_destroy(&stream->lock);
+
+  rasqal_service_stream_free_transfer(stream);
+
+  if(stream->svc_reference)
+    rasqal_free_service(stream->svc);
+  else
+    stream->svc->stream = NULL;
+
+  RASQAL_FREE(rasqal_service_stream, stream);
+}
+
+
+static int
+rasqal_service_stream_read_bytes(void *user_data, void *ptr,
+                                 size_t size, size_t nmemb)
+{
+  rasqal_service_stream* stream = (rasqal_service_stream*)user_data;
+  unsigned char* p = RASQAL_GOOD_CAST(unsigned char*, ptr);
+  size_t want;
+  size_t total = 0;
+
+  if(!ptr || size <= 0 || !nmemb)
+    return -1;
+
+  want = size * nmemb;
+
+  pthread_mutex_lock(&stream->lock);
+
+  /* Readers treat a short read as the end of the data so only
+   * return one at the end of the transfer */
+  while(total < want) {
+    size_t avail;
+
+    while(!stream->length && !stream->finished)
+      pthread_cond_wait(&stream->cond, &stream->lock);
+    if(!stream->length) {
+      rasqal_service_stream_report_error(stream);
+      break;
+    }
+
+    avail = stream->length;
+    if(avail > RASQAL_SERVICE_STREAM_BUFFER_SIZE - stream->start)
+      avail = RASQAL_SERVICE_STREAM_BUFFER_SIZE - stream->start;
+    if(avail > want - total)
+      avail = want - total;
+
+    memcpy(p + total, stream->buffer + stream->start, avail);
+    total += avail;
+    stream->start = (stream->start + avail) % RASQAL_SERVICE_STREAM_BUFFER_SIZE;
+    stream->length -= avail;
+
+    pthread_cond_broadcast(&stream->cond);
+  }
+
+  pthread_mutex_unlock(&stream->lock);
+
+  return RASQAL_BAD_CAST(int, total / size);
+}
+
+
+static int
+rasqal_service_stream_read_eof(void *user_data)
+{
+  rasqal_service_stream* stream = (rasqal_service_stream*)user_data;
+  int eof;
+
+  pthread_mutex_lock(&stream->lock);
+  while(!stream->length && !stream->finished)
+    pthread_cond_wait(&stream->cond, &stream->lock);
+  eof = (!stream->length && stream->finished);
+  if(eof)
+    rasqal_service_stream_report_error(stream);
+  pthread_mutex_unlock(&stream->lock);
+
+  return eof;
+}
+
+
+static const raptor_iostream_handler rasqal_service_stream_iostream_handler = {
+  /* .version     = */ 2,
+  /* .init        = */ NULL,
+  /* .finish      = */ rasqal_service_stream_finish,
+  /* .write_byte  = */ NULL,
+  /* .write_bytes = */ NULL,
+  /* .write_end   = */ NULL,
+  /* .read_bytes  = */ rasqal_service_stream_read_bytes,
+  /* .read_eof    = */ rasqal_service_stream_read_eof
+};
+
+
+/*
+ * rasqal_service_stream_start:
+ * @svc: rasqal service
+ * @retrieval_uri: URI to retrieve
+ *
+ * INTERNAL - Start retrieving a service response in the background
+ *
+ * The new stream is owned by @svc until it is read with
+ * rasqal_service_stream_as_iostream().
+ *
+ * Return value: new stream or NULL on failure
+ */
+static rasqal_service_stream*
+rasqal_service_stream_start(rasqal_service* svc, raptor_uri* retrieval_uri)
+{
+  rasqal_service_stream* stream;
+  raptor_world* raptor_world_ptr;
+
+  stream = RASQAL_CALLOC(rasqal_service_stream*, 1, sizeof(*stream));
+  if(!stream)
+    return NULL;
+
+  if(pthread_mutex_init(&stream->lock, NULL)) {
+    RASQAL_FREE(rasqal_service_stream, stream);
+    return NULL;
+  }
+  if(pthread_cond_init(&stream->cond, NULL)) {
+    pthread_mutex_destroy(&stream->lock);
+    RASQAL_FREE(rasqal_service_stream, stream);
+    return NULL;
+  }
+
+  stream->svc = svc;
+
+  stream->connection = rasqal_service_get_connection(svc);
+  if(!stream->connection)
+    goto failed;
+  raptor_world_ptr = stream->connection->raptor_world_ptr;
+  raptor_world_set_log_handler(raptor_world_ptr, stream,
+                               rasqal_service_stream_log_handler);
+
+  stream->www = raptor_new_www_with_connection(raptor_world_ptr,
+                                               raptor_www_get_connection(svc->www ? svc->www : stream->connection->www));
+  if(!stream->www)
+    goto failed;
+  rasqal_service_set_www_options(svc, stream->www);
+  raptor_www_set_write_bytes_handler(stream->www,
+                                     rasqal_service_stream_write_bytes, stream);
+
+  stream->retrieval_uri = raptor_new_uri(raptor_world_ptr,
+                                         raptor_uri_as_string(retrieval_uri));
+  if(!stream->retrieval_uri)
+    goto failed;
+
+  if(pthread_create(&stream->thread, NULL, rasqal_service_stream_fetch,
+                    stream))
+    goto failed;
+
+  return stream;
+
+  failed:
+  rasqal_service_stream_free_transfer(stream);
+  pthread_cond_destroy(&stream->cond);
+  pthread_mutex_destroy(&stream->lock);
+  RASQAL_FREE(rasqal_service_stream, stream);
+
+  return NULL;
+}
+
+
+/*
+ * rasqal_service_stream_as_iostream:
+ * @stream: service stream owned by its service
+ *
+ * INTERNAL - Wait for a service response to start and read it as an iostream
+ *
+ * Once the response body has started the content type and final URI
+ * of the service are set.  The stream becomes owned by the iostream
+ * and ends the transfer when it is freed.
+ *
+ * Return value: new iostream or NULL on failure
+ */
+static raptor_iostream*
+rasqal_service_stream_as_iostream(rasqal_service_stream* stream)
+{
+  rasqal_service* svc = stream->svc;
+  raptor_world* raptor_world_ptr = rasqal_world_get_raptor(svc->world);
+  int started;
+
+  pthread_mutex_lock(&stream->lock);
+  while(!stream->started && !stream->finished)
+    pthread_cond_wait(&stream->cond, &stream->lock);
+  started = stream->started;
+  if(!started)
+    rasqal_service_stream_report_error(stream);
+  pthread_mutex_unlock(&stream->lock);
+
+  if(!started) {
+    /* failed before any of the response arrived */
+    rasqal_service_stream_finish(stream);
+    return NULL;
+  }
+
+  /* the retrieval thread no longer changes the final URI string */
+  if(stream->final_uri_string)
+    svc->final_uri = raptor_new_uri(raptor_world_ptr,
+                                    RASQAL_GOOD_CAST(const unsigned char*, stream->final_uri_string));
+
+  /* The stream now keeps the service alive */
+  svc->stream = NULL;
+  rasqal_new_service_from_service(svc);
+  stream->svc_reference = 1;
+
+  return raptor_new_iostream_from_handler(raptor_world_ptr, stream,
+                                          &rasqal_service_stream_iostream_handler);
+}
+#endif /* HAVE_PTHREAD */
+
+
+/*
+ * rasqal_service_init_www:
+ * @svc: rasqal service
+ *
+ * INTERNAL - Prepare the service for a new retrieval
+ *
+ * Without thread support this also prepares the WWW object of the
+ * service; otherwise each retrieval makes its own.
+ *
+ * Return value: non-0 on failure
+ */
+static int
+rasqal_service_init_www(rasqal_service* svc)
+{
+#ifndef HAVE_PTHREAD
+  raptor_world* raptor_world_ptr = rasqal_world_get_raptor(svc->world);
+
+  if(!svc->www) {
+    svc->www = raptor_new_www(raptor_world_ptr);
+
+    if(!svc->www) {
+      rasqal_log_error_simple(svc->world, RAPTOR_LOG_LEVEL_ERROR, NULL,
+                              "Failed to create WWW");
+      return 1;
+    }
+  }
+#endif
+
+  svc->started = 0;
+  svc->failed = 0;
+  svc->final_uri = NULL;
+#ifndef HAVE_PTHREAD
+  svc->sb = raptor_new_stringbuffer();
+
+  rasqal_service_set_www_options(svc, svc->www);
+  raptor_www_set_write_bytes_handler(svc->www,
+                                     rasqal_service_write_bytes, svc);
+#endif
+  svc->content_type = NULL;
+
+  return 0;
+}
+
+
+/*
+ * rasqal_service_get_retrieval_uri:
+ * @svc: rasqal service
+ *
+ * INTERNAL - Make the SPARQL protocol URI to retrieve for the service
+ *
+ * Return value: new URI or NULL on failure
+ */
+static raptor_uri*
+rasqal_service_get_retrieval_uri(rasqal_service* svc)
+{
+  raptor_uri* retrieval_uri = NULL;
+  raptor_stringbuffer* uri_sb = NULL;
+  size_t len;
+  unsigned char* str;
+  raptor_world* raptor_world_ptr = rasqal_world_get_raptor(svc->world);
+
+  /* Construct a URI to retrieve following SPARQL protocol HTTP
+   *  binding from concatenation of
+   *
+   * 1. service_uri
+   * 2. '?'
+   * 3. "query=" query_string
+   * 4. "&default-graph-uri=" background graph URI if any
+   * 5. "&named-graph-uri=" named graph URI for all named graphs
+   * with URI-escaping of the values
+   */
+
+  uri_sb = raptor_new_stringbuffer();
+  if(!uri_sb) {
+    rasqal_log_error_simple(svc->world, RAPTOR_LOG_LEVEL_ERROR, NULL,
+                            "Failed to create stringbuffer");
+    goto error;
+  }
+
+  str = raptor_uri_as_counted_string(svc->service_uri, &len);
+  raptor_stringbuffer_append_counted_string(uri_sb, str, len, 1);
+
+  raptor_stringbuffer_append_counted_string(uri_sb,
+                                            RASQAL_GOOD_CAST(const unsigned char*, "?"), 1, 1);
+
+  if(svc->query_string) {
+    raptor_stringbuffer_append_counted_string(uri_sb,
+                                              RASQAL_GOOD_CAST(const unsigned char*, "query="), 6, 1);
+    raptor_stringbuffer_append_uri_escaped_counted_string(uri_sb,
+                                                          svc->query_string,
+                                                          svc->query_string_len,
+                                                          1);
+  }
+
+
+  if(svc->data_graphs) {
+    rasqal_data_graph* dg;
+    int i;
+    int bg_graph_count;
+    
+    for(i = 0, bg_graph_count = 0;
+        (dg = (rasqal_data_graph*)raptor_sequence_get_at(svc->data_graphs, i));
+        i++) {
+      unsigned char* graph_str;
+      size_t graph_len;
+      raptor_uri* graph_uri;
+      
+      if(dg->flags & RASQAL_DATA_GRAPH_BACKGROUND) {
+
+        if(bg_graph_count++) {
+          if(bg_graph_count == 2) {
+            /* Warn once, only when the second BG is seen */
+            rasqal_log_warning_simple(svc->world,
+                                      RASQAL_WARNING_LEVEL_MULTIPLE_BG_GRAPHS,
+                                      NULL,
+                                      "Attempted to add multiple background graphs");
+          }
+          /* always skip after first BG */
+          continue;
+        }
+        
+        raptor_stringbuffer_append_counted_string(uri_sb,
+                                                  RASQAL_GOOD_CAST(const unsigned char*, "&default-graph-uri="), 19, 1);
+        graph_uri = dg->uri;
+      } else {
+        raptor_stringbuffer_append_counted_string(uri_sb,
+                                                  RASQAL_GOOD_CAST(const unsigned char*, "&named-graph-uri="), 17, 1);
+        graph_uri = dg->name_uri;
+      }
+      
+      graph_str = raptor_uri_as_counted_string(graph_uri, &graph_len);
+      raptor_stringbuffer_append_uri_escaped_counted_string(uri_sb,
+                                                            RASQAL_GOOD_CAST(const char*, graph_str), graph_len, 1);
+    }
+  }
+  
+
+  str = raptor_stringbuffer_as_string(uri_sb);
+
+  retrieval_uri = raptor_new_uri(raptor_world_ptr, str);
+  if(!retrieval_uri) {
+    rasqal_log_error_simple(svc->world, RAPTOR_LOG_LEVEL_ERROR, NULL,
+                            "Failed to create retrieval URI %s",
+                            raptor_uri_as_string(retrieval_uri));
+    goto error;
+  }
+
+  raptor_free_stringbuffer(uri_sb);
+
+  return retrieval_uri;
+
+  error:
+  if(uri_sb)
+    raptor_free_stringbuffer(uri_sb);
+
+  return NULL;
+}
+
+
+/*
+ * rasqal_service_get_cache_key:
+ * @svc: rasqal service
+ * @len_p: pointer to store key length
+ *
+ * INTERNAL - Make the key of the service request in the SERVICE results cache
+ *
+ * The retrieval URI contains the service URI, query and data graphs
+ * and is followed by the requested format.
+ *
+ * Return value: new key string or NULL on failure
+ */
+static unsigned char*
+rasqal_service_get_cache_key(rasqal_service* svc, size_t* len_p)
+{
+  raptor_uri* retrieval_uri;
+  const char* format = svc->format ? svc->format : DEFAULT_FORMAT;
+  unsigned char* uri_str;
+  size_t uri_len;
+  size_t format_len;
+  unsigned char* key;
+
+  retrieval_uri = rasqal_service_get_retrieval_uri(svc);
+  if(!retrieval_uri)
+    return NULL;
+
+  uri_str = raptor_uri_as_counted_string(retrieval_uri, &uri_len);
+  format_len = strlen(format);
+
+  key = RASQAL_MALLOC(unsigned char*, uri_len + 1 + format_len + 1);
+  if(key) {
+    memcpy(key, uri_str, uri_len);
+    key[uri_len] = '\n';
+    memcpy(key + uri_len + 1, format, format_len + 1);
+    *len_p = uri_len + 1 + format_len;
+  }
+
+  raptor_free_uri(retrieval_uri);
+
+  return key;
+}
+
+
+/*
+ * rasqal_service_cache_rowsource:
+ * @svc: rasqal service
+ * @rowsource: rowsource decoding the service response
+ * @vars_table: variables table
+ * @key: cache key
+ * @key_len: length of @key
+ *
+ * INTERNAL - Read a service response and add it to the SERVICE results cache
+ *
+ * Takes ownership of @rowsource.
+ *
+ * Return value: rowsource for the response or NULL on failure
+ */
+static rasqal_rowsource*
+rasqal_service_cache_rowsource(rasqal_service* svc,
+                               rasqal_rowsource* rowsource,
+                               rasqal_variables_table* vars_table,
+                               const unsigned char* key, size_t key_len)
+{
+  raptor_sequence* vars_seq;
+  raptor_sequence* rows_seq;
+  int size;
+  int i;
+
+  if(rasqal_rowsource_ensure_variables(rowsource)) {
+    rasqal_free_rowsource(rowsource);
+    return NULL;
+  }
+
+  /* Results with no variables cannot be replayed from a row sequence */
+  size = rasqal_rowsource_get_size(rowsource);
+  if(!size)
+    return rowsource;
+
+  vars_seq = raptor_new_sequence((raptor_data_free_handler)rasqal_free_variable,
+                                 (raptor_data_print_handler)rasqal_variable_print);
+  if(!vars_seq) {
+    rasqal_free_rowsource(rowsource);
+    return NULL;
+  }
+
+  for(i = 0; i < size; i++) {
+    rasqal_variable* v = rasqal_rowsource_get_variable_by_offset(rowsource, i);
+
+    raptor_sequence_push(vars_seq, rasqal_new_variable_from_variable(v));
+  }
+
+  rows_seq = rasqal_rowsource_read_all_rows(rowsource);
+  if(!rows_seq) {
+    raptor_free_sequence(vars_seq);
+    rasqal_free_rowsource(rowsource);
+    return NULL;
+  }
+
+  rasqal_free_rowsource(rowsource);
+
+  /* A transfer that ended early is neither cached nor returned */
+  if(svc->failed) {
+    rasqal_log_error_simple(svc->world, RAPTOR_LOG_LEVEL_ERROR, NULL,
+                            "Failed to fetch all results from service %s",
+                            raptor_uri_as_string(svc->service_uri));
+    raptor_free_sequence(rows_seq);
+    raptor_free_sequence(vars_seq);
+    return NULL;
+  }
+
+  rasqal_service_cache_add(svc->world->service_cache, key, key_len,
+                           vars_seq, rows_seq);
+
+  /* rows_seq and vars_seq become owned by the rowsource */
+  return rasqal_new_rowsequence_rowsource(svc->world, NULL, vars_table,
+                                          rows_seq, vars_seq);
+}
+
+
+/*
+ * rasqal_service_prefetch:
+ * @svc: rasqal service
+ *
+ * INTERNAL - Start retrieving the service results in the background
+ *
+ * A following rasqal_service_execute_as_rowsource() reads the
+ * results of this retrieval.  Without thread support this does
+ * nothing and the service is retrieved when it is executed.
+ *
+ * Return value: non-0 on failure
+ */
+int
+rasqal_service_prefetch(rasqal_service* svc)
+{
+#ifdef HAVE_PTHREAD
+  raptor_uri* retrieval_uri;
+
+  if(svc->stream)
+    return 0;
+
+  /* Results in the SERVICE results cache need no retrieval */
+  if(svc->world->service_cache) {
+    unsigned char* key;
+    size_t key_len = 0;
+    int cached;
+
+    key = rasqal_service_get_cache_key(svc, &key_len);
+    if(!key)
+      return 1;
+
+    cached = rasqal_service_cache_contains(svc->world->service_cache,
+                                           key, key_len);
+    RASQAL_FREE(char*, key);
+    if(cached)
+      return 0;
+  }
+
+  if(rasqal_service_init_www(svc))
+    return 1;
+
+  retrieval_uri = rasqal_service_get_retrieval_uri(svc);
+  if(!retrieval_uri)
+    return 1;
+
+  svc->stream = rasqal_service_stream_start(svc, retrieval_uri);
+  raptor_free_uri(retrieval_uri);
+
+  return !svc->stream;
+#else
+  return 0;
+#endif
+}
+
+
+/*
+ * rasqal_service_get_failed:
+ * @svc: rasqal service
+ *
+ * INTERNAL - Check if the last retrieval of the service failed
+ *
+ * Query results readers see the end of a response that stopped part
+ * way through as the end of the results, so this is checked once the
+ * rowsource from rasqal_service_execute_as_rowsource() has no more
+ * rows.
+ *
+ * Return value: non-0 if the retrieval failed
+ */
+int
+rasqal_service_get_failed(rasqal_service* svc)
+{
+  return svc->failed;
+}
+
+
+/**
+ * rasqal_service_execute_as_rowsource:
+ * @svc: rasqal service
+ *
+ * INTERNAL - Execute a rasqal sparql protocol service to a rowsurce
+ *
+ * Return value: query results or NULL on failure
+ */
+rasqal_rowsource*
+rasqal_service_execute_as_rowsource(rasqal_service* svc,
+                                    rasqal_variables_table* vars_table)
+{
+  raptor_iostream* read_iostr = NULL;
+  raptor_uri* read_base_uri = NULL;
+  rasqal_query_results_formatter* read_formatter = NULL;
+  rasqal_rowsource* rowsource = NULL;
+  unsigned char* cache_key = NULL;
+  size_t cache_key_len = 0;
+#ifndef HAVE_PTHREAD
+  raptor_uri* retrieval_uri = NULL;
+  raptor_world* raptor_world_ptr = rasqal_world_get_raptor(svc->world);
+#endif
+
+  if(svc->world->service_cache) {
+    cache_key = rasqal_service_get_cache_key(svc, &cache_key_len);
+    if(cache_key) {
+      rowsource = rasqal_service_cache_get_rowsource(svc->world->service_cache,
+                                                     cache_key, cache_key_len,
+                                                     vars_table);
+      if(rowsource)
+        goto error;
+    }
+  }
+
+#ifdef HAVE_PTHREAD
+  /* Results are decoded while the response is still arriving */
+  if(rasqal_service_prefetch(svc)) {
+    rasqal_log_error_simple(svc->world, RAPTOR_LOG_LEVEL_ERROR, NULL,
+                            "Failed to start retrieval from service %s",
+                            raptor_uri_as_string(svc->service_uri));
+    goto error;
+  }
+
+  read_iostr = rasqal_service_stream_as_iostream(svc->stream);
+  if(!read_iostr) {
+    rasqal_log_error_simple(svc->world, RAPTOR_LOG_LEVEL_ERROR, NULL,
+                            "Failed to fetch results from service %s",
+                            raptor_uri_as_string(svc->service_uri));
+    goto error;
+  }
+#else
+  if(rasqal_service_init_www(svc))
+    goto error;
+
+  retrieval_uri = rasqal_service_get_retrieval_uri(svc);
+  if(!retrieval_uri)
+    goto error;
+
+  if(raptor_www_fetch(svc->www, retrieval_uri)) {
+    svc->failed = 1;
+    rasqal_log_error_simple(svc->world, RAPTOR_LOG_LEVEL_ERROR, NULL,
+                            "Failed to fetch retrieval URI %s",
+                            raptor_uri_as_string(retrieval_uri));
+    goto error;
+  }
+
+  /* Takes ownership of svc->sb */
+  read_iostr = rasqal_new_iostream_from_stringbuffer(raptor_world_ptr,
+                                                     svc->sb);
+  svc->sb = NULL;
+  if(!read_iostr) {
+    rasqal_log_error_simple(svc->world, RAPTOR_LOG_LEVEL_ERROR, NULL,
+                            "Failed to create iostream from string");
+    goto error;
+  }
+#endif
+
+  read_base_uri = svc->final_uri ? svc->final_uri : svc->service_uri;
+  read_formatter = rasqal_new_query_results_formatter(svc->world,
+                                                      /* format name */ NULL,
+                                                      svc->content_type,
+                                                      /* format URI */ NULL);
+  if(!read_formatter) {
+    rasqal_log_error_simple(svc->world, RAPTOR_LOG_LEVEL_ERROR, NULL,
+                            "Failed to find query results reader for content type %s returned from %s",
+                            svc->content_type,
+                            raptor_uri_as_string(read_base_uri));
+    goto error;
+  }
+
+  /* Takes ownership of read_iostr with flags = 1 */
+  rowsource = rasqal_query_results_formatter_get_read_rowsource(svc->world,
+                                                                read_iostr,
+                                                                read_formatter,
+                                                                vars_table,
+                                                                read_base_uri,
+                                                                /* flags */ 1);
+  read_iostr = NULL;
+  if(!rowsource) {
+    rasqal_log_error_simple(svc->world, RAPTOR_LOG_LEVEL_ERROR, NULL,
+                            "Failed to decode %s query results data returned from %s",
+                            svc->content_type,
+                            raptor_uri_as_string(read_base_uri));
+    goto error;
+  }
+
+  if(cache_key)
+    rowsource = rasqal_service_cache_rowsource(svc, rowsource, vars_table,
+                                               cache_key, cache_key_len);
+
+
+  error:
+  if(cache_key)
+    RASQAL_FREE(char*, cache_key);
+
+#ifndef HAVE_PTHREAD
+  if(retrieval_uri)
+    raptor_free_uri(retrieval_uri);
+#endif
+
+  if(read_formatter)
+    rasqal_free_query_results_formatter(read_formatter);
+
+  if(read_iostr)
+    raptor_free_iostream(read_iostr);
+
+  if(svc->final_uri) {
+    raptor_free_uri(svc->final_uri);
+    svc->final_uri = NULL;
+  }
+
+  if(svc->content_type) {
+    RASQAL_FREE(char*, svc->content_type);
+    svc->content_type = NULL;
+  }
+
+  if(svc->sb) {
+    raptor_free_stringbuffer(svc->sb);
+    svc->sb = NULL;
+  }
+  
+  return rowsource;
+}
+
+
+/**
+ * rasqal_service_execute:
+ * @svc: rasqal service
+ *
+ * Execute a rasqal sparql protocol service
+ *
+ * Return value: query results or NULL on failure
+ */
+rasqal_query_results*
+rasqal_service_execute(rasqal_service* svc)
+{
+  rasqal_query_results* results = NULL;
+  rasqal_variables_table* vars_table;
   rasqal_rowsource* rowsource = NULL;
 
   results = rasqal_new_query_results2(svc->world, NULL, 
@@ -549,6 +1616,11 @@ rasqal_service_execute(rasqal_service* svc)
     rasqal_query_results_add_row(results, row);
   }
 
+  if(svc->failed)
+    rasqal_log_error_simple(svc->world, RAPTOR_LOG_LEVEL_ERROR, NULL,
+                            "Failed to fetch all results from service %s",
+                            raptor_uri_as_string(svc->service_uri));
+
 
   error:
   if(rowsource)
@@ -556,3 +1628,802 @@ rasqal_service_execute(rasqal_service* svc)
 
   return results;
 }
+
+
+#endif /* not STANDALONE */
+
+
+
+#ifdef STANDALONE
+
+#if defined(HAVE_PTHREAD) && !defined(WIN32)
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+/* one more prototype */
+int main(int argc, char *argv[]);
+
+
+/*
+ * Stub SPARQL protocol server on the loopback interface that sends
+ * the same JSON results to every request.
+ */
+#define SERVICE_TEST_MAX_CONNECTIONS 16
+
+typedef struct
+{
+  int fd;
+  int port;
+  pthread_t thread;
+  pthread_mutex_t lock;
+
+  /* response body and the Content-Length sent with it */
+  const char* body;
+  size_t body_len;
+  size_t content_length;
+
+  pthread_t connections[SERVICE_TEST_MAX_CONNECTIONS];
+  int requests;
+  int stopping;
+} service_test_server;
+
+
+typedef struct
+{
+  service_test_server* server;
+  int fd;
+} service_test_connection;
+
+
+static int
+service_test_write(int fd, const char* buffer, size_t len)
+{
+  while(len > 0) {
+    ssize_t n = write(fd, buffer, len);
+    if(n <= 0)
+      return 1;
+    buffer += n;
+    len -= RASQAL_GOOD_CAST(size_t, n);
+  }
+
+  return 0;
+}
+
+
+static void*
+service_test_connection_run(void* arg)
+{
+  service_test_connection* c = (service_test_connection*)arg;
+  service_test_server* server = c->server;
+  char buffer[8192];
+  size_t len = 0;
+
+  /* The request itself is not needed; read up to the end of headers */
+  while(len < sizeof(buffer) - 1) {
+    ssize_t n = read(c->fd, buffer + len, sizeof(buffer) - 1 - len);
+    if(n <= 0)
+      break;
+    len += RASQAL_GOOD_CAST(size_t, n);
+    buffer[len] = '\0';
+    if(strstr(buffer, "\r\n\r\n"))
+      break;
+  }
+
+  sprintf(buffer,
+          "HTTP/1.0 200 OK\r\n"
+          "Content-Type: application/sparql-results+json\r\n"
+          "Content-Length: %lu\r\n"
+          "\r\n",
+          RASQAL_GOOD_CAST(unsigned long, server->content_length));
+
+  /* Stops early when the client goes away */
+  if(!service_test_write(c->fd, buffer, strlen(buffer)))
+    service_test_write(c->fd, server->body, server->body_len);
+
+  close(c->fd);
+  free(c);
+
+  return NULL;
+}
+
+
+static void*
+service_test_server_run(void* arg)
+{
+  service_test_server* server = (service_test_server*)arg;
+
+  while(1) {
+    service_test_connection* c;
+    int fd = accept(server->fd, NULL, NULL);
+
+    pthread_mutex_lock(&server->lock);
+    if(fd < 0 || server->stopping ||
+       server->requests == SERVICE_TEST_MAX_CONNECTIONS) {
+      pthread_mutex_unlock(&server->lock);
+      if(fd >= 0)
+        close(fd);
+      break;
+    }
+
+    c = (service_test_connection*)malloc(sizeof(*c));
+    c->server = server;
+    c->fd = fd;
+    pthread_create(&server->connections[server->requests++], NULL,
+                   service_test_connection_run, c);
+    pthread_mutex_unlock(&server->lock);
+  }
+
+  return NULL;
+}
+
+
+static int
+service_test_server_start(service_test_server* server, const char* body,
+                          size_t content_length)
+{
+  struct sockaddr_in addr;
+  socklen_t addr_len = sizeof(addr);
+
+  memset(server, 0, sizeof(*server));
+  server->body = body;
+  server->body_len = strlen(body);
+  server->content_length = content_length ? content_length : server->body_len;
+
+  server->fd = socket(AF_INET, SOCK_STREAM, 0);
+  if(server->fd < 0)
+    return 1;
+
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = 0;
+  if(bind(server->fd, (struct sockaddr*)&addr, sizeof(addr)) ||
+     getsockname(server->fd, (struct sockaddr*)&addr, &addr_len) ||
+     listen(server->fd, SERVICE_TEST_MAX_CONNECTIONS)) {
+    close(server->fd);
+    return 1;
+  }
+  server->port = ntohs(addr.sin_port);
+
+  pthread_mutex_init(&server->lock, NULL);
+  if(pthread_create(&server->thread, NULL, service_test_server_run, server)) {
+    pthread_mutex_destroy(&server->lock);
+    close(server->fd);
+    return 1;
+  }
+
+  return 0;
+}
+
+
+static int
+service_test_server_stop(service_test_server* server)
+{
+  struct sockaddr_in addr;
+  int fd;
+  int requests;
+  int i;
+
+  pthread_mutex_lock(&server->lock);
+  server->stopping = 1;
+  pthread_mutex_unlock(&server->lock);
+
+  /* wake up accept() */
+  fd = socket(AF_INET, SOCK_STREAM, 0);
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = htons(RASQAL_GOOD_CAST(unsigned short, server->port));
+  if(fd >= 0) {
+    connect(fd, (struct sockaddr*)&addr, sizeof(addr));
+    close(fd);
+  }
+
+  pthread_join(server->thread, NULL);
+  requests = server->requests;
+  for(i = 0; i < requests; i++)
+    pthread_join(server->connections[i], NULL);
+
+  close(server->fd);
+  pthread_mutex_destroy(&server->lock);
+
+  return requests;
+}
+
+
+/*
+ * Wait up to 10 seconds for the server to have accepted @count requests
+ *
+ * Return value: number of requests accepted
+ */
+static int
+service_test_wait_requests(service_test_server* server, int count)
+{
+  int requests = 0;
+  int i;
+
+  for(i = 0; i < 1000; i++) {
+    pthread_mutex_lock(&server->lock);
+    requests = server->requests;
+    pthread_mutex_unlock(&server->lock);
+    if(requests >= count)
+      break;
+    usleep(10000);
+  }
+
+  return requests;
+}
+
+
+/*
+ * Count the idle connections kept for the endpoint @service_uri
+ */
+static int
+service_test_idle_connections(rasqal_world* world, raptor_uri* service_uri)
+{
+  rasqal_service_connection* conn;
+  const char* endpoint;
+  int count = 0;
+
+  endpoint = RASQAL_GOOD_CAST(const char*,
+                              raptor_uri_as_string(service_uri));
+  pthread_mutex_lock(&world->service_lock);
+  for(conn = world->service_connections; conn; conn = conn->next) {
+    if(!strcmp(conn->endpoint, endpoint))
+      count++;
+  }
+  pthread_mutex_unlock(&world->service_lock);
+
+  return count;
+}
+
+
+static raptor_uri*
+service_test_server_uri(rasqal_world* world, service_test_server* server)
+{
+  char uri_string[64];
+
+  sprintf(uri_string, "http://127.0.0.1:%d/sparql", server->port);
+
+  return raptor_new_uri(rasqal_world_get_raptor(world),
+                        RASQAL_GOOD_CAST(const unsigned char*, uri_string));
+}
+
+
+#define SERVICE_TEST_QUERY "SELECT * WHERE { ?s ?p ?x }"
+
+#define SERVICE_TEST_RESULTS \
+  "{ \"head\": { \"vars\": [ \"x\" ] },\n" \
+  "  \"results\": { \"bindings\": [\n" \
+  "    { \"x\": { \"type\": \"literal\", \"value\": \"1\" } },\n" \
+  "    { \"x\": { \"type\": \"literal\", \"value\": \"2\" } }\n" \
+  "  ] }\n" \
+  "}\n"
+
+
+/*
+ * Read all the results of a service with a rasqal_service object
+ *
+ * Return value: number of rows or <0 if there was no rowsource
+ */
+static int
+service_test_read_service(rasqal_world* world, raptor_uri* service_uri,
+                          int* failed_p)
+{
+  rasqal_variables_table* vt;
+  rasqal_service* svc;
+  rasqal_rowsource* rowsource;
+  rasqal_row* row;
+  int count = -1;
+
+  vt = rasqal_new_variables_table(world);
+  svc = rasqal_new_service(world, service_uri,
+                           RASQAL_GOOD_CAST(const unsigned char*, SERVICE_TEST_QUERY),
+                           NULL);
+
+  rowsource = rasqal_service_execute_as_rowsource(svc, vt);
+  if(rowsource) {
+    for(count = 0; (row = rasqal_rowsource_read_row(rowsource)); count++)
+      rasqal_free_row(row);
+    rasqal_free_rowsource(rowsource);
+  }
+  *failed_p = rasqal_service_get_failed(svc);
+
+  rasqal_free_service(svc);
+  rasqal_free_variables_table(vt);
+
+  return count;
+}
+
+
+/*
+ * Read all the results of a SERVICE rowsource of a new query
+ *
+ * Return value: number of rows or <0 if there was no rowsource
+ */
+static int
+service_test_read_rowsource(rasqal_world* world, raptor_uri* service_uri,
+                            unsigned int rs_flags, int* failed_p)
+{
+  rasqal_query* query;
+  rasqal_rowsource* rowsource;
+  rasqal_row* row;
+  int count = -1;
+
+  query = rasqal_new_query(world, "sparql", NULL);
+
+  rowsource = rasqal_new_service_rowsource(world, query, service_uri,
+                                           RASQAL_GOOD_CAST(const unsigned char*, SERVICE_TEST_QUERY),
+                                           NULL, rs_flags);
+  if(rowsource) {
+    for(count = 0; (row = rasqal_rowsource_read_row(rowsource)); count++)
+      rasqal_free_row(row);
+    rasqal_free_rowsource(rowsource);
+  }
+  *failed_p = query->failed;
+
+  rasqal_free_query(query);
+
+  return count;
+}
+
+
+/* rows in a response larger than the service stream buffer */
+#define SERVICE_TEST_LARGE_ROWS 10000
+
+/*
+ * Make JSON results with @rows rows binding ?x
+ *
+ * Return value: new string
+ */
+static char*
+service_test_make_results(int rows)
+{
+  const char* head = "{ \"head\": { \"vars\": [ \"x\" ] },\n"
+                     "  \"results\": { \"bindings\": [\n";
+  char* results;
+  char* p;
+  int i;
+
+  results = (char*)malloc(strlen(head) + RASQAL_GOOD_CAST(size_t, rows) * 64 + 16);
+  p = results;
+  strcpy(p, head);
+  p += strlen(p);
+  for(i = 0; i < rows; i++) {
+    sprintf(p, "    { \"x\": { \"type\": \"literal\", \"value\": \"%d\" } }%s\n",
+            i, (i < rows - 1) ? "," : "");
+    p += strlen(p);
+  }
+  strcpy(p, "  ] }\n}\n");
+
+  return results;
+}
+
+
+/*
+ * Read two services with responses larger than the stream buffer,
+ * one row from each in turn, with a concurrency limit of one request
+ *
+ * Return value: non-0 on failure
+ */
+static int
+service_test_read_two(rasqal_world* world, raptor_uri* service_uri,
+                      int* counts)
+{
+  rasqal_variables_table* vt;
+  rasqal_service* svcs[2];
+  rasqal_rowsource* rowsources[2];
+  rasqal_row* row;
+  int active = 0;
+  int rc = 0;
+  int i;
+
+  vt = rasqal_new_variables_table(world);
+
+  for(i = 0; i < 2; i++) {
+    svcs[i] = rasqal_new_service(world, service_uri,
+                                 RASQAL_GOOD_CAST(const unsigned char*, SERVICE_TEST_QUERY),
+                                 NULL);
+    rasqal_service_set_request_limits(svcs[i], 0, 1);
+    rowsources[i] = NULL;
+    counts[i] = 0;
+  }
+
+  /* The first response fills the stream buffer while the second
+   * request waits for a request slot */
+  rowsources[0] = rasqal_service_execute_as_rowsource(svcs[0], vt);
+  if(rowsources[0]) {
+    active++;
+    row = rasqal_rowsource_read_row(rowsources[0]);
+    if(row) {
+      counts[0]++;
+      rasqal_free_row(row);
+    }
+
+    rowsources[1] = rasqal_service_execute_as_rowsource(svcs[1], vt);
+    if(rowsources[1])
+      active++;
+  }
+  if(active != 2)
+    rc = 1;
+
+  while(active) {
+    for(i = 0; i < 2; i++) {
+      if(!rowsources[i])
+        continue;
+
+      row = rasqal_rowsource_read_row(rowsources[i]);
+      if(row) {
+        counts[i]++;
+        rasqal_free_row(row);
+      } else {
+        rasqal_free_rowsource(rowsources[i]);
+        rowsources[i] = NULL;
+        active--;
+      }
+    }
+  }
+
+  for(i = 0; i < 2; i++)
+    rasqal_free_service(svcs[i]);
+  rasqal_free_variables_table(vt);
+
+  return rc;
+}
+
+
+#define SERVICE_TEST_JOIN_RESULTS \
+  "{ \"head\": { \"vars\": [ \"b\", \"c\" ] },\n" \
+  "  \"results\": { \"bindings\": [\n" \
+  "    { \"b\": { \"type\": \"literal\", \"value\": \"red\" },\n" \
+  "      \"c\": { \"type\": \"literal\", \"value\": \"x\" } },\n" \
+  "    { \"b\": { \"type\": \"literal\", \"value\": \"blue\" },\n" \
+  "      \"c\": { \"type\": \"literal\", \"value\": \"y\" } }\n" \
+  "  ] }\n" \
+  "}\n"
+
+static const char* const service_test_keyed_rows[] =
+{
+  "a",   NULL, "b",     NULL,
+  "foo", NULL, "red",   NULL,
+  "bob", NULL, "green", NULL,
+  "sue", NULL, "red",   NULL,
+  NULL,  NULL, NULL,    NULL
+};
+
+static const char* const service_test_keyless_rows[] =
+{
+  "a",   NULL, "b",  NULL,
+  "foo", NULL, NULL, NULL,
+  "bob", NULL, NULL, NULL,
+  "sue", NULL, NULL, NULL,
+  NULL,  NULL, NULL, NULL
+};
+
+#define SERVICE_TEST_BATCH_SIZE 2
+
+
+/*
+ * Bind-join rows binding ?a and ?b with a service binding ?b and ?c
+ *
+ * The joined rows are written to @result as lines of "a b c" values
+ * with "-" for an unbound value.
+ *
+ * Return value: number of rows
+ */
+static int
+service_test_bindjoin(rasqal_world* world, raptor_uri* service_uri,
+                      const char* const left_data[], unsigned int rs_flags,
+                      char* result, int* failed_p)
+{
+  rasqal_query* query;
+  rasqal_variables_table* vt;
+  raptor_sequence* seq;
+  raptor_sequence* vars_seq = NULL;
+  raptor_sequence* service_vars;
+  rasqal_rowsource* rowsource;
+  unsigned char* query_string;
+  rasqal_row* row;
+  int count = 0;
+
+  query = rasqal_new_query(world, "sparql", NULL);
+  vt = query->vars_table;
+
+  seq = rasqal_new_row_sequence(world, vt, left_data, 2, &vars_seq);
+
+  service_vars = raptor_new_sequence((raptor_data_free_handler)rasqal_free_variable,
+                                     (raptor_data_print_handler)rasqal_variable_print);
+  raptor_sequence_push(service_vars,
+                       rasqal_new_variable_from_variable((rasqal_variable*)raptor_sequence_get_at(vars_seq, 1)));
+  raptor_sequence_push(service_vars,
+                       rasqal_variables_table_add2(vt, RASQAL_VARIABLE_TYPE_NORMAL,
+                                                   RASQAL_GOOD_CAST(const unsigned char*, "c"),
+                                                   0, NULL));
+
+  /* seq and vars_seq become owned by the rowsource */
+  rowsource = rasqal_new_rowsequence_rowsource(world, query, vt, seq,
+                                               vars_seq);
+
+  query_string = RASQAL_MALLOC(unsigned char*, sizeof(SERVICE_TEST_QUERY));
+  memcpy(query_string, SERVICE_TEST_QUERY, sizeof(SERVICE_TEST_QUERY));
+
+  /* rowsource, query_string and service_vars become owned by the
+   * bind-join rowsource */
+  rowsource = rasqal_new_bindjoin_rowsource(world, query, rowsource,
+                                            service_uri, query_string, NULL,
+                                            service_vars, rs_flags,
+                                            SERVICE_TEST_BATCH_SIZE);
+
+  *result = '\0';
+  while((row = rasqal_rowsource_read_row(rowsource))) {
+    int i;
+
+    for(i = 0; i < 3; i++) {
+      rasqal_literal* l = row->values[i];
+
+      strcat(result, l ? RASQAL_GOOD_CAST(const char*, rasqal_literal_as_string(l)) : "-");
+      strcat(result, i < 2 ? " " : "\n");
+    }
+    rasqal_free_row(row);
+    count++;
+  }
+  *failed_p = query->failed;
+
+  rasqal_free_rowsource(rowsource);
+  rasqal_free_query(query);
+
+  return count;
+}
+
+
+int
+main(int argc, char *argv[])
+{
+  const char *program = rasqal_basename(argv[0]);
+  rasqal_world* world;
+  service_test_server server;
+  raptor_uri* service_uri;
+  rasqal_query* query;
+  rasqal_rowsource* rowsources[2];
+  rasqal_row* row;
+  char* large_results;
+  char result[256];
+  int counts[2];
+  int failures = 0;
+  int requests;
+  int failed;
+  int count;
+  int idle;
+  int i;
+
+#ifdef SIGPIPE
+  /* the client may close a connection before the response is sent */
+  signal(SIGPIPE, SIG_IGN);
+#endif
+
+  world = rasqal_new_world();
+  if(!world || rasqal_world_open(world)) {
+    fprintf(stderr, "%s: rasqal_world init failed\n", program);
+    return(1);
+  }
+
+  /* A complete response */
+  if(service_test_server_start(&server, SERVICE_TEST_RESULTS, 0)) {
+    fprintf(stderr, "%s: Skipping test: cannot start a local HTTP server\n",
+            program);
+    rasqal_free_world(world);
+    return 0;
+  }
+  service_uri = service_test_server_uri(world, &server);
+
+  count = service_test_read_service(world, service_uri, &failed);
+  idle = service_test_idle_connections(world, service_uri);
+
+  raptor_free_uri(service_uri);
+  if(!service_test_server_stop(&server)) {
+    fprintf(stderr, "%s: Skipping test: raptor cannot retrieve HTTP URIs\n",
+            program);
+    rasqal_free_world(world);
+    return 0;
+  }
+
+  if(count != 2 || failed) {
+    fprintf(stderr, "%s: complete response returned %d rows with failed %d, expected 2 rows and no failure\n",
+            program, count, failed);
+    failures++;
+  }
+
+  if(idle != 1) {
+    fprintf(stderr, "%s: %d idle connections were kept after a complete response, expected 1\n",
+            program, idle);
+    failures++;
+  }
+
+  /* A response that stops before its Content-Length; the results
+   * received are a complete document so only the transfer failed */
+  service_test_server_start(&server, SERVICE_TEST_RESULTS,
+                            sizeof(SERVICE_TEST_RESULTS) + 100);
+  service_uri = service_test_server_uri(world, &server);
+
+  count = service_test_read_service(world, service_uri, &failed);
+  if(!failed) {
+    fprintf(stderr, "%s: partial response returned %d rows and was not reported as failed\n",
+            program, count);
+    failures++;
+  }
+
+  count = service_test_read_rowsource(world, service_uri, 0, &failed);
+  if(!failed) {
+    fprintf(stderr, "%s: partial response returned %d SERVICE rows without failing the query\n",
+            program, count);
+    failures++;
+  }
+
+  count = service_test_read_rowsource(world, service_uri,
+                                      RASQAL_ENGINE_BITFLAG_SILENT, &failed);
+  if(failed) {
+    fprintf(stderr, "%s: partial response failed the query for SERVICE SILENT\n",
+            program);
+    failures++;
+  }
+
+  /* With the SERVICE results cache a partial response returns no
+   * rows and is not cached, so it is requested again */
+  rasqal_world_set_service_cache(world, 1024 * 1024, 60);
+  count = service_test_read_service(world, service_uri, &failed);
+  if(count >= 0 || !failed) {
+    fprintf(stderr, "%s: partial response read into the cache returned %d rows with failed %d, expected no rowsource\n",
+            program, count, failed);
+    failures++;
+  }
+  service_test_read_service(world, service_uri, &failed);
+  rasqal_world_set_service_cache(world, 0, 0);
+
+  raptor_free_uri(service_uri);
+  requests = service_test_server_stop(&server);
+  if(requests != 5) {
+    fprintf(stderr, "%s: partial responses were requested %d times, expected 5\n",
+            program, requests);
+    failures++;
+  }
+
+  /* The SERVICE rowsources of a query send their requests when they
+   * are made, before any is read */
+  service_test_server_start(&server, SERVICE_TEST_RESULTS, 0);
+  service_uri = service_test_server_uri(world, &server);
+
+  query = rasqal_new_query(world, "sparql", NULL);
+  rowsources[0] = rasqal_new_service_rowsource(world, query, service_uri,
+                                               RASQAL_GOOD_CAST(const unsigned char*, SERVICE_TEST_QUERY),
+                                               NULL, 0);
+  rowsources[1] = rasqal_new_service_rowsource(world, query, service_uri,
+                                               RASQAL_GOOD_CAST(const unsigned char*, SERVICE_TEST_QUERY),
+                                               NULL, 0);
+  requests = service_test_wait_requests(&server, 2);
+  for(i = 0; i < 2; i++) {
+    counts[i] = 0;
+    while((row = rasqal_rowsource_read_row(rowsources[i]))) {
+      counts[i]++;
+      rasqal_free_row(row);
+    }
+    rasqal_free_rowsource(rowsources[i]);
+  }
+  rasqal_free_query(query);
+
+  /* Connections to the endpoint are kept for reuse, one for each
+   * request that was retrieved at the same time */
+  idle = service_test_idle_connections(world, service_uri);
+
+  raptor_free_uri(service_uri);
+  service_test_server_stop(&server);
+  if(requests != 2 || counts[0] != 2 || counts[1] != 2) {
+    fprintf(stderr, "%s: two SERVICE rowsources sent %d requests before being read and returned %d and %d rows, expected 2 requests and 2 rows each\n",
+            program, requests, counts[0], counts[1]);
+    failures++;
+  }
+
+  if(idle != 2) {
+    fprintf(stderr, "%s: %d idle connections were kept after two requests, expected 2\n",
+            program, idle);
+    failures++;
+  }
+
+  /* A response waiting to be read does not hold up the other request
+   * when only one request can be retrieved at a time.  This hangs
+   * rather than fails if it does, so the alarm ends it. */
+  large_results = service_test_make_results(SERVICE_TEST_LARGE_ROWS);
+  service_test_server_start(&server, large_results, 0);
+  service_uri = service_test_server_uri(world, &server);
+
+  alarm(60);
+  if(service_test_read_two(world, service_uri, counts) ||
+     counts[0] != SERVICE_TEST_LARGE_ROWS ||
+     counts[1] != SERVICE_TEST_LARGE_ROWS) {
+    fprintf(stderr, "%s: reading two large responses with a concurrency limit of 1 returned %d and %d rows, expected %d\n",
+            program, counts[0], counts[1], SERVICE_TEST_LARGE_ROWS);
+    failures++;
+  }
+  alarm(0);
+
+  raptor_free_uri(service_uri);
+  service_test_server_stop(&server);
+  free(large_results);
+
+  /* Bind-join: rows join with the service solutions that agree on ?b
+   * and each batch of up to SERVICE_TEST_BATCH_SIZE rows is a request */
+  service_test_server_start(&server, SERVICE_TEST_JOIN_RESULTS, 0);
+  service_uri = service_test_server_uri(world, &server);
+
+  service_test_bindjoin(world, service_uri, service_test_keyed_rows, 0,
+                        result, &failed);
+  requests = service_test_server_stop(&server);
+  if(failed || requests != 2 ||
+     strcmp(result, "foo red x\nsue red x\n")) {
+    fprintf(stderr, "%s: bind-join with %d requests failed %d returned rows:\n%s",
+            program, requests, failed, result);
+    failures++;
+  }
+
+  /* Rows with no ?b join with every service solution and are still
+   * sent in batches */
+  service_test_server_start(&server, SERVICE_TEST_JOIN_RESULTS, 0);
+  raptor_free_uri(service_uri);
+  service_uri = service_test_server_uri(world, &server);
+
+  service_test_bindjoin(world, service_uri, service_test_keyless_rows, 0,
+                        result, &failed);
+  requests = service_test_server_stop(&server);
+  if(failed || requests != 2 ||
+     strcmp(result, "foo red x\nbob red x\nfoo blue y\nbob blue y\n"
+                    "sue red x\nsue blue y\n")) {
+    fprintf(stderr, "%s: bind-join without join values with %d requests failed %d returned rows:\n%s",
+            program, requests, failed, result);
+    failures++;
+  }
+
+  /* The server has now gone.  A silent service joins each row with
+   * one empty solution; otherwise the query fails */
+  service_test_bindjoin(world, service_uri, service_test_keyed_rows,
+                        RASQAL_ENGINE_BITFLAG_SILENT, result, &failed);
+  if(failed || strcmp(result, "foo red -\nbob green -\nsue red -\n")) {
+    fprintf(stderr, "%s: SILENT bind-join with a failed service failed %d returned rows:\n%s",
+            program, failed, result);
+    failures++;
+  }
+
+  count = service_test_bindjoin(world, service_uri, service_test_keyed_rows,
+                                0, result, &failed);
+  if(!failed || count) {
+    fprintf(stderr, "%s: bind-join with a failed service returned %d rows and did not fail the query\n",
+            program, count);
+    failures++;
+  }
+
+  raptor_free_uri(service_uri);
+
+  rasqal_free_world(world);
+
+  return failures;
+}
+
+#else
+
+/* one more prototype */
+int main(int argc, char *argv[]);
+
+int
+main(int argc, char *argv[])
+{
+  const char *program = rasqal_basename(argv[0]);
+
+  fprintf(stderr, "%s: Skipping test: needs threads and sockets\n", program);
+
+  return 0;
+}
+
+#endif /* HAVE_PTHREAD and not WIN32 */
+
+#endif /* STANDALONE */
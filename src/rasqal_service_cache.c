@@ -0,0 +1,868 @@
+/* -*- Mode: c; c-basic-offset: 2 -*-
+ *
+ * rasqal_service_cache.c - Rasqal SERVICE results cache
+ *
+ * Copyright (C) 2026, David Beckett http://www.dajobe.org/
+ *
+ * This package is Free Software and part of Redland http://librdf.org/
+ *
+ * It is licensed under the following three licenses as alternatives:
+ *   1. GNU Lesser General Public License (LGPL) V2.1 or any newer version
+ *   2. GNU General Public License (GPL) V2 or any newer version
+ *   3. Apache License, V2.0 or any newer version
+ *
+ * You may not use this file except in compliance with at least one of
+ * the above three licenses.
+ *
+ * See LICENSE.html or LICENSE.txt at the top of this package for the
+ * complete terms and further detail along with the license texts for
+ * the licenses in COPYING.LIB, COPYING and LICENSE-2.0.txt respectively.
+ *
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#include <rasqal_config.h>
+#endif
+
+#ifdef WIN32
+#include <win32_rasqal_config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+
+#include <raptor.h>
+
+#include "rasqal.h"
+#include "rasqal_internal.h"
+
+
+#ifndef STANDALONE
+
+/*
+ * The decoded results of SERVICE requests are kept in the world,
+ * keyed on the service URI, the query string (including any VALUES
+ * block sent by a bind-join), the data graphs and the requested
+ * format.  Entries are found by a hash of the key and are also kept
+ * on a list in order of use.  Entries expire after a time to live
+ * and the least recently used entries are removed when the cache
+ * grows over its size limit.
+ *
+ * The cache does not use HTTP caching headers: raptor_www only
+ * reports the content type and final URI of a response.
+ */
+
+/* initial number of hash buckets; always a power of 2 */
+#define RASQAL_SERVICE_CACHE_BUCKETS 64
+
+typedef struct rasqal_service_cache_entry_s
+{
+  unsigned char* key;
+  size_t key_len;
+
+  /* hash of @key */
+  unsigned int hash;
+
+  /* next entry in the same hash bucket */
+  struct rasqal_service_cache_entry_s* bucket_next;
+
+  /* more and less recently used entries */
+  struct rasqal_service_cache_entry_s* prev;
+  struct rasqal_service_cache_entry_s* next;
+
+  /* sequence of variable names (unsigned char*) */
+  raptor_sequence* names;
+
+  /* rows_count rows of names size values, row by row; NULL if unbound */
+  rasqal_literal** values;
+  int rows_count;
+
+  /* when this entry expires */
+  time_t expires;
+
+  /* approximate memory used by this entry */
+  size_t size;
+} rasqal_service_cache_entry;
+
+
+struct rasqal_service_cache_s
+{
+  rasqal_world* world;
+
+  /* hash buckets of entries */
+  rasqal_service_cache_entry** buckets;
+  unsigned int buckets_count;
+
+  /* number of entries */
+  unsigned int count;
+
+  /* most and least recently used entries */
+  rasqal_service_cache_entry* first;
+  rasqal_service_cache_entry* last;
+
+  /* approximate memory used by all entries */
+  size_t size;
+
+  /* maximum memory to use */
+  size_t max_size;
+
+  /* time to live of entries in seconds */
+  int ttl;
+};
+
+
+static void
+rasqal_free_service_cache_entry(rasqal_service_cache_entry* entry)
+{
+  if(entry->key)
+    RASQAL_FREE(char*, entry->key);
+
+  if(entry->names)
+    raptor_free_sequence(entry->names);
+
+  if(entry->values) {
+    int count = entry->rows_count * raptor_sequence_size(entry->names);
+    int i;
+
+    for(i = 0; i < count; i++) {
+      if(entry->values[i])
+        rasqal_free_literal(entry->values[i]);
+    }
+
+    RASQAL_FREE(rasqal_literal**, entry->values);
+  }
+
+  RASQAL_FREE(rasqal_service_cache_entry, entry);
+}
+
+
+static void
+rasqal_service_cache_free_name(unsigned char* name)
+{
+  RASQAL_FREE(char*, name);
+}
+
+
+/*
+ * rasqal_new_service_cache:
+ * @world: rasqal world
+ * @max_size: maximum approximate memory in bytes to use
+ * @ttl: time to live of cached results in seconds
+ *
+ * INTERNAL - Constructor - create a new SERVICE results cache
+ *
+ * Return value: new cache or NULL on failure
+ */
+static rasqal_service_cache*
+rasqal_new_service_cache(rasqal_world* world, size_t max_size, int ttl)
+{
+  rasqal_service_cache* cache;
+
+  cache = RASQAL_CALLOC(rasqal_service_cache*, 1, sizeof(*cache));
+  if(!cache)
+    return NULL;
+
+  cache->world = world;
+  cache->max_size = max_size;
+  cache->ttl = ttl;
+
+  cache->buckets_count = RASQAL_SERVICE_CACHE_BUCKETS;
+  cache->buckets = RASQAL_CALLOC(rasqal_service_cache_entry**,
+                                 cache->buckets_count,
+                                 sizeof(rasqal_service_cache_entry*));
+  if(!cache->buckets) {
+    RASQAL_FREE(rasqal_service_cache, cache);
+    return NULL;
+  }
+
+  return cache;
+}
+
+
+/*
+ * rasqal_free_service_cache:
+ * @cache: SERVICE results cache
+ *
+ * INTERNAL - Destructor - destroy a SERVICE results cache
+ */
+void
+rasqal_free_service_cache(rasqal_service_cache* cache)
+{
+  rasqal_service_cache_entry* entry;
+
+  if(!cache)
+    return;
+
+  while((entry = cache->first)) {
+    cache->first = entry->next;
+    rasqal_free_service_cache_entry(entry);
+  }
+
+  if(cache->buckets)
+    RASQAL_FREE(rasqal_service_cache_entry**, cache->buckets);
+
+  RASQAL_FREE(rasqal_service_cache, cache);
+}
+
+
+/* FNV-1a hash of a request key */
+static unsigned int
+rasqal_service_cache_hash(const unsigned char* key, size_t key_len)
+{
+  unsigned int hash = 2166136261U;
+
+  while(key_len--) {
+    hash ^= *key++;
+    hash *= 16777619U;
+  }
+
+  return hash;
+}
+
+
+/*
+ * rasqal_service_cache_unlink_use:
+ *
+ * INTERNAL - Take an entry off the list in order of use
+ */
+static void
+rasqal_service_cache_unlink_use(rasqal_service_cache* cache,
+                                rasqal_service_cache_entry* entry)
+{
+  if(entry->prev)
+    entry->prev->next = entry->next;
+  else
+    cache->first = entry->next;
+
+  if(entry->next)
+    entry->next->prev = entry->prev;
+  else
+    cache->last = entry->prev;
+
+  entry->prev = NULL;
+  entry->next = NULL;
+}
+
+
+/*
+ * rasqal_service_cache_link_first:
+ *
+ * INTERNAL - Put an entry at the front of the list as the most recently used
+ */
+static void
+rasqal_service_cache_link_first(rasqal_service_cache* cache,
+                                rasqal_service_cache_entry* entry)
+{
+  entry->prev = NULL;
+  entry->next = cache->first;
+  if(cache->first)
+    cache->first->prev = entry;
+  else
+    cache->last = entry;
+  cache->first = entry;
+}
+
+
+/*
+ * rasqal_service_cache_remove:
+ *
+ * INTERNAL - Remove and free an entry
+ */
+static void
+rasqal_service_cache_remove(rasqal_service_cache* cache,
+                            rasqal_service_cache_entry* entry)
+{
+  rasqal_service_cache_entry** prev;
+
+  prev = &cache->buckets[entry->hash & (cache->buckets_count - 1)];
+  while(*prev != entry)
+    prev = &(*prev)->bucket_next;
+  *prev = entry->bucket_next;
+
+  rasqal_service_cache_unlink_use(cache, entry);
+
+  cache->count--;
+  cache->size -= entry->size;
+  rasqal_free_service_cache_entry(entry);
+}
+
+
+/*
+ * rasqal_service_cache_grow:
+ *
+ * INTERNAL - Double the hash buckets when there are more entries than buckets
+ *
+ * The cache keeps working with the old buckets if they cannot be grown.
+ */
+static void
+rasqal_service_cache_grow(rasqal_service_cache* cache)
+{
+  rasqal_service_cache_entry** buckets;
+  rasqal_service_cache_entry* entry;
+  unsigned int buckets_count = cache->buckets_count << 1;
+
+  if(cache->count <= cache->buckets_count)
+    return;
+
+  buckets = RASQAL_CALLOC(rasqal_service_cache_entry**, buckets_count,
+                          sizeof(rasqal_service_cache_entry*));
+  if(!buckets)
+    return;
+
+  for(entry = cache->first; entry; entry = entry->next) {
+    rasqal_service_cache_entry** bucket;
+
+    bucket = &buckets[entry->hash & (buckets_count - 1)];
+    entry->bucket_next = *bucket;
+    *bucket = entry;
+  }
+
+  RASQAL_FREE(rasqal_service_cache_entry**, cache->buckets);
+  cache->buckets = buckets;
+  cache->buckets_count = buckets_count;
+}
+
+
+/*
+ * rasqal_service_cache_find:
+ *
+ * INTERNAL - Find the unexpired entry for a key
+ *
+ * An expired entry is removed when it is found.
+ *
+ * Return value: entry or NULL if not present
+ */
+static rasqal_service_cache_entry*
+rasqal_service_cache_find(rasqal_service_cache* cache,
+                          const unsigned char* key, size_t key_len)
+{
+  rasqal_service_cache_entry* entry;
+  unsigned int hash = rasqal_service_cache_hash(key, key_len);
+
+  entry = cache->buckets[hash & (cache->buckets_count - 1)];
+  for(; entry; entry = entry->bucket_next) {
+    if(entry->hash == hash && entry->key_len == key_len &&
+       !memcmp(entry->key, key, key_len))
+      break;
+  }
+
+  if(entry && entry->expires <= time(NULL)) {
+    rasqal_service_cache_remove(cache, entry);
+    entry = NULL;
+  }
+
+  return entry;
+}
+
+
+/*
+ * rasqal_service_cache_literal_size:
+ *
+ * INTERNAL - Approximate memory used by a literal
+ */
+static size_t
+rasqal_service_cache_literal_size(rasqal_literal* l)
+{
+  size_t size = sizeof(*l) + l->string_len;
+
+  if(l->type == RASQAL_LITERAL_URI) {
+    size_t uri_len;
+
+    raptor_uri_as_counted_string(l->value.uri, &uri_len);
+    size += uri_len;
+  }
+
+  return size;
+}
+
+
+/*
+ * rasqal_service_cache_entry_rowsource:
+ * @cache: SERVICE results cache
+ * @entry: cache entry
+ * @vars_table: variables table
+ *
+ * INTERNAL - Make a rowsource returning the results in a cache entry
+ *
+ * Return value: new rowsource or NULL on failure
+ */
+static rasqal_rowsource*
+rasqal_service_cache_entry_rowsource(rasqal_service_cache* cache,
+                                     rasqal_service_cache_entry* entry,
+                                     rasqal_variables_table* vars_table)
+{
+  raptor_sequence* vars_seq;
+  raptor_sequence* rows_seq;
+  int size;
+  int i;
+
+  size = raptor_sequence_size(entry->names);
+
+  vars_seq = raptor_new_sequence((raptor_data_free_handler)rasqal_free_variable,
+                                 (raptor_data_print_handler)rasqal_variable_print);
+  rows_seq = raptor_new_sequence((raptor_data_free_handler)rasqal_free_row,
+                                 (raptor_data_print_handler)rasqal_row_print);
+  if(!vars_seq || !rows_seq)
+    goto failed;
+
+  for(i = 0; i < size; i++) {
+    unsigned char* name;
+    rasqal_variable* v;
+
+    name = (unsigned char*)raptor_sequence_get_at(entry->names, i);
+    v = rasqal_variables_table_add2(vars_table, RASQAL_VARIABLE_TYPE_NORMAL,
+                                    name, 0, NULL);
+    if(!v || raptor_sequence_push(vars_seq, v))
+      goto failed;
+  }
+
+  for(i = 0; i < entry->rows_count; i++) {
+    rasqal_literal** values = &entry->values[i * size];
+    rasqal_row* row;
+    int j;
+
+    row = rasqal_new_row_for_size(cache->world, size);
+    if(!row)
+      goto failed;
+
+    for(j = 0; j < size; j++) {
+      if(values[j])
+        row->values[j] = rasqal_new_literal_from_literal(values[j]);
+    }
+    row->offset = i;
+
+    if(raptor_sequence_push(rows_seq, row))
+      goto failed;
+  }
+
+  /* rows_seq and vars_seq become owned by the rowsource */
+  return rasqal_new_rowsequence_rowsource(cache->world, NULL, vars_table,
+                                          rows_seq, vars_seq);
+
+  failed:
+  if(vars_seq)
+    raptor_free_sequence(vars_seq);
+  if(rows_seq)
+    raptor_free_sequence(rows_seq);
+
+  return NULL;
+}
+
+
+/*
+ * rasqal_service_cache_contains:
+ * @cache: SERVICE results cache
+ * @key: request key
+ * @key_len: length of @key
+ *
+ * INTERNAL - Check if the results of a SERVICE request are cached
+ *
+ * Return value: non-0 if present
+ */
+int
+rasqal_service_cache_contains(rasqal_service_cache* cache,
+                              const unsigned char* key, size_t key_len)
+{
+  return (rasqal_service_cache_find(cache, key, key_len) != NULL);
+}
+
+
+/*
+ * rasqal_service_cache_get_rowsource:
+ * @cache: SERVICE results cache
+ * @key: request key
+ * @key_len: length of @key
+ * @vars_table: variables table for the rowsource
+ *
+ * INTERNAL - Get a rowsource for cached results of a SERVICE request
+ *
+ * Return value: new rowsource or NULL if the results are not cached
+ */
+rasqal_rowsource*
+rasqal_service_cache_get_rowsource(rasqal_service_cache* cache,
+                                   const unsigned char* key, size_t key_len,
+                                   rasqal_variables_table* vars_table)
+{
+  rasqal_service_cache_entry* entry;
+
+  entry = rasqal_service_cache_find(cache, key, key_len);
+  if(!entry)
+    return NULL;
+
+  /* Move to the front as the most recently used */
+  rasqal_service_cache_unlink_use(cache, entry);
+  rasqal_service_cache_link_first(cache, entry);
+
+  RASQAL_DEBUG3("Using %d cached rows for service request '%s'\n",
+                entry->rows_count, key);
+
+  return rasqal_service_cache_entry_rowsource(cache, entry, vars_table);
+}
+
+
+/*
+ * rasqal_service_cache_add:
+ * @cache: SERVICE results cache
+ * @key: request key
+ * @key_len: length of @key
+ * @vars_seq: sequence of #rasqal_variable of the results
+ * @rows_seq: sequence of #rasqal_row of the results
+ *
+ * INTERNAL - Add the results of a SERVICE request to the cache
+ *
+ * Results larger than the cache size limit are not added.  The
+ * sequences are not changed.
+ *
+ * Return value: non-0 on failure
+ */
+int
+rasqal_service_cache_add(rasqal_service_cache* cache,
+                         const unsigned char* key, size_t key_len,
+                         raptor_sequence* vars_seq, raptor_sequence* rows_seq)
+{
+  rasqal_service_cache_entry* entry;
+  rasqal_service_cache_entry** bucket;
+  int size;
+  int count;
+  int i;
+
+  size = raptor_sequence_size(vars_seq);
+  /* A rowsequence rowsource needs at least one variable */
+  if(!size)
+    return 0;
+
+  entry = rasqal_service_cache_find(cache, key, key_len);
+  if(entry)
+    rasqal_service_cache_remove(cache, entry);
+
+  entry = RASQAL_CALLOC(rasqal_service_cache_entry*, 1, sizeof(*entry));
+  if(!entry)
+    return 1;
+
+  entry->expires = time(NULL) + cache->ttl;
+  entry->size = sizeof(*entry) + key_len;
+  entry->hash = rasqal_service_cache_hash(key, key_len);
+
+  entry->key = RASQAL_MALLOC(unsigned char*, key_len + 1);
+  entry->names = raptor_new_sequence((raptor_data_free_handler)rasqal_service_cache_free_name,
+                                     NULL);
+  if(!entry->key || !entry->names)
+    goto failed;
+  memcpy(entry->key, key, key_len);
+  entry->key[key_len] = '\0';
+  entry->key_len = key_len;
+
+  for(i = 0; i < size; i++) {
+    rasqal_variable* v;
+    unsigned char* name;
+    size_t name_len;
+
+    v = (rasqal_variable*)raptor_sequence_get_at(vars_seq, i);
+    name_len = strlen(RASQAL_GOOD_CAST(const char*, v->name));
+    name = RASQAL_MALLOC(unsigned char*, name_len + 1);
+    if(!name)
+      goto failed;
+    memcpy(name, v->name, name_len + 1);
+
+    if(raptor_sequence_push(entry->names, name))
+      goto failed;
+    entry->size += name_len + 1;
+  }
+
+  entry->rows_count = raptor_sequence_size(rows_seq);
+  count = entry->rows_count * size;
+  entry->size += RASQAL_GOOD_CAST(size_t, count) * sizeof(rasqal_literal*);
+  if(entry->size > cache->max_size) {
+    rasqal_free_service_cache_entry(entry);
+    return 0;
+  }
+
+  if(count) {
+    entry->values = RASQAL_CALLOC(rasqal_literal**,
+                                  RASQAL_GOOD_CAST(size_t, count),
+                                  sizeof(rasqal_literal*));
+    if(!entry->values) {
+      entry->rows_count = 0;
+      goto failed;
+    }
+  }
+
+  for(i = 0; i < entry->rows_count; i++) {
+    rasqal_row* row = (rasqal_row*)raptor_sequence_get_at(rows_seq, i);
+    int j;
+
+    for(j = 0; j < size && j < row->size; j++) {
+      rasqal_literal* l = row->values[j];
+
+      if(!l)
+        continue;
+
+      entry->values[i * size + j] = rasqal_new_literal_from_literal(l);
+      entry->size += rasqal_service_cache_literal_size(l);
+    }
+
+    if(entry->size > cache->max_size) {
+      rasqal_free_service_cache_entry(entry);
+      return 0;
+    }
+  }
+
+  /* Make room by removing the least recently used entries */
+  while(cache->size + entry->size > cache->max_size && cache->last)
+    rasqal_service_cache_remove(cache, cache->last);
+
+  bucket = &cache->buckets[entry->hash & (cache->buckets_count - 1)];
+  entry->bucket_next = *bucket;
+  *bucket = entry;
+  rasqal_service_cache_link_first(cache, entry);
+  cache->count++;
+  cache->size += entry->size;
+
+  rasqal_service_cache_grow(cache);
+
+  RASQAL_DEBUG4("Cached %d rows using %lu bytes for service request '%s'\n",
+                entry->rows_count, RASQAL_GOOD_CAST(unsigned long, entry->size),
+                key);
+
+  return 0;
+
+  failed:
+  rasqal_free_service_cache_entry(entry);
+
+  return 1;
+}
+
+
+/**
+ * rasqal_world_set_service_cache:
+ * @world: rasqal_world object
+ * @max_size: maximum approximate memory in bytes to use or 0 to disable
+ * @ttl: time to live of cached results in seconds
+ *
+ * Set the cache of SERVICE results.
+ *
+ * When enabled, the results of SERVICE requests in queries and of
+ * rasqal_service_execute() are kept for @ttl seconds and repeated
+ * requests with the same service URI, query, data graphs and format
+ * are answered from the cache without network access.  The least
+ * recently used results are removed when the cache grows over
+ * @max_size bytes.
+ *
+ * Calling this method removes any cached results.  The cache is
+ * disabled by default.
+ *
+ * Return value: non-0 on failure
+ */
+int
+rasqal_world_set_service_cache(rasqal_world* world, size_t max_size, int ttl)
+{
+  RASQAL_ASSERT_OBJECT_POINTER_RETURN_VALUE(world, rasqal_world, 1);
+
+  if(ttl < 0)
+    return 1;
+
+  if(world->service_cache) {
+    rasqal_free_service_cache(world->service_cache);
+    world->service_cache = NULL;
+  }
+
+  if(!max_size || !ttl)
+    return 0;
+
+  world->service_cache = rasqal_new_service_cache(world, max_size, ttl);
+
+  return (world->service_cache == NULL);
+}
+
+
+#endif /* not STANDALONE */
+
+
+
+#ifdef STANDALONE
+
+/* one more prototype */
+int main(int argc, char *argv[]);
+
+
+#define CACHE_KEY "http://example.org/sparql\nSELECT * WHERE { ?s ?p ?o }"
+#define CACHE_KEY_FORMAT "http://example.org/sparql\nSELECT * { ?s ?p %d }"
+#define CACHE_KEYS_COUNT 200
+
+int
+main(int argc, char *argv[])
+{
+  const char *program = rasqal_basename(argv[0]);
+  rasqal_world* world = NULL;
+  rasqal_query* query = NULL;
+  rasqal_variables_table* vt;
+  raptor_sequence* vars_seq = NULL;
+  raptor_sequence* rows_seq = NULL;
+  rasqal_rowsource* rowsource = NULL;
+  rasqal_variable* v;
+  rasqal_row* row;
+  char key[64];
+  int failures = 0;
+  int count;
+
+  world = rasqal_new_world();
+  if(!world || rasqal_world_open(world)) {
+    fprintf(stderr, "%s: rasqal_world init failed\n", program);
+    return(1);
+  }
+
+  query = rasqal_new_query(world, "sparql", NULL);
+  vt = query->vars_table;
+
+  if(rasqal_world_set_service_cache(world, 1024 * 1024, 60)) {
+    fprintf(stderr, "%s: rasqal_world_set_service_cache() failed\n", program);
+    failures++;
+    goto tidy;
+  }
+
+  /* Nothing is cached yet */
+  rowsource = rasqal_service_cache_get_rowsource(world->service_cache,
+                                                 (const unsigned char*)CACHE_KEY,
+                                                 strlen(CACHE_KEY), vt);
+  if(rowsource) {
+    fprintf(stderr, "%s: empty cache returned a rowsource\n", program);
+    failures++;
+    goto tidy;
+  }
+
+  vars_seq = raptor_new_sequence((raptor_data_free_handler)rasqal_free_variable,
+                                 (raptor_data_print_handler)rasqal_variable_print);
+  rows_seq = raptor_new_sequence((raptor_data_free_handler)rasqal_free_row,
+                                 (raptor_data_print_handler)rasqal_row_print);
+  v = rasqal_variables_table_add2(vt, RASQAL_VARIABLE_TYPE_NORMAL,
+                                  (const unsigned char*)"s", 0, NULL);
+  raptor_sequence_push(vars_seq, v);
+
+  for(count = 0; count < 3; count++) {
+    unsigned char* s = RASQAL_MALLOC(unsigned char*, 2);
+
+    s[0] = RASQAL_GOOD_CAST(unsigned char, 'a' + count);
+    s[1] = '\0';
+    row = rasqal_new_row_for_size(world, 1);
+    row->values[0] = rasqal_new_string_literal(world, s, NULL, NULL, NULL);
+    raptor_sequence_push(rows_seq, row);
+  }
+
+  if(rasqal_service_cache_add(world->service_cache,
+                              (const unsigned char*)CACHE_KEY,
+                              strlen(CACHE_KEY), vars_seq, rows_seq)) {
+    fprintf(stderr, "%s: rasqal_service_cache_add() failed\n", program);
+    failures++;
+    goto tidy;
+  }
+
+  rowsource = rasqal_service_cache_get_rowsource(world->service_cache,
+                                                 (const unsigned char*)CACHE_KEY,
+                                                 strlen(CACHE_KEY), vt);
+  if(!rowsource) {
+    fprintf(stderr, "%s: cached results were not found\n", program);
+    failures++;
+    goto tidy;
+  }
+
+  count = 0;
+  while((row = rasqal_rowsource_read_row(rowsource))) {
+    const unsigned char* s;
+
+    s = rasqal_literal_as_string(row->values[0]);
+    if(!s || s[0] != 'a' + count) {
+      fprintf(stderr, "%s: cached row %d has wrong value\n", program, count);
+      failures++;
+    }
+    count++;
+    rasqal_free_row(row);
+  }
+
+  if(count != 3) {
+    fprintf(stderr, "%s: read %d cached rows, expected 3\n", program, count);
+    failures++;
+  }
+  rasqal_free_rowsource(rowsource);
+  rowsource = NULL;
+
+  /* Many keys are all found after the hash buckets grow */
+  for(count = 0; count < CACHE_KEYS_COUNT; count++) {
+    sprintf(key, CACHE_KEY_FORMAT, count);
+    rasqal_service_cache_add(world->service_cache, (const unsigned char*)key,
+                             strlen(key), vars_seq, rows_seq);
+  }
+  for(count = 0; count < CACHE_KEYS_COUNT; count++) {
+    sprintf(key, CACHE_KEY_FORMAT, count);
+    if(!rasqal_service_cache_contains(world->service_cache,
+                                      (const unsigned char*)key,
+                                      strlen(key))) {
+      fprintf(stderr, "%s: cached results for key %d were not found\n",
+              program, count);
+      failures++;
+      break;
+    }
+  }
+
+  /* The least recently used results are removed first */
+  rasqal_world_set_service_cache(world, 4096, 60);
+  for(count = 0; count < CACHE_KEYS_COUNT; count++) {
+    sprintf(key, CACHE_KEY_FORMAT, count);
+    rasqal_service_cache_add(world->service_cache, (const unsigned char*)key,
+                             strlen(key), vars_seq, rows_seq);
+
+    /* keep the first results in use */
+    sprintf(key, CACHE_KEY_FORMAT, 0);
+    rowsource = rasqal_service_cache_get_rowsource(world->service_cache,
+                                                   (const unsigned char*)key,
+                                                   strlen(key), vt);
+    if(!rowsource) {
+      fprintf(stderr, "%s: results in use were removed after adding key %d\n",
+              program, count);
+      failures++;
+      break;
+    }
+    rasqal_free_rowsource(rowsource);
+    rowsource = NULL;
+  }
+  sprintf(key, CACHE_KEY_FORMAT, 1);
+  if(rasqal_service_cache_contains(world->service_cache,
+                                   (const unsigned char*)key, strlen(key))) {
+    fprintf(stderr, "%s: least recently used results were not removed\n",
+            program);
+    failures++;
+  }
+
+  /* Results over the size limit are not cached */
+  rasqal_world_set_service_cache(world, 16, 60);
+  rasqal_service_cache_add(world->service_cache,
+                           (const unsigned char*)CACHE_KEY,
+                           strlen(CACHE_KEY), vars_seq, rows_seq);
+  rowsource = rasqal_service_cache_get_rowsource(world->service_cache,
+                                                 (const unsigned char*)CACHE_KEY,
+                                                 strlen(CACHE_KEY), vt);
+  if(rowsource) {
+    fprintf(stderr, "%s: results over the cache size limit were cached\n",
+            program);
+    failures++;
+  }
+
+  tidy:
+  if(rowsource)
+    rasqal_free_rowsource(rowsource);
+  if(rows_seq)
+    raptor_free_sequence(rows_seq);
+  if(vars_seq)
+    raptor_free_sequence(vars_seq);
+  if(query)
+    rasqal_free_query(query);
+  if(world)
+    rasqal_free_world(world);
+
+  return failures;
+}
+
+#endif /* STANDALONE */
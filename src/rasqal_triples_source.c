@@ -397,3 +397,26 @@ rasqal_triples_source_support_feature(rasqal_triples_source *rts,
 }
 
 
+/*
+ * rasqal_triples_source_triples_count:
+ * @rts: triples source
+ * @t: triple pattern
+ * @count_p: pointer to store the count
+ *
+ * INTERNAL - Count the triples matching a triple pattern
+ *
+ * Variables in @t are wildcards.  Only triples sources of API V3 or
+ * later that provide a triples_count method can do this.
+ *
+ * Return value: non-0 if the triples source cannot count @t
+ */
+int
+rasqal_triples_source_triples_count(rasqal_triples_source *rts,
+                                    rasqal_triple *t,
+                                    rasqal_integer *count_p)
+{
+  if(rts->version >= 3 && rts->triples_count)
+    return rts->triples_count(rts, rts->user_data, t, count_p);
+  else
+    return 1;
+}
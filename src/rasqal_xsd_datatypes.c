@@ -105,9 +105,6 @@ rasqal_xsd_check_boolean_format(const unsigned char* string, int flags)
 }
 
 
-#define ADVANCE_OR_DIE(p) if(!*(++p)) return 0;
-
-
 /**
  * rasqal_xsd_check_date_format:
  * @string: lexical form string
@@ -146,54 +143,111 @@ rasqal_xsd_check_dateTime_format(const unsigned char* string, int flags)
 }
 
 
+/* Numeric types accepting a lexical form in rasqal_xsd_scan_numeric() */
+#define XSD_NUMERIC_INTEGER 1
+#define XSD_NUMERIC_DECIMAL 2
+#define XSD_NUMERIC_DOUBLE  4
+
+#define XSD_IS_DIGIT(c) ((c) >= '0' && (c) <= '9')
+
 /**
- * rasqal_xsd_check_decimal_format:
+ * rasqal_xsd_scan_numeric:
  * @string: lexical form string
- * flags: flags
  *
- * INTERNAL - Check an XSD decimal lexical form
+ * INTERNAL - Scan a numeric lexical form once for all the numeric XSD types
  *
- * Return value: non-0 if the string is valid
+ * Validates @string in a single pass against
+ * http://www.w3.org/TR/xmlschema-2/#integer
+ * http://www.w3.org/TR/xmlschema-2/#decimal and
+ * http://www.w3.org/TR/xmlschema-2/#double (also used for #float)
+ *
+ * Return value: bitmask of XSD_NUMERIC_ flags for the types that
+ * accept @string
  */
 static int
-rasqal_xsd_check_decimal_format(const unsigned char* string, int flags) 
+rasqal_xsd_scan_numeric(const unsigned char* string)
 {
-  const char* p;
-  
-  /* This should be correct according to 
-   * http://www.w3.org/TR/xmlschema-2/#decimal
-   */
-  p = RASQAL_GOOD_CAST(const char*, string);
+  const unsigned char* p = string;
+  const unsigned char* digits;
+  int have_sign = 0;
+  int have_point = 0;
+  size_t int_digits;
+  size_t frac_digits = 0;
+  int accept = 0;
+
   if(*p == '+' || *p == '-') {
-    ADVANCE_OR_DIE(p);
+    have_sign = 1;
+    p++;
   }
 
-  while(*p && isdigit(RASQAL_GOOD_CAST(int, *p)))
-    p++;
-  if(!*p)
-    return 1;
-  /* Fail if first non-digit is not '.' */
-  if(*p != '.')
+  /* double specials -INF, INF and NaN */
+  if(*p == 'I' || *p == 'N') {
+    if((*string != '+' && !strcmp(RASQAL_GOOD_CAST(const char*, p), "INF")) ||
+       (!have_sign && !strcmp(RASQAL_GOOD_CAST(const char*, p), "NaN")))
+      return XSD_NUMERIC_DOUBLE;
+    return 0;
+  }
+
+  for(digits = p; XSD_IS_DIGIT(*p); p++)
+    ;
+  int_digits = RASQAL_GOOD_CAST(size_t, p - digits);
+
+  if(*p == '.') {
+    have_point = 1;
+    for(digits = ++p; XSD_IS_DIGIT(*p); p++)
+      ;
+    frac_digits = RASQAL_GOOD_CAST(size_t, p - digits);
+  }
+
+  if(!*p) {
+    /* decimal allows anything but a sign on its own */
+    if(!have_sign || int_digits || have_point)
+      accept |= XSD_NUMERIC_DECIMAL;
+
+    /* integer and double need leading digits; double forbids ending
+     * with a '.' */
+    if(int_digits) {
+      if(!have_point)
+        accept |= XSD_NUMERIC_INTEGER | XSD_NUMERIC_DOUBLE;
+      else if(frac_digits)
+        accept |= XSD_NUMERIC_DOUBLE;
+    }
+
+    return accept;
+  }
+
+  /* only a double may continue, with an exponent after mantissa digits */
+  if((*p != 'e' && *p != 'E') || !int_digits)
     return 0;
   p++;
-  
-  while(*p && isdigit(RASQAL_GOOD_CAST(int, *p)))
+
+  if(*p == '-' || *p == '+')
     p++;
-  /* Fail if anything other than a digit seen before NUL */
-  if(*p)
+
+  for(digits = p; XSD_IS_DIGIT(*p); p++)
+    ;
+  if(p == digits || *p)
     return 0;
 
-  return 1;
+  return XSD_NUMERIC_DOUBLE;
 }
 
 
-/* Legal special double values */
-#define XSD_DOUBLE_SPECIALS_LEN 3
-static const char * const xsd_double_specials[XSD_DOUBLE_SPECIALS_LEN] = {
-  "-INF",
-  "INF",
-  "NaN"
-};
+/**
+ * rasqal_xsd_check_decimal_format:
+ * @string: lexical form string
+ * flags: flags
+ *
+ * INTERNAL - Check an XSD decimal lexical form
+ *
+ * Return value: non-0 if the string is valid
+ */
+static int
+rasqal_xsd_check_decimal_format(const unsigned char* string, int flags) 
+{
+  return (rasqal_xsd_scan_numeric(string) & XSD_NUMERIC_DECIMAL) != 0;
+}
+
 
 /**
  * rasqal_xsd_check_double_format:
@@ -207,74 +261,7 @@ static const char * const xsd_double_specials[XSD_DOUBLE_SPECIALS_LEN] = {
 int
 rasqal_xsd_check_double_format(const unsigned char* string, int flags) 
 {
-  const char *p = RASQAL_GOOD_CAST(const char*, string);
-  const char *saved_p;
-  int i;
-  
-  if(!*p)
-    return 0;
-
-  /* Validating http://www.w3.org/TR/xmlschema-2/#double */
-
-  /* check for specials */
-  for(i = 0; i < XSD_DOUBLE_SPECIALS_LEN; i++) {
-    if(!strcmp(xsd_double_specials[i], p))
-      return 1;
-  }
-
-  /* mantissa: follows http://www.w3.org/TR/xmlschema-2/#decimal */
-  if(*p == '-' || *p == '+')
-    p++;
-  if(!*p)
-    return 0;
-
-  saved_p = p;
-  while(isdigit(*p))
-    p++;
-  
-  /* no digits is a failure */
-  if(p == saved_p)
-    return 0;
-
-  /* ending now is ok - whole number (-1, +2, 3) */
-  if(!*p)
-    return 1;
-
-  /* .DIGITS is optional */
-  if(*p == '.') {
-    p++;
-    /* ending after . is not ok */
-    if(!*p)
-      return 0;
-
-    while(isdigit(*p))
-      p++;
-
-    /* ending with digits now is ok (-1.2, +2.3, 2.3) */
-    if(!*p)
-      return 1;
-  }
-
-  /* must be an exponent letter here (-1E... +2e... , -1.3E...,
-   * +2.4e..., 2E..., -4e...) */
-  if(*p != 'e' && *p != 'E')
-    return 0;
-  p++;
-
-  /* exponent: follows http://www.w3.org/TR/xmlschema-2/#integer */
-  if(*p == '-' || *p == '+')
-    p++;
-
-  saved_p = p;
-  while(isdigit(*p))
-    p++;
-  if(p == saved_p)
-    return 0;
-
-  if(*p)
-    return 0;
-
-  return 1;
+  return (rasqal_xsd_scan_numeric(string) & XSD_NUMERIC_DOUBLE) != 0;
 }
 
 
@@ -307,27 +294,7 @@ rasqal_xsd_check_float_format(const unsigned char* string, int flags)
 static int
 rasqal_xsd_check_integer_format(const unsigned char* string, int flags)
 {
-  /* This should be correct according to 
-   * http://www.w3.org/TR/xmlschema-2/#integer
-   */
-
-  /* Forbid empty string */
-  if(!*string)
-    return 0;
-
-  if(*string == '+' || *string == '-') {
-    string++;
-    /* Forbid "+" and "-" */
-    if(!*string)
-      return 0;
-  }
-
-  /* Digits */
-  for(;*string; string++) {
-    if(*string < '0' || *string > '9')
-      return 0;
-  }
-  return 1;
+  return (rasqal_xsd_scan_numeric(string) & XSD_NUMERIC_INTEGER) != 0;
 }
 
 
@@ -336,7 +303,7 @@ rasqal_xsd_check_integer_format(const unsigned char* string, int flags)
  * @i: integer
  * @len_p: pointer to length of result or NULL
  *
- * INTERNAL - Format a C integer as a string in XSD decimal integer format.
+ * INTERNAL - Format a #rasqal_integer as a string in XSD decimal integer format.
  *
  * This is suitable for multiple XSD decimal integer types that are
  * xsd:integer or sub-types such as xsd:short, xsd:int, xsd:long,
@@ -346,7 +313,7 @@ rasqal_xsd_check_integer_format(const unsigned char* string, int flags)
  * Return value: new string or NULL on failure
  */
 unsigned char*
-rasqal_xsd_format_integer(int i, size_t *len_p)
+rasqal_xsd_format_integer(rasqal_integer i, size_t *len_p)
 {
   unsigned char* string;
   
@@ -355,21 +322,97 @@ rasqal_xsd_format_integer(int i, size_t *len_p)
    *   6: 16 bit decimal integers (xsd:short) "-32768" to "32767" 
    *  11: 32 bit decimal integers (xsd:int)   "-2147483648" to "2147483647"
    *  20: 64 bit decimal integers (xsd:long)  "-9223372036854775808" to "9223372036854775807"
-   * (the lexical form may have leading 0s in non-canonical representations)
    */
 #define INTEGER_BUFFER_SIZE 20
-  string = RASQAL_MALLOC(unsigned char*, INTEGER_BUFFER_SIZE + 1);
+  unsigned char buffer[INTEGER_BUFFER_SIZE];
+  unsigned char* p = buffer + INTEGER_BUFFER_SIZE;
+  size_t len;
+  int negative = (i < 0);
+
+  /* Digits are taken from the least significant end; remainders of a
+   * negative value are negative so RASQAL_INTEGER_MIN is not negated */
+  do {
+    int digit = RASQAL_BAD_CAST(int, i % 10);
+
+    *--p = RASQAL_GOOD_CAST(unsigned char, '0' + (negative ? -digit : digit));
+    i /= 10;
+  } while(i);
+  if(negative)
+    *--p = '-';
+
+  len = RASQAL_GOOD_CAST(size_t, (buffer + INTEGER_BUFFER_SIZE) - p);
+  string = RASQAL_MALLOC(unsigned char*, len + 1);
   if(!string)
     return NULL;
-  /* snprintf() takes as length the buffer size including NUL */
-  snprintf(RASQAL_GOOD_CAST(char*, string), INTEGER_BUFFER_SIZE + 1, "%d", i);
+  memcpy(string, p, len);
+  string[len] = '\0';
   if(len_p)
-    *len_p = strlen(RASQAL_GOOD_CAST(const char*, string));
+    *len_p = len;
 
   return string;
 }
 
 
+/**
+ * rasqal_xsd_parse_integer:
+ * @string: decimal integer lexical form
+ * @value_p: pointer to store value
+ *
+ * INTERNAL - Parse a decimal integer into a #rasqal_integer
+ *
+ * Accepts the same forms as strtol() in base 10 - leading white
+ * space, an optional sign and decimal digits - which must end the
+ * string.
+ *
+ * Return value: 0 on success, <0 if @string is not an integer, >0 if
+ * the value is out of the #rasqal_integer range
+ */
+int
+rasqal_xsd_parse_integer(const unsigned char* string,
+                         rasqal_integer* value_p)
+{
+  const unsigned char* p = string;
+  rasqal_integer value = 0;
+  int negative = 0;
+  int overflow = 0;
+
+  while(isspace(*p))
+    p++;
+
+  if(*p == '-' || *p == '+')
+    negative = (*p++ == '-');
+
+  if(!isdigit(*p))
+    return -1;
+
+  /* Accumulate as a negative value which has the larger range */
+  for(; isdigit(*p); p++) {
+    int digit = *p - '0';
+
+    if(value < (RASQAL_INTEGER_MIN + digit) / 10)
+      overflow = 1;
+    else
+      value = value * 10 - digit;
+  }
+
+  if(*p)
+    return -1;
+
+  if(!negative) {
+    if(value == RASQAL_INTEGER_MIN)
+      overflow = 1;
+    else
+      value = -value;
+  }
+
+  if(overflow)
+    return 1;
+
+  *value_p = value;
+  return 0;
+}
+
+
 /**
  * rasqal_xsd_format_float:
  * @i: float
@@ -541,6 +584,49 @@ static int (*const sparql_xsd_checkfns[CHECKFNS_COUNT])(const unsigned char* str
 #define CHECKFN_DATE_OFFSET (RASQAL_LITERAL_DATETIME - RASQAL_LITERAL_FIRST_XSD + 1)
 
 
+#define XSD_DATATYPE_HASH_MASK (RASQAL_XSD_DATATYPE_HASH_SIZE - 1)
+
+/*
+ * rasqal_xsd_datatype_name_hash:
+ * @name: XSD datatype local name
+ * @len: length of @name
+ *
+ * INTERNAL - Get the world xsd_datatype_hash slot to start probing for @name
+ *
+ * Return value: slot index
+ */
+static unsigned int
+rasqal_xsd_datatype_name_hash(const unsigned char* name, size_t len)
+{
+  unsigned int hash = 2166136261U;
+  size_t i;
+
+  /* FNV-1a */
+  for(i = 0; i < len; i++) {
+    hash ^= name[i];
+    hash *= 16777619U;
+  }
+
+  return hash & XSD_DATATYPE_HASH_MASK;
+}
+
+
+static void
+rasqal_xsd_datatype_hash_add(rasqal_world* world, int i)
+{
+  const unsigned char* name;
+  unsigned int slot;
+
+  name = RASQAL_GOOD_CAST(const unsigned char*, sparql_xsd_names[i]);
+  slot = rasqal_xsd_datatype_name_hash(name,
+                                       strlen(RASQAL_GOOD_CAST(const char*, name)));
+  while(world->xsd_datatype_hash[slot])
+    slot = (slot + 1) & XSD_DATATYPE_HASH_MASK;
+
+  world->xsd_datatype_hash[slot] = RASQAL_GOOD_CAST(unsigned char, i);
+}
+
+
 int
 rasqal_xsd_init(rasqal_world* world) 
 {
@@ -564,6 +650,11 @@ rasqal_xsd_init(rasqal_world* world)
       return 1;
   }
 
+  memset(world->xsd_datatype_hash, '\0', sizeof(world->xsd_datatype_hash));
+  for(i = RASQAL_GOOD_CAST(int, RASQAL_LITERAL_FIRST_XSD); i <= RASQAL_GOOD_CAST(int, XSD_INTEGER_DERIVED_LAST); i++)
+    rasqal_xsd_datatype_hash_add(world, i);
+  rasqal_xsd_datatype_hash_add(world, XSD_DATE_OFFSET);
+
   return 0;
 }
 
@@ -591,33 +682,59 @@ rasqal_xsd_finish(rasqal_world* world)
  
 
   
+/**
+ * rasqal_xsd_datatype_uri_to_type:
+ * @world: world
+ * @uri: datatype URI
+ *
+ * INTERNAL - Get the native literal type for an XSD datatype URI
+ *
+ * Finds the local name after the XSD namespace in the world
+ * xsd_datatype_hash so no more than a couple of names are compared.
+ *
+ * Return value: literal type or RASQAL_LITERAL_UNKNOWN if @uri is
+ * not a known XSD datatype
+ */
 rasqal_literal_type
 rasqal_xsd_datatype_uri_to_type(rasqal_world* world, raptor_uri* uri)
 {
+  const unsigned char* uri_string;
+  const unsigned char* ns_string;
+  const unsigned char* name;
+  size_t uri_len;
+  size_t ns_len;
+  size_t name_len;
+  unsigned int slot;
   int i;
-  rasqal_literal_type native_type = RASQAL_LITERAL_UNKNOWN;
   
   if(!uri || !world->xsd_datatype_uris)
-    return native_type;
-  
-  for(i = RASQAL_GOOD_CAST(int, RASQAL_LITERAL_FIRST_XSD); i <= RASQAL_GOOD_CAST(int, XSD_INTEGER_DERIVED_LAST); i++) {
-    if(raptor_uri_equals(uri, world->xsd_datatype_uris[i])) {
+    return RASQAL_LITERAL_UNKNOWN;
+
+  uri_string = raptor_uri_as_counted_string(uri, &uri_len);
+  ns_string = raptor_uri_as_counted_string(world->xsd_namespace_uri, &ns_len);
+  if(uri_len <= ns_len || memcmp(uri_string, ns_string, ns_len))
+    return RASQAL_LITERAL_UNKNOWN;
+
+  name = uri_string + ns_len;
+  name_len = uri_len - ns_len;
+
+  slot = rasqal_xsd_datatype_name_hash(name, name_len);
+  while((i = world->xsd_datatype_hash[slot])) {
+    const char* xsd_name = sparql_xsd_names[i];
+
+    if(!strncmp(xsd_name, RASQAL_GOOD_CAST(const char*, name), name_len) &&
+       !xsd_name[name_len]) {
+      if(i == XSD_DATE_OFFSET)
+        return RASQAL_LITERAL_DATE;
       if(i >= XSD_INTEGER_DERIVED_FIRST)
-        native_type = RASQAL_LITERAL_INTEGER_SUBTYPE;
-      else
-        native_type = (rasqal_literal_type)i;
-      break;
+        return RASQAL_LITERAL_INTEGER_SUBTYPE;
+      return (rasqal_literal_type)i;
     }
-  }
 
-  if(native_type == RASQAL_LITERAL_UNKNOWN) {
-    /* DATE is not in the range FIRST_XSD .. INTEGER_DERIVED_LAST */
-    i = RASQAL_GOOD_CAST(int, XSD_DATE_OFFSET);
-    if(raptor_uri_equals(uri, world->xsd_datatype_uris[i]))
-      native_type = RASQAL_LITERAL_DATE;
+    slot = (slot + 1) & XSD_DATATYPE_HASH_MASK;
   }
 
-  return native_type;
+  return RASQAL_LITERAL_UNKNOWN;
 }
 
 
@@ -761,6 +878,20 @@ const char *double_invalid_tests[N_INVALID_TESTS+1] = {
   NULL
 };
 
+#define N_INTEGER_TESTS 6
+static const struct {
+  const char* string;
+  int rc;
+  const char* canonical;
+} integer_tests[N_INTEGER_TESTS] = {
+  { "+0012", 0, "12" },
+  { "-9223372036854775808", 0, "-9223372036854775808" },
+  { "9223372036854775807", 0, "9223372036854775807" },
+  { "9223372036854775808", 1, NULL },
+  { "-9223372036854775809", 1, NULL },
+  { "12a", -1, NULL }
+};
+
 int
 main(int argc, char *argv[])
 {
@@ -805,6 +936,34 @@ main(int argc, char *argv[])
     }
   }
 
+  for(test = 0; test < N_INTEGER_TESTS; test++) {
+    rasqal_integer value = 0;
+    unsigned char* str;
+    int rc;
+
+    rc = rasqal_xsd_parse_integer(RASQAL_GOOD_CAST(const unsigned char*, integer_tests[test].string), &value);
+    if(rc != integer_tests[test].rc) {
+      fprintf(stderr, "%s: Integer Test %3d value: %s returned %d expected %d\n",
+              program, test, integer_tests[test].string, rc,
+              integer_tests[test].rc);
+      failures++;
+      continue;
+    }
+    if(rc)
+      continue;
+
+    str = rasqal_xsd_format_integer(value, NULL);
+    if(!str || strcmp(RASQAL_GOOD_CAST(const char*, str),
+                      integer_tests[test].canonical)) {
+      fprintf(stderr, "%s: Integer Test %3d value: %s formatted as %s expected %s\n",
+              program, test, integer_tests[test].string, str,
+              integer_tests[test].canonical);
+      failures++;
+    }
+    if(str)
+      RASQAL_FREE(char*, str);
+  }
+
   tidy:
 
   rasqal_free_world(world);
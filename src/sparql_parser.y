@@ -36,6 +36,9 @@
 
 #include <stdio.h>
 #include <stdarg.h>
+#ifdef HAVE_LIMITS_H
+#include <limits.h>
+#endif
 
 #include <rasqal.h>
 #include <rasqal_internal.h>
@@ -2638,7 +2641,11 @@ LimitClause: LIMIT INTEGER_LITERAL
   $$ = -1;
 
   if($2 != NULL) {
-    $$ = $2->value.integer;
+    /* clamp to the int range used for query limit and offset */
+    if($2->value.integer > INT_MAX)
+      $$ = INT_MAX;
+    else
+      $$ = RASQAL_BAD_CAST(int, $2->value.integer);
     rasqal_free_literal($2);
   }
   
@@ -2652,7 +2659,11 @@ OffsetClause: OFFSET INTEGER_LITERAL
   $$ = -1;
 
   if($2 != NULL) {
-    $$ = $2->value.integer;
+    /* clamp to the int range used for query limit and offset */
+    if($2->value.integer > INT_MAX)
+      $$ = INT_MAX;
+    else
+      $$ = RASQAL_BAD_CAST(int, $2->value.integer);
     rasqal_free_literal($2);
   }
 }
@@ -0,0 +1,629 @@
+/* -*- Mode: c; c-basic-offset: 2 -*-
+ *
+ * rasqal_benchmark.c - Rasqal RDF Query engine benchmark
+ *
+ * Copyright (C) 2026, David Beckett http://www.dajobe.org/
+ *
+ * This package is Free Software and part of Redland http://librdf.org/
+ *
+ * It is licensed under the following three licenses as alternatives:
+ *   1. GNU Lesser General Public License (LGPL) V2.1 or any newer version
+ *   2. GNU General Public License (GPL) V2 or any newer version
+ *   3. Apache License, V2.0 or any newer version
+ *
+ * You may not use this file except in compliance with at least one of
+ * the above three licenses.
+ *
+ * See LICENSE.html or LICENSE.txt at the top of this package for the
+ * complete terms and further detail along with the license texts for
+ * the licenses in COPYING.LIB, COPYING and LICENSE-2.0.txt respectively.
+ *
+ *
+ * Generates a synthetic dataset of a given scale with a seeded
+ * random number generator (so the same scale and seed always give
+ * the same triples), runs a fixed set of queries over it several
+ * times and writes one JSON object per query with the row count,
+ * rows/sec, latency percentiles and the peak RSS of the whole process
+ * so far (process_peak_rss_kb), which is not reset between queries.
+ *
+ * The dataset mixes two shapes:
+ *   - LUBM-like: universities, departments, faculty, students and
+ *     courses linked by memberOf, takesCourse, teacherOf, advisor
+ *   - BSBM-like: producers and products with labels, integer prices
+ *     and features plus reviews with ratings
+ *
+ * Every query run adds the data file to the query as a background
+ * data graph with rasqal_query_add_data_graph() so each timing
+ * includes parsing the data file; the "load" benchmark measures that
+ * cost alone so it can be subtracted.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <rasqal_config.h>
+#endif
+
+#ifdef WIN32
+#include <win32_rasqal_config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#include <stdarg.h>
+#ifdef HAVE_SYS_TIME_H
+#include <sys/time.h>
+#endif
+#ifdef HAVE_SYS_RESOURCE_H
+#include <sys/resource.h>
+#endif
+
+#include "rasqal.h"
+#include "rasqal_internal.h"
+
+
+#ifndef HAVE_GETTIMEOFDAY
+#define gettimeofday(x,y) rasqal_gettimeofday(x,y)
+#endif
+
+
+#ifdef RASQAL_QUERY_SPARQL
+#define QUERY_LANGUAGE "sparql"
+#else
+#define NO_QUERY_LANGUAGE
+#endif
+
+
+#ifdef NO_QUERY_LANGUAGE
+int
+main(int argc, char **argv) {
+  const char *program = rasqal_basename(argv[0]);
+  fprintf(stderr, "%s: SPARQL query language not available, skipping benchmark\n", program);
+  return(0);
+}
+#else
+
+/* one prototype needed */
+int main(int argc, char *argv[]);
+
+
+#define DEFAULT_SCALE 1000
+#define DEFAULT_RUNS 5
+#define DEFAULT_SEED 1234567U
+#define DEFAULT_DATA_FILENAME "benchmark-data.nt"
+
+#define UB "http://swat.cse.lehigh.edu/onto/univ-bench.owl#"
+#define BSBM "http://www4.wiwiss.fu-berlin.de/bizer/bsbm/v01/vocabulary/"
+#define RDF_TYPE "http://www.w3.org/1999/02/22-rdf-syntax-ns#type"
+#define RDFS_LABEL "http://www.w3.org/2000/01/rdf-schema#label"
+#define XSD_INTEGER "http://www.w3.org/2001/XMLSchema#integer"
+#define DATA "http://example.org/bench/"
+
+#define QUERY_PREFIXES "\
+PREFIX ub: <" UB "> \
+PREFIX bsbm: <" BSBM "> \
+PREFIX rdfs: <http://www.w3.org/2000/01/rdf-schema#> \
+"
+
+typedef struct
+{
+  const char* name;
+  const char* query_string;
+} benchmark_query;
+
+static const benchmark_query benchmark_queries[] = {
+  { "load",
+    "ASK { }" },
+  { "bgp-join",
+    QUERY_PREFIXES "\
+SELECT ?student ?faculty ?course WHERE { \
+  ?student a ub:GraduateStudent . \
+  ?student ub:advisor ?faculty . \
+  ?faculty ub:teacherOf ?course . \
+  ?student ub:takesCourse ?course \
+}" },
+  { "optional",
+    QUERY_PREFIXES "\
+SELECT ?student ?email WHERE { \
+  ?student ub:memberOf ?dept . \
+  OPTIONAL { ?student ub:emailAddress ?email } \
+}" },
+  { "filter-regex",
+    QUERY_PREFIXES "\
+SELECT ?product ?label ?price WHERE { \
+  ?product rdfs:label ?label . \
+  ?product bsbm:price ?price \
+  FILTER(REGEX(?label, \"^product1\") && ?price < 5000) \
+}" },
+  { "group-by",
+    QUERY_PREFIXES "\
+SELECT ?dept (COUNT(?student) AS ?students) (AVG(?age) AS ?age_avg) \
+WHERE { \
+  ?student ub:memberOf ?dept . \
+  ?student ub:age ?age \
+} \
+GROUP BY ?dept" },
+  { "order-limit",
+    QUERY_PREFIXES "\
+SELECT ?product ?price WHERE { \
+  ?product bsbm:price ?price \
+} \
+ORDER BY DESC(?price) ?product \
+LIMIT 10" },
+  { "distinct",
+    QUERY_PREFIXES "\
+SELECT DISTINCT ?feature WHERE { \
+  ?product bsbm:productFeature ?feature \
+}" },
+  { "union",
+    QUERY_PREFIXES "\
+SELECT ?person ?name WHERE { \
+  { ?person a ub:GraduateStudent . ?person ub:name ?name } \
+  UNION \
+  { ?person a ub:FullProfessor . ?person ub:name ?name } \
+}" },
+  { NULL, NULL }
+};
+
+
+/*
+ * Dataset shape for a given scale
+ *
+ * scale is approximately the number of students; everything else is
+ * derived from it so that the join selectivities stay roughly
+ * constant as the scale changes.
+ */
+typedef struct
+{
+  int departments;
+  int faculty_per_department;
+  int courses_per_department;
+  int students_per_department;
+  int courses_per_student;
+  int producers;
+  int products;
+  int features;
+  int reviews_per_product;
+} benchmark_shape;
+
+
+static void
+benchmark_shape_init(benchmark_shape* shape, int scale)
+{
+  shape->students_per_department = 100;
+  shape->departments = scale / shape->students_per_department;
+  if(shape->departments < 1)
+    shape->departments = 1;
+  shape->faculty_per_department = 10;
+  shape->courses_per_department = 20;
+  shape->courses_per_student = 3;
+  shape->products = scale;
+  shape->producers = 1 + scale / 50;
+  shape->features = 1 + scale / 20;
+  shape->reviews_per_product = 2;
+}
+
+
+static int
+benchmark_irand(rasqal_random* random_object, int n)
+{
+  return rasqal_random_irand(random_object) % n;
+}
+
+
+/*
+ * benchmark_generate_data:
+ *
+ * Write the dataset as N-Triples to @fh
+ *
+ * Return value: number of triples written
+ */
+static long
+benchmark_generate_data(FILE* fh, rasqal_random* random_object,
+                        benchmark_shape* shape)
+{
+  long count = 0;
+  int d;
+  int i;
+  int j;
+
+#define T_URI(s, si, p, o, oi) do { \
+    fprintf(fh, "<" DATA s "%d> <" p "> <" DATA o "%d> .\n", si, oi); \
+    count++; \
+  } while(0)
+#define T_TYPE(s, si, c) do { \
+    fprintf(fh, "<" DATA s "%d> <" RDF_TYPE "> <%s> .\n", si, c); \
+    count++; \
+  } while(0)
+#define T_STRING(s, si, p, fmt, oi) do { \
+    fprintf(fh, "<" DATA s "%d> <" p "> \"" fmt "\" .\n", si, oi); \
+    count++; \
+  } while(0)
+#define T_INTEGER(s, si, p, oi) do { \
+    fprintf(fh, "<" DATA s "%d> <" p "> \"%d\"^^<" XSD_INTEGER "> .\n", \
+            si, oi); \
+    count++; \
+  } while(0)
+
+  /* LUBM-like university part */
+  for(d = 0; d < shape->departments; d++) {
+    int faculty_base = d * shape->faculty_per_department;
+    int course_base = d * shape->courses_per_department;
+    int student_base = d * shape->students_per_department;
+
+    T_TYPE("dept", d, UB "Department");
+    T_URI("dept", d, UB "subOrganizationOf", "university", d / 10);
+
+    for(i = 0; i < shape->courses_per_department; i++)
+      T_TYPE("course", course_base + i, UB "Course");
+
+    for(i = 0; i < shape->faculty_per_department; i++) {
+      int f = faculty_base + i;
+
+      T_TYPE("faculty", f,
+             (i % 3) ? UB "AssociateProfessor" : UB "FullProfessor");
+      T_URI("faculty", f, UB "worksFor", "dept", d);
+      T_STRING("faculty", f, UB "name", "Faculty%d", f);
+      for(j = 0; j < 2; j++)
+        T_URI("faculty", f, UB "teacherOf", "course",
+              course_base + (2 * i + j) % shape->courses_per_department);
+    }
+
+    for(i = 0; i < shape->students_per_department; i++) {
+      int s = student_base + i;
+
+      T_TYPE("student", s,
+             (i % 4) ? UB "UndergraduateStudent" : UB "GraduateStudent");
+      T_URI("student", s, UB "memberOf", "dept", d);
+      T_STRING("student", s, UB "name", "Student%d", s);
+      T_INTEGER("student", s, UB "age", 18 + benchmark_irand(random_object, 15));
+      /* only some students have an email address (for OPTIONAL) */
+      if(benchmark_irand(random_object, 3))
+        T_STRING("student", s, UB "emailAddress", "student%d@example.org", s);
+      T_URI("student", s, UB "advisor", "faculty",
+            faculty_base + benchmark_irand(random_object,
+                                           shape->faculty_per_department));
+      for(j = 0; j < shape->courses_per_student; j++)
+        T_URI("student", s, UB "takesCourse", "course",
+              course_base + benchmark_irand(random_object,
+                                            shape->courses_per_department));
+    }
+  }
+
+  /* BSBM-like product part */
+  for(i = 0; i < shape->producers; i++)
+    T_TYPE("producer", i, BSBM "Producer");
+
+  for(i = 0; i < shape->products; i++) {
+    T_TYPE("product", i, BSBM "Product");
+    T_STRING("product", i, RDFS_LABEL, "product%d", i);
+    T_URI("product", i, BSBM "producer", "producer",
+          benchmark_irand(random_object, shape->producers));
+    T_INTEGER("product", i, BSBM "price",
+              1 + benchmark_irand(random_object, 10000));
+    for(j = 0; j < 3; j++)
+      T_URI("product", i, BSBM "productFeature", "feature",
+            benchmark_irand(random_object, shape->features));
+
+    for(j = 0; j < shape->reviews_per_product; j++) {
+      int r = i * shape->reviews_per_product + j;
+
+      T_URI("review", r, BSBM "reviewFor", "product", i);
+      T_INTEGER("review", r, BSBM "rating",
+                1 + benchmark_irand(random_object, 10));
+    }
+  }
+
+#undef T_URI
+#undef T_TYPE
+#undef T_STRING
+#undef T_INTEGER
+
+  return count;
+}
+
+
+static double
+benchmark_elapsed_ms(struct timeval* start, struct timeval* end)
+{
+  return (double)(end->tv_sec - start->tv_sec) * 1000.0 +
+    (double)(end->tv_usec - start->tv_usec) / 1000.0;
+}
+
+
+static int
+benchmark_compare_double(const void* a, const void* b)
+{
+  double da = *(const double*)a;
+  double db = *(const double*)b;
+
+  if(da < db)
+    return -1;
+  return (da > db);
+}
+
+
+/* nearest-rank percentile of sorted @values */
+static double
+benchmark_percentile(double* values, int count, int percent)
+{
+  int rank = (percent * count + 99) / 100;
+
+  if(rank < 1)
+    rank = 1;
+  return values[rank - 1];
+}
+
+
+/* peak resident set size of this process since it started in
+ * kilobytes or -1; it covers every query run so far, not just the
+ * last one */
+static long
+benchmark_peak_rss_kb(void)
+{
+#if defined(HAVE_SYS_RESOURCE_H) && defined(HAVE_GETRUSAGE)
+  struct rusage usage;
+
+  if(!getrusage(RUSAGE_SELF, &usage))
+    return RASQAL_GOOD_CAST(long, usage.ru_maxrss);
+#endif
+  return -1L;
+}
+
+
+/*
+ * benchmark_run_query:
+ *
+ * Prepare, execute and drain the results of one query
+ *
+ * Return value: number of rows (or triples or 1 for boolean results) or <0 on failure
+ */
+static long
+benchmark_run_query(rasqal_world* world, const char* query_string,
+                    raptor_uri* base_uri, raptor_uri* data_uri)
+{
+  rasqal_query *query;
+  rasqal_query_results *results;
+  rasqal_data_graph *dg;
+  long rows = 0;
+
+  query = rasqal_new_query(world, QUERY_LANGUAGE, NULL);
+  if(!query)
+    return -1;
+
+  if(rasqal_query_prepare(query, (const unsigned char*)query_string,
+                          base_uri)) {
+    rasqal_free_query(query);
+    return -1;
+  }
+
+  dg = rasqal_new_data_graph_from_uri(world, data_uri, NULL,
+                                      RASQAL_DATA_GRAPH_BACKGROUND,
+                                      "ntriples", NULL, NULL);
+  if(!dg) {
+    rasqal_free_query(query);
+    return -1;
+  }
+
+  /* the query owns dg from here; it is freed if it cannot be added */
+  if(rasqal_query_add_data_graph(query, dg)) {
+    rasqal_free_query(query);
+    return -1;
+  }
+
+  results = rasqal_query_execute(query);
+  if(!results) {
+    rasqal_free_query(query);
+    return -1;
+  }
+
+  if(rasqal_query_results_is_bindings(results)) {
+    while(!rasqal_query_results_finished(results)) {
+      rows++;
+      if(rasqal_query_results_next(results))
+        break;
+    }
+  } else if(rasqal_query_results_is_graph(results)) {
+    while(rasqal_query_results_get_triple(results)) {
+      rows++;
+      if(rasqal_query_results_next_triple(results))
+        break;
+    }
+  } else if(rasqal_query_results_is_boolean(results)) {
+    if(rasqal_query_results_get_boolean(results) < 0)
+      rows = -1;
+    else
+      rows = 1;
+  }
+
+  rasqal_free_query_results(results);
+  rasqal_free_query(query);
+
+  return rows;
+}
+
+
+int
+main(int argc, char *argv[])
+{
+  const char *program = rasqal_basename(argv[0]);
+  int scale = DEFAULT_SCALE;
+  int runs = DEFAULT_RUNS;
+  unsigned int seed = DEFAULT_SEED;
+  const char* data_filename = DEFAULT_DATA_FILENAME;
+  const char* output_filename = NULL;
+  FILE* out_fh = stdout;
+  FILE* data_fh;
+  rasqal_world *world;
+  rasqal_random* random_object;
+  benchmark_shape shape;
+  raptor_uri* base_uri;
+  raptor_uri* data_uri;
+  unsigned char *uri_string;
+  double* times;
+  long triples_count;
+  int failures = 0;
+  int i;
+
+  for(i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+
+    if(!strcmp(arg, "-h") || i + 1 >= argc) {
+      fprintf(stderr,
+              "USAGE: %s [-s SCALE] [-r RUNS] [-S SEED] [-d DATA-FILE] [-o OUTPUT-FILE]\n"
+              "  -s SCALE      dataset scale; roughly number of students (default %d)\n"
+              "  -r RUNS       number of timed runs per query (default %d)\n"
+              "  -S SEED       random seed for the data generator (default %u)\n"
+              "  -d DATA-FILE  N-Triples file to generate (default %s)\n"
+              "  -o OUTPUT     write JSON results here (default stdout)\n",
+              program, DEFAULT_SCALE, DEFAULT_RUNS, DEFAULT_SEED,
+              DEFAULT_DATA_FILENAME);
+      return 1;
+    }
+
+    if(!strcmp(arg, "-s"))
+      scale = atoi(argv[++i]);
+    else if(!strcmp(arg, "-r"))
+      runs = atoi(argv[++i]);
+    else if(!strcmp(arg, "-S"))
+      seed = RASQAL_GOOD_CAST(unsigned int, strtoul(argv[++i], NULL, 10));
+    else if(!strcmp(arg, "-d"))
+      data_filename = argv[++i];
+    else if(!strcmp(arg, "-o"))
+      output_filename = argv[++i];
+    else {
+      fprintf(stderr, "%s: Unknown argument '%s'\n", program, arg);
+      return 1;
+    }
+  }
+
+  if(scale < 1 || runs < 1) {
+    fprintf(stderr, "%s: scale and runs must be positive\n", program);
+    return 1;
+  }
+
+  world = rasqal_new_world();
+  if(!world || rasqal_world_open(world)) {
+    fprintf(stderr, "%s: rasqal_world init failed\n", program);
+    return(1);
+  }
+
+  /* Generate the dataset */
+  random_object = rasqal_new_random(world);
+  if(!random_object) {
+    fprintf(stderr, "%s: failed to create random number generator\n", program);
+    return 1;
+  }
+  rasqal_random_seed(random_object, seed);
+
+  data_fh = fopen(data_filename, "w");
+  if(!data_fh) {
+    fprintf(stderr, "%s: failed to open data file %s for writing\n", program,
+            data_filename);
+    return 1;
+  }
+  benchmark_shape_init(&shape, scale);
+  triples_count = benchmark_generate_data(data_fh, random_object, &shape);
+  fclose(data_fh);
+  rasqal_free_random(random_object);
+
+  uri_string = raptor_uri_filename_to_uri_string("");
+  base_uri = raptor_new_uri(world->raptor_world_ptr, uri_string);
+  raptor_free_memory(uri_string);
+
+  uri_string = raptor_uri_filename_to_uri_string(data_filename);
+  data_uri = raptor_new_uri(world->raptor_world_ptr, uri_string);
+  raptor_free_memory(uri_string);
+
+  if(output_filename) {
+    out_fh = fopen(output_filename, "w");
+    if(!out_fh) {
+      fprintf(stderr, "%s: failed to open output file %s for writing\n",
+              program, output_filename);
+      return 1;
+    }
+  }
+
+  times = RASQAL_CALLOC(double*, RASQAL_GOOD_CAST(size_t, runs), sizeof(double));
+  if(!times) {
+    fprintf(stderr, "%s: failed to allocate timings\n", program);
+    if(output_filename)
+      fclose(out_fh);
+    raptor_free_uri(data_uri);
+    raptor_free_uri(base_uri);
+    rasqal_free_world(world);
+    return 1;
+  }
+
+  for(i = 0; benchmark_queries[i].name; i++) {
+    const benchmark_query* bq = &benchmark_queries[i];
+    double total_ms = 0.0;
+    long rows = 0;
+    int run;
+
+    /* untimed warm up run that also checks the query works */
+    rows = benchmark_run_query(world, bq->query_string, base_uri, data_uri);
+    if(rows < 0) {
+      fprintf(stderr, "%s: benchmark %s query failed\n", program, bq->name);
+      failures++;
+      continue;
+    }
+
+    for(run = 0; run < runs; run++) {
+      struct timeval start;
+      struct timeval end;
+
+      gettimeofday(&start, NULL);
+      rows = benchmark_run_query(world, bq->query_string, base_uri, data_uri);
+      gettimeofday(&end, NULL);
+
+      if(rows < 0)
+        break;
+
+      times[run] = benchmark_elapsed_ms(&start, &end);
+      total_ms += times[run];
+    }
+
+    if(run < runs) {
+      fprintf(stderr, "%s: benchmark %s query failed in timed run %d\n",
+              program, bq->name, run + 1);
+      failures++;
+      continue;
+    }
+
+    qsort(times, RASQAL_GOOD_CAST(size_t, runs), sizeof(double),
+          benchmark_compare_double);
+
+    fprintf(out_fh,
+            "{\"benchmark\": \"%s\", \"scale\": %d, \"seed\": %u, "
+            "\"triples\": %ld, \"runs\": %d, \"rows\": %ld, "
+            "\"rows_per_sec\": %.1f, \"mean_ms\": %.3f, "
+            "\"min_ms\": %.3f, \"p50_ms\": %.3f, \"p90_ms\": %.3f, "
+            "\"p99_ms\": %.3f, \"max_ms\": %.3f, \"process_peak_rss_kb\": %ld}\n",
+            bq->name, scale, seed, triples_count, runs, rows,
+            (total_ms > 0.0) ? (double)rows * runs * 1000.0 / total_ms : 0.0,
+            total_ms / runs,
+            times[0],
+            benchmark_percentile(times, runs, 50),
+            benchmark_percentile(times, runs, 90),
+            benchmark_percentile(times, runs, 99),
+            times[runs - 1],
+            benchmark_peak_rss_kb());
+    fflush(out_fh);
+  }
+
+  RASQAL_FREE(double*, times);
+
+  if(output_filename)
+    fclose(out_fh);
+
+  raptor_free_uri(data_uri);
+  raptor_free_uri(base_uri);
+
+  rasqal_free_world(world);
+
+  return failures;
+}
+
+#endif